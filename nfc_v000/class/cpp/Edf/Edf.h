@@ -56,6 +56,10 @@ using namespace boost::numeric::ublas;
 #include <string.h>        // C string processing
 #include <limits.h>        // need to know the size of some C data types
 #include <dirent.h>        // directory processing
+#include <fcntl.h>         // low-level file i/o
+#include <unistd.h>        // pread
+#include <sys/mman.h>      // memory-mapped files
+#include <pthread.h>       // threads for parallel file i/o
 
 // special definitions:
 //  these typedefs are using to describe signal and fature vectors
@@ -72,6 +76,229 @@ typedef vector<VVectorDouble> VVVectorDouble;
 typedef matrix<double> MatrixDouble;
 typedef vector<MatrixDouble> VMatrixDouble;
 
+// FeatureTensor: a contiguous (channels x frames x features) block of
+// feature data, allocated once. feature k of frame j of channel i is
+// stored at data[i * cstride + j * fstride + k]. frames are packed
+// (fstride equals the dimension) and each channel starts on an ALIGN
+// byte boundary. the methods are defined in edf_12.
+//
+class FeatureTensor {
+
+public:
+
+  // alignment of each channel in bytes
+  //
+  static const long ALIGN = 64;
+
+  // constructors and destructors
+  //
+  FeatureTensor();
+  FeatureTensor(const FeatureTensor& ft);
+  FeatureTensor& operator=(const FeatureTensor& ft);
+  ~FeatureTensor();
+
+  // set the shape:
+  //  memory is only reallocated when it grows, and values are not kept
+  //
+  bool resize(long nchan, long nframes, long dim);
+  bool clear();
+
+  // change the dimension of the frames, keeping their values
+  //
+  bool set_dim(long dim);
+
+  // get the shape and the strides
+  //
+  long get_nchan() const {
+    return nchan_d;
+  }
+
+  long get_nframes() const {
+    return nframes_d;
+  }
+
+  long get_dim() const {
+    return dim_d;
+  }
+
+  long get_cstride() const {
+    return cstride_d;
+  }
+
+  long get_fstride() const {
+    return fstride_d;
+  }
+
+  // access the data
+  //
+  double* get_data() {
+    return data_d;
+  }
+
+  double* get_channel(long chan) {
+    return data_d + chan * cstride_d;
+  }
+
+  double* get_frame(long chan, long frame) {
+    return data_d + chan * cstride_d + frame * fstride_d;
+  }
+
+  double& operator()(long chan, long frame, long k) {
+    return data_d[chan * cstride_d + frame * fstride_d + k];
+  }
+
+  // convert from and to nested vectors:
+  //  every channel must have the same number of frames, and every
+  //  frame the same dimension
+  //
+  bool assign(VVVectorDouble& feat);
+  bool copy_to(VVVectorDouble& feat) const;
+
+private:
+
+  // the shape, the strides and the data (size_d is the capacity)
+  //
+  long nchan_d;
+  long nframes_d;
+  long dim_d;
+  long cstride_d;
+  long fstride_d;
+  long size_d;
+  double* data_d;
+};
+
+// FeatureStats: running statistics of features, kept for each channel
+// and feature. the mean and variance are updated with Welford's method
+// and two sets of statistics are combined exactly, so files, threads
+// and machines can each collect their own and merge them. quantiles
+// come from sketches of relative accuracy alpha, whose counts simply
+// add when merged. the methods are defined in edf_22.
+//
+class FeatureStats {
+
+public:
+
+  // normalization modes:
+  //  mean (CMN), mean and variance (CMVN), or median and interquartile
+  //  range from the sketches
+  //
+  enum NORM_MODE {NORM_MEAN = 0, NORM_MEANVAR, NORM_ROBUST,
+		  DEF_NORM = NORM_MEANVAR};
+
+  // sketches keep magnitudes in [SKETCH_MIN, SKETCH_MAX] to within
+  // alpha (smaller ones count as zero, larger ones as SKETCH_MAX), and
+  // variances below VAR_FLOOR are not scaled. files start with MAGIC.
+  //
+  static double DEF_ALPHA;
+  static double SKETCH_MIN;
+  static double SKETCH_MAX;
+  static double VAR_FLOOR;
+  static const char* MAGIC;
+  static const long HEADER_SIZE = 64;
+
+  // constructors and destructors
+  //
+  FeatureStats();
+  ~FeatureStats();
+
+  // set the shape and clear the statistics (alpha 0 disables the
+  // sketches). statistics with no shape take the shape of the first
+  // features added to them.
+  //
+  bool resize(long nchan, long dim, double alpha = DEF_ALPHA);
+  bool clear();
+
+  // get the shape and the statistics
+  //
+  long get_nchan() const {
+    return nchan_d;
+  }
+
+  long get_dim() const {
+    return dim_d;
+  }
+
+  double get_alpha() const {
+    return alpha_d;
+  }
+
+  long get_count(long chan) const {
+    return count_d[chan];
+  }
+
+  double get_mean(long chan, long k) const {
+    return mean_d[chan * dim_d + k];
+  }
+
+  double get_var(long chan, long k) const {
+    return (count_d[chan] > 0) ?
+      m2_d[chan * dim_d + k] / (double)count_d[chan] : 0.0;
+  }
+
+  double get_quantile(long chan, long k, double q) const;
+
+  // add frames
+  //
+  bool add_frame(const double* x, long chan);
+  bool add_frames(const double* x, long nframes, long chan);
+  bool add(FeatureTensor& feat);
+  bool add(VVVectorDouble& feat);
+
+  // combine with statistics of the same shape
+  //
+  bool merge(const FeatureStats& st);
+
+  // save and load the statistics
+  //
+  bool write(char* fn);
+  bool read(char* fn);
+
+  // normalize features in place
+  //
+  bool apply(FeatureTensor& feat, NORM_MODE mode = DEF_NORM);
+  bool apply(VVVectorDouble& feat, NORM_MODE mode = DEF_NORM);
+
+private:
+
+  // sketch methods
+  //
+  long get_bucket(double x) const;
+  double get_bucket_value(long b) const;
+  bool add_bucket(long sketch, long b, long n);
+  bool add_value(long sketch, double x);
+  bool get_transform(VectorDouble& a, VectorDouble& b, NORM_MODE mode);
+  bool transform(double* x, const double* a, const double* b);
+
+  // the shape and the moments: channel i has seen count_d[i] frames,
+  // and feature k of it has mean mean_d[i * dim_d + k] and sum of
+  // squared deviations m2_d[i * dim_d + k]
+  //
+  long nchan_d;
+  long dim_d;
+  VectorLong count_d;
+  VectorDouble mean_d;
+  VectorDouble m2_d;
+
+  // the sketches: sketch s = i * dim_d + k counts zero_d[s] values of
+  // magnitude below SKETCH_MIN, and pos_d[s][j] (neg_d[s][j]) positive
+  // (negative) values in bucket lo_d[2 s] + j (lo_d[2 s + 1] + j). the
+  // bucket b holds magnitudes in (gamma^(b-1), gamma^b], with
+  // gamma = (1 + alpha) / (1 - alpha) and lgamma_d = log(gamma).
+  //
+  double alpha_d;
+  double lgamma_d;
+  long bmin_d;
+  long bmax_d;
+  VectorLong zero_d;
+  VectorLong lo_d;
+  VVectorLong pos_d;
+  VVectorLong neg_d;
+
+  // scratch space for the moments of a block of frames
+  //
+  VectorDouble work_d;
+};
+
 // Edf: a class that supports simple manipulation of EDF files. This
 // includes reading the header, loading the signal data, and
 // writing various feature file formats.
@@ -155,6 +382,7 @@ public:
 
   static const long EDF_VERS_BSIZE =  8;
   static const char* EDF_VERS;
+  static const char* BDF_VERS;
   static const char* EDF_FTYP;
   
   static const long EDF_LPTI_BSIZE = 80;
@@ -198,6 +426,7 @@ public:
   // enumerations related to selection mode
   //
   enum INTERPOLATE_MODE {INTMODE_NONE = 0, INTMODE_AVERAGE,  
+		         INTMODE_IDW, INTMODE_SPLINE,
 		         DEF_INTERPOLATE_MODE = INTMODE_NONE};
   
   // enumerations related to interpolate output mode
@@ -205,6 +434,38 @@ public:
   enum INTERPOLATE_OMODE {INTOMODE_REPLACE = 0, INTOMODE_CONCAT,   
 			  DEF_INTERPOLATE_OMODE = INTOMODE_CONCAT};  
 
+  // weighted interpolation:
+  //  electrodes are located by their 10-20 name using spherical
+  //  angles in degrees (theta is signed by hemisphere). spherical
+  //  spline weights use SPLINE_NTERMS Legendre terms of order
+  //  SPLINE_ORDER, regularized by SPLINE_LAMBDA. weight matrices are
+  //  cached for up to MAX_NWCACHE channel configurations.
+  //
+  static const long NUM_ELECTRODES = 29;
+  static const char* ELECTRODE_NAMES[];
+  static const double ELECTRODE_THETA[];
+  static const double ELECTRODE_PHI[];
+
+  static const long SPLINE_ORDER = 4;
+  static const long SPLINE_NTERMS = 50;
+  static double SPLINE_LAMBDA;
+  static double IDW_POWER;
+  static const long MAX_NWCACHE = 8;
+
+  // enumerations related to re-referencing mode
+  //
+  enum REFERENCE_MODE {REFMODE_NONE = 0, REFMODE_CAR, REFMODE_LAPLACIAN,
+		       DEF_REFERENCE_MODE = REFMODE_NONE};
+
+  // re-referencing is computed over blocks of samples (time tiles)
+  // so that all channels of a tile stay in cache during the reduction
+  //
+  static const long REF_TILE_SIZE = 256;
+
+  // matrix-signal products are blocked over time in the same way
+  //
+  static const long MAT_TILE_SIZE = 256;
+
   //----------------------------------------
   //
   // test signal-related constants
@@ -244,17 +505,37 @@ public:
   static const char* FFMT_NAME_01;
   static const char* FFMT_NAME_02;
   static const char* FFMT_NAME_03;
+  static const char* FFMT_NAME_04;
+  static const char* FFMT_NAME_05;
+  static const char* FFMT_NAME_06;
+  static const char* FFMT_NAME_07;
 
   // enumerations related to output file generation
   //
-  enum FFMT {FFMT_EDF = 0, FFMT_RAW, FFMT_HTK, FFMT_KALDI,
-	     DEF_FFMT = FFMT_EDF};
+  enum FFMT {FFMT_EDF = 0, FFMT_RAW, FFMT_HTK, FFMT_KALDI, FFMT_KALDI_CM,
+	     FFMT_RAW2, FFMT_RAW2_F16, FFMT_RAW2_BF16, DEF_FFMT = FFMT_EDF};
+
+  // file types recognized by sniff:
+  //  the type is decided from the first SNIFF_BSIZE bytes of a file,
+  //  which is enough to hold a Kaldi key and matrix header
+  //
+  enum FTYPE {FTYPE_UNKNOWN = 0, FTYPE_EDF, FTYPE_BDF, FTYPE_FILELIST,
+	      FTYPE_RAW, FTYPE_RAW2, FTYPE_HTK, FTYPE_KALDI};
+
+  static const long SNIFF_BSIZE = 1024;
   
   // HTK constants:
   //  note that even though HTK scales fdur by 100ns, we use a
   //  larger value here because it helps HTK work better
   //
   static double HTK_FDUR_SCALE;
+  static const long HTK_HEADER_SIZE = 12;
+  static const long HTK_PARMKIND_USER = 9;
+
+  // multichannel HTK files are read and written by up to this many
+  // threads, one file per channel
+  //
+  static const long DEF_NTHREADS = 4;
 
   // Kaldi constants
   //
@@ -263,7 +544,156 @@ public:
   static const long KALDI_FRAME_FIXED_LOC = 6;
   static const char KALDI_HEADER_EOT = 4;
   static const char* KALDI_HEADER_STR;
+  static const char* KALDI_SCP_EXT;
+
+  // Kaldi compressed matrices:
+  //  "CM" quantizes each column to bytes using a header of four
+  //  percentiles per column. "CM2" and "CM3" quantize every value to
+  //  16 or 8 bits over the global range. As in Kaldi, "CM" is written
+  //  for matrices with more than KALDI_CM_MIN_ROWS rows and "CM2"
+  //  otherwise.
+  //
+  enum KALDI_MTYPE {KMAT_FM = 0, KMAT_CM, KMAT_CM2, KMAT_CM3};
+
+  static const long KALDI_MAX_HEADER_SIZE = 22;
+  static const long KALDI_CM_MIN_ROWS = 8;
+  static const char* KALDI_CM_STR;
+  static const char* KALDI_CM2_STR;
+  static const char* KALDI_CM3_STR;
+
+  // raw v2 constants:
+  //  a version 2 raw file starts with RAW2_MAGIC and a fixed size
+  //  header giving the channels, frames, dimension and data type. it is
+  //  followed by a table of channel offsets. each channel is a dense
+  //  (frames x dimension) matrix that starts on a RAW2_ALIGN boundary.
+  //  values are stored as 32-bit floats, IEEE half precision floats or
+  //  bfloat16 (the upper half of a 32-bit float).
+  //
+  enum RAW_DTYPE {RDT_FLOAT32 = 0, RDT_FLOAT16, RDT_BFLOAT16,
+		  DEF_RAW_DTYPE = RDT_FLOAT32};
+
+  static const char* RAW2_MAGIC;
+  static const long RAW2_HEADER_SIZE = 64;
+  static const long RAW2_ALIGN = 64;
+  static const long RAW2_BLOCK = 256;
+
+  // training shard constants:
+  //  a shard holds up to shard_size examples stored as contiguous
+  //  floats, followed by an index footer (one SHARD_RECORD_SIZE record
+  //  per example and a table of filenames) and a fixed size trailer.
+  //  the writer draws each shard at random from a pool of SHARD_NPOOL
+  //  shards worth of examples.
+  //
+  static const char* SHARD_MAGIC;
+  static const char* SHARD_EXT;
+  static const long SHARD_RECORD_SIZE = 40;
+  static const long SHARD_TRAILER_SIZE = 32;
+  static const long SHARD_NPOOL = 8;
+  static const long DEF_SHARD_SIZE = 1024;
+
+  // streaming feature writer constants:
+  //  frames are written in blocks of FWR_BLOCK frames per channel
+  //
+  static const long FWR_BLOCK = 256;
   
+  //----------------------------------------
+  //
+  // signal processing constants
+  //
+  //----------------------------------------
+
+  // framing:
+  //  frames are spaced by fdur_d secs and span wdur_d secs, and are
+  //  tapered by a window
+  //
+  static double DEF_WDUR;
+
+  enum WINDOW {WIN_RECTANGULAR = 0, WIN_HAMMING, WIN_HANN, WIN_BLACKMAN,
+	       DEF_WINDOW = WIN_HAMMING};
+
+  // fft plans:
+  //  up to FFT_NPLANS lengths are cached, each with at most FFT_MAXPASS
+  //  passes
+  //
+  static const long FFT_NPLANS = 16;
+  static const long FFT_MAXPASS = 64;
+
+  // band power:
+  //  the default bands are delta, theta, alpha, beta and gamma, and
+  //  powers are floored at LOG_FLOOR before the log is taken
+  //
+  static const long DEF_NBANDS = 5;
+  static double DEF_BAND_LO[DEF_NBANDS];
+  static double DEF_BAND_HI[DEF_NBANDS];
+  static double LOG_FLOOR;
+
+  // cepstral front end:
+  //  the default filterbank spans [0, fs / 2] with DEF_LFCC_NFILT
+  //  triangular filters, and DEF_LFCC_NCEP coefficients follow the
+  //  frame energy
+  //
+  static const long DEF_LFCC_NFILT = 24;
+  static const long DEF_LFCC_NCEP = 7;
+
+  // differential features:
+  //  deltas use +/- DEF_DELTA_WIN frames and the differential energy
+  //  +/- DEF_MINMAX_WIN frames. a stream runs up to DLT_NSTAGES stages
+  //  per channel.
+  //
+  enum DELTA_STAGE {DLT_MINMAX = 0, DLT_DELTA, DLT_DDELTA};
+
+  static const long DEF_DELTA_WIN = 2;
+  static const long DEF_MINMAX_WIN = 4;
+  static const long MAX_DELTA_WIN = 32;
+  static const long DLT_NSTAGES = 3;
+
+  // filters:
+  //  butterworth filters are of order DEF_FILT_ORDER by default, and
+  //  FIR filters of at least FIR_FFT_MIN taps use overlap-save. the
+  //  cascade runs over blocks of FILT_BLOCK samples.
+  //
+  enum FILTER_TYPE {FILT_LOWPASS = 0, FILT_HIGHPASS, FILT_NOTCH};
+
+  static const long DEF_FILT_ORDER = 4;
+  static const long MAX_FILT_ORDER = 16;
+  static const long FIR_FFT_MIN = 64;
+  static const long FILT_BLOCK = 256;
+  static double DEF_NOTCH_Q;
+
+  // resampling:
+  //  up to RS_NDESIGNS polyphase filters are cached, for rate changes
+  //  L / M with L, M <= MAX_RS_FACTOR. the prototype spans
+  //  RS_HALF_ZEROS zero crossings on each side.
+  //
+  static const long RS_NDESIGNS = 8;
+  static const long RS_HALF_ZEROS = 10;
+  static const long MAX_RS_FACTOR = 1024;
+  static double RS_KAISER_BETA;
+
+  // sliding spectra:
+  //  band powers of overlapping frames can be computed by sliding the
+  //  needed bins from frame to frame instead of transforming each
+  //  frame. the bins are recomputed from the samples every
+  //  DEF_SDFT_RESYNC frames. accumulators are processed in groups of
+  //  SDFT_GROUP, a window has at most SDFT_MAXTERM exponentials and a
+  //  frame is summed in at most SDFT_MAXRING blocks.
+  //
+  enum SPECTRUM_MODE {SPEC_FFT = 0, SPEC_SLIDING, SPEC_MULTITAPER,
+		      DEF_SPECTRUM = SPEC_FFT};
+
+  static const long DEF_SDFT_RESYNC = 100;
+  static const long SDFT_GROUP = 4;
+  static const long SDFT_MAXTERM = 5;
+  static const long SDFT_MAXRING = 32;
+
+  // multitaper spectra:
+  //  spectra are averaged over the tapers of time half-bandwidth
+  //  product DEF_MT_NW (2 NW - 1 tapers by default). the tapers of up
+  //  to MT_NSETS frame lengths are cached.
+  //
+  static double DEF_MT_NW;
+  static const long MT_NSETS = 4;
+
   //----------------------------------------
   //
   // error codes
@@ -376,6 +806,23 @@ protected:
   // hold the labels to each new channel
   //
   char* new_chan_labels_d[MAX_NCHANS];   
+
+  // cache of interpolation weight matrices:
+  //  each entry is keyed by the mode and the missing and available
+  //  channel labels, so the weights are computed once per configuration
+  //
+  long num_wcache_d;
+  char* wcache_keys_d[MAX_NWCACHE];
+  MatrixDouble wcache_d[MAX_NWCACHE];
+
+  // hold the neighbor sets used for re-referencing:
+  //  ref_chan_labels_d[i] is referenced to the num_ref_adj_d[i]
+  //  channels stored in ref_adj_labels_d[i]
+  //
+  long num_rlabels_d;
+  VectorLong num_ref_adj_d;
+  char** ref_adj_labels_d[MAX_NCHANS];
+  char* ref_chan_labels_d[MAX_NCHANS];
   
   // (6) define some derived values
   //
@@ -407,10 +854,351 @@ protected:
   long chan_num_d[MAX_NCHANS];
   char* mchan_d[MAX_NCHANS];
 
+  // montage decode plan:
+  //  each montage channel is computed directly from a raw record
+  //  buffer. pos2 is -1 when there is no differencing. when both
+  //  operands share a scale factor, the difference is computed on
+  //  the integer samples (mplan_int_d) and scaled once.
+  //
+  long num_mplan_d;
+  long mplan_pos1_d[MAX_NCHANS];
+  long mplan_pos2_d[MAX_NCHANS];
+  double mplan_scale1_d[MAX_NCHANS];
+  double mplan_scale2_d[MAX_NCHANS];
+  double mplan_dc1_d[MAX_NCHANS];
+  double mplan_dc2_d[MAX_NCHANS];
+  bool mplan_int_d[MAX_NCHANS];
+  long rec_offset_d[MAX_NCHANS];
+  long rec_nsamp_d;
+
+  // streaming pipeline state:
+  //  the file is read one tile of stream_nrecs_d records at a time.
+  //  samples that do not fill a frame are carried into the next tile.
+  //  output channel i is row stream_row_d[i] of the decoded channels
+  //  followed by the interpolated channels.
+  //
+  FILE* sfp_d;
+  long stream_rec_d;
+  long stream_nrecs_d;
+  short int* stream_buf_d;
+  VVectorDouble stream_tile_d;
+  VVectorDouble stream_carry_d;
+  long stream_ncarry_d[MAX_NCHANS];
+  long stream_flen_d[MAX_NCHANS];
+
+  long stream_nchan_d;
+  long stream_row_d[MAX_NCHANS];
+  long stream_rsize_d[MAX_NCHANS];
+  char* stream_labels_d[MAX_NCHANS];
+  INTERPOLATE_MODE stream_imode_d;
+  MatrixDouble stream_w_d;
+  VectorLong stream_wpos_d;
+  VVectorDouble stream_interp_d;
+
+  // memory-mapped Kaldi ark:
+  //  the ark is mapped once and its matrices are located in a single
+  //  pass. offsets are relative to the start of the mapping.
+  //
+  char* kmap_d;
+  long kmap_size_d;
+  long num_kmat_d;
+  VectorLong kmat_key_d;
+  VectorLong kmat_klen_d;
+  VectorLong kmat_type_d;
+  VectorLong kmat_rows_d;
+  VectorLong kmat_cols_d;
+  VectorLong kmat_data_d;
+
+  // memory-mapped raw v2 file:
+  //  rmap_offset_d holds the offset of each channel in the mapping
+  //
+  char* rmap_d;
+  long rmap_size_d;
+  long rmap_dtype_d;
+  long rmap_nchan_d;
+  long rmap_nframes_d;
+  long rmap_dim_d;
+  VectorLong rmap_offset_d;
+
+  // training shard writer:
+  //  examples wait in a pool until a shard is drawn from it. filenames
+  //  are stored once in shard_names_d and referenced by offset.
+  //
+  char shard_base_d[MAX_LSTR_LENGTH + 1];
+  long shard_num_d;
+  long shard_size_d;
+  long shard_nframes_d;
+  unsigned short shard_seed_d[3];
+  long shard_npool_d;
+  VVVectorDouble shard_pool_d;
+  VectorLong shard_file_d;
+  VectorLong shard_chan_d;
+  VectorLong shard_label_d;
+  VectorDouble shard_start_d;
+  char* shard_names_d;
+  long shard_nbytes_d;
+  long shard_ncap_d;
+  long shard_last_d;
+
+  // training shard reader:
+  //  one shard at a time is held in shard_buf_d. the next shard is
+  //  opened in advance so that it can be prefetched.
+  //
+  char shard_rbase_d[MAX_LSTR_LENGTH + 1];
+  long shard_rnum_d;
+  int shard_fd_d;
+  char* shard_buf_d;
+  long shard_bsize_d;
+  long shard_nex_d;
+  long shard_footer_d;
+  long shard_nnames_d;
+
+  // streaming feature writer:
+  //  each channel has a block of FWR_BLOCK encoded frames in fwr_buf_d
+  //  that is written to fwr_sink_d when it fills. the sinks of raw files
+  //  and Kaldi arks are the output (channel 0) and temporary files.
+  //
+  char fwr_fname_d[MAX_LSTR_LENGTH + 1];
+  FFMT fwr_ffmt_d;
+  long fwr_dtype_d;
+  long fwr_nchan_d;
+  long fwr_dim_d;
+  long fwr_fbytes_d;
+  FILE* fwr_fp_d;
+  FILE* fwr_sink_d[MAX_NCHANS];
+  char* fwr_names_d[MAX_NCHANS];
+  long fwr_nframes_d[MAX_NCHANS];
+  long fwr_nbuf_d[MAX_NCHANS];
+  char* fwr_buf_d;
+
+  // framing parameters:
+  //  win_tab_d holds the window of type win_ttype_d and length win_len_d
+  //
+  double wdur_d;
+  WINDOW win_type_d;
+  WINDOW win_ttype_d;
+  long win_len_d;
+  double* win_tab_d;
+
+  // fft plans:
+  //  plan i transforms fft_n_d[i] real samples with a complex transform
+  //  of fft_nc_d[i] points. its tables are in fft_tab_d[i], starting at
+  //  fft_toff_d[i][pass] for each pass and at fft_soff_d[i] for the
+  //  split step (offsets are in complex values).
+  //
+  long fft_nplans_d;
+  long fft_next_d;
+  long fft_n_d[FFT_NPLANS];
+  long fft_nc_d[FFT_NPLANS];
+  long fft_npass_d[FFT_NPLANS];
+  long fft_radix_d[FFT_NPLANS][FFT_MAXPASS];
+  long fft_toff_d[FFT_NPLANS][FFT_MAXPASS];
+  long fft_soff_d[FFT_NPLANS];
+  double* fft_tab_d[FFT_NPLANS];
+  double* fft_work_d;
+  long fft_wsize_d;
+
+  // band power parameters:
+  //  the bin weights of band b start at bin band_first_d[b] and are
+  //  stored one band after the other in band_wgt_d. they are valid for
+  //  a frame length, sample frequency, window and spectrum mode
+  //  (band_n_d is -1 when they must be recomputed). band_buf_d holds a
+  //  frame and its spectrum.
+  //
+  VectorDouble band_lo_d;
+  VectorDouble band_hi_d;
+  long band_n_d;
+  double band_fs_d;
+  WINDOW band_win_d;
+  SPECTRUM_MODE band_mode_d;
+  VectorLong band_first_d;
+  VectorLong band_nbins_d;
+  VectorDouble band_wgt_d;
+  double* band_buf_d;
+  long band_bsize_d;
+
+  // cepstral parameters:
+  //  the filter weights are stored like the band weights. the tables
+  //  are valid for a frame length and sample frequency (lfcc_n_d is -1
+  //  when they must be recomputed). lfcc_buf_d holds the DCT followed
+  //  by the scratch space of a frame.
+  //
+  long lfcc_nfilt_d;
+  long lfcc_ncep_d;
+  double lfcc_flo_d;
+  double lfcc_fhi_d;
+  long lfcc_n_d;
+  double lfcc_fs_d;
+  VectorLong lfcc_first_d;
+  VectorLong lfcc_nbins_d;
+  VectorDouble lfcc_wgt_d;
+  double* lfcc_buf_d;
+  long lfcc_bsize_d;
+
+  // delta parameters:
+  //  stage s of a stream reads frames of dlt_width_d[s] values and
+  //  writes frames of dlt_wout_d[s] values. the ring of stage s of
+  //  channel i starts at dlt_buf_d + i * dlt_cstride_d + dlt_off_d[s],
+  //  and its state is at index i * DLT_NSTAGES + s of the vectors.
+  //
+  long dlt_win_d;
+  long dlt_ndd_d;
+  bool dlt_mm_d;
+  long dlt_mmwin_d;
+  long dlt_nchan_d;
+  long dlt_nstages_d;
+  DELTA_STAGE dlt_type_d[DLT_NSTAGES];
+  long dlt_h_d[DLT_NSTAGES];
+  long dlt_width_d[DLT_NSTAGES];
+  long dlt_wout_d[DLT_NSTAGES];
+  long dlt_off_d[DLT_NSTAGES];
+  long dlt_cstride_d;
+  VectorLong dlt_head_d;
+  VectorLong dlt_fill_d;
+  VectorLong dlt_nin_d;
+  VectorLong dlt_nout_d;
+  double* dlt_buf_d;
+  long dlt_bsize_d;
+
+  // filter parameters:
+  //  filter i of the cascade is described by filt_stype_d[i],
+  //  filt_sfreq_d[i] and filt_sparam_d[i]. the sections and the fft of
+  //  the taps are valid for filt_fs_d (-1 when they must be
+  //  recomputed). the state of a stream holds two values per section
+  //  per channel, followed by the FIR history of each channel.
+  //
+  VectorLong filt_stype_d;
+  VectorDouble filt_sfreq_d;
+  VectorDouble filt_sparam_d;
+  VectorDouble filt_h_d;
+  VectorDouble filt_hr_d;
+  bool filt_zphase_d;
+  double filt_fs_d;
+  long filt_nsos_d;
+  VectorDouble filt_sos_d;
+  long filt_nfft_d;
+  double* filt_buf_d;
+  long filt_bsize_d;
+  long filt_nchan_d;
+  long filt_cpad_d;
+  double* filt_state_d;
+  long filt_ssize_d;
+  double* filt_ext_d;
+  long filt_esize_d;
+
+  // resampling parameters:
+  //  design d converts by rs_l_d[d] / rs_m_d[d] with rs_ntap_d[d] taps
+  //  per phase and a delay of rs_half_d[d] upsampled samples. channel
+  //  i of a stream converts by rs_cl_d[i] / rs_cm_d[i], has read
+  //  rs_nin_d[i] samples and written rs_nout_d[i], and keeps its last
+  //  inputs at rs_hist_d + i * rs_hstride_d. if rs_read_fs_d is
+  //  positive, signals are resampled to it when they are read, and
+  //  open_stream fails.
+  //
+  long rs_ndesigns_d;
+  long rs_next_d;
+  long rs_l_d[RS_NDESIGNS];
+  long rs_m_d[RS_NDESIGNS];
+  long rs_half_d[RS_NDESIGNS];
+  long rs_ntap_d[RS_NDESIGNS];
+  double* rs_tab_d[RS_NDESIGNS];
+  long rs_nchan_d;
+  VectorLong rs_cl_d;
+  VectorLong rs_cm_d;
+  VectorLong rs_nin_d;
+  VectorLong rs_nout_d;
+  double* rs_hist_d;
+  long rs_hstride_d;
+  long rs_hsize_d;
+  double* rs_ext_d;
+  long rs_esize_d;
+  double rs_read_fs_d;
+
+  // sliding spectrum parameters:
+  //  the tables slide sdft_bin_d.size() bins of a frame of sdft_n_d
+  //  samples by sdft_h_d samples. bin b uses sdft_nterm_d accumulators
+  //  (one per exponential of the window, weighted by sdft_coef_d),
+  //  stored in groups of SDFT_GROUP real parts followed by as many
+  //  imaginary parts. sdft_tab_d holds the tables of blocks of
+  //  sdft_nb_d samples, then the block offsets (at sdft_poff_d), then
+  //  the slide factors and the scratch space (at sdft_zoff_d). slot i
+  //  of sdft_state_d holds the accumulators and the ring of block sums
+  //  (of sdft_nring_d blocks) of a channel, and has slid
+  //  sdft_count_d[i] frames since it was last recomputed (-1 when it is
+  //  not valid).
+  //
+  SPECTRUM_MODE spec_mode_d;
+  long sdft_resync_d;
+  long sdft_n_d;
+  long sdft_h_d;
+  long sdft_nring_d;
+  long sdft_nb_d;
+  long sdft_nterm_d;
+  long sdft_ngrp_d;
+  double sdft_coef_d[SDFT_MAXTERM];
+  VectorLong sdft_bin_d;
+  double* sdft_tab_d;
+  long sdft_tsize_d;
+  long sdft_poff_d;
+  long sdft_zoff_d;
+  long sdft_nslots_d;
+  long sdft_sstride_d;
+  double* sdft_state_d;
+  long sdft_ssize_d;
+  VectorLong sdft_head_d;
+  VectorLong sdft_count_d;
+
+  // band power stream parameters:
+  //  channel i of a stream buffers bs_fill_d[i] samples at bs_buf_d +
+  //  i * bs_cap_d, starting at its last frame once bs_nout_d[i] frames
+  //  were written. the frame length, shift and spectrum mode are fixed
+  //  when the stream is opened.
+  //
+  long bs_nchan_d;
+  long bs_n_d;
+  long bs_h_d;
+  SPECTRUM_MODE bs_mode_d;
+  long bs_cap_d;
+  double* bs_buf_d;
+  long bs_bsize_d;
+  VectorLong bs_fill_d;
+  VectorLong bs_nout_d;
+
+  // feature statistics:
+  //  when stats_on_d is set, features written by write_features or the
+  //  feature writer are added to stats_d
+  //
+  bool stats_on_d;
+  FeatureStats stats_d;
+
+  // multitaper parameters:
+  //  set s of the cache holds the tapers of mt_sk_d[s] tapers of
+  //  mt_sn_d[s] samples for mt_snw_d[s] (mt_sn_d[s] is -1 when the set
+  //  is not valid). mt_tab_d[s] holds the tapers in pairs, interleaved
+  //  as the real and imaginary parts of one complex sequence and scaled
+  //  by the square root of their weights, followed by the concentration
+  //  of each taper. mt_set_d and mt_plan_d are the set and the complex
+  //  fft plan of the current frame length, and mt_buf_d holds the
+  //  tapered frames, the transforms and a spectrum.
+  //
+  double mt_nw_d;
+  long mt_k_d;
+  long mt_nsets_d;
+  long mt_next_d;
+  long mt_sn_d[MT_NSETS];
+  double mt_snw_d[MT_NSETS];
+  long mt_sk_d[MT_NSETS];
+  double* mt_tab_d[MT_NSETS];
+  long mt_set_d;
+  long mt_plan_d;
+  double* mt_buf_d;
+  long mt_bsize_d;
+
   // htk-related parameters
   //
   double fdur_d;
   char fnmod_d[MAX_SSTR_LENGTH];
+  long nthreads_d;
 
   //---------------------------------------------------------------------------
   //
@@ -473,16 +1261,17 @@ public:
   // read feature data (edf_01)
   //
   bool read_features(VVVectorDouble& feat, char* fname);
-  bool read_features_raw(VVVectorDouble& feat, char* fn);
+  bool read_features_raw(VVVectorDouble& feat, char* fn, int fd = -1);
   bool read_features_htk(VVVectorDouble& feat, char* fn);
-  bool read_features_kaldi(VVVectorDouble& feat, char* fn);
+  bool read_features_kaldi(VVVectorDouble& feat, char* fn, int fd = -1);
 
   // write feature data (edf_01)
   //
   bool write_features(VVVectorDouble& feat, char* fname, FFMT fffmt);
   bool write_features_raw(VVVectorDouble& feat, char* fn);
   bool write_features_htk(VVVectorDouble& feat, char* fn);
-  bool write_features_kaldi(VVVectorDouble& feat, char* fn);
+  bool write_features_kaldi(VVVectorDouble& feat, char* fn,
+			    bool compress = false);
 
   // informational methods (edf_01)
   //
@@ -491,6 +1280,7 @@ public:
   bool is_raw(char* fname);
   bool is_htk(char* fname);
   bool is_kaldi(char* fname);
+  FTYPE sniff(int& fd, char* fname);
   bool debug(VVectorDouble& sig, FILE* fp = stdout);
   bool debug(VVVectorDouble& feat, FILE* fp = stdout);
 
@@ -504,6 +1294,16 @@ public:
     return (fdur_d = fdur);
   }
 
+  // get/set for the number of threads used for HTK files
+  //
+  long get_nthreads() {
+    return nthreads_d;
+  }
+
+  long set_nthreads(long nthreads) {
+    return (nthreads_d = (nthreads > 0) ? nthreads : 1);
+  }
+
   // get/set for the filename modifier
   //
   bool get_filename_modifier(char* fnmod) {
@@ -565,6 +1365,458 @@ public:
 		   INTERPOLATE_MODE mode,
 		   INTERPOLATE_OMODE omode);
 
+  //---------------------------------------------------------------------------
+  //
+  // public methods: re-referencing (edf_06)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // common average and Laplacian references
+  //
+  bool rereference(VVectorDouble& sigo,
+		   VVectorDouble& sigi,
+		   REFERENCE_MODE mode, MATCH_MODE matmode);
+
+  // montages computed while decoding
+  //
+  bool read_edf_montage(VVectorDouble& sig, char* fn,
+			char** mselect, MATCH_MODE matmode);
+
+  // montages applied to linear features (e.g., complex spectra)
+  //
+  bool apply_montage_features(VVVectorDouble& feato,
+			      VVVectorDouble& feati,
+			      char** mselect, MATCH_MODE matmode);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: streaming pipeline (edf_07)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // read, select, montage, interpolate and frame a file one tile
+  // at a time
+  //
+  bool open_stream(char* fn, char* cselect,
+		   char** mselect, MATCH_MODE matmode,
+		   INTERPOLATE_MODE intmode = INTMODE_NONE,
+		   INTERPOLATE_OMODE omode = DEF_INTERPOLATE_OMODE);
+  bool read_stream(VVVectorDouble& frames, long& nframes);
+  bool close_stream();
+
+  // the output channels of the last stream that was opened
+  //
+  long get_num_stream_channels() {
+    return stream_nchan_d;
+  }
+
+  char* get_stream_label(long chan) {
+    return ((chan >= 0) && (chan < stream_nchan_d)) ?
+      stream_labels_d[chan] : (char*)NULL;
+  }
+
+  // compare the stream with the staged methods
+  //
+  bool benchmark_stream(double& tstaged, double& tstream, char* fn,
+			char* cselect, char** mselect, MATCH_MODE matmode,
+			INTERPOLATE_MODE intmode = INTMODE_NONE,
+			INTERPOLATE_OMODE omode = DEF_INTERPOLATE_OMODE,
+			FILE* fp = stdout);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: Kaldi ark access (edf_08)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // read one channel of an ark by its key using the scp index
+  //
+  bool read_features_kaldi(VVectorDouble& feat, char* scp, char* key);
+
+  // map an ark and access its matrices without copying
+  //
+  bool map_kaldi(char* fn, int fd = -1);
+  bool unmap_kaldi();
+
+  long get_kaldi_nmat() {
+    return num_kmat_d;
+  }
+
+  const char* get_kaldi_matrix(long& rows, long& cols, char* key,
+			       long index);
+  bool widen(VVectorDouble& feat, const char* data, long rows, long cols);
+  bool get_kaldi_features(VVectorDouble& feat, long index);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: raw v2 feature files (edf_10)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // read and write dense, aligned raw files
+  //
+  bool read_features_raw2(VVVectorDouble& feat, char* fn, int fd = -1);
+  bool write_features_raw2(VVVectorDouble& feat, char* fn,
+			   RAW_DTYPE dtype = DEF_RAW_DTYPE);
+
+  // read a range of frames of one channel with a single pread
+  //
+  bool read_features_raw(VVectorDouble& feat, char* fn, long chan,
+			 long start, long nframes);
+
+  // map a raw v2 file and access its channels without copying
+  //
+  bool map_raw(char* fn);
+  bool unmap_raw();
+  const float* get_raw_matrix(long& nframes, long& dim, long chan);
+  bool get_raw_features(VVectorDouble& feat, long chan);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: training shards (edf_11)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // write examples to shuffled, fixed size shards
+  //
+  bool open_shard_writer(char* base, long nframes,
+			 long shard_size = DEF_SHARD_SIZE, long seed = 0);
+  bool add_examples(VVVectorDouble& feat, char* fname, long label);
+  bool add_example(VVectorDouble& ex, char* fname, long chan,
+		   double start, long label);
+  bool close_shard_writer();
+
+  // read shards one at a time
+  //
+  bool open_shard_reader(char* base);
+  bool read_shard(VVVectorDouble& ex, long& nex);
+  bool get_shard_info(char* fname, long& chan, double& start, long& label,
+		      long index);
+  bool close_shard_reader();
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: feature tensors (edf_12)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // read feature data into a contiguous tensor
+  //
+  bool read_features(FeatureTensor& feat, char* fn);
+  bool read_features_raw(FeatureTensor& feat, char* fn, int fd = -1);
+  bool read_features_raw2(FeatureTensor& feat, char* fn, int fd = -1);
+  bool read_features_htk(FeatureTensor& feat, char* fn);
+  bool read_features_kaldi(FeatureTensor& feat, char* fn, int fd = -1);
+
+  // write feature data from a contiguous tensor
+  //
+  bool write_features(FeatureTensor& feat, char* fname, FFMT fffmt);
+  bool write_features_raw(FeatureTensor& feat, char* fn);
+  bool write_features_raw2(FeatureTensor& feat, char* fn,
+			   RAW_DTYPE dtype = DEF_RAW_DTYPE);
+  bool write_features_htk(FeatureTensor& feat, char* fn);
+  bool write_features_kaldi(FeatureTensor& feat, char* fn,
+			    bool compress = false);
+
+  // display a tensor
+  //
+  bool debug(FeatureTensor& feat, FILE* fp = stdout);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: streaming feature writers (edf_13)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // write a feature file as its frames are produced
+  //
+  bool open_feature_writer(char* fn, FFMT ffmt, long nchan, long dim);
+  bool write_frames(VVVectorDouble& frames, long nframes);
+  bool write_frame(VectorDouble& frame, long chan);
+  bool close_feature_writer();
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: framing and windowing (edf_14)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // get/set for the window duration and type:
+  //  the frame duration (see set_fdur) is the spacing of the frames
+  //
+  double get_wdur() {
+    return wdur_d;
+  }
+
+  double set_wdur(double wdur) {
+    return (wdur_d = wdur);
+  }
+
+  WINDOW get_window() {
+    return win_type_d;
+  }
+
+  WINDOW set_window(WINDOW type) {
+    return (win_type_d = type);
+  }
+
+  // frame sizes in samples, from the sample frequency
+  //
+  long get_frame_shift();
+  long get_window_length();
+  long get_num_frames(long nsamples);
+
+  // cut signals into tapered frames
+  //
+  const double* get_frame_view(VectorDouble& sig, long frame);
+  bool window_frame(double* y, const double* x);
+  bool frame_signal(FeatureTensor& frames, VVectorDouble& sig);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: fast Fourier transforms (edf_15)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // transforms of real signals of any length
+  //
+  bool fft(double* y, const double* x, long n);
+  bool ifft(double* y, const double* x, long n);
+
+  // transform all frames of all channels
+  //
+  bool fft(FeatureTensor& spec, FeatureTensor& frames);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: band power features (edf_16)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // set the bands in Hz
+  //
+  bool set_bands(VectorDouble& flo, VectorDouble& fhi);
+  long get_num_bands() {
+    return band_lo_d.size();
+  }
+
+  // compute log band powers from a signal or from tapered frames
+  //
+  bool compute_band_power(FeatureTensor& feat, VVectorDouble& sig);
+  bool compute_band_power(FeatureTensor& feat, FeatureTensor& frames);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: cepstral features (edf_17)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // set the filterbank and the number of cepstral coefficients
+  //
+  bool set_lfcc(long nfilt, long ncep, double flo = 0, double fhi = 0);
+  long get_num_cepstra() {
+    return lfcc_ncep_d;
+  }
+
+  // compute the frame energy followed by the cepstral coefficients
+  //
+  bool compute_lfcc(FeatureTensor& feat, VVectorDouble& sig);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: differential features (edf_18)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // set the regression window, the number of delta-deltas and the
+  // differential energy
+  //
+  bool set_deltas(long win, long ndd = -1);
+  bool set_minmax_energy(bool mode, long win = DEF_MINMAX_WIN);
+  long get_delta_dim(long dim);
+
+  // append differential features to a tensor in place
+  //
+  bool append_deltas(FeatureTensor& feat);
+
+  // compute differential features frame by frame
+  //
+  bool open_delta_stream(long nchan, long dim);
+  bool push_delta_frame(double* y, long& nout, const double* x, long chan);
+  bool flush_delta_frame(double* y, long& nout, long chan);
+  bool close_delta_stream();
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: filters (edf_19)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // build the cascade of filters
+  //
+  bool add_lowpass(double fc, long order = DEF_FILT_ORDER);
+  bool add_highpass(double fc, long order = DEF_FILT_ORDER);
+  bool add_notch(double f0, double q = DEF_NOTCH_Q);
+  bool set_fir(VectorDouble& h);
+  bool design_fir(VectorDouble& h, double flo, double fhi, long ntaps);
+  bool clear_filters();
+
+  // set the batch mode to zero phase (forward and backward)
+  //
+  bool set_zero_phase(bool mode) {
+    filt_zphase_d = mode;
+    return true;
+  }
+
+  bool get_zero_phase() {
+    return filt_zphase_d;
+  }
+
+  // filter a signal in place, at once or block by block
+  //
+  bool filter_signal(VVectorDouble& sig);
+  bool open_filter_stream(long nchan);
+  bool filter_block(VVectorDouble& sig);
+  bool close_filter_stream();
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: resampling (edf_20)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // the sample frequency of a channel from its record size
+  //
+  double get_channel_frequency(long chan);
+
+  // resample to a common rate when signals are read (0 disables it)
+  //
+  bool set_read_frequency(double fs) {
+    rs_read_fs_d = fs;
+    return true;
+  }
+
+  double get_read_frequency() {
+    return rs_read_fs_d;
+  }
+
+  // resample a signal at once, using the rates of the header or given
+  // rates
+  //
+  bool resample(VVectorDouble& sig, double fs);
+  bool resample(VVectorDouble& sig, VectorDouble& fs_in, double fs_out);
+
+  // resample a signal block by block
+  //
+  bool open_resample_stream(VectorDouble& fs_in, double fs_out);
+  bool resample_block(VVectorDouble& sig);
+  bool flush_resample_stream(VVectorDouble& sig);
+  bool close_resample_stream();
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: sliding spectra (edf_21)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // get/set the way band power spectra of a signal are computed, and
+  // how many frames are slid before the bins are recomputed
+  //
+  SPECTRUM_MODE get_spectrum_mode() {
+    return spec_mode_d;
+  }
+
+  SPECTRUM_MODE set_spectrum_mode(SPECTRUM_MODE mode) {
+    return (spec_mode_d = mode);
+  }
+
+  long get_sdft_resync() {
+    return sdft_resync_d;
+  }
+
+  long set_sdft_resync(long nframes) {
+    return (sdft_resync_d = nframes);
+  }
+
+  // compute band powers block by block
+  //
+  bool open_band_stream(long nchan);
+  bool band_power_block(FeatureTensor& feat, VVectorDouble& sig);
+  bool close_band_stream();
+
+  // time both spectrum modes for several frame durations
+  //
+  bool benchmark_band_power(VectorDouble& tfft, VectorDouble& tsdft,
+			    VVectorDouble& sig, VectorDouble& fdur,
+			    FILE* fp = stdout);
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: feature statistics (edf_22)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // collect statistics of the features that are written
+  //
+  bool set_collect_stats(bool mode) {
+    stats_on_d = mode;
+    return true;
+  }
+
+  bool get_collect_stats() {
+    return stats_on_d;
+  }
+
+  // access the statistics (resize them to choose the accuracy of the
+  // sketches before features are written)
+  //
+  FeatureStats& get_stats() {
+    return stats_d;
+  }
+
+  //---------------------------------------------------------------------------
+  //
+  // public methods: multitaper spectra (edf_23)
+  //
+  //---------------------------------------------------------------------------
+public:
+
+  // set the time half-bandwidth product and the number of tapers (2 nw
+  // - 1 when ntapers is not given)
+  //
+  bool set_multitaper(double nw, long ntapers = -1);
+  double get_multitaper_nw() {
+    return mt_nw_d;
+  }
+
+  long get_num_tapers() {
+    return mt_k_d;
+  }
+
+  // get the tapers of a frame length and their concentrations
+  //
+  bool get_tapers(VVectorDouble& tapers, VectorDouble& conc, long n);
+
+  // compute the multitaper power spectral density of every frame
+  //
+  bool compute_psd(FeatureTensor& psd, VVectorDouble& sig);
+
   //---------------------------------------------------------------------------
   //
   // public methods: infrastructure methods (edf_00)
@@ -593,6 +1845,7 @@ public:
   bool cleanup();
   bool cleanup(char** strs, long num_strs);
   bool cleanup_labels();
+  bool cleanup_reference();
 
   // conversion from strings to ints / enums
   //
@@ -605,11 +1858,13 @@ public:
   long find_vname(char* name, char** vnames);
   bool set_var(long pos, char* value, char** vtypes, void** vptrs);
   bool parse_aux(char** strm, char** stri);
+  bool parse_reference(char** strr);
 
   // parses the channel numbers for interpolation and montage
   //
   bool set_interp_chans(long new_channels);
   bool set_montage_chans(long num_montage);
+  bool set_reference_chans(long num_chans);
 
   //---------------------------------------------------------------------------
   //
@@ -689,6 +1944,12 @@ public:
   double min(double val1, double val2);
   bool shift(VectorDouble& v, long incr);
 
+  // matrix functions
+  //
+  bool multiply(VVectorDouble& out, MatrixDouble& w,
+		VVectorDouble& in, VectorLong& pos);
+  bool solve(MatrixDouble& x, MatrixDouble& a, MatrixDouble& b);
+
   //---------------------------------------------------------------------------
   //
   // private methods
@@ -703,6 +1964,7 @@ private:
 
   bool is_big_endian();
   bool swap_bytes(void* buf, void* value, long nbytes);
+  bool get_scale(double& scale, double& dc, long chan);
   
   // methods to get/put edf file data (edf_03)
   //
@@ -727,6 +1989,9 @@ private:
   bool parse_interp_channels(long& nl_i, char*** labels1,
 			     VectorLong& num_chans, char** newChannel,
 			     char** str);
+  bool parse_interp_channels(long& nl_i, char*** labels1,
+			     VectorLong& num_chans, char** newChannel,
+			     char** str, long nc);
 
   // filename processing methods (edf_03)
   //
@@ -734,10 +1999,151 @@ private:
   bool create_matching_filename(char* dirname, char* bname, char* ext,
 				char* fname, long nf, char* bfn, char* fmt);
 
+  // montage decode methods (edf_06)
+  //
+  bool create_montage_plan(char** mselect, MATCH_MODE matmode);
+  bool decode_montage(VVectorDouble& sig, short int* buf, long rec);
+
+  // streaming pipeline methods (edf_07)
+  //
+  bool select_plan(char* cselect, bool identity, MATCH_MODE matmode);
+  bool interp_plan(MATCH_MODE matmode, INTERPOLATE_MODE intmode,
+		   INTERPOLATE_OMODE omode);
+
+  // Kaldi ark access methods (edf_08)
+  //
+  bool find_kaldi_key(char* ark, long& offset, char* scp, char* key);
+  bool create_kaldi_scp_name(char* scp, char* ark);
+  bool parse_kaldi_header(long& type, long& rows, long& cols,
+			  float& vmin, float& range, long& hsize, long& dsize,
+			  const unsigned char* hdr, long n);
+  bool decode_kaldi_matrix(VVectorDouble& feat, long type,
+			   long rows, long cols, float vmin, float range,
+			   const unsigned char* data);
+  bool write_kaldi_cm(FILE* fp, VVectorDouble& feat);
+
+  // batched HTK methods (edf_09)
+  //
+  bool read_htk_channels(VVVectorDouble& feat, char** fnames, long nf);
+  bool write_htk_channels(VVVectorDouble& feat, char** fnames, long nf);
+  bool encode_htk_channel(unsigned char*& buf, long& nbytes,
+			  VVectorDouble& feat, double fdur);
+  bool decode_htk_channel(VVectorDouble& feat, double& fdur,
+			  const unsigned char* buf, long nbytes);
+  bool list_matching_filenames(char** fnames, long& nf, char* bfn, char* fmt);
+  static void* htk_worker(void* arg);
+
+  // raw v2 methods (edf_10)
+  //
+  bool read_raw2_header(long& dtype, long& nchan, long& nframes, long& dim,
+			VectorLong& offsets, int fd, long fsize);
+  bool decode_raw2(VVectorDouble& feat, const char* data,
+		   long nframes, long dim, long dtype);
+  bool write_raw2_header(FILE* fp, long& cbytes, long nchan, long nframes,
+			 long dim, long dtype);
+  bool encode_values(char* y, const double* x, long n, long dtype);
+  bool decode_values(double* y, const char* x, long n, long dtype);
+  bool is_raw2(const unsigned char* buf, long n);
+  long get_raw2_esize(long dtype);
+  bool encode_half(uint16_t* y, const float* x, long n, long dtype);
+  bool decode_half(float* y, const uint16_t* x, long n, long dtype);
+
+  // training shard methods (edf_11)
+  //
+  bool write_shard(long nex);
+  bool create_shard_name(char* fname, char* base, long num);
+  bool open_next_shard();
+
+  // streaming feature writer methods (edf_13)
+  //
+  bool write_fwr_header(FILE* fp, long chan, long nframes);
+  bool flush_fwr_block(long chan);
+  bool release_feature_writer();
+
+  // framing methods (edf_14)
+  //
+  bool create_window(long wlen);
+  bool multiply(double* y, const double* x, const double* w, long n);
+
+  // fft methods (edf_15)
+  //
+  long get_fft_plan(long n);
+  bool create_fft_plan(long plan, long n);
+  double* fft_complex(long plan, double* a, double* b);
+  double* fft_batch(long plan, double* a, double* b, long nseq);
+  bool fft_pass(double* y, const double* x, const double* tw,
+		long m, long s, long r);
+  bool fft_real(long plan, double* y, const double* x);
+  bool ifft_real(long plan, double* y, const double* x);
+
+  // band power methods (edf_16)
+  //
+  bool create_band_weights(long n);
+  bool band_power(double* y, const double* x, long plan);
+  bool band_sum(double* y, const double* spec);
+
+  // cepstral methods (edf_17)
+  //
+  bool create_lfcc_tables(long n);
+  bool lfcc_frame(double* y, const double* x, long plan);
+  double dot(const double* x, const double* y, long n);
+
+  // delta methods (edf_18)
+  //
+  bool run_delta_stages(double* y, long& nout, const double* x,
+			long chan, long first);
+  bool push_delta_stage(double* y, const double* x, long chan, long s);
+
+  // filter methods (edf_19)
+  //
+  bool add_filter_spec(FILTER_TYPE type, double freq, double param);
+  bool create_filter_tables();
+  bool reset_filter_state();
+  bool set_filter_state(long chan, double x0);
+  bool run_filters(VVectorDouble& sig);
+  bool biquad_lanes(double* x, long n, long chan);
+  bool biquad_channel(double* x, long n, long chan);
+  bool fir_channel(VectorDouble& x, long chan);
+
+  // resampling methods (edf_20)
+  //
+  bool is_annotation(long chan);
+  bool get_resample_ratio(long& l, long& m, double fs_in, double fs_out);
+  long get_resample_design(long l, long m);
+  bool resample_channel(VectorDouble& x, long chan, bool flush);
+  double bessel_i0(double x);
+
+  // sliding spectrum methods (edf_21)
+  //
+  bool band_frame(double* y, const double* x, long plan, long slot,
+		  bool first);
+  bool create_sdft_tables(long n, long h, long nslots);
+  bool sdft_frame(double* spec, const double* x, long slot, bool sync);
+  bool sdft_block_sum(double* g, const double* x, long len);
+
+  // multitaper methods (edf_23)
+  //
+  bool create_multitaper(long n);
+  long get_taper_set(long n);
+  bool create_dpss(double* tab, long n, double nw, long k);
+  bool mt_frame(double* y, const double* x, long set, long plan,
+		double* buf);
+  bool band_psum(double* y, const double* pow);
+  static void* mt_worker(void* arg);
+
   // interpolation methods (edf_05)
   //
   bool interpolate_average(VVectorDouble& new_chan,
 			   VVectorDouble& sig);
+  bool interpolate_weighted(VVectorDouble& new_chan,
+			    VVectorDouble& sig, INTERPOLATE_MODE mode);
+  bool find_interp_weights(long& ind, long& na, char** alabels,
+			   INTERPOLATE_MODE mode);
+  bool compute_interp_weights(MatrixDouble& w, INTERPOLATE_MODE mode,
+			      long nm, char** mlabels,
+			      long na, char** alabels);
+  bool get_electrode_pos(double* xyz, char* label);
+  double legendre_sum(double x, double* coef, long nterms);
   //
   // end of class
 };
@@ -133,6 +133,22 @@ Edf::Edf(long debug_level_a) {
     adj_chan_labels_d[i] = (char**)NULL;
   }
 
+  // variables related to weighted interpolation
+  //
+  num_wcache_d = 0;
+  for (long i = 0; i < MAX_NWCACHE; i++) {
+    wcache_keys_d[i] = (char*)NULL;
+  }
+
+  // variables related to re-referencing
+  //
+  num_rlabels_d = -1;
+
+  for (long i = 0; i < MAX_NCHANS; i++) {
+    ref_chan_labels_d[i] = (char*)NULL;
+    ref_adj_labels_d[i] = (char**)NULL;
+  }
+
   // (6) define some derived values
   //
   if (debug_level_d >= LEVEL_FULL) {
@@ -160,7 +176,176 @@ Edf::Edf(long debug_level_a) {
     slabels_d[i] = (char*)NULL;
     mlabels1_d[i] = (char*)NULL;
     mlabels2_d[i] = (char*)NULL;
-  }
+    stream_labels_d[i] = (char*)NULL;
+  }
+
+  num_mplan_d = 0;
+  rec_nsamp_d = 0;
+
+  sfp_d = (FILE*)NULL;
+  stream_rec_d = 0;
+  stream_nrecs_d = 0;
+  stream_buf_d = (short int*)NULL;
+  stream_nchan_d = 0;
+  stream_imode_d = INTMODE_NONE;
+
+  kmap_d = (char*)NULL;
+  kmap_size_d = 0;
+  num_kmat_d = 0;
+
+  rmap_d = (char*)NULL;
+  rmap_size_d = 0;
+  rmap_dtype_d = DEF_RAW_DTYPE;
+  rmap_nchan_d = 0;
+  rmap_nframes_d = 0;
+  rmap_dim_d = 0;
+
+  shard_base_d[0] = (char)NULL;
+  shard_num_d = 0;
+  shard_size_d = DEF_SHARD_SIZE;
+  shard_nframes_d = 0;
+  shard_npool_d = 0;
+  shard_names_d = (char*)NULL;
+  shard_nbytes_d = 0;
+  shard_ncap_d = 0;
+  shard_last_d = -1;
+
+  shard_rbase_d[0] = (char)NULL;
+  shard_rnum_d = 0;
+  shard_fd_d = -1;
+  shard_buf_d = (char*)NULL;
+  shard_bsize_d = 0;
+  shard_nex_d = 0;
+  shard_footer_d = 0;
+  shard_nnames_d = 0;
+
+  fwr_fname_d[0] = (char)NULL;
+  fwr_ffmt_d = DEF_FFMT;
+  fwr_dtype_d = DEF_RAW_DTYPE;
+  fwr_nchan_d = 0;
+  fwr_dim_d = 0;
+  fwr_fbytes_d = 0;
+  fwr_fp_d = (FILE*)NULL;
+  for (long i = 0; i < MAX_NCHANS; i++) {
+    fwr_sink_d[i] = (FILE*)NULL;
+    fwr_names_d[i] = (char*)NULL;
+  }
+  fwr_buf_d = (char*)NULL;
+
+  wdur_d = DEF_WDUR;
+  win_type_d = DEF_WINDOW;
+  win_ttype_d = DEF_WINDOW;
+  win_len_d = 0;
+  win_tab_d = (double*)NULL;
+
+  fft_nplans_d = 0;
+  fft_next_d = 0;
+  for (long i = 0; i < FFT_NPLANS; i++) {
+    fft_n_d[i] = -1;
+    fft_tab_d[i] = (double*)NULL;
+  }
+  fft_work_d = (double*)NULL;
+  fft_wsize_d = 0;
+
+  Edf::resize(band_lo_d, DEF_NBANDS, false);
+  Edf::resize(band_hi_d, DEF_NBANDS, false);
+  for (long i = 0; i < DEF_NBANDS; i++) {
+    band_lo_d[i] = DEF_BAND_LO[i];
+    band_hi_d[i] = DEF_BAND_HI[i];
+  }
+  band_n_d = -1;
+  band_fs_d = 0;
+  band_win_d = DEF_WINDOW;
+  band_mode_d = DEF_SPECTRUM;
+  band_buf_d = (double*)NULL;
+  band_bsize_d = 0;
+
+  lfcc_nfilt_d = DEF_LFCC_NFILT;
+  lfcc_ncep_d = DEF_LFCC_NCEP;
+  lfcc_flo_d = 0;
+  lfcc_fhi_d = 0;
+  lfcc_n_d = -1;
+  lfcc_fs_d = 0;
+  lfcc_buf_d = (double*)NULL;
+  lfcc_bsize_d = 0;
+
+  dlt_win_d = DEF_DELTA_WIN;
+  dlt_ndd_d = -1;
+  dlt_mm_d = false;
+  dlt_mmwin_d = DEF_MINMAX_WIN;
+  dlt_nchan_d = 0;
+  dlt_nstages_d = 0;
+  dlt_cstride_d = 0;
+  dlt_buf_d = (double*)NULL;
+  dlt_bsize_d = 0;
+
+  filt_zphase_d = false;
+  filt_fs_d = -1;
+  filt_nsos_d = 0;
+  filt_nfft_d = 0;
+  filt_buf_d = (double*)NULL;
+  filt_bsize_d = 0;
+  filt_nchan_d = 0;
+  filt_cpad_d = 0;
+  filt_state_d = (double*)NULL;
+  filt_ssize_d = 0;
+  filt_ext_d = (double*)NULL;
+  filt_esize_d = 0;
+
+  rs_ndesigns_d = 0;
+  rs_next_d = 0;
+  for (long i = 0; i < RS_NDESIGNS; i++) {
+    rs_l_d[i] = -1;
+    rs_m_d[i] = -1;
+    rs_tab_d[i] = (double*)NULL;
+  }
+  rs_nchan_d = 0;
+  rs_hist_d = (double*)NULL;
+  rs_hstride_d = 0;
+  rs_hsize_d = 0;
+  rs_ext_d = (double*)NULL;
+  rs_esize_d = 0;
+  rs_read_fs_d = 0;
+
+  spec_mode_d = DEF_SPECTRUM;
+  sdft_resync_d = DEF_SDFT_RESYNC;
+  sdft_n_d = -1;
+  sdft_h_d = -1;
+  sdft_nring_d = 0;
+  sdft_nb_d = 0;
+  sdft_nterm_d = 0;
+  sdft_ngrp_d = 0;
+  sdft_tab_d = (double*)NULL;
+  sdft_tsize_d = 0;
+  sdft_poff_d = 0;
+  sdft_zoff_d = 0;
+  sdft_nslots_d = 0;
+  sdft_sstride_d = 0;
+  sdft_state_d = (double*)NULL;
+  sdft_ssize_d = 0;
+
+  bs_nchan_d = 0;
+  bs_n_d = 0;
+  bs_h_d = 0;
+  bs_mode_d = DEF_SPECTRUM;
+  bs_cap_d = 0;
+  bs_buf_d = (double*)NULL;
+  bs_bsize_d = 0;
+
+  stats_on_d = false;
+
+  mt_nw_d = DEF_MT_NW;
+  mt_k_d = (long)(2 * DEF_MT_NW) - 1;
+  mt_nsets_d = 0;
+  mt_next_d = 0;
+  for (long i = 0; i < MT_NSETS; i++) {
+    mt_sn_d[i] = -1;
+    mt_tab_d[i] = (double*)NULL;
+  }
+  mt_set_d = -1;
+  mt_plan_d = -1;
+  mt_buf_d = (double*)NULL;
+  mt_bsize_d = 0;
 
   // display debugging information
   //
@@ -172,6 +357,7 @@ Edf::Edf(long debug_level_a) {
   //
   fdur_d = DEF_FDUR;
   strcpy(fnmod_d, DEF_FNMOD);
+  nthreads_d = DEF_NTHREADS;
 
   // exit gracefully
   //
@@ -470,6 +656,116 @@ bool Edf::cleanup() {
     fprintf(stdout, "Edf::cleanup(): starting clean up of memory\n");
   }
 
+  // close any open stream and mapped files
+  //
+  Edf::close_stream();
+  Edf::unmap_kaldi();
+  Edf::unmap_raw();
+  Edf::close_shard_writer();
+  Edf::close_shard_reader();
+  Edf::close_feature_writer();
+
+  // release the window table
+  //
+  free(win_tab_d);
+  win_tab_d = (double*)NULL;
+  win_len_d = 0;
+
+  // release the fft plans
+  //
+  for (long i = 0; i < FFT_NPLANS; i++) {
+    free(fft_tab_d[i]);
+    fft_tab_d[i] = (double*)NULL;
+    fft_n_d[i] = -1;
+  }
+  fft_nplans_d = 0;
+  fft_next_d = 0;
+  free(fft_work_d);
+  fft_work_d = (double*)NULL;
+  fft_wsize_d = 0;
+
+  // release the band power scratch buffer
+  //
+  free(band_buf_d);
+  band_buf_d = (double*)NULL;
+  band_bsize_d = 0;
+  band_n_d = -1;
+
+  // release the cepstral tables
+  //
+  free(lfcc_buf_d);
+  lfcc_buf_d = (double*)NULL;
+  lfcc_bsize_d = 0;
+  lfcc_n_d = -1;
+
+  // release the delta streams
+  //
+  Edf::close_delta_stream();
+  free(dlt_buf_d);
+  dlt_buf_d = (double*)NULL;
+  dlt_bsize_d = 0;
+
+  // release the filter buffers
+  //
+  Edf::close_filter_stream();
+  free(filt_buf_d);
+  filt_buf_d = (double*)NULL;
+  filt_bsize_d = 0;
+  free(filt_state_d);
+  filt_state_d = (double*)NULL;
+  filt_ssize_d = 0;
+  free(filt_ext_d);
+  filt_ext_d = (double*)NULL;
+  filt_esize_d = 0;
+  filt_fs_d = -1;
+
+  // release the resampling designs and buffers
+  //
+  Edf::close_resample_stream();
+  for (long i = 0; i < RS_NDESIGNS; i++) {
+    free(rs_tab_d[i]);
+    rs_tab_d[i] = (double*)NULL;
+    rs_l_d[i] = -1;
+    rs_m_d[i] = -1;
+  }
+  rs_ndesigns_d = 0;
+  rs_next_d = 0;
+  free(rs_hist_d);
+  rs_hist_d = (double*)NULL;
+  rs_hsize_d = 0;
+  free(rs_ext_d);
+  rs_ext_d = (double*)NULL;
+  rs_esize_d = 0;
+
+  // release the sliding spectrum tables and the band power stream
+  //
+  Edf::close_band_stream();
+  free(sdft_tab_d);
+  sdft_tab_d = (double*)NULL;
+  sdft_tsize_d = 0;
+  free(sdft_state_d);
+  sdft_state_d = (double*)NULL;
+  sdft_ssize_d = 0;
+  sdft_nslots_d = 0;
+  sdft_n_d = -1;
+  free(bs_buf_d);
+  bs_buf_d = (double*)NULL;
+  bs_bsize_d = 0;
+
+  // release the tapers
+  //
+  for (long i = 0; i < MT_NSETS; i++) {
+    free(mt_tab_d[i]);
+    mt_tab_d[i] = (double*)NULL;
+    mt_sn_d[i] = -1;
+  }
+  mt_nsets_d = 0;
+  mt_next_d = 0;
+  mt_set_d = -1;
+  free(mt_buf_d);
+  mt_buf_d = (double*)NULL;
+  mt_bsize_d = 0;
+
   // clear space for filename storage
   //
   if (debug_level_d >= LEVEL_FULL) {
@@ -560,6 +856,27 @@ bool Edf::cleanup() {
     }
   }
 
+  // clear space for the re-referencing neighbor sets
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::cleanup(): re-referencing labels\n");
+  }
+  cleanup_reference();
+
+  // clear space for the interpolation weight cache
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::cleanup(): interpolation weights\n");
+  }
+
+  for (int i = 0; i < MAX_NWCACHE; i++) {
+    if (wcache_keys_d[i] != (char*)NULL) {
+      delete [] wcache_keys_d[i];
+      wcache_keys_d[i] = (char*)NULL;
+    }
+  }
+  num_wcache_d = 0;
+
   // clear space for selected and montage labels
   //
   if (debug_level_d >= LEVEL_FULL) {
@@ -600,6 +917,36 @@ bool Edf::cleanup(char** strs_a, long num_strs_a) {
   return true;
 }
 
+// method: cleanup_reference
+//
+// arguments: none
+//
+// return: a boolean value indicating status
+//
+// This method deletes memory allocated for the re-referencing
+// neighbor sets. It is also called before a new set is parsed.
+//
+bool Edf::cleanup_reference() {
+
+  // loop over all reference channels
+  //
+  for (long i = 0; i < MAX_NCHANS; i++) {
+    if (ref_chan_labels_d[i] != (char*)NULL) {
+      delete [] ref_chan_labels_d[i];
+      ref_chan_labels_d[i] = (char*)NULL;
+    }
+    if (ref_adj_labels_d[i] != (char**)NULL) {
+      Edf::cleanup(ref_adj_labels_d[i], num_ref_adj_d[i]);
+      delete [] ref_adj_labels_d[i];
+      ref_adj_labels_d[i] = (char**)NULL;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
 // method: cleanup_labels
 //
 // arguments: none
@@ -635,12 +982,17 @@ bool Edf::cleanup_labels() {
       mlabels1_d[i] = (char*)NULL;
       mlabels2_d[i] = (char*)NULL;
     }
+    if (stream_labels_d[i] != (char*)NULL) {
+      delete [] stream_labels_d[i];
+      stream_labels_d[i] = (char*)NULL;
+    }
   }
 
   // reset counters
   //
   num_slabels_d = -1;
   num_mlabels_d = -1;
+  stream_nchan_d = 0;
   
   // display a debug message
   //
@@ -852,6 +1204,26 @@ bool Edf::set_montage_chans(long num_montage_a) {
   }
 }
 
+// method: set_reference_chans
+//
+// arguments:
+//  long num_chans_a: the number of re-referenced channels (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the number of neighbor sets used by the Laplacian
+// reference.
+// 
+bool Edf::set_reference_chans(long num_chans_a) {
+  num_rlabels_d = num_chans_a;
+  if (num_chans_a == 0) {
+    return false;
+  }
+  else {
+    return true;
+  }
+}
+
 // method: parse_aux
 //
 // arguments:
@@ -895,6 +1267,45 @@ bool Edf::parse_aux(char** strm_a, char** stri_a) {
   return status;
 }
 
+// method: parse_reference
+//
+// arguments:
+//  char** strr_a: the re-referencing neighbor sets (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the variables ref_chan_labels_d, ref_adj_labels_d and
+// num_ref_adj_d. The neighbor sets use the same syntax as the
+// interpolation specification:
+//
+//  EEG C3-REF: EEG F3-REF, EEG T3-REF, EEG P3-REF, EEG CZ-REF
+//
+// set_reference_chans() must be called first to set the number of sets.
+//
+bool Edf::parse_reference(char** strr_a) {
+
+  // declare local variables
+  //
+  long num_chans;
+
+  // release any previous neighbor sets
+  //
+  cleanup_reference();
+
+  // parse the neighbor sets
+  //
+  if (!parse_interp_channels(num_chans, ref_adj_labels_d, num_ref_adj_d,
+			     ref_chan_labels_d, strr_a, num_rlabels_d)) {
+    fprintf(stdout,
+	    "Edf::parse_reference(): could not parse re-referencing information\n");
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 //
 // we define non-integral constants in the default constructor
@@ -941,11 +1352,25 @@ const char* Edf::VTYPE_NAME_03("double");
 // constants: EDF header
 //
 const char* Edf::EDF_VERS("0       ");
+const char* Edf::BDF_VERS("\377BIOSEMI");
 const char* Edf::EDF_FTYP("EDF  ");
 
 // constants: Kaldi header
 //
 const char* Edf::KALDI_HEADER_STR("BFM");
+const char* Edf::KALDI_SCP_EXT("scp");
+const char* Edf::KALDI_CM_STR("CM");
+const char* Edf::KALDI_CM2_STR("CM2");
+const char* Edf::KALDI_CM3_STR("CM3");
+
+// constants: raw v2 files
+//
+const char* Edf::RAW2_MAGIC("RAW2");
+
+// constants: training shards
+//
+const char* Edf::SHARD_MAGIC("SHD1");
+const char* Edf::SHARD_EXT("shd");
 
 // constants: debug / verbosity levels
 //
@@ -962,8 +1387,34 @@ const char* Edf::FFMT_NAME_00("edf");
 const char* Edf::FFMT_NAME_01("raw");
 const char* Edf::FFMT_NAME_02("htk");
 const char* Edf::FFMT_NAME_03("kaldi");
+const char* Edf::FFMT_NAME_04("kaldi_cm");
+const char* Edf::FFMT_NAME_05("raw2");
+const char* Edf::FFMT_NAME_06("raw2_f16");
+const char* Edf::FFMT_NAME_07("raw2_bf16");
 const char* Edf::DEF_FFMT_NAME(Edf::FFMT_NAME_00);
 
+// constants: 10-20 electrode positions (BESA spherical angles)
+//
+const char* Edf::ELECTRODE_NAMES[Edf::NUM_ELECTRODES] = {
+  "FP1", "FP2", "F7", "F3", "FZ", "F4", "F8", "T3", "C3", "CZ",
+  "C4", "T4", "T5", "P3", "PZ", "P4", "T6", "O1", "O2", "FPZ",
+  "OZ", "A1", "A2", "T1", "T2", "T7", "T8", "P7", "P8"};
+
+const double Edf::ELECTRODE_THETA[Edf::NUM_ELECTRODES] = {
+  -92, 92, -92, -60, 46, 60, 92, -92, -46, 0,
+  46, 92, -92, -60, 46, 60, 92, -92, 92, 92,
+  92, -120, 120, -106, 106, -92, 92, -92, 92};
+
+const double Edf::ELECTRODE_PHI[Edf::NUM_ELECTRODES] = {
+  -72, 72, -36, -51, 90, 51, 36, 0, 0, 0,
+  0, 0, 36, 51, -90, -51, -36, 72, -72, 90,
+  -90, 0, 0, -18, 18, 0, 0, 36, -36};
+
+// constants: weighted interpolation
+//
+double Edf::SPLINE_LAMBDA = 1e-05;
+double Edf::IDW_POWER = 2.0;
+
 // constants: test signal related
 //
 double Edf::EDF_TST_F1 = 1.0;
@@ -984,6 +1435,16 @@ double Edf::EDF_TST_A7 = 10.0;
 // constants: feature file related
 //
 double Edf::DEF_FDUR = 1.0;
+double Edf::DEF_WDUR = 1.0;
+
+// constants: band power
+//
+double Edf::DEF_BAND_LO[Edf::DEF_NBANDS] = {0.5, 4.0, 8.0, 13.0, 30.0};
+double Edf::DEF_BAND_HI[Edf::DEF_NBANDS] = {4.0, 8.0, 13.0, 30.0, 50.0};
+double Edf::LOG_FLOOR = 1e-10;
+double Edf::DEF_NOTCH_Q = 30.0;
+double Edf::RS_KAISER_BETA = 5.0;
+double Edf::DEF_MT_NW = 3.0;
 
 // HTK constants
 //
@@ -134,25 +134,16 @@ bool Edf::read_edf(VVectorDouble& sig_a, char* fn_a,
 
       // compute scale factors:
       //  the data must be scaled from digital to physical signal levels.
-      //  a dc offset is also computed according to the standard. 
-      //  note that for some data, the max and min values are zero,
-      //  so we must check this. if it is zero, we ignore it by making
-      //  the scale factor 1 and the bias 0;
       //
-      double sum_n = hdr_chan_phys_max_d[j] - hdr_chan_phys_min_d[j];
-      double sum_d = (double)(hdr_chan_dig_max_d[j] - hdr_chan_dig_min_d[j]);
-      double sum = 1.0;
-      double dc = 0;
-      if (sum_d != 0) {
-	sum = sum_n / sum_d;
-	dc = hdr_chan_phys_max_d[j] - sum * (double)hdr_chan_dig_max_d[j];
-      }
+      double sum;
+      double dc;
+      Edf::get_scale(sum, dc, j);
 
       if ((debug_level_d >= LEVEL_FULL) && (i < DEF_DBG_NF) &&
 	  (j < DEF_DBG_NF)) {
 	fprintf(stdout,
-		"Edf::read_edf(): [%ld %ld] dc offset = %f (%f, %f, %f)\n",
-		i, j, dc, sum_n, sum_d, sum);
+		"Edf::read_edf(): [%ld %ld] dc offset = %f (%f)\n",
+		i, j, dc, sum);
       }
 
       // transfer the data to the double precision output
@@ -202,6 +193,51 @@ bool Edf::read_edf(VVectorDouble& sig_a, char* fn_a,
     fprintf(stdout, "Edf::read_edf(): done closing an EDF file\n");
   }
 
+  // resample to the read frequency if one is set
+  //
+  if ((rs_read_fs_d > 0) && (!Edf::resample(sig_a, rs_read_fs_d))) {
+    fprintf(stdout, "**> Edf::read_edf(): error resampling (%s)\n", fn_d);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_scale
+//
+// arguments:
+//  double& scale: the scale factor (output)
+//  double& dc: the dc offset (output)
+//  long chan: the channel number in the header (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the factors that scale a channel from digital to
+// physical signal levels: phys = scale * dig + dc. A dc offset is computed
+// according to the standard. Note that for some data, the max and min
+// values are zero, so we must check this. If it is zero, we ignore it by
+// making the scale factor 1 and the bias 0.
+//
+bool Edf::get_scale(double& scale_a, double& dc_a, long chan_a) {
+
+  // compute the ranges
+  //
+  double sum_n = hdr_chan_phys_max_d[chan_a] - hdr_chan_phys_min_d[chan_a];
+  double sum_d = (double)(hdr_chan_dig_max_d[chan_a] -
+			  hdr_chan_dig_min_d[chan_a]);
+
+  // compute the scale factor and the offset
+  //
+  scale_a = 1.0;
+  dc_a = 0;
+  if (sum_d != 0) {
+    scale_a = sum_n / sum_d;
+    dc_a = hdr_chan_phys_max_d[chan_a] -
+      scale_a * (double)hdr_chan_dig_max_d[chan_a];
+  }
+
   // exit gracefully
   //
   return true;
@@ -370,7 +406,8 @@ bool Edf::write_edf(VVectorDouble& sig_a, char* fn_a) {
 // return: a logical value indicating status
 //
 // This method reads feature data from a file. It branches on the
-// type of the file.
+// type of the file, which is found by sniff from a single read of the
+// start of the file. The file stays open and is passed to the reader.
 //
 // This method is a little fragile since raw and htk files don't really
 // have identifiers. If the exact filename doesn't exist, it must be
@@ -381,7 +418,7 @@ bool Edf::read_features(VVVectorDouble& feat_a, char* fn_a) {
 
   // declare local variables
   //
-  FFMT ffmt;
+  int fd;
   
   // display debugging information
   //
@@ -390,35 +427,33 @@ bool Edf::read_features(VVVectorDouble& feat_a, char* fn_a) {
 	    "Edf::read_features(): begin reading a feature file\n");
   }
 
-  // check the file type using informational methods
+  // check the file type
   //
-  if (is_htk(fn_a)) {
-    ffmt = FFMT_HTK;
-  }
-  else if (is_kaldi(fn_a)) {
-    ffmt = FFMT_KALDI;
+  FTYPE ftype = Edf::sniff(fd, fn_a);
+
+  // check for one of four things: raw, raw v2, kaldi, htk
+  //
+  if (ftype == FTYPE_RAW) {
+    return Edf::read_features_raw(feat_a, fn_a, fd);
   }
-  else if (is_raw(fn_a)) {
-    ffmt = FFMT_RAW;
+  else if (ftype == FTYPE_RAW2) {
+    return Edf::read_features_raw2(feat_a, fn_a, fd);
   }
-  else {
-    fprintf(stdout, "Edf::read_features(): The file type is not supported\n"); 
-    return false;
+  else if (ftype == FTYPE_KALDI) {
+    return Edf::read_features_kaldi(feat_a, fn_a, fd);
   }
 
-  // check for one of three things: raw, htk, kaldi
+  // htk files are read channel by channel from their own names
   //
-  if (ffmt == FFMT_RAW) {
-    return Edf::read_features_raw(feat_a, fn_a);
-  }
-  else if (ffmt == FFMT_HTK) {
+  else if (ftype == FTYPE_HTK) {
+    close(fd);
     return Edf::read_features_htk(feat_a, fn_a);
   }
-  else if (ffmt == FFMT_KALDI) {
-    return Edf::read_features_kaldi(feat_a, fn_a);
-  }
   else {
-    fprintf(stdout, "Edf::read_features(): Error choosing input type\n"); 
+    if (fd >= 0) {
+      close(fd);
+    }
+    fprintf(stdout, "Edf::read_features(): The file type is not supported\n"); 
     return false; 
   }
   
@@ -439,12 +474,14 @@ bool Edf::read_features(VVVectorDouble& feat_a, char* fn_a) {
 // arguments:
 //  VVVectorDouble& feat: feature data (output)
 //  char* fn: input filename (input)
+//  int fd: the file, if already open (input)
 //
 // return: a logical value indicating status
 //
-// This method reads feature data from a raw file.
+// This method reads feature data from a raw file. If fd is not
+// negative, it is read instead of opening fn, and it is closed.
 //
-bool Edf::read_features_raw(VVVectorDouble& feat_a, char* fn_a) {
+bool Edf::read_features_raw(VVVectorDouble& feat_a, char* fn_a, int fd_a) {
 
   // declare local variables
   //
@@ -459,8 +496,22 @@ bool Edf::read_features_raw(VVVectorDouble& feat_a, char* fn_a) {
 
   // open the file
   //
-  FILE* fp = fopen(fn_a, "r");
+  int fd = (fd_a >= 0) ? fd_a : open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  // version 2 files are dense and are read by channel
+  //
+  unsigned char hdr[RAW2_HEADER_SIZE];
+  long n = pread(fd, hdr, RAW2_HEADER_SIZE, 0);
+  if (Edf::is_raw2(hdr, n)) {
+    return Edf::read_features_raw2(feat_a, fn_a, fd);
+  }
+
+  FILE* fp = fdopen(fd, "r");
   if (fp == (FILE*)NULL) {
+    close(fd);
     return false;
   }
 
@@ -562,7 +613,8 @@ bool Edf::read_features_raw(VVVectorDouble& feat_a, char* fn_a) {
 // a single feature vector data structure. In this version, the user
 // provides a list of filenames which are mapped to channel 0, channel 1,
 // ... channel N. Since HTK feature files can only hold one channel of
-// feature data, an EDF file must be split into multiple files.
+// feature data, an EDF file must be split into multiple files. The
+// files are read in parallel (see read_htk_channels).
 //
 bool Edf::read_features_htk(VVVectorDouble& feat_a, char* fn_a) {
 
@@ -573,11 +625,11 @@ bool Edf::read_features_htk(VVVectorDouble& feat_a, char* fn_a) {
 	    "Edf::read_features_htk(): begin reading htk formatted files\n");
   }
 
-  // build the filelist
+  // build the filelist with a single pass over the directory
   //
   long nf;
   char* fnames[MAX_NCHANS];
-  if (Edf::get_matching_filenames(fnames, nf, fn_a, fnmod_d) == false) {
+  if (Edf::list_matching_filenames(fnames, nf, fn_a, fnmod_d) == false) {
     return false;
   }
 
@@ -588,21 +640,11 @@ bool Edf::read_features_htk(VVVectorDouble& feat_a, char* fn_a) {
     }
   }
 
-  // create space for the feature data
+  // read all files in the list in parallel
   //
-  if (feat_a.size() != nf) {
-    Edf::resize(feat_a, nf, false);
-  }
-
-  // loop over all files in the list
-  //
-  for(long i = 0; i < nf; i++){
-    if (read_htk_channel(feat_a[i], fdur_d, fnames[i]) == false) {
-      fprintf(stdout,
-	      "**> Edf::read_features_htk(): error reading channel %ld - [%s]\n",
-	      i, fnames[i]);
-      return false;
-    }
+  if (Edf::read_htk_channels(feat_a, fnames, nf) == false) {
+    Edf::cleanup(fnames, nf);
+    return false;
   }
 
   // clean up memory
@@ -626,28 +668,26 @@ bool Edf::read_features_htk(VVVectorDouble& feat_a, char* fn_a) {
 // arguments:
 //  VVVectorDouble& feat: feature matrix (output)
 //  char* fn: base filename (input)
+//  int fd: the file, if already open (input)
 //
 // return: a logical value indicating status
 //
 // This method reads each channel of a multichannel Kaldi ARK file into
-// a single feature vector structure.
+// a single feature vector structure. The ark is mapped into memory and
+// its headers are walked once (see map_kaldi), so each matrix is
+// converted straight from the mapping without intermediate reads.
+// Compressed matrices are decompressed. If fd is not negative, it is
+// mapped instead of opening fn, and it is closed.
 //
-bool Edf::read_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
-
-  // declare local variables
-  //
-  unsigned char buf[sizeof(float)];
-
-  // check if we need to byte swap
-  //
-  bool big_endian = Edf::is_big_endian();
+bool Edf::read_features_kaldi(VVVectorDouble& feat_a, char* fn_a,
+			      int fd_a) {
 
   // display debugging information
   //
   if (debug_level_d >= LEVEL_DETAILED) {
     fprintf(stdout,
 	    "Edf::read_features_kaldi(): begin reading kaldi formatted file");
-    if (big_endian = false) {
+    if (Edf::is_big_endian() == false) {
       fprintf(stdout, " byte order = little endian\n"); 
     }
     else {
@@ -661,150 +701,27 @@ bool Edf::read_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
   //
   char static_assert_float32[1 - (2 * ((sizeof(float) * CHAR_BIT) != 32))];
 
-  // open the input Kaldi file for reading
-  //
-  FILE* fp = fopen(fn_a, "r");
-  if (fp == (FILE*)NULL) {
-    return false;
-  }
-
-  // get the name from the header and its length
-  //
-  char hname[MAX_MSTR_LENGTH];
-  long hname_length = strlen(hname);
-
-  // get the header size
+  // map the ark and locate all matrices
   //
-  long header_size = KALDI_HEADER_FIXED_SIZE + hname_length;
-  
-  // go to frame size and read it
-  //
-  int32_t frame_size;
-  fseek(fp, hname_length + KALDI_FRAME_FIXED_LOC, SEEK_SET);
-  if (fread(&buf, sizeof(int32_t), 1, fp) != 1) {
-    fclose(fp);
+  if (!Edf::map_kaldi(fn_a, fd_a)) {
     return false;
   }
-  if (big_endian) {
-    Edf::swap_bytes(&frame_size, buf, sizeof(int32_t));
-  }
-  else {
-    memcpy(&frame_size, buf, sizeof(int32_t));
-  }
-
-  // go to vector size and read it
-  //
-  int32_t vec_size;
-  fseek(fp,
-	KALDI_VECTOR_FIXED_LOC - KALDI_FRAME_FIXED_LOC - sizeof(float),
-	SEEK_CUR);
-  if (fread(&buf, sizeof(int32_t), 1, fp) != 1) {
-      fclose(fp);
-      return false;
-    }
-  if (big_endian) {
-    Edf::swap_bytes(&vec_size, buf, sizeof(int32_t));
-  }
-  else {
-    memcpy(&vec_size, buf, sizeof(int32_t));
-  }
-
-  // calculate the difference in ark access indexes
-  //
-  int32_t ark_index_dif = vec_size * frame_size * sizeof(float) + header_size;
-
-  // find the end of file
-  //
-  fseek(fp, 0, SEEK_END);
-  long eof = ftell(fp);
-  
-  // find the number of channels in the file
-  //
-  long num_channels = 0;
-  fseek(fp, 0, SEEK_SET);
-  while (ftell(fp) < eof) {
-    num_channels += 1;
-    fseek(fp, ark_index_dif, SEEK_CUR);
-  }
 
   // initialize the feature matrix:
-  //  resize the matrix so it can fit the information from each channe;
-  //
-  if (feat_a.size() != num_channels) {
-    Edf::resize(feat_a, num_channels, false);
-  }
-  
-  // resize each channel of the matrix so it can fit all of the frames
+  //  resize the matrix so it can fit the information from each channel
   //
-  for (long i = 0; i < num_channels; i++) {
-    if (feat_a[i].size() != frame_size){
-      Edf::resize(feat_a[i], frame_size, false);
-    }
+  long num_channels = Edf::get_kaldi_nmat();
+  Edf::resize(feat_a, num_channels, false);
 
-    // resize each frame of the matrix so it can fit all of the vectors
-    //
-    for (long j = 0; j < frame_size; j++) {
-      if (feat_a[i][j].size() != vec_size) {
-	Edf::resize(feat_a[i][j], vec_size, false);
-      }
-    }
-  }
-  
-  // initialize variables to read features
-  //
-  float sum;
-  float tmp_buf[vec_size];
-  
-  // start reading the features:
-  //  Kaldi ark files are written in little endian format. This loop will loop
-  //  through all of the channels in the file and skip the headers to go right
-  //  to the feature information. Then, it will loop through the frames and
-  //  store each vector a temporary buffer. Perform an endian swap if the
-  //  system is not little endian, and then store the value into the feature
-  //  matrix.
+  // convert each channel
   //
-  fseek(fp, 0, SEEK_SET);
-
   for (long i = 0; i < num_channels; i++) {
-
-    // skip the header for each channel
-    //
-    fseek(fp, header_size, SEEK_CUR);
-
-    // loop over all frames and elements
-    //
-    for (long j = 0; j < frame_size; j++) {
-
-      // read the vector from the file
-      //
-      if (fread(tmp_buf, sizeof(float), vec_size, fp) != vec_size) {
-	fclose(fp);
-	return false;
-      }
-      
-      // convert the vector to a double
-      //
-      for (long k = 0; k < vec_size; k++){
-
-	// byte swap if necessary
-	//
-	if (big_endian) {
-	  Edf::swap_bytes(&sum, &tmp_buf[k], sizeof(float));
-	}
-	else {
-	  sum = tmp_buf[k];
-	}
-
-	// covert to single precision floating point number
-	//
-	feat_a[i][j][k] = sum; 
-      }
-    }
+    Edf::get_kaldi_features(feat_a[i], i);
   }
-  
-  // close the file
+
+  // release the mapping
   //
-  fclose(fp);
+  Edf::unmap_kaldi();
   
   // display debugging information
   //
@@ -833,33 +750,57 @@ bool Edf::read_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
 //
 bool Edf::write_features(VVVectorDouble& feat_a, char* fn_a, FFMT ffmt_a) {
 
+  // declare local variables
+  //
+  bool status = false;
+
   // check for one of three things: htk, raw, or kaldi
   //
   if (ffmt_a == FFMT_HTK) {
-    return Edf::write_features_htk(feat_a, fn_a);
+    status = Edf::write_features_htk(feat_a, fn_a);
   }
 
   // case 2: if it is a kaldi feature file
   //
   else if (ffmt_a == FFMT_KALDI) {
-    return Edf::write_features_kaldi(feat_a, fn_a);
+    status = Edf::write_features_kaldi(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_KALDI_CM) {
+    status = Edf::write_features_kaldi(feat_a, fn_a, true);
   }
   
   // case 3: if it is a raw feature file
   //
   else if (ffmt_a == FFMT_RAW) {
-    return Edf::write_features_raw(feat_a, fn_a);
+    status = Edf::write_features_raw(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_RAW2) {
+    status = Edf::write_features_raw2(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_RAW2_F16) {
+    status = Edf::write_features_raw2(feat_a, fn_a, RDT_FLOAT16);
+  }
+  else if (ffmt_a == FFMT_RAW2_BF16) {
+    status = Edf::write_features_raw2(feat_a, fn_a, RDT_BFLOAT16);
   }
 
   // case 4: unrecognized filetype
   //
   else {
-    fprintf(stdout, "Edf::write_features(): unrecognized filetype\n");
+    fprintf(stdout, "**> Edf::write_features(): unrecognized filetype\n");
+    return false;
+  }
+
+  // add the features to the statistics when they are collected: only
+  // features that were written are counted
+  //
+  if ((status) && (stats_on_d) && (!stats_d.add(feat_a))) {
+    return false;
   }
 
   // exit gracefully
   //
-  return true;
+  return status;
 }
 
 // method: write_features_raw
@@ -989,7 +930,8 @@ bool Edf::write_features_raw(VVVectorDouble& feat_a, char* fn_a) {
 // See write_htk_channel for more information on why the frame duration
 // is needed as an argument.
 // 
-// All data is written in a binary format.
+// All data is written in a binary format. The files are written in
+// parallel (see write_htk_channels).
 //
 bool Edf::write_features_htk(VVVectorDouble& feat_a, char* fn_a) {
 
@@ -1016,15 +958,11 @@ bool Edf::write_features_htk(VVVectorDouble& feat_a, char* fn_a) {
     }
   }
 
-  // loop over all files in the list
+  // write all files in the list in parallel
   //
-  for(long i = 0; i < nf; i++){
-    if (write_htk_channel(feat_a[i], fdur_d, fnames[i]) == false) {
-      fprintf(stdout,
-	      "**> Edf::write_features_htk(): error writing channel %ld - [%s]\n",
-	      i, fnames[i]);
-      return false;
-    }
+  if (Edf::write_htk_channels(feat_a, fnames, nf) == false) {
+    Edf::cleanup(fnames, nf);
+    return false;
   }
 
   // clean up memory
@@ -1048,13 +986,17 @@ bool Edf::write_features_htk(VVVectorDouble& feat_a, char* fn_a) {
 // arguments:
 //  VVVectorDouble& feat: feature matrix (input)
 //  char* fn: output filename (input)
+//  bool compress: if true, write compressed matrices (input)
 //
 // return: a logical value indicating status
 //
 // This method writes each channel of a multichannel EDF signal into
-// one file in a Kaldi ARK format.
+// one file in a Kaldi ARK format. If compress is true, each channel is
+// written in Kaldi's compressed matrix format (see write_kaldi_cm),
+// which is about a quarter of the size.
 //
-bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
+bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a,
+			       bool compress_a) {
   
   // declare local variables
   //
@@ -1090,6 +1032,21 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
     return false;
   }
 
+  // open the companion scp file:
+  //  each line maps a key to the location of its matrix in the ark
+  //  ("key ark:offset"), which allows a single channel to be loaded
+  //  without scanning the ark.
+  //
+  char scp_name[strlen(fn_a) + strlen(KALDI_SCP_EXT) + 2];
+  Edf::create_kaldi_scp_name(scp_name, fn_a);
+  FILE* fp_scp = fopen(scp_name, "w");
+  if (fp_scp == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::write_features_kaldi(): error opening (%s)\n",
+	    scp_name);
+    fclose(fp);
+    return false;
+  }
+
   // get the basename of the input edf file from the header
   //
   long nc = feat_a.size();
@@ -1121,6 +1078,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
 	      vec_size * sizeof(float),
 	      (long)pow(2, sizeof(int16_t) * CHAR_BIT - 1));
       fclose(fp);
+      fclose(fp_scp);
       return false;
     }
 
@@ -1134,8 +1092,35 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
 		"feature vectors must have the same size",
 		(long)feat_a[i][j].size(), vec_size);
 	fclose(fp);
+	fclose(fp_scp);
+	return false;
+      }
+    }
+
+    // write the scp entry:
+    //  the offset points just past the key, at the binary marker
+    //
+    if (fprintf(fp_scp, "%s %s:%ld\n", oname_no_ext, fn_a,
+		ftell(fp) + (long)strlen(oname_no_ext) + 1) < 0) {
+      fprintf(stdout, "**> Edf::write_features_kaldi(): error writing (%s)\n",
+	      scp_name);
+      fclose(fp);
+      fclose(fp_scp);
+      return false;
+    }
+
+    // write a compressed matrix
+    //
+    if (compress_a) {
+      if ((fprintf(fp, "%s ", oname_no_ext) < 0) ||
+	  (!Edf::write_kaldi_cm(fp, feat_a[i]))) {
+	fprintf(stdout, "**> Edf::write_features_kaldi(): error writing (%s)\n",
+		fn_a);
+	fclose(fp);
+	fclose(fp_scp);
 	return false;
       }
+      continue;
     }
 
     // get the basename of the input edf file, and then write the header
@@ -1146,6 +1131,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
 	      "**> Edf::write_features_kaldi():",
 	      "error writing to header");
       fclose(fp);
+      fclose(fp_scp);
       return false;
     }
     
@@ -1159,6 +1145,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
     }
     if (fwrite(&buf, sizeof(int32_t), 1, fp) != 1){
       fclose(fp);
+      fclose(fp_scp);
       return false;
     }
 
@@ -1171,6 +1158,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
 	      "error writing second formatted string",
 	      fn_a);
       fclose(fp);
+      fclose(fp_scp);
       return false;
     }
 
@@ -1184,6 +1172,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
     }
     if (fwrite(&buf, sizeof(int32_t), 1, fp) != 1) {
       fclose(fp);
+      fclose(fp_scp);
       return false;
     }
     
@@ -1228,6 +1217,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
       //
       if (fwrite(tmp_buf, sizeof(float), vec_size, fp) != vec_size) {
 	fclose(fp);
+	fclose(fp_scp);
 	return false;
       }
     }
@@ -1236,6 +1226,7 @@ bool Edf::write_features_kaldi(VVVectorDouble& feat_a, char* fn_a) {
   // close the file
   //
   fclose(fp);
+  fclose(fp_scp);
 
   // display debugging information
   //
@@ -1307,52 +1298,22 @@ bool Edf::is_edf(const char* fn_a) {
 // return: a boolean value that is true if the file contains filenames
 //
 // This method attempts to determine if a file is a filelist or
-// a binary file. It uses a heuristic check of the byte sequences.
-//
-// Note that this method is extremely funky in the way it checks
-// the type of file. Since HTK multichannel files use a basename,
-// the file does not technically exist. Therefore, if an open
-// of fname_a fails, it might possibly be an HTK file.
+// a binary file. It uses a heuristic check of the byte sequences
+// (see sniff).
 //
 bool Edf::is_filelist(char* fname_a) {
 
-  // declare local variables
-  //
-  bool status = true;
-
-  // declare a buffer to be used to scan for an unprintable character
-  //
-  char buf[FLIST_BSIZE];
-  
-  // open the file
-  //
-  FILE* fp = fopen(fname_a, "r");
-  if (fp == (FILE*)NULL) {
-    return false;
-  }
-
-  // read a fixed number of bytes
+  // sniff the file
   //
-  long nbytes = fread(buf, 1, FLIST_BSIZE, fp);
-
-  // search for non-ASCII characters
-  //
-  long i = 0;
-  while (i < nbytes) {
-    if ((!isspace(buf[i])) && (!isprint(buf[i]))) {
-      status = false;
-      break;
-    }
-    i++;
+  int fd;
+  FTYPE ftype = Edf::sniff(fd, fname_a);
+  if (fd >= 0) {
+    close(fd);
   }
 
-  // close the file
-  //
-  fclose(fp);
-  
   // exit gracefully
   //
-  return status;
+  return (ftype == FTYPE_FILELIST);
 }
 
 // method: is_raw
@@ -1362,64 +1323,23 @@ bool Edf::is_filelist(char* fname_a) {
 //
 // return: a boolean value that is true if the file is a raw file
 //
-// This method looks for specific header information, such as number
-// of channels. It is not very robust and is very heuristic.
+// This method checks whether a file is a raw file of either version
+// (see sniff). Version 1 files have no identifier, so the check is
+// very heuristic.
 //
 bool Edf::is_raw(char* fname_a) {
 
-  // declare local variables
-  //
-  bool status = false;
-  unsigned char buf[FLIST_BSIZE];
-
-  // open the file
-  //
-  FILE* fp = fopen(fname_a, "r");
-  if (fp == (FILE*)NULL) {
-    return false;
-  }
-
-  // read a block and look for non-ASCII characters
+  // sniff the file
   //
-  long nbytes = fread(buf, sizeof(unsigned char), FLIST_BSIZE, fp);
-  if (nbytes <= 0) {
-    fclose(fp);
-    return false;
-  }
-  long n = 0;
-  long non_ascii = false;
-  while (n < nbytes) {
-    if ((!isspace(buf[n])) && (!isprint(buf[n]))) {
-      non_ascii = true;
-      break;
-    }
-    n++;
-  }
-  if (non_ascii == false) {
-    fclose(fp);
-    return false;
+  int fd;
+  FTYPE ftype = Edf::sniff(fd, fname_a);
+  if (fd >= 0) {
+    close(fd);
   }
 
-  // read and check the dimensions
-  //
-  int32_t dims[2];
-  rewind(fp);
-  if (fread(dims, sizeof(int32_t), 2, fp) != 2) {
-    fclose(fp);
-    return false;
-  }
-  if ((dims[0] < 0) || (dims[1] < 0)) {
-    fclose(fp);
-    return false;
-  }
-
-  // close the file
-  //
-  fclose(fp);
-
   // exit gracefully
   //
-  return true;
+  return ((ftype == FTYPE_RAW) || (ftype == FTYPE_RAW2));
 }
 
 // method: is_htk
@@ -1429,139 +1349,23 @@ bool Edf::is_raw(char* fname_a) {
 //
 // return: a boolean value that is true if the file is an htk file
 //
-// This method looks for specific header information, such as the htk code.
+// This method checks the header of the first channel of a
+// multichannel htk file, which is named using the filename modifier
+// (see sniff).
 //
 bool Edf::is_htk(char* fname_a) {
 
-  // declare local variables
+  // sniff the file
   //
-  double fdur;
-  bool status = false;
-  unsigned char buf[4];
-
-  // build the modified filename
-  //
-  char* onames[1];
-  Edf::create_filelist(onames, 1, fname_a, fnmod_d);
-
-  // check if we need to byte swap
-  //
-  bool big_endian = Edf::is_big_endian();
-
-  // display debugging information
-  //
-  if (debug_level_d >= LEVEL_DETAILED) {
-    fprintf(stdout, " Edf::is_htk(): beginning check [%s] ", fname_a);
-    if (big_endian == false) {
-      fprintf(stdout, " byte order = little endian\n");
-    }
-    else {
-      fprintf(stdout, " byte order = big endian\n");
-    }
-  }
-
-  // check the size of a float:
-  //  a float must be 32 bits long for this code to work properly. so we
-  //  check this and make the program crash if this isn't the case.
-  //
-  char static_assert_float32[1 - (2 * ((sizeof(float) * CHAR_BIT) != 32))];
-
-  // open the file for reading
-  //
-  FILE* fp = fopen(onames[0], "r");
-  if (fp == (FILE*)NULL) {
-    return false;
-  }
-
-  // read the number of frames
-  //
-  int32_t num_frames;
-
-  if (fread(&buf, sizeof(int32_t), 1, fp) != 1) {
-    fclose(fp);
-    return false;
-  }
-  if (!big_endian) {
-    Edf::swap_bytes(&num_frames, buf, sizeof(int32_t));
-  }
-  else {
-    memcpy(&num_frames, buf, sizeof(int32_t));
-  }
-
-  // read the frame duration in 100 mic-sec units
-  //
-  int32_t ifdur;
-  if (fread(&buf, sizeof(int32_t), 1, fp) != 1) {
-    fclose(fp);
-    return false;
-  }
-  if (!big_endian) {
-    Edf::swap_bytes(&ifdur, buf, sizeof(int32_t));
-  }
-  else {
-    memcpy(&ifdur, buf, sizeof(int32_t));
-  }
-  fdur = ifdur * HTK_FDUR_SCALE;
-
-  // read the sample size: how many bytes in an entire frame
-  //
-  int16_t sample_size;
-  if (fread(&buf, sizeof(int16_t), 1, fp) != 1) {
-    fclose(fp);
-    return false;
-  }
-  if (!big_endian) {
-    Edf::swap_bytes(&sample_size, buf, sizeof(int16_t));
-  }
-  else {
-    memcpy(&sample_size, buf, sizeof(int16_t));
-  }
-  long vec_size = sample_size / sizeof(float);
-
-  // read the HTK code
-  //
-  int16_t htk_code;
-  if (fread(&buf, sizeof(int16_t), 1, fp) != 1) {
-    fclose(fp);
-    return false;
-  }
-  if (!big_endian) {
-    Edf::swap_bytes(&htk_code, buf, sizeof(int16_t));
-  }
-  else {
-    memcpy(&htk_code, buf, sizeof(int16_t));
+  int fd;
+  FTYPE ftype = Edf::sniff(fd, fname_a);
+  if (fd >= 0) {
+    close(fd);
   }
 
-  // check the htk code to determine if this is an htk file
-  //
-  if ((htk_code == 9) && (num_frames > 0) && (vec_size > 0) &&
-      (fdur > 0) && (sample_size > 0)) {
-    status = true;
-  }
-  else {
-    status = false;
-  }
-
-  // close the file
-  //
-  fclose(fp);
-
-  // display debugging information
-  //
-  if (debug_level_d >= LEVEL_DETAILED) {
-    fprintf(stdout, "%s %s (%ld %ld %f %ld %ld)\n",
-	    "  Edf::htk_read_channel():",
-	    "(nf, fdim, fdur, ssize, htk_code)",
-	    (long)num_frames, vec_size, fdur, (long)sample_size, (long)htk_code);
-  }
-  
-  // clean up memory
-  //
-  delete [] onames[0];
-
   // exit gracefully
   //
-  return status;
+  return (ftype == FTYPE_HTK);
 }
 
 // method: is_kaldi
@@ -1571,120 +1375,177 @@ bool Edf::is_htk(char* fname_a) {
 //
 // return: a boolean value that is true if the file is a kaldi file
 //
-// This method looks for header information at kaldi-specific byte locations.
+// This method checks that the file starts with a key followed by the
+// header of a float or compressed matrix (see sniff).
 //
 bool Edf::is_kaldi(char *fname_a) {
 
-  // declare local variables
-  //
-  unsigned char buf[sizeof(float)];
-  bool status = false;
-
-  // check if we need to byte swap
-  //
-  bool big_endian = Edf::is_big_endian();
-
-  // display debugging information
+  // sniff the file
   //
-  if (debug_level_d >= LEVEL_DETAILED) {
-    fprintf(stdout, " Edf::is_kaldi(): beginning check [%s] ", fname_a);
-    if (big_endian == false) {
-      fprintf(stdout, " byte order = little endian\n");
-    }
-    else {
-      fprintf(stdout, " byte order = big endian\n");
-    }
+  int fd;
+  FTYPE ftype = Edf::sniff(fd, fname_a);
+  if (fd >= 0) {
+    close(fd);
   }
 
-  // open the file for reading
+  // exit gracefully
   //
-  FILE* fp = fopen(fname_a, "r");
-  if (fp == (FILE*)NULL) {
-    return false;
-  }
+  return (ftype == FTYPE_KALDI);
+}
 
-  // get size of header
-  //
-  char hname[MAX_MSTR_LENGTH];
+// method: sniff
+//
+// arguments:
+//  int& fd: the open file, or -1 (output)
+//  char* fname: the filename to be checked (input)
+//
+// return: the type of the file
+//
+// This method opens a file and decides its type from a single read of
+// its first SNIFF_BSIZE bytes. The checks are made in this order:
+//
+//  EDF:      the EDF version field
+//  BDF:      the BDF version field
+//  raw v2:   the RAW2_MAGIC string
+//  Kaldi:    a key followed by a float or compressed matrix header
+//  filelist: printable characters only
+//  raw:      two non-negative dimensions
+//
+// If fname cannot be opened, the first channel of a multichannel HTK
+// file (fname with the filename modifier) is opened instead and its
+// header is checked.
+//
+// The file is left open and returned in fd, positioned at its start,
+// so that it can be passed to a reader. The caller must close it. fd
+// is -1 if the type is FTYPE_UNKNOWN.
+//
+Edf::FTYPE Edf::sniff(int& fd_a, char* fname_a) {
 
-  // check the size of a float:
-  //  a float most be 32 bits long for this code to work properly. So we
-  //  check this and make the program crash if this isn't the case.
+  // declare local variables
   //
-  char static_assert_float32[1 - (2 * ((sizeof(float) * CHAR_BIT) != 32))];
+  unsigned char buf[SNIFF_BSIZE];
+  FTYPE ftype = FTYPE_UNKNOWN;
+  long n = 0;
 
-  // get the size of the name from the header
+  // open the file and read its prefix
   //
-  long hname_size = strlen(hname);
+  fd_a = open(fname_a, O_RDONLY);
+  if (fd_a >= 0) {
+    n = pread(fd_a, buf, SNIFF_BSIZE, 0);
+    if (n <= 0) {
+      close(fd_a);
+      fd_a = -1;
+      return FTYPE_UNKNOWN;
+    }
+  }
 
-  // go to end of name in header
+  // a missing file may be the base name of a multichannel htk file
   //
-  fseek(fp, hname_size, SEEK_SET);
+  else if (rindex(fname_a, DOT[0]) != (char*)NULL) {
+    char* onames[1];
+    Edf::create_filelist(onames, 1, fname_a, fnmod_d);
+    fd_a = open(onames[0], O_RDONLY);
+    delete [] onames[0];
+    if (fd_a < 0) {
+      return FTYPE_UNKNOWN;
+    }
 
-  // go to BFM string and read it
-  //
-  char bfm_str[MAX_SSTR_LENGTH];
-  fseek(fp, 1, SEEK_CUR);
-  if (fread(&bfm_str, strlen(KALDI_HEADER_STR), 1, fp) != 1) {
-    fclose(fp);
-    return false;
-  }
-  
-  // go to frame size and read it
-  //
-  int32_t frame_size;
-  fseek(fp, KALDI_FRAME_FIXED_LOC + hname_size, SEEK_SET);
-  if (fread(&buf, sizeof(int32_t), 1, fp) != 1) {
-      fclose(fp);
-      return false;
+    // check the header: four big endian fields
+    //
+    unsigned char hdr[HTK_HEADER_SIZE];
+    int32_t ival[2];
+    int16_t sval[2];
+    if (pread(fd_a, hdr, HTK_HEADER_SIZE, 0) == HTK_HEADER_SIZE) {
+      memcpy(ival, hdr, sizeof(ival));
+      memcpy(sval, hdr + sizeof(ival), sizeof(sval));
+      if (!Edf::is_big_endian()) {
+	ival[0] = __builtin_bswap32(ival[0]);
+	ival[1] = __builtin_bswap32(ival[1]);
+	sval[0] = __builtin_bswap16(sval[0]);
+	sval[1] = __builtin_bswap16(sval[1]);
+      }
+      if ((sval[1] == HTK_PARMKIND_USER) && (ival[0] > 0) &&
+	  (ival[1] > 0) && (sval[0] >= (long)sizeof(float))) {
+	ftype = FTYPE_HTK;
+      }
+    }
+    if (ftype != FTYPE_HTK) {
+      close(fd_a);
+      fd_a = -1;
     }
-  if (big_endian) {
-    Edf::swap_bytes(&frame_size, buf, sizeof(int32_t));
   }
   else {
-    memcpy(&frame_size, buf, sizeof(int32_t));
+    return FTYPE_UNKNOWN;
   }
 
-  // go to vector size and read it
+  // check the signatures of the prefix, if one was read
   //
-  int32_t vec_size;
-  fseek(fp,
-	KALDI_VECTOR_FIXED_LOC - KALDI_FRAME_FIXED_LOC - sizeof(float),
-	SEEK_CUR);
-  if (fread(&buf, sizeof(int32_t), 1, fp) != 1) {
-    fclose(fp);
-    return false;
+  if (n == 0) {
+    return ftype;
   }
-  if (big_endian) {
-    Edf::swap_bytes(&vec_size, buf, sizeof(int32_t));
+
+  if ((n >= EDF_VERS_BSIZE) &&
+      (memcmp(buf, EDF_VERS, EDF_VERS_BSIZE) == 0)) {
+    ftype = FTYPE_EDF;
   }
-  else {
-    memcpy(&vec_size, buf, sizeof(int32_t));
+  else if ((n >= EDF_VERS_BSIZE) &&
+	   (memcmp(buf, BDF_VERS, EDF_VERS_BSIZE) == 0)) {
+    ftype = FTYPE_BDF;
   }
-
-  // check the values read from the file to see if it is a kaldi ark file
-  //
-  if ((frame_size > 0) && (vec_size > 0) &&
-      !strcmp(bfm_str, KALDI_HEADER_STR)) {
-    status = true;
+  else if (Edf::is_raw2(buf, n)) {
+    ftype = FTYPE_RAW2;
   }
+  else {
 
-  // close the file
-  //
-  fclose(fp);
+    // kaldi: the key ends at the first space
+    //
+    unsigned char* sp = (unsigned char*)memchr(buf, SPACE[0], n);
+    if ((sp != (unsigned char*)NULL) && (sp > buf)) {
+      long type, rows, cols, hsize, dsize;
+      float vmin, range;
+      if (Edf::parse_kaldi_header(type, rows, cols, vmin, range, hsize,
+				  dsize, sp + 1, n - (sp + 1 - buf))) {
+	ftype = FTYPE_KALDI;
+      }
+    }
+
+    // filelists are printable, raw files start with their dimensions
+    //
+    if (ftype == FTYPE_UNKNOWN) {
+      long i = 0;
+      while ((i < n) && (isspace(buf[i]) || isprint(buf[i]))) {
+	i++;
+      }
+      if (i == n) {
+	ftype = FTYPE_FILELIST;
+      }
+      else if (n >= (long)(2 * sizeof(int32_t))) {
+	int32_t dims[2];
+	memcpy(dims, buf, sizeof(dims));
+	if ((dims[0] >= 0) && (dims[1] >= 0)) {
+	  ftype = FTYPE_RAW;
+	}
+      }
+    }
+  }
 
   // display debugging information
   //
   if (debug_level_d >= LEVEL_DETAILED) {
-    fprintf(stdout, "%s %s (%s %ld %ld)\n",
-	    "  Edf::is_kaldi():",
-	    "(modified file name from header, frame size, vector size)",
-	    hname, (long)frame_size, (long)vec_size);
+    fprintf(stdout, "Edf::sniff(): file type %ld [%s]\n",
+	    (long)ftype, fname_a);
+  }
+
+  // close the file if it was not recognized
+  //
+  if ((ftype == FTYPE_UNKNOWN) && (fd_a >= 0)) {
+    close(fd_a);
+    fd_a = -1;
   }
 
   // exit gracefully
   //
-  return status;
+  return ftype;
 }
 
 // method: debug
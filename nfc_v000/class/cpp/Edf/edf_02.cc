@@ -1396,7 +1396,22 @@ bool Edf::interpolate(VVectorDouble& sigo_a,
     }
   }
     
-  // case 2: unknown
+  // case 2: weighted interpolation (inverse distance or spherical spline)
+  //
+  else if ((mode_a == INTMODE_IDW) || (mode_a == INTMODE_SPLINE)) {
+
+    // display debug information
+    //
+    if (debug_level_d >= Edf::LEVEL_DETAILED) {
+      fprintf(stdout, " Edf::interpolate(): weighted mode (%lu)\n",
+	      (long)mode_a);
+    }
+    if (!(status = interpolate_weighted(new_channels, sigo_a, mode_a))) {
+      return status;
+    }
+  }
+
+  // case 3: unknown
   //
   else {
     fprintf(stdout,
@@ -1565,6 +1565,33 @@ bool Edf:: parse_interp_channels(long& nl_i, char*** labels1_a,
 				 VectorLong& num_chans_a,
 				 char** nchans_a, char** str_a){
 
+  // parse the number of interpolated channels
+  //
+  return Edf::parse_interp_channels(nl_i, labels1_a, num_chans_a,
+				    nchans_a, str_a, num_clabels_d);
+}
+
+// method: parse_interp_channels
+//
+// arguments:
+//  long& nl_i: the number of labels (output)
+//  char*** labels1_a: an array of an array of strings containing the adjacent
+//                     channels (output)
+//  VectorLong& num_chans_a: the number of adjacent channels (output)
+//  char** nchans_a: contains the channel that we want to interpolate (output)
+//  char* str_a: a string containing the label list (input)
+//  long nc_a: the number of strings to parse (input)
+//
+// return: a boolean indicating status
+//
+// This method parses nc_a lines in the adjacency format described above.
+// It is shared by interpolation and re-referencing, which both describe
+// a channel in terms of its neighbors.
+//
+bool Edf:: parse_interp_channels(long& nl_i, char*** labels1_a,
+				 VectorLong& num_chans_a,
+				 char** nchans_a, char** str_a, long nc_a){
+
   if (debug_level_d >= LEVEL_FULL) {
     fprintf(stdout,
 	    "Edf::parse_interp_channels(): entering parse_interp_channels\n");
@@ -1575,11 +1602,11 @@ bool Edf:: parse_interp_channels(long& nl_i, char*** labels1_a,
   char* tmp_nlabels[MAX_NCHANS];
   char* tmp_adlabels[MAX_NCHANS];  
   
-  Edf::resize(num_chans_a, num_clabels_d);
+  Edf::resize(num_chans_a, nc_a);
 
   // loops over the whole array
   //
-  for (long i = 0; i < num_clabels_d; i++) {
+  for (long i = 0; i < nc_a; i++) {
 
    // initialzes the local variables
    //
@@ -1648,7 +1675,7 @@ bool Edf:: parse_interp_channels(long& nl_i, char*** labels1_a,
 
   // assign output variable related to the number of new channels
   //
-  nl_i = num_clabels_d;
+  nl_i = nc_a;
 
   // display debug information
   //
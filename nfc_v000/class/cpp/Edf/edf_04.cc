@@ -215,5 +215,182 @@ bool Edf::shift(VectorDouble& v_a, long incr_a) {
   return true;
 }
 
+// method: multiply
+//
+// arguments:
+//  VVectorDouble& out: the product (output)
+//  MatrixDouble& w: a weight matrix (input)
+//  VVectorDouble& in: a multichannel signal (input)
+//  VectorLong& pos: the channel of the signal used for each column
+//                   of the weight matrix (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the matrix-signal product:
+//
+//  out[i][t] = sum_k w(i, k) * in[pos[k]][t]
+//
+// The product is blocked over time in tiles of MAT_TILE_SIZE samples so
+// the input channels of a tile are reused from cache for every output
+// row. The inner loop runs over contiguous samples and vectorizes.
+//
+bool Edf::multiply(VVectorDouble& out_a, MatrixDouble& w_a,
+		   VVectorDouble& in_a, VectorLong& pos_a) {
+
+  // declare local variables
+  //
+  long nr = w_a.size1();
+  long nc = w_a.size2();
+
+  // check the arguments
+  //
+  if ((nc <= 0) || ((long)pos_a.size() != nc)) {
+    fprintf(stdout, "**> Edf::multiply(): dimension mismatch\n");
+    return false;
+  }
+  long nsamp = in_a[pos_a[0]].size();
+  for (long k = 1; k < nc; k++) {
+    if ((long)in_a[pos_a[k]].size() != nsamp) {
+      fprintf(stdout, "**> Edf::multiply(): channels differ in length\n");
+      return false;
+    }
+  }
+
+  // create output space
+  //
+  Edf::resize(out_a, nr, false);
+  for (long i = 0; i < nr; i++) {
+    Edf::resize(out_a[i], nsamp, false);
+  }
+
+  // loop over all tiles
+  //
+  for (long t0 = 0; t0 < nsamp; t0 += MAT_TILE_SIZE) {
+
+    // compute the tile length
+    //
+    long nt = nsamp - t0;
+    if (nt > MAT_TILE_SIZE) {
+      nt = MAT_TILE_SIZE;
+    }
+
+    // accumulate each output row
+    //
+    for (long i = 0; i < nr; i++) {
+      double* y = &out_a[i][t0];
+      for (long t = 0; t < nt; t++) {
+	y[t] = 0;
+      }
+      for (long k = 0; k < nc; k++) {
+	double wik = w_a(i, k);
+	if (wik == 0) {
+	  continue;
+	}
+	const double* x = &in_a[pos_a[k]][t0];
+	for (long t = 0; t < nt; t++) {
+	  y[t] += wik * x[t];
+	}
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: solve
+//
+// arguments:
+//  MatrixDouble& x: the solution (output)
+//  MatrixDouble& a: a square matrix (input)
+//  MatrixDouble& b: the right-hand side (input)
+//
+// return: a logical value indicating status
+//
+// This method solves a * x = b by Gauss-Jordan elimination with partial
+// pivoting. It is intended for the small systems that arise when
+// computing interpolation weights. false is returned if the matrix
+// is singular.
+//
+bool Edf::solve(MatrixDouble& x_a, MatrixDouble& a_a, MatrixDouble& b_a) {
+
+  // declare local variables
+  //
+  long n = a_a.size1();
+  long m = b_a.size2();
+
+  // check the arguments
+  //
+  if (((long)a_a.size2() != n) || ((long)b_a.size1() != n)) {
+    fprintf(stdout, "**> Edf::solve(): dimension mismatch\n");
+    return false;
+  }
+
+  // work on copies of the matrices
+  //
+  MatrixDouble a(a_a);
+  Edf::resize(x_a, n, m, false);
+  x_a = b_a;
+
+  // loop over all columns
+  //
+  for (long j = 0; j < n; j++) {
+
+    // find the pivot
+    //
+    long piv = j;
+    for (long i = j + 1; i < n; i++) {
+      if (fabs(a(i, j)) > fabs(a(piv, j))) {
+	piv = i;
+      }
+    }
+    if (a(piv, j) == 0) {
+      fprintf(stdout, "**> Edf::solve(): singular matrix\n");
+      return false;
+    }
+
+    // swap rows
+    //
+    if (piv != j) {
+      for (long k = 0; k < n; k++) {
+	double tmp = a(j, k); a(j, k) = a(piv, k); a(piv, k) = tmp;
+      }
+      for (long k = 0; k < m; k++) {
+	double tmp = x_a(j, k); x_a(j, k) = x_a(piv, k); x_a(piv, k) = tmp;
+      }
+    }
+
+    // normalize the pivot row
+    //
+    double scale = 1.0 / a(j, j);
+    for (long k = 0; k < n; k++) {
+      a(j, k) *= scale;
+    }
+    for (long k = 0; k < m; k++) {
+      x_a(j, k) *= scale;
+    }
+
+    // eliminate the column from all other rows
+    //
+    for (long i = 0; i < n; i++) {
+      double f = a(i, j);
+      if ((i == j) || (f == 0)) {
+	continue;
+      }
+      for (long k = 0; k < n; k++) {
+	a(i, k) -= f * a(j, k);
+      }
+      for (long k = 0; k < m; k++) {
+	x_a(i, k) -= f * x_a(j, k);
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
 //
 // end of file
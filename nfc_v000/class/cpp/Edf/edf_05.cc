@@ -141,5 +141,446 @@ bool Edf::interpolate_average(VVectorDouble& new_chano_a,
   return status;
 }
 
+// method: interpolate_weighted
+//
+// arguments:
+//  VVectorDouble& new_chano: interpolated channels (output)
+//  VVectorDouble& sigi: original signal in which the interpolated 
+//                       channels will be added (input)
+//  INTERPOLATE_MODE mode: INTMODE_IDW or INTMODE_SPLINE (input)
+//  
+// return: a boolean value indicating status
+//
+// This method interpolates the new channels as a weighted sum of the
+// available channels. The available set is the union of the adjacent
+// channels listed for all new channels. For inverse distance weighting,
+// each new channel only uses its own adjacent channels. For spherical
+// splines, every available channel contributes.
+//
+// The weight matrix depends only on the channel labels, so it is
+// computed once per signature and cached. The signature holds the mode
+// and each new channel with its own adjacent channels (e.g.,
+// "0:X=P,Q:Y=R"), which also determine the available set. Applying it
+// is a single blocked matrix-signal product.
+//
+bool Edf::interpolate_weighted(VVectorDouble& new_chano_a,
+			       VVectorDouble& sigi_a,
+			       INTERPOLATE_MODE mode_a) {
+
+  // display a debug message
+  //
+  if (debug_level_d >= Edf::LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::interpolate_weighted(): beginning weighted interpolation\n");
+  }
+
+  // look up the weights of this configuration
+  //
+  char* alabels[MAX_NCHANS];
+  long na = 0;
+  long ind = -1;
+  if (!Edf::find_interp_weights(ind, na, alabels, mode_a)) {
+    return false;
+  }
+
+  // locate the available channels in the signal
+  //
+  VectorLong pos(na);
+  for (long i = 0; i < na; i++) {
+    if ((pos[i] = Edf::find_match(alabels[i], hdr_ghdi_nsig_rec_d,
+				  hdr_chan_labels_d, smmode_d)) < 0) {
+      fprintf(stdout,
+	      "**> Edf::interpolate_weighted(): no match for [%s]\n",
+	      alabels[i]);
+      return false;
+    }
+  }
+
+  // apply the weights
+  //
+  if (!Edf::multiply(new_chano_a, wcache_d[ind], sigi_a, pos)) {
+    return false;
+  }
+
+  // display a debug message
+  //
+  if (debug_level_d >= Edf::LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::interpolate_weighted(): done weighted interpolation\n");
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: find_interp_weights
+//
+// arguments:
+//  long& ind: the index of the weights in the cache (output)
+//  long& na: the number of available channels (output)
+//  char** alabels: the labels of the available channels (output)
+//  INTERPOLATE_MODE mode: INTMODE_IDW or INTMODE_SPLINE (input)
+//
+// return: a boolean value indicating status
+//
+// This method returns the weights of the new channels, computing them
+// if they are not in the cache: wcache_d[ind] is an nm x na matrix
+// whose columns are the available channels.
+//
+bool Edf::find_interp_weights(long& ind_a, long& na_a, char** alabels_a,
+			      INTERPOLATE_MODE mode_a) {
+
+  // collect the available channels (without duplicates)
+  //
+  na_a = 0;
+  for (long i = 0; i < num_clabels_d; i++) {
+    for (long j = 0; j < num_adj_chan_d[i]; j++) {
+      if (Edf::find_match(adj_chan_labels_d[i][j], na_a, alabels_a,
+			  MATMODE_EXACT) < 0) {
+	alabels_a[na_a++] = adj_chan_labels_d[i][j];
+      }
+    }
+  }
+
+  if ((num_clabels_d <= 0) || (na_a == 0)) {
+    fprintf(stdout,
+	    "**> Edf::find_interp_weights(): no channels to interpolate\n");
+    return false;
+  }
+
+  // build the signature of this configuration
+  //
+  long len = 2 * MAX_SSTR_LENGTH;
+  for (long i = 0; i < num_clabels_d; i++) {
+    len += strlen(new_chan_labels_d[i]) + 2;
+    for (long j = 0; j < num_adj_chan_d[i]; j++) {
+      len += strlen(adj_chan_labels_d[i][j]) + 1;
+    }
+  }
+
+  char* key = new char[len];
+  sprintf(key, "%ld", (long)mode_a);
+  for (long i = 0; i < num_clabels_d; i++) {
+    strcat(key, COLON);
+    strcat(key, new_chan_labels_d[i]);
+    strcat(key, VALUE_DELIMITER);
+    for (long j = 0; j < num_adj_chan_d[i]; j++) {
+      if (j > 0) {
+	strcat(key, COMMA);
+      }
+      strcat(key, adj_chan_labels_d[i][j]);
+    }
+  }
+
+  // look up the weights in the cache
+  //
+  long nc = Edf::min(num_wcache_d, MAX_NWCACHE);
+  ind_a = Edf::find_match(key, nc, wcache_keys_d, MATMODE_EXACT);
+
+  // compute the weights if they aren't cached:
+  //  the oldest entry is replaced when the cache is full
+  //
+  if (ind_a < 0) {
+    ind_a = num_wcache_d % MAX_NWCACHE;
+    if (!Edf::compute_interp_weights(wcache_d[ind_a], mode_a,
+				     num_clabels_d, new_chan_labels_d,
+				     na_a, alabels_a)) {
+      delete [] key;
+      return false;
+    }
+    if (wcache_keys_d[ind_a] != (char*)NULL) {
+      delete [] wcache_keys_d[ind_a];
+    }
+    wcache_keys_d[ind_a] = key;
+    num_wcache_d++;
+
+    if (debug_level_d >= Edf::LEVEL_FULL) {
+      fprintf(stdout,
+	      "Edf::find_interp_weights(): computed weights (%ld x %ld)\n",
+	      num_clabels_d, na_a);
+    }
+  }
+  else {
+    delete [] key;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_interp_weights
+//
+// arguments:
+//  MatrixDouble& w: the weight matrix (nm x na) (output)
+//  INTERPOLATE_MODE mode: INTMODE_IDW or INTMODE_SPLINE (input)
+//  long nm: the number of missing channels (input)
+//  char** mlabels: the labels of the missing channels (input)
+//  long na: the number of available channels (input)
+//  char** alabels: the labels of the available channels (input)
+//
+// return: a boolean value indicating status
+//
+// This method computes interpolation weights from 10-20 electrode
+// positions on a unit sphere.
+//
+// For inverse distance weighting, the weight of each adjacent channel
+// is proportional to 1 / d^IDW_POWER, where d is the chord distance.
+//
+// For spherical splines (Perrin et al., 1989), the weights solve
+//
+//  [G + lambda I  1] [c ]   [v]
+//  [1'            0] [c0] = [0]
+//
+// where G(i, j) = g(cos(angle(i, j))) and
+//
+//  g(x) = 1 / (4 pi) sum_n (2n + 1) / (n (n + 1))^m P_n(x)
+//
+// so the interpolated value is [g(e), 1] * inv(A) * [v; 0].
+//
+bool Edf::compute_interp_weights(MatrixDouble& w_a, INTERPOLATE_MODE mode_a,
+				 long nm_a, char** mlabels_a,
+				 long na_a, char** alabels_a) {
+
+  // locate all electrodes
+  //
+  double mpos[nm_a][3];
+  double apos[na_a][3];
+
+  for (long i = 0; i < nm_a; i++) {
+    if (!Edf::get_electrode_pos(mpos[i], mlabels_a[i])) {
+      fprintf(stdout,
+	      "**> Edf::compute_interp_weights(): unknown electrode [%s]\n",
+	      mlabels_a[i]);
+      return false;
+    }
+  }
+  for (long i = 0; i < na_a; i++) {
+    if (!Edf::get_electrode_pos(apos[i], alabels_a[i])) {
+      fprintf(stdout,
+	      "**> Edf::compute_interp_weights(): unknown electrode [%s]\n",
+	      alabels_a[i]);
+      return false;
+    }
+  }
+
+  // create output space
+  //
+  Edf::resize(w_a, nm_a, na_a, false);
+
+  // case 1: inverse distance weighting
+  //
+  if (mode_a == INTMODE_IDW) {
+
+    for (long i = 0; i < nm_a; i++) {
+
+      // weight the adjacent channels of this channel
+      //
+      double sum = 0;
+      bool exact = false;
+
+      for (long k = 0; k < na_a; k++) {
+	w_a(i, k) = 0;
+
+	// only the adjacent channels of channel i contribute
+	//
+	if (Edf::find_match(alabels_a[k], num_adj_chan_d[i],
+			    adj_chan_labels_d[i], MATMODE_EXACT) < 0) {
+	  continue;
+	}
+
+	double dx = mpos[i][0] - apos[k][0];
+	double dy = mpos[i][1] - apos[k][1];
+	double dz = mpos[i][2] - apos[k][2];
+	double d = sqrt(dx * dx + dy * dy + dz * dz);
+
+	// a coincident electrode takes all the weight
+	//
+	if (d < 1e-06) {
+	  for (long j = 0; j < na_a; j++) {
+	    w_a(i, j) = 0;
+	  }
+	  w_a(i, k) = 1.0;
+	  sum = 1.0;
+	  exact = true;
+	  break;
+	}
+	w_a(i, k) = 1.0 / pow(d, IDW_POWER);
+	sum += w_a(i, k);
+      }
+
+      // normalize the weights
+      //
+      if (!exact) {
+	for (long k = 0; k < na_a; k++) {
+	  w_a(i, k) /= sum;
+	}
+      }
+    }
+  }
+
+  // case 2: spherical splines
+  //
+  else if (mode_a == INTMODE_SPLINE) {
+
+    // precompute the Legendre series coefficients
+    //
+    double coef[SPLINE_NTERMS + 1];
+    coef[0] = 0;
+    for (long n = 1; n <= SPLINE_NTERMS; n++) {
+      coef[n] = (2.0 * n + 1.0) /
+	(pow((double)n * (double)(n + 1), (double)SPLINE_ORDER) * 4.0 * M_PI);
+    }
+
+    // build the system matrix
+    //
+    long n = na_a + 1;
+    MatrixDouble a(n, n);
+    MatrixDouble b(n, na_a);
+    MatrixDouble x;
+
+    for (long i = 0; i < na_a; i++) {
+      for (long j = 0; j < na_a; j++) {
+	double c = apos[i][0] * apos[j][0] + apos[i][1] * apos[j][1] +
+	  apos[i][2] * apos[j][2];
+	a(i, j) = Edf::legendre_sum(c, coef, SPLINE_NTERMS);
+	b(i, j) = (i == j) ? 1.0 : 0.0;
+      }
+      a(i, i) += SPLINE_LAMBDA;
+      a(i, na_a) = 1.0;
+      a(na_a, i) = 1.0;
+      b(na_a, i) = 0;
+    }
+    a(na_a, na_a) = 0;
+
+    // x holds the first na columns of the inverse
+    //
+    if (!Edf::solve(x, a, b)) {
+      fprintf(stdout,
+	      "**> Edf::compute_interp_weights(): singular spline system\n");
+      return false;
+    }
+
+    // project each missing channel
+    //
+    for (long i = 0; i < nm_a; i++) {
+      double g[n];
+      for (long k = 0; k < na_a; k++) {
+	double c = mpos[i][0] * apos[k][0] + mpos[i][1] * apos[k][1] +
+	  mpos[i][2] * apos[k][2];
+	g[k] = Edf::legendre_sum(c, coef, SPLINE_NTERMS);
+      }
+      g[na_a] = 1.0;
+
+      for (long k = 0; k < na_a; k++) {
+	double sum = 0;
+	for (long j = 0; j < n; j++) {
+	  sum += g[j] * x(j, k);
+	}
+	w_a(i, k) = sum;
+      }
+    }
+  }
+
+  // case 3: unknown
+  //
+  else {
+    fprintf(stdout,
+	    "**> Edf::compute_interp_weights(): unknown mode (%ld)\n",
+	    (long)mode_a);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: legendre_sum
+//
+// arguments:
+//  double x: the argument (input)
+//  double* coef: series coefficients (input)
+//  long nterms: the number of terms (input)
+//
+// return: the value of sum_n coef[n] * P_n(x) for n = 0 ... nterms
+//
+// This method evaluates a Legendre series using the three-term
+// recurrence (n + 1) P_n+1(x) = (2n + 1) x P_n(x) - n P_n-1(x).
+//
+double Edf::legendre_sum(double x_a, double* coef_a, long nterms_a) {
+
+  // clip the argument to the valid range
+  //
+  x_a = Edf::clip(x_a, -1.0, 1.0);
+
+  // loop over all terms
+  //
+  double p0 = 1.0;
+  double p1 = x_a;
+  double sum = coef_a[0] * p0;
+  if (nterms_a > 0) {
+    sum += coef_a[1] * p1;
+  }
+  for (long n = 1; n < nterms_a; n++) {
+    double p2 = ((2.0 * n + 1.0) * x_a * p1 - (double)n * p0) /
+      (double)(n + 1);
+    sum += coef_a[n + 1] * p2;
+    p0 = p1;
+    p1 = p2;
+  }
+
+  // exit gracefully
+  //
+  return sum;
+}
+
+// method: get_electrode_pos
+//
+// arguments:
+//  double* xyz: the electrode position on a unit sphere (output)
+//  char* label: a channel label (input)
+//
+// return: a boolean value indicating status
+//
+// This method locates an electrode from a channel label such as
+// "EEG FP1-REF": the electrode name is the text following the last
+// space, up to the first dash.
+//
+bool Edf::get_electrode_pos(double* xyz_a, char* label_a) {
+
+  // isolate the electrode name
+  //
+  char* ptr = strrchr(label_a, SPACE[0]);
+  ptr = (ptr == (char*)NULL) ? label_a : ptr + 1;
+
+  char name[MAX_SSTR_LENGTH + 1];
+  long len = 0;
+  while ((ptr[len] != (char)NULL) && (ptr[len] != DASHDASH[0]) &&
+	 (len < (long)MAX_SSTR_LENGTH)) {
+    name[len] = toupper(ptr[len]);
+    len++;
+  }
+  name[len] = (char)NULL;
+
+  // look up the electrode
+  //
+  for (long i = 0; i < NUM_ELECTRODES; i++) {
+    if (strcmp(name, ELECTRODE_NAMES[i]) == 0) {
+      double theta = ELECTRODE_THETA[i] * M_PI / 180.0;
+      double phi = ELECTRODE_PHI[i] * M_PI / 180.0;
+      xyz_a[0] = sin(theta) * cos(phi);
+      xyz_a[1] = sin(theta) * sin(phi);
+      xyz_a[2] = cos(theta);
+      return true;
+    }
+  }
+
+  // exit ungracefully
+  //
+  return false;
+}
+
 //
 // end of file
@@ -0,0 +1,809 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_06.cc
+//
+// This file contains methods associated with the class Edf that
+// re-reference a signal: the common average reference (CAR), the
+// surface Laplacian, and montages computed while a file is decoded.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+// method: rereference
+//
+// arguments:
+//  VVectorDouble& sigo: re-referenced signal (output)
+//  VVectorDouble& sigi: input signal (input)
+//  REFERENCE_MODE mode: the type of reference (input)
+//  MATCH_MODE matmode: the match mode used to locate neighbors (input)
+//
+// return: a logical value indicating status
+//
+// This method re-references a signal in one pass. The signal is
+// processed in tiles of REF_TILE_SIZE samples. For each tile, the
+// reference (the mean of all channels for CAR, or the mean of the
+// neighbors for the Laplacian) is accumulated channel by channel and
+// subtracted while the tile is still in cache, so no intermediate copy
+// of the signal is made.
+//
+// For CAR, every channel with the same number of samples as channel 0
+// contributes to the average. Other channels (e.g., channels sampled at a
+// different rate) are copied unchanged. sigo and sigi can be the same
+// object.
+//
+// For the Laplacian, the output contains one channel per neighbor set
+// (see parse_reference), computed as the center channel minus the
+// mean of its neighbors. The header labels are updated in the same way
+// as apply_montage. sigo and sigi must be different objects.
+//
+bool Edf::rereference(VVectorDouble& sigo_a, VVectorDouble& sigi_a,
+		      REFERENCE_MODE mode_a, MATCH_MODE match_mode_a) {
+
+  // declare local variables
+  //
+  long nchan = sigi_a.size();
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::rereference(): beginning rereference (%ld)\n",
+	    (long)mode_a);
+  }
+
+  // check the arguments
+  //
+  if (nchan <= 0) {
+    fprintf(stdout, "**> Edf::rereference(): empty signal\n");
+    return false;
+  }
+
+  // case 1: no reference - copy the signal
+  //
+  if (mode_a == REFMODE_NONE) {
+    if (&sigo_a != &sigi_a) {
+      return Edf::copy_signal(sigo_a, sigi_a);
+    }
+    return true;
+  }
+
+  // case 2: common average reference
+  //
+  else if (mode_a == REFMODE_CAR) {
+
+    // find the channels that contribute to the average
+    //
+    long nsamp = sigi_a[0].size();
+    long pos[nchan];
+    long np = 0;
+
+    for (long i = 0; i < nchan; i++) {
+      if ((long)sigi_a[i].size() == nsamp) {
+	pos[np++] = i;
+      }
+      else if (debug_level_d >= LEVEL_FULL) {
+	fprintf(stdout,
+		"Edf::rereference(): channel %ld excluded from the average\n",
+		i);
+      }
+    }
+
+    // create output space:
+    //  channels that are not part of the average are copied
+    //
+    if (&sigo_a != &sigi_a) {
+      Edf::resize(sigo_a, nchan, false);
+      for (long i = 0; i < nchan; i++) {
+	Edf::resize(sigo_a[i], sigi_a[i].size(), false);
+	if ((long)sigi_a[i].size() != nsamp) {
+	  sigo_a[i] = sigi_a[i];
+	}
+      }
+    }
+
+    // loop over all tiles
+    //
+    double scale = 1.0 / (double)np;
+    double mean[REF_TILE_SIZE];
+
+    for (long t0 = 0; t0 < nsamp; t0 += REF_TILE_SIZE) {
+
+      // compute the tile length
+      //
+      long nt = nsamp - t0;
+      if (nt > REF_TILE_SIZE) {
+	nt = REF_TILE_SIZE;
+      }
+
+      // accumulate the channel mean for this tile
+      //
+      for (long t = 0; t < nt; t++) {
+	mean[t] = 0;
+      }
+      for (long i = 0; i < np; i++) {
+	const double* x = &sigi_a[pos[i]][t0];
+	for (long t = 0; t < nt; t++) {
+	  mean[t] += x[t];
+	}
+      }
+      for (long t = 0; t < nt; t++) {
+	mean[t] *= scale;
+      }
+
+      // subtract the mean while the tile is still in cache
+      //
+      for (long i = 0; i < np; i++) {
+	const double* x = &sigi_a[pos[i]][t0];
+	double* y = &sigo_a[pos[i]][t0];
+	for (long t = 0; t < nt; t++) {
+	  y[t] = x[t] - mean[t];
+	}
+      }
+    }
+  }
+
+  // case 3: Laplacian reference
+  //
+  else if (mode_a == REFMODE_LAPLACIAN) {
+
+    // check the arguments
+    //
+    if (&sigo_a == &sigi_a) {
+      fprintf(stdout,
+	      "**> Edf::rereference(): the Laplacian can't be done in place\n");
+      return false;
+    }
+    if (num_rlabels_d <= 0) {
+      fprintf(stdout,
+	      "**> Edf::rereference(): no neighbor sets have been defined\n");
+      return false;
+    }
+
+    // locate the center channels and their neighbors once:
+    //  a missing center produces a zero channel and a missing neighbor
+    //  is dropped from the average, in both cases with a warning.
+    //
+    long cpos[num_rlabels_d];
+    VVectorLong npos(num_rlabels_d);
+    VectorDouble weight(num_rlabels_d);
+
+    for (long i = 0; i < num_rlabels_d; i++) {
+
+      // find the center channel
+      //
+      if ((cpos[i] = Edf::find_match(ref_chan_labels_d[i],
+				     hdr_ghdi_nsig_rec_d, hdr_chan_labels_d,
+				     match_mode_a)) < 0) {
+	fprintf(stdout, "**> Edf::rereference(): no match for [%s]\n",
+		ref_chan_labels_d[i]);
+      }
+
+      // find the neighbors
+      //
+      long nn = 0;
+      Edf::resize(npos[i], num_ref_adj_d[i], false);
+
+      for (long j = 0; j < num_ref_adj_d[i]; j++) {
+	long pos = Edf::find_match(ref_adj_labels_d[i][j],
+				   hdr_ghdi_nsig_rec_d, hdr_chan_labels_d,
+				   match_mode_a);
+	if (pos < 0) {
+	  fprintf(stdout, "**> Edf::rereference(): no match for [%s]\n",
+		  ref_adj_labels_d[i][j]);
+	}
+	else if ((cpos[i] >= 0) &&
+		 (sigi_a[pos].size() != sigi_a[cpos[i]].size())) {
+	  fprintf(stdout,
+		  "**> Edf::rereference(): [%s] and [%s] differ in length\n",
+		  ref_adj_labels_d[i][j], ref_chan_labels_d[i]);
+	  return false;
+	}
+	else {
+	  npos[i][nn++] = pos;
+	}
+      }
+      Edf::resize(npos[i], nn, true);
+
+      // each neighbor has an equal weight
+      //
+      weight[i] = (nn > 0) ? 1.0 / (double)nn : 0.0;
+    }
+
+    // create output space
+    //
+    Edf::resize(sigo_a, num_rlabels_d, false);
+    for (long i = 0; i < num_rlabels_d; i++) {
+      long nsamp = (cpos[i] >= 0) ? sigi_a[cpos[i]].size() : sigi_a[0].size();
+      Edf::resize(sigo_a[i], nsamp, false);
+    }
+
+    // loop over all tiles:
+    //  each output tile is initialized from the center channel and the
+    //  weighted neighbors are subtracted from it
+    //
+    long nsamp_max = 0;
+    for (long i = 0; i < num_rlabels_d; i++) {
+      if ((long)sigo_a[i].size() > nsamp_max) {
+	nsamp_max = sigo_a[i].size();
+      }
+    }
+
+    for (long t0 = 0; t0 < nsamp_max; t0 += REF_TILE_SIZE) {
+      for (long i = 0; i < num_rlabels_d; i++) {
+
+	// compute the tile length for this channel
+	//
+	long nt = (long)sigo_a[i].size() - t0;
+	if (nt <= 0) {
+	  continue;
+	}
+	if (nt > REF_TILE_SIZE) {
+	  nt = REF_TILE_SIZE;
+	}
+	double* y = &sigo_a[i][t0];
+
+	// a missing center produces zeroes
+	//
+	if (cpos[i] < 0) {
+	  for (long t = 0; t < nt; t++) {
+	    y[t] = 0;
+	  }
+	  continue;
+	}
+
+	// copy the center channel
+	//
+	const double* x = &sigi_a[cpos[i]][t0];
+	for (long t = 0; t < nt; t++) {
+	  y[t] = x[t];
+	}
+
+	// subtract the weighted neighbors
+	//
+	double w = weight[i];
+	for (long j = 0; j < (long)npos[i].size(); j++) {
+	  const double* xn = &sigi_a[npos[i][j]][t0];
+	  for (long t = 0; t < nt; t++) {
+	    y[t] -= w * xn[t];
+	  }
+	}
+      }
+    }
+
+    // adjust the header:
+    //  the labels and record sizes now follow the center channels
+    //
+    long rec_size[num_rlabels_d];
+    for (long i = 0; i < num_rlabels_d; i++) {
+      rec_size[i] = (cpos[i] >= 0) ?
+	hdr_chan_rec_size_d[cpos[i]] : hdr_chan_rec_size_d[0];
+    }
+
+    for (long i = 0; i < num_rlabels_d; i++) {
+      Edf::resize(hdr_chan_labels_d[i], strlen(ref_chan_labels_d[i]) + 1);
+      strcpy(hdr_chan_labels_d[i], ref_chan_labels_d[i]);
+      hdr_chan_rec_size_d[i] = rec_size[i];
+    }
+
+    // update the number of channels and the header size
+    //
+    hdr_ghdi_nsig_rec_d = num_rlabels_d;
+    hdr_ghdi_hsize_d = compute_header_size(hdr_ghdi_nsig_rec_d);
+  }
+
+  // case 4: unknown
+  //
+  else {
+    fprintf(stdout, "**> Edf::rereference(): unknown mode (%ld)\n",
+	    (long)mode_a);
+    return false;
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::rereference(): done with rereference\n");
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_edf_montage
+//
+// arguments:
+//  VVectorDouble& sig: the montage signal (output)
+//  char* fn: input filename (input)
+//  char** mselect: the montage specification (input)
+//  MATCH_MODE matmode: the match mode used to locate operands (input)
+//
+// return: a logical value indicating status
+//
+// This method reads an EDF file and computes the montage while the data
+// is being decoded. It is equivalent to read_edf followed by select and
+// apply_montage, but the referential channels are never converted to
+// double precision: each record is read with one call and the montage
+// channels are computed directly from the raw samples (see
+// decode_montage). The montage must have been parsed with parse_aux.
+//
+// The header is updated as it would be by apply_montage, and the
+// per-channel record sizes and ranges follow the first operand.
+//
+bool Edf::read_edf_montage(VVectorDouble& sig_a, char* fn_a,
+			   char** mstr_a, MATCH_MODE match_mode_a) {
+
+  // copy the filename
+  //
+  Edf::resize(fn_d, strlen(fn_a) + 1);
+  strcpy(fn_d, fn_a);
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::read_edf_montage(): opening an EDF file (%s)\n",
+	    fn_a);
+  }
+
+  // open the file and load the header
+  //
+  if ((fp_d = fopen(fn_a, "r")) == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::read_edf_montage(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+  if (!Edf::get_header(fp_d)) {
+    fprintf(stdout,
+	    "**> Edf::read_edf_montage(): error in get_header (%s)\n", fn_a);
+    fclose(fp_d);
+    return false;
+  }
+
+  // save the match mode and build the decode plan
+  //
+  mmmode_d = match_mode_a;
+  if (!Edf::create_montage_plan(mstr_a, match_mode_a)) {
+    fclose(fp_d);
+    return false;
+  }
+
+  // position the file to the beginning of the data
+  //
+  if (fseek(fp_d, hdr_ghdi_hsize_d, SEEK_SET)) {
+    fclose(fp_d);
+    return false;
+  }
+
+  // create space to hold the montage
+  //
+  Edf::resize(sig_a, num_mplan_d, false);
+  for (long i = 0; i < num_mplan_d; i++) {
+    long pos = (mplan_pos1_d[i] >= 0) ? mplan_pos1_d[i] : 0;
+    Edf::resize(sig_a[i], hdr_ghdi_num_recs_d * hdr_chan_rec_size_d[pos],
+		false);
+  }
+
+  // loop over all records:
+  //  a record is read in one call and decoded directly into the montage
+  //
+  short int* buf = new short int[rec_nsamp_d];
+
+  for (long i = 0; i < hdr_ghdi_num_recs_d; i++) {
+    if ((long)fread(buf, sizeof(short int), rec_nsamp_d, fp_d) !=
+	rec_nsamp_d) {
+      fprintf(stdout,
+	      "**> Edf::read_edf_montage(): error reading record %ld (%s)\n",
+	      i, fn_a);
+      delete [] buf;
+      fclose(fp_d);
+      return false;
+    }
+    Edf::decode_montage(sig_a, buf, i);
+  }
+
+  // clean up memory and close the file
+  //
+  delete [] buf;
+  if (fclose(fp_d) == EOF) {
+    fprintf(stdout, "**> Edf::read_edf_montage(): error closing (%s)\n",
+	    fn_d);
+    return false;
+  }
+  fp_d = (FILE*)NULL;
+
+  // adjust the header:
+  //  the channel ranges and record sizes follow the first operand.
+  //  we save them first because the plan may reorder channels.
+  //
+  double phys_min[num_mplan_d];
+  double phys_max[num_mplan_d];
+  long dig_min[num_mplan_d];
+  long dig_max[num_mplan_d];
+  long rec_size[num_mplan_d];
+
+  for (long i = 0; i < num_mplan_d; i++) {
+    long pos = (mplan_pos1_d[i] >= 0) ? mplan_pos1_d[i] : 0;
+    phys_min[i] = hdr_chan_phys_min_d[pos];
+    phys_max[i] = hdr_chan_phys_max_d[pos];
+    dig_min[i] = hdr_chan_dig_min_d[pos];
+    dig_max[i] = hdr_chan_dig_max_d[pos];
+    rec_size[i] = hdr_chan_rec_size_d[pos];
+  }
+
+  for (long i = 0; i < num_mplan_d; i++) {
+    hdr_chan_phys_min_d[i] = phys_min[i];
+    hdr_chan_phys_max_d[i] = phys_max[i];
+    hdr_chan_dig_min_d[i] = dig_min[i];
+    hdr_chan_dig_max_d[i] = dig_max[i];
+    hdr_chan_rec_size_d[i] = rec_size[i];
+  }
+
+  // write the labels specified by the parameter file
+  //
+  if (strcmp(mstr_a[0], Edf::NULL_NAME) != 0) {
+    for (long i = 0; i < num_mplan_d; i++) {
+      Edf::resize(hdr_chan_labels_d[i], strlen(mchan_d[i]) + 1);
+      strcpy(hdr_chan_labels_d[i], mchan_d[i]);
+    }
+  }
+
+  // update the number of channels and the header size
+  //
+  hdr_ghdi_nsig_rec_d = num_mplan_d;
+  hdr_ghdi_hsize_d = compute_header_size(hdr_ghdi_nsig_rec_d);
+
+  // resample to the read frequency if one is set
+  //
+  if ((rs_read_fs_d > 0) && (!Edf::resample(sig_a, rs_read_fs_d))) {
+    fprintf(stdout, "**> Edf::read_edf_montage(): error resampling (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::read_edf_montage(): done reading (%s)\n", fn_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: apply_montage_features
+//
+// arguments:
+//  VVVectorDouble& feato: montage features (output)
+//  VVVectorDouble& feati: features of the referential channels (input)
+//  char** mselect: the montage specification (input)
+//  MATCH_MODE matmode: the match mode used to locate operands (input)
+//
+// return: a logical value indicating status
+//
+// This method applies a montage to features rather than to the signal.
+// This is only valid for features that are linear in the signal, such
+// as complex spectra stored as interleaved (real, imaginary) pairs: the
+// spectrum of a bipolar channel is then the difference of the spectra
+// of its operands, so the transforms computed for the referential
+// channels can be reused for the montage instead of being recomputed.
+// Quantities such as power or log energy must be computed after the
+// montage is applied.
+//
+// The channels of feati correspond to the channels currently described
+// by the header (e.g., after select). The same sign convention as
+// apply_montage is used. The header is not modified, since the
+// referential features remain valid.
+//
+bool Edf::apply_montage_features(VVVectorDouble& feato_a,
+				 VVVectorDouble& feati_a,
+				 char** mstr_a, MATCH_MODE match_mode_a) {
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::apply_montage_features(): beginning apply_montage_features\n");
+  }
+
+  // check the arguments
+  //
+  if ((long)feati_a.size() != hdr_ghdi_nsig_rec_d) {
+    fprintf(stdout,
+	    "**> Edf::apply_montage_features(): %ld channels in the features"
+	    " but %ld in the header\n",
+	    (long)feati_a.size(), hdr_ghdi_nsig_rec_d);
+    return false;
+  }
+
+  // resolve the montage operands once
+  //
+  mmmode_d = match_mode_a;
+  if (!Edf::create_montage_plan(mstr_a, match_mode_a)) {
+    return false;
+  }
+
+  // create output space
+  //
+  Edf::resize(feato_a, num_mplan_d, false);
+
+  // loop over all montage channels
+  //
+  for (long i = 0; i < num_mplan_d; i++) {
+
+    long pos1 = mplan_pos1_d[i];
+    long pos2 = mplan_pos2_d[i];
+    long ref = (pos1 >= 0) ? pos1 : 0;
+
+    // the operands must have the same shape
+    //
+    long nframes = feati_a[ref].size();
+    if ((pos2 >= 0) && ((long)feati_a[pos2].size() != nframes)) {
+      fprintf(stdout,
+	      "**> Edf::apply_montage_features(): operands of channel %ld"
+	      " differ in the number of frames\n", i);
+      return false;
+    }
+    Edf::resize(feato_a[i], nframes, false);
+
+    // loop over all frames
+    //
+    for (long j = 0; j < nframes; j++) {
+
+      long ndim = feati_a[ref][j].size();
+      Edf::resize(feato_a[i][j], ndim, false);
+      if (ndim == 0) {
+	continue;
+      }
+      double* y = &feato_a[i][j][0];
+
+      // case 1: missing operand - write zeroes
+      //
+      if (pos1 < 0) {
+	for (long k = 0; k < ndim; k++) {
+	  y[k] = 0;
+	}
+      }
+
+      // case 2: no differencing
+      //
+      else if (pos2 < 0) {
+	const double* a = &feati_a[pos1][j][0];
+	for (long k = 0; k < ndim; k++) {
+	  y[k] = a[k];
+	}
+      }
+
+      // case 3: differencing (a complex subtraction for spectra)
+      //
+      else {
+	if ((long)feati_a[pos2][j].size() != ndim) {
+	  fprintf(stdout,
+		  "**> Edf::apply_montage_features(): operands of channel %ld"
+		  " differ in dimension\n", i);
+	  return false;
+	}
+	const double* a = &feati_a[pos1][j][0];
+	const double* b = &feati_a[pos2][j][0];
+	for (long k = 0; k < ndim; k++) {
+	  y[k] = b[k] - a[k];
+	}
+      }
+    }
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::apply_montage_features(): done with apply_montage_features\n");
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: create_montage_plan
+//
+// arguments:
+//  char** mselect: the montage specification (input)
+//  MATCH_MODE matmode: the match mode used to locate operands (input)
+//
+// return: a logical value indicating status
+//
+// This method resolves the montage operands against the channels in the
+// file header and computes everything decode_montage needs: the
+// position of each channel in a record buffer, the operand positions
+// and their scale factors. If the montage is "(null)", every channel in
+// the file is decoded as is.
+//
+bool Edf::create_montage_plan(char** mstr_a, MATCH_MODE match_mode_a) {
+
+  // compute the location of each channel in a record
+  //
+  rec_nsamp_d = 0;
+  for (long i = 0; i < hdr_ghdi_nsig_rec_d; i++) {
+    rec_offset_d[i] = rec_nsamp_d;
+    rec_nsamp_d += hdr_chan_rec_size_d[i];
+  }
+
+  // case 1: no montage - decode every channel
+  //
+  if (strcmp(mstr_a[0], Edf::NULL_NAME) == 0) {
+    num_mplan_d = hdr_ghdi_nsig_rec_d;
+    for (long i = 0; i < num_mplan_d; i++) {
+      mplan_pos1_d[i] = i;
+      mplan_pos2_d[i] = -1;
+    }
+  }
+
+  // case 2: locate the operands of each montage channel
+  //
+  else {
+    num_mplan_d = num_mlabels_d;
+    for (long i = 0; i < num_mplan_d; i++) {
+
+      // find the first operand
+      //
+      if ((mplan_pos1_d[i] = Edf::find_match(mlabels1_d[i],
+					     hdr_ghdi_nsig_rec_d,
+					     hdr_chan_labels_d,
+					     match_mode_a)) < 0) {
+	fprintf(stdout, "**> Edf::create_montage_plan(): no match for [%s]\n",
+		mlabels1_d[i]);
+      }
+
+      // find the second operand
+      //
+      mplan_pos2_d[i] = -1;
+      if (mlabels2_d[i] != (char*)NULL) {
+	if ((mplan_pos2_d[i] = Edf::find_match(mlabels2_d[i],
+					       hdr_ghdi_nsig_rec_d,
+					       hdr_chan_labels_d,
+					       match_mode_a)) < 0) {
+	  fprintf(stdout,
+		  "**> Edf::create_montage_plan(): no match for [%s]\n",
+		  mlabels2_d[i]);
+
+	  // a missing operand produces a channel of zeroes
+	  //
+	  mplan_pos1_d[i] = -1;
+	}
+      }
+
+      // the operands must have the same sample frequency
+      //
+      if ((mplan_pos1_d[i] >= 0) && (mplan_pos2_d[i] >= 0) &&
+	  (hdr_chan_rec_size_d[mplan_pos1_d[i]] !=
+	   hdr_chan_rec_size_d[mplan_pos2_d[i]])) {
+	fprintf(stdout,
+		"**> Edf::create_montage_plan(): [%s] and [%s] differ in"
+		" record size\n", mlabels1_d[i], mlabels2_d[i]);
+	return false;
+      }
+    }
+  }
+
+  // compute the scale factors:
+  //  the integer path is used when both operands share a scale factor,
+  //  in which case the dc offsets reduce to a single bias term.
+  //
+  for (long i = 0; i < num_mplan_d; i++) {
+    mplan_scale1_d[i] = 1.0;
+    mplan_scale2_d[i] = 1.0;
+    mplan_dc1_d[i] = 0;
+    mplan_dc2_d[i] = 0;
+    mplan_int_d[i] = false;
+
+    if (mplan_pos1_d[i] >= 0) {
+      Edf::get_scale(mplan_scale1_d[i], mplan_dc1_d[i], mplan_pos1_d[i]);
+    }
+    if ((mplan_pos1_d[i] >= 0) && (mplan_pos2_d[i] >= 0)) {
+      Edf::get_scale(mplan_scale2_d[i], mplan_dc2_d[i], mplan_pos2_d[i]);
+      mplan_int_d[i] = (mplan_scale1_d[i] == mplan_scale2_d[i]);
+    }
+
+    if (debug_level_d >= LEVEL_FULL) {
+      fprintf(stdout,
+	      "Edf::create_montage_plan(): channel %ld = [%ld, %ld] (%s)\n",
+	      i, mplan_pos1_d[i], mplan_pos2_d[i],
+	      mplan_int_d[i] ? "integer" : "float");
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: decode_montage
+//
+// arguments:
+//  VVectorDouble& sig: the montage signal (output)
+//  short int* buf: one record of raw samples (input)
+//  long rec: the record index (input)
+//
+// return: a logical value indicating status
+//
+// This method converts one raw record into the montage channels
+// described by the decode plan. sig must already be sized. When both
+// operands share a scale factor, the difference is computed on the
+// integer samples and scaled once:
+//
+//  -((s * a + dc1) - (s * b + dc2)) = -s * (a - b) - (dc1 - dc2)
+//
+// Otherwise each operand is scaled separately. Note the montage is
+// negated to account for negative gain, as in apply_montage.
+//
+bool Edf::decode_montage(VVectorDouble& sig_a, short int* buf_a,
+			 long rec_a) {
+
+  // loop over all montage channels
+  //
+  for (long i = 0; i < num_mplan_d; i++) {
+
+    // case 1: missing operand - write zeroes
+    //
+    long pos1 = mplan_pos1_d[i];
+    long pos2 = mplan_pos2_d[i];
+
+    if (pos1 < 0) {
+      long nsamp = hdr_chan_rec_size_d[0];
+      if (nsamp == 0) {
+	continue;
+      }
+      double* y = &sig_a[i][rec_a * nsamp];
+      for (long k = 0; k < nsamp; k++) {
+	y[k] = 0;
+      }
+      continue;
+    }
+
+    long nsamp = hdr_chan_rec_size_d[pos1];
+    if (nsamp == 0) {
+      continue;
+    }
+    double* y = &sig_a[i][rec_a * nsamp];
+    const short int* a = buf_a + rec_offset_d[pos1];
+
+    // case 2: no differencing
+    //
+    if (pos2 < 0) {
+      double scale = mplan_scale1_d[i];
+      double dc = mplan_dc1_d[i];
+      for (long k = 0; k < nsamp; k++) {
+	y[k] = scale * (double)a[k] + dc;
+      }
+    }
+
+    // case 3: differencing in the integer domain
+    //
+    else if (mplan_int_d[i] == true) {
+      const short int* b = buf_a + rec_offset_d[pos2];
+      double scale = -mplan_scale1_d[i];
+      double dc = mplan_dc2_d[i] - mplan_dc1_d[i];
+      for (long k = 0; k < nsamp; k++) {
+	y[k] = scale * (double)((int)a[k] - (int)b[k]) + dc;
+      }
+    }
+
+    // case 4: differencing with separate scale factors
+    //
+    else {
+      const short int* b = buf_a + rec_offset_d[pos2];
+      double scale1 = mplan_scale1_d[i];
+      double scale2 = mplan_scale2_d[i];
+      double dc = mplan_dc2_d[i] - mplan_dc1_d[i];
+      for (long k = 0; k < nsamp; k++) {
+	y[k] = scale2 * (double)b[k] - scale1 * (double)a[k] + dc;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
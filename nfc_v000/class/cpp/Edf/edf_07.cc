@@ -0,0 +1,771 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_07.cc
+//
+// This file contains methods associated with the class Edf that
+// stream a file through channel selection, montage, interpolation and
+// framing one tile of records at a time.
+//
+
+// system include files
+//
+#include <time.h>
+
+// local include files
+//
+#include "Edf.h"
+
+// method: open_stream
+//
+// arguments:
+//  char* fn: input filename (input)
+//  char* cselect: the channel selection ("(null)" for all) (input)
+//  char** mselect: the montage specification (input)
+//  MATCH_MODE matmode: the match mode used to locate channels (input)
+//  INTERPOLATE_MODE intmode: the interpolation mode (input)
+//  INTERPOLATE_OMODE omode: the interpolation output mode (input)
+//
+// return: a logical value indicating status
+//
+// This method opens a file for streaming. It loads the header and
+// composes the channel selection and the montage into a single decode
+// plan so that each record is converted directly into the montage
+// channels. The channels of the current interpolation configuration
+// are then computed from these with the weights of interpolate, so the
+// output is that of read_edf, select, apply_montage and interpolate.
+// No part of the signal is read here.
+//
+// The file is consumed in tiles of records. A tile spans the smallest
+// number of records that holds at least one frame of fdur_d seconds,
+// so memory use depends only on the tile size and not on the length of
+// the recording. The header is left as it is in the file; the names of
+// the output channels are given by get_stream_label.
+//
+// Streams are not resampled: if a read frequency is set (see
+// set_read_frequency), the stream is not opened.
+//
+bool Edf::open_stream(char* fn_a, char* sstr_a, char** mstr_a,
+		      MATCH_MODE match_mode_a, INTERPOLATE_MODE int_mode_a,
+		      INTERPOLATE_OMODE int_omode_a) {
+
+  // close any stream that is still open
+  //
+  if (sfp_d != (FILE*)NULL) {
+    Edf::close_stream();
+  }
+  stream_nchan_d = 0;
+
+  // streams keep the sample frequency of the file
+  //
+  if (rs_read_fs_d > 0) {
+    fprintf(stdout, "**> Edf::open_stream(): %s (%f)\n",
+	    "streams cannot be resampled to a read frequency", rs_read_fs_d);
+    return false;
+  }
+
+  // copy the filename
+  //
+  Edf::resize(fn_d, strlen(fn_a) + 1);
+  strcpy(fn_d, fn_a);
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::open_stream(): opening an EDF file (%s)\n", fn_a);
+  }
+
+  // open the file and load the header
+  //
+  if ((sfp_d = fopen(fn_a, "r")) == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::open_stream(): error opening (%s)\n", fn_a);
+    return false;
+  }
+  if (!Edf::get_header(sfp_d)) {
+    fprintf(stdout, "**> Edf::open_stream(): error in get_header (%s)\n",
+	    fn_a);
+    Edf::close_stream();
+    return false;
+  }
+  if (hdr_ghdi_dur_rec_d <= 0) {
+    fprintf(stdout, "**> Edf::open_stream(): invalid record duration (%s)\n",
+	    fn_a);
+    Edf::close_stream();
+    return false;
+  }
+
+  // build the decode plan and restrict it to the selected channels
+  //
+  smmode_d = match_mode_a;
+  mmmode_d = match_mode_a;
+  bool identity = (strcmp(mstr_a[0], NULL_NAME) == 0);
+  if ((!Edf::create_montage_plan(mstr_a, match_mode_a)) ||
+      (!Edf::select_plan(sstr_a, identity, match_mode_a))) {
+    Edf::close_stream();
+    return false;
+  }
+
+  // name the montage channels and add the interpolated channels
+  //
+  for (long i = 0; i < num_mplan_d; i++) {
+    char* label = (identity) ? hdr_chan_labels_d[mplan_pos1_d[i]] :
+      mchan_d[i];
+    Edf::resize(stream_labels_d[i], strlen(label) + 1, false);
+    strcpy(stream_labels_d[i], label);
+    stream_rsize_d[i] = hdr_chan_rec_size_d[(mplan_pos1_d[i] >= 0) ?
+					    mplan_pos1_d[i] : 0];
+  }
+  if (!Edf::interp_plan(match_mode_a, int_mode_a, int_omode_a)) {
+    Edf::close_stream();
+    return false;
+  }
+
+  // compute the frame length of each output channel and the number of
+  // records needed to hold one frame
+  //
+  stream_nrecs_d = 1;
+  for (long i = 0; i < stream_nchan_d; i++) {
+    long rsize = stream_rsize_d[i];
+    stream_flen_d[i] = (long)round(fdur_d * (double)rsize /
+				   (double)hdr_ghdi_dur_rec_d);
+    if ((rsize <= 0) || (stream_flen_d[i] <= 0)) {
+      fprintf(stdout,
+	      "**> Edf::open_stream(): channel %ld has no samples per frame\n",
+	      i);
+      Edf::close_stream();
+      return false;
+    }
+    long nrecs = (stream_flen_d[i] + rsize - 1) / rsize;
+    if (nrecs > stream_nrecs_d) {
+      stream_nrecs_d = nrecs;
+    }
+  }
+
+  // create space for one tile: the raw records, the decoded channels
+  // and the samples carried between tiles
+  //
+  stream_buf_d = new short int[stream_nrecs_d * rec_nsamp_d];
+
+  Edf::resize(stream_tile_d, num_mplan_d, false);
+  for (long i = 0; i < num_mplan_d; i++) {
+    long rsize = hdr_chan_rec_size_d[(mplan_pos1_d[i] >= 0) ?
+				     mplan_pos1_d[i] : 0];
+    Edf::resize(stream_tile_d[i], stream_nrecs_d * rsize, false);
+  }
+
+  Edf::resize(stream_carry_d, stream_nchan_d, false);
+  for (long i = 0; i < stream_nchan_d; i++) {
+    Edf::resize(stream_carry_d[i],
+		stream_nrecs_d * stream_rsize_d[i] + stream_flen_d[i], false);
+    stream_ncarry_d[i] = 0;
+  }
+
+  // position the file to the beginning of the data
+  //
+  stream_rec_d = 0;
+  if (fseek(sfp_d, hdr_ghdi_hsize_d, SEEK_SET)) {
+    fprintf(stdout, "**> Edf::open_stream(): error seeking (%s)\n", fn_a);
+    Edf::close_stream();
+    return false;
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::open_stream(): %ld channels, %ld records per tile (%s)\n",
+	    stream_nchan_d, stream_nrecs_d, fn_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_stream
+//
+// arguments:
+//  VVVectorDouble& frames: frames of the output channels (output)
+//  long& nframes: the number of frames returned (output)
+//
+// return: a logical value indicating status
+//
+// This method reads the next tile, decodes it into the montage
+// channels, interpolates and cuts it into non-overlapping frames:
+// frames[i][j] is frame j of output channel i. Samples that do not fill
+// a frame are carried into the next call. nframes is zero when the end
+// of the file is reached; a partial frame at the end of the file is
+// discarded. frames is reused across calls, so its storage is only
+// allocated once.
+//
+bool Edf::read_stream(VVVectorDouble& frames_a, long& nframes_a) {
+
+  // check that a stream is open
+  //
+  nframes_a = 0;
+  if (sfp_d == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::read_stream(): no stream is open\n");
+    return false;
+  }
+
+  // read tiles until at least one frame is available
+  //
+  while ((nframes_a == 0) && (stream_rec_d < hdr_ghdi_num_recs_d)) {
+
+    // read the records in one call and decode them
+    //
+    long nrecs = hdr_ghdi_num_recs_d - stream_rec_d;
+    if (nrecs > stream_nrecs_d) {
+      nrecs = stream_nrecs_d;
+    }
+    if ((long)fread(stream_buf_d, sizeof(short int), nrecs * rec_nsamp_d,
+		    sfp_d) != nrecs * rec_nsamp_d) {
+      fprintf(stdout, "**> Edf::read_stream(): error reading record %ld\n",
+	      stream_rec_d);
+      return false;
+    }
+    for (long r = 0; r < nrecs; r++) {
+      Edf::decode_montage(stream_tile_d, stream_buf_d + r * rec_nsamp_d, r);
+    }
+    stream_rec_d += nrecs;
+
+    // interpolate the tile: the weights are a linear map over the
+    // montage channels, so the tile gives the same samples as the
+    // whole signal does
+    //
+    if ((stream_imode_d != INTMODE_NONE) &&
+	(!Edf::multiply(stream_interp_d, stream_w_d, stream_tile_d,
+			stream_wpos_d))) {
+      return false;
+    }
+
+    // the number of frames is limited by the channel with the fewest
+    // complete frames, so that all channels stay aligned in time
+    //
+    nframes_a = -1;
+    for (long i = 0; i < stream_nchan_d; i++) {
+      long nf = (stream_ncarry_d[i] + nrecs * stream_rsize_d[i]) /
+	stream_flen_d[i];
+      if ((nframes_a < 0) || (nf < nframes_a)) {
+	nframes_a = nf;
+      }
+    }
+    if (nframes_a < 0) {
+      nframes_a = 0;
+    }
+
+    // create output space
+    //
+    Edf::resize(frames_a, stream_nchan_d, false);
+
+    // loop over all channels:
+    //  the channel is the concatenation of the carried samples and the
+    //  tile. frames are copied out and the remainder is carried over.
+    //
+    for (long i = 0; i < stream_nchan_d; i++) {
+
+      long row = stream_row_d[i];
+      long flen = stream_flen_d[i];
+      long nc = stream_ncarry_d[i];
+      long nt = nrecs * stream_rsize_d[i];
+      double* c = &stream_carry_d[i][0];
+      const double* t = (row < num_mplan_d) ? &stream_tile_d[row][0] :
+	&stream_interp_d[row - num_mplan_d][0];
+
+      Edf::resize(frames_a[i], nframes_a, false);
+      for (long j = 0; j < nframes_a; j++) {
+	Edf::resize(frames_a[i][j], flen, false);
+	double* y = &frames_a[i][j][0];
+
+	// split the frame at the boundary between the carry and the tile
+	//
+	long start = j * flen;
+	long ksplit = nc - start;
+	if (ksplit < 0) {
+	  ksplit = 0;
+	}
+	else if (ksplit > flen) {
+	  ksplit = flen;
+	}
+	for (long k = 0; k < ksplit; k++) {
+	  y[k] = c[start + k];
+	}
+	const double* ts = t + (start + ksplit - nc);
+	for (long k = ksplit; k < flen; k++) {
+	  y[k] = ts[k - ksplit];
+	}
+      }
+
+      // carry the remaining samples into the next tile
+      //
+      long used = nframes_a * flen;
+      long nrem = nc + nt - used;
+      if (nrem > (long)stream_carry_d[i].size()) {
+	Edf::resize(stream_carry_d[i], nrem, true);
+	c = &stream_carry_d[i][0];
+      }
+      long n = 0;
+      for (long k = used; k < nc; k++) {
+	c[n++] = c[k];
+      }
+      for (long k = (used > nc) ? (used - nc) : 0; k < nt; k++) {
+	c[n++] = t[k];
+      }
+      stream_ncarry_d[i] = nrem;
+    }
+  }
+
+  // make sure the output reflects the end of the file
+  //
+  if (nframes_a == 0) {
+    Edf::resize(frames_a, stream_nchan_d, false);
+    for (long i = 0; i < stream_nchan_d; i++) {
+      Edf::resize(frames_a[i], 0, false);
+    }
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::read_stream(): %ld frames (record %ld of %ld)\n",
+	    nframes_a, stream_rec_d, hdr_ghdi_num_recs_d);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_stream
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method closes the file opened by open_stream and releases the
+// tile buffers. The names of the output channels are kept until the
+// next stream is opened.
+//
+bool Edf::close_stream() {
+
+  // declare local variables
+  //
+  bool status = true;
+
+  // close the file
+  //
+  if (sfp_d != (FILE*)NULL) {
+    if (fclose(sfp_d) == EOF) {
+      fprintf(stdout, "**> Edf::close_stream(): error closing (%s)\n", fn_d);
+      status = false;
+    }
+    sfp_d = (FILE*)NULL;
+  }
+
+  // release the tile buffers
+  //
+  if (stream_buf_d != (short int*)NULL) {
+    delete [] stream_buf_d;
+    stream_buf_d = (short int*)NULL;
+  }
+  stream_tile_d.resize(0);
+  stream_carry_d.resize(0);
+  stream_interp_d.resize(0);
+  stream_rec_d = 0;
+  stream_nrecs_d = 0;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: benchmark_stream
+//
+// arguments:
+//  double& tstaged: the time taken by the staged methods in secs (output)
+//  double& tstream: the time taken by the stream in secs (output)
+//  char* fn: input filename (input)
+//  char* cselect: the channel selection ("(null)" for all) (input)
+//  char** mselect: the montage specification (input)
+//  MATCH_MODE matmode: the match mode used to locate channels (input)
+//  INTERPOLATE_MODE intmode: the interpolation mode (input)
+//  INTERPOLATE_OMODE omode: the interpolation output mode (input)
+//  FILE* fp: the stream to print the results to (input)
+//
+// return: a logical value indicating status
+//
+// This method frames a file with read_edf, select, apply_montage and
+// interpolate, and then with open_stream and read_stream, and prints
+// the times and the largest difference between the frames. Only the
+// calls that produce frames are timed. The header is left as the
+// stream loads it.
+//
+bool Edf::benchmark_stream(double& tstaged_a, double& tstream_a, char* fn_a,
+			   char* sstr_a, char** mstr_a,
+			   MATCH_MODE match_mode_a,
+			   INTERPOLATE_MODE int_mode_a,
+			   INTERPOLATE_OMODE int_omode_a, FILE* fp_a) {
+
+  // declare local variables
+  //
+  VVectorDouble sig;
+  VVectorDouble sig_sel;
+  VVectorDouble sig_mont;
+  VVVectorDouble sframes;
+  VVVectorDouble frames;
+  struct timespec t0;
+  struct timespec t1;
+
+  tstaged_a = 0;
+  tstream_a = 0;
+
+  // frame the file with the staged methods
+  //
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if ((!Edf::read_edf(sig, fn_a)) ||
+      (!Edf::select(sig_sel, sig, sstr_a, match_mode_a)) ||
+      (!Edf::apply_montage(sig_mont, sig_sel, mstr_a, match_mode_a))) {
+    return false;
+  }
+  if ((int_mode_a != INTMODE_NONE) &&
+      (!Edf::interpolate(sig_mont, match_mode_a, int_mode_a, int_omode_a))) {
+    return false;
+  }
+
+  // the montage reorders the channels, so the record size of each
+  // output channel is taken from its length rather than the header
+  //
+  long nchan = sig_mont.size();
+  long nframes = -1;
+  long flen[nchan];
+  for (long i = 0; i < nchan; i++) {
+    long rsize = (hdr_ghdi_num_recs_d > 0) ?
+      (long)sig_mont[i].size() / hdr_ghdi_num_recs_d : 0;
+    flen[i] = (long)round(fdur_d * (double)rsize /
+			  (double)hdr_ghdi_dur_rec_d);
+    if (flen[i] <= 0) {
+      fprintf(stdout,
+	      "**> Edf::benchmark_stream(): channel %ld has no samples"
+	      " per frame\n", i);
+      return false;
+    }
+    long nf = sig_mont[i].size() / flen[i];
+    if ((nframes < 0) || (nf < nframes)) {
+      nframes = nf;
+    }
+  }
+  if (nframes < 0) {
+    nframes = 0;
+  }
+
+  Edf::resize(sframes, nchan, false);
+  for (long i = 0; i < nchan; i++) {
+    Edf::resize(sframes[i], nframes, false);
+    for (long j = 0; j < nframes; j++) {
+      Edf::resize(sframes[i][j], flen[i], false);
+      memcpy(&sframes[i][j][0], &sig_mont[i][j * flen[i]],
+	     flen[i] * sizeof(double));
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  tstaged_a = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+  // release the staged signal before streaming
+  //
+  sig.resize(0);
+  sig_sel.resize(0);
+  sig_mont.resize(0);
+
+  // frame the file with the stream and compare each block of frames
+  //
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (!Edf::open_stream(fn_a, sstr_a, mstr_a, match_mode_a, int_mode_a,
+			int_omode_a)) {
+    return false;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  tstream_a += (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+  if (stream_nchan_d != nchan) {
+    fprintf(stdout, "**> Edf::benchmark_stream(): %s (%ld %ld)\n",
+	    "the number of channels differs", nchan, stream_nchan_d);
+    Edf::close_stream();
+    return false;
+  }
+  for (long i = 0; i < nchan; i++) {
+    if (stream_flen_d[i] != flen[i]) {
+      fprintf(stdout, "**> Edf::benchmark_stream(): %s %ld (%ld %ld)\n",
+	      "the frame length differs for channel", i, flen[i],
+	      stream_flen_d[i]);
+      Edf::close_stream();
+      return false;
+    }
+  }
+
+  double diff = 0;
+  long nout = 0;
+  long nf = 0;
+  bool status = true;
+
+  do {
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    status = Edf::read_stream(frames, nf);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    tstream_a += (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+    for (long i = 0; (status) && (i < nchan); i++) {
+      for (long j = 0; (j < nf) && (nout + j < nframes); j++) {
+	for (long k = 0; k < flen[i]; k++) {
+	  diff = Edf::max(diff, fabs(frames[i][j][k] -
+				     sframes[i][nout + j][k]));
+	}
+      }
+    }
+    nout += nf;
+  } while ((status) && (nf > 0));
+
+  Edf::close_stream();
+  if (!status) {
+    return false;
+  }
+  if (nout != nframes) {
+    fprintf(stdout, "**> Edf::benchmark_stream(): %s (%ld %ld)\n",
+	    "the number of frames differs", nframes, nout);
+    return false;
+  }
+
+  // print the results
+  //
+  fprintf(fp_a, "%10s %10s %14s %14s %8s %10s\n", "nchan", "nframes",
+	  "staged (secs)", "stream (secs)", "speedup", "max diff");
+  fprintf(fp_a, "%10ld %10ld %14.4f %14.4f %8.2f %10.2e\n",
+	  nchan, nframes, tstaged_a, tstream_a,
+	  (tstream_a > 0) ? tstaged_a / tstream_a : 0.0, diff);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: select_plan
+//
+// arguments:
+//  char* cselect: the channel selection ("(null)" for all) (input)
+//  bool identity: true if the plan decodes every channel as is (input)
+//  MATCH_MODE matmode: the match mode used to locate channels (input)
+//
+// return: a logical value indicating status
+//
+// This method restricts a decode plan built by create_montage_plan to
+// a channel selection, which has the same effect as calling select
+// before apply_montage. Without a montage, the plan becomes the
+// selected channels in the order given. With a montage, every operand
+// must be one of the selected channels; a montage channel with an
+// operand that is not selected becomes a channel of zeroes, as it would
+// in apply_montage.
+//
+bool Edf::select_plan(char* sstr_a, bool identity_a,
+		      MATCH_MODE match_mode_a) {
+
+  // mode "(null)": keep the plan
+  //
+  if (strcmp(sstr_a, NULL_NAME) == 0) {
+    return true;
+  }
+
+  // parse the channel selection field
+  //
+  if (!Edf::parse_line(num_slabels_d, slabels_d, sstr_a, (char*)COMMA)) {
+    fprintf(stdout, "**> Edf::select_plan(): error parsing channel tag [%s]\n",
+	    sstr_a);
+    return false;
+  }
+
+  // locate the selected channels in the file
+  //
+  long spos[num_slabels_d];
+  for (long i = 0; i < num_slabels_d; i++) {
+    if ((spos[i] = Edf::find_match(slabels_d[i], hdr_ghdi_nsig_rec_d,
+				   hdr_chan_labels_d, match_mode_a)) < 0) {
+      fprintf(stdout, "**> Edf::select_plan(): no match for [%s]\n",
+	      slabels_d[i]);
+      return false;
+    }
+  }
+
+  // case 1: no montage - decode the selected channels
+  //
+  if (identity_a) {
+    num_mplan_d = num_slabels_d;
+    for (long i = 0; i < num_mplan_d; i++) {
+      mplan_pos1_d[i] = spos[i];
+      mplan_pos2_d[i] = -1;
+      Edf::get_scale(mplan_scale1_d[i], mplan_dc1_d[i], spos[i]);
+      mplan_scale2_d[i] = 1.0;
+      mplan_dc2_d[i] = 0;
+      mplan_int_d[i] = false;
+    }
+  }
+
+  // case 2: drop montage channels whose operands are not selected
+  //
+  else {
+    for (long i = 0; i < num_mplan_d; i++) {
+      bool found1 = (mplan_pos1_d[i] < 0);
+      bool found2 = (mplan_pos2_d[i] < 0);
+      for (long j = 0; j < num_slabels_d; j++) {
+	found1 |= (spos[j] == mplan_pos1_d[i]);
+	found2 |= (spos[j] == mplan_pos2_d[i]);
+      }
+      if ((!found1) || (!found2)) {
+	fprintf(stdout,
+		"**> Edf::select_plan(): channel %ld uses an unselected"
+		" channel\n", i);
+	mplan_pos1_d[i] = -1;
+	mplan_pos2_d[i] = -1;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: interp_plan
+//
+// arguments:
+//  MATCH_MODE matmode: the match mode used to locate channels (input)
+//  INTERPOLATE_MODE intmode: the interpolation mode (input)
+//  INTERPOLATE_OMODE omode: the interpolation output mode (input)
+//
+// return: a logical value indicating status
+//
+// This method lays out the output channels of a stream. The montage
+// channels of the decode plan must be named in stream_labels_d. The new
+// channels of the current interpolation configuration are a weight
+// matrix times the montage channels: an average of the adjacent
+// channels, or the cached weights of interpolate_weighted. As in
+// add_interp_channel, they follow the montage channels or replace them.
+//
+bool Edf::interp_plan(MATCH_MODE match_mode_a, INTERPOLATE_MODE int_mode_a,
+		      INTERPOLATE_OMODE int_omode_a) {
+
+  // no interpolation: the output is the montage
+  //
+  stream_imode_d = int_mode_a;
+  if (int_mode_a == INTMODE_NONE) {
+    stream_nchan_d = num_mplan_d;
+    for (long i = 0; i < stream_nchan_d; i++) {
+      stream_row_d[i] = i;
+    }
+    return true;
+  }
+
+  // check the output mode
+  //
+  long nold = 0;
+  if (int_omode_a == INTOMODE_CONCAT) {
+    nold = num_mplan_d;
+  }
+  else if (int_omode_a != INTOMODE_REPLACE) {
+    fprintf(stdout, "**> Edf::interp_plan(): unknown output mode (%ld)\n",
+	    (long)int_omode_a);
+    return false;
+  }
+  if (nold + num_clabels_d > MAX_NCHANS) {
+    fprintf(stdout, "**> Edf::interp_plan(): too many channels (%ld)\n",
+	    nold + num_clabels_d);
+    return false;
+  }
+
+  // find the weights over the available channels
+  //
+  char* alabels[MAX_NCHANS];
+  long na = 0;
+
+  if (int_mode_a == INTMODE_AVERAGE) {
+    for (long i = 0; i < num_clabels_d; i++) {
+      for (long j = 0; j < num_adj_chan_d[i]; j++) {
+	if (Edf::find_match(adj_chan_labels_d[i][j], na, alabels,
+			    MATMODE_EXACT) < 0) {
+	  alabels[na++] = adj_chan_labels_d[i][j];
+	}
+      }
+    }
+    if ((num_clabels_d <= 0) || (na == 0)) {
+      fprintf(stdout, "**> Edf::interp_plan(): no channels to interpolate\n");
+      return false;
+    }
+
+    Edf::resize(stream_w_d, num_clabels_d, na, false);
+    for (long i = 0; i < num_clabels_d; i++) {
+      for (long k = 0; k < na; k++) {
+	stream_w_d(i, k) = 0;
+      }
+      for (long j = 0; j < num_adj_chan_d[i]; j++) {
+	long k = Edf::find_match(adj_chan_labels_d[i][j], na, alabels,
+				 MATMODE_EXACT);
+	stream_w_d(i, k) += 1.0 / (double)num_adj_chan_d[i];
+      }
+    }
+  }
+  else if ((int_mode_a == INTMODE_IDW) || (int_mode_a == INTMODE_SPLINE)) {
+    long ind;
+    if (!Edf::find_interp_weights(ind, na, alabels, int_mode_a)) {
+      return false;
+    }
+    stream_w_d = wcache_d[ind];
+  }
+  else {
+    fprintf(stdout, "**> Edf::interp_plan(): unknown mode (%ld)\n",
+	    (long)int_mode_a);
+    return false;
+  }
+
+  // locate the available channels among the montage channels: they
+  // are multiplied as a block, so they must share a sample rate
+  //
+  Edf::resize(stream_wpos_d, na, false);
+  for (long k = 0; k < na; k++) {
+    if ((stream_wpos_d[k] = Edf::find_match(alabels[k], num_mplan_d,
+					    stream_labels_d,
+					    match_mode_a)) < 0) {
+      fprintf(stdout, "**> Edf::interp_plan(): no match for [%s]\n",
+	      alabels[k]);
+      return false;
+    }
+    if (stream_rsize_d[stream_wpos_d[k]] != stream_rsize_d[stream_wpos_d[0]]) {
+      fprintf(stdout,
+	      "**> Edf::interp_plan(): [%s] differs in sample frequency\n",
+	      alabels[k]);
+      return false;
+    }
+  }
+
+  // lay out the output channels: the montage channels that are kept,
+  // followed by the new channels
+  //
+  long rsize = stream_rsize_d[stream_wpos_d[0]];
+  stream_nchan_d = nold + num_clabels_d;
+  for (long i = 0; i < stream_nchan_d; i++) {
+    stream_row_d[i] = (int_omode_a == INTOMODE_CONCAT) ? i : i + num_mplan_d;
+    if (stream_row_d[i] >= num_mplan_d) {
+      char* label = new_chan_labels_d[stream_row_d[i] - num_mplan_d];
+      Edf::resize(stream_labels_d[i], strlen(label) + 1, false);
+      strcpy(stream_labels_d[i], label);
+      stream_rsize_d[i] = rsize;
+    }
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::interp_plan(): %ld new channels from %ld (%ld)\n",
+	    num_clabels_d, na, (long)int_mode_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,960 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_08.cc
+//
+// This file contains methods associated with the class Edf that
+// provide direct access to the matrices stored in Kaldi ark files.
+//
+
+// system include files
+//
+#include <algorithm>
+
+// local include files
+//
+#include "Edf.h"
+
+// method: read_features_kaldi
+//
+// arguments:
+//  VVectorDouble& feat: the features of one channel (output)
+//  char* scp: the scp file written with the ark (input)
+//  char* key: the key of the matrix to load (input)
+//
+// return: a logical value indicating status
+//
+// This method loads a single matrix from an ark. The key is looked up
+// in the scp file, which gives the ark and the offset of the matrix.
+// The binary header and the matrix are then each read with one pread,
+// so the rest of the ark is never touched. Compressed matrices are
+// decompressed.
+//
+bool Edf::read_features_kaldi(VVectorDouble& feat_a, char* scp_a,
+			      char* key_a) {
+
+  // declare local variables
+  //
+  char ark[MAX_LSTR_LENGTH + 1];
+  long offset;
+  unsigned char hdr[KALDI_MAX_HEADER_SIZE];
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::read_features_kaldi(): loading [%s] from (%s)\n",
+	    key_a, scp_a);
+  }
+
+  // locate the matrix
+  //
+  if (!Edf::find_kaldi_key(ark, offset, scp_a, key_a)) {
+    fprintf(stdout, "**> Edf::read_features_kaldi(): no entry for [%s]\n",
+	    key_a);
+    return false;
+  }
+
+  // open the ark and read the header of the matrix
+  //
+  int fd = open(ark, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::read_features_kaldi(): error opening (%s)\n",
+	    ark);
+    return false;
+  }
+  long n = pread(fd, hdr, KALDI_MAX_HEADER_SIZE, offset);
+
+  long type, num_frames, vec_size, hsize, dsize;
+  float vmin, range;
+  if (!Edf::parse_kaldi_header(type, num_frames, vec_size, vmin, range,
+			       hsize, dsize, hdr, n)) {
+    fprintf(stdout,
+	    "**> Edf::read_features_kaldi(): [%s] is not a matrix\n", key_a);
+    close(fd);
+    return false;
+  }
+
+  // read the matrix in one call
+  //
+  unsigned char* buf = new unsigned char[dsize + 1];
+  if (pread(fd, buf, dsize, offset + hsize) != dsize) {
+    fprintf(stdout, "**> Edf::read_features_kaldi(): error reading (%s)\n",
+	    ark);
+    delete [] buf;
+    close(fd);
+    return false;
+  }
+  close(fd);
+
+  // convert the matrix to double precision
+  //
+  Edf::decode_kaldi_matrix(feat_a, type, num_frames, vec_size, vmin, range,
+			   buf);
+
+  // clean up memory
+  //
+  delete [] buf;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::read_features_kaldi(): [%s] is %ld x %ld\n",
+	    key_a, (long)num_frames, (long)vec_size);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: map_kaldi
+//
+// arguments:
+//  char* fn: the ark filename (input)
+//  int fd: the ark, if already open (input)
+//
+// return: a logical value indicating status
+//
+// This method maps an ark into memory and walks the binary headers once
+// to locate every matrix. No data is copied: get_kaldi_matrix returns a
+// pointer into the mapping, which stays valid until unmap_kaldi is
+// called or another ark is mapped. If fd is not negative, it is mapped
+// instead of opening fn, and it is closed.
+//
+bool Edf::map_kaldi(char* fn_a, int fd_a) {
+
+  // release any ark that is already mapped
+  //
+  Edf::unmap_kaldi();
+
+  // open the file and map it
+  //
+  int fd = (fd_a >= 0) ? fd_a : open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::map_kaldi(): error opening (%s)\n", fn_a);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    fprintf(stdout, "**> Edf::map_kaldi(): error in fstat (%s)\n", fn_a);
+    close(fd);
+    return false;
+  }
+  kmap_size_d = st.st_size;
+
+  if (kmap_size_d > 0) {
+    void* map = mmap(NULL, kmap_size_d, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      fprintf(stdout, "**> Edf::map_kaldi(): error in mmap (%s)\n", fn_a);
+      close(fd);
+      kmap_size_d = 0;
+      return false;
+    }
+    kmap_d = (char*)map;
+    madvise(map, kmap_size_d, MADV_SEQUENTIAL);
+  }
+  close(fd);
+
+  // walk the entries: "key " followed by the header and the data
+  //
+  long pos = 0;
+  while (pos < kmap_size_d) {
+
+    // locate the key
+    //
+    char* sp = (char*)memchr(kmap_d + pos, SPACE[0], kmap_size_d - pos);
+    if (sp == (char*)NULL) {
+      fprintf(stdout, "**> Edf::map_kaldi(): truncated header at %ld (%s)\n",
+	      pos, fn_a);
+      Edf::unmap_kaldi();
+      return false;
+    }
+    long key = pos;
+    long klen = sp - (kmap_d + pos);
+    const unsigned char* hdr = (const unsigned char*)(sp + 1);
+
+    // parse the header
+    //
+    long type, rows, cols, hsize, nbytes;
+    float vmin, range;
+    if (!Edf::parse_kaldi_header(type, rows, cols, vmin, range, hsize,
+				 nbytes, hdr,
+				 kmap_size_d - (key + klen + 1))) {
+      fprintf(stdout,
+	      "**> Edf::map_kaldi(): unsupported matrix at %ld (%s)\n",
+	      pos, fn_a);
+      Edf::unmap_kaldi();
+      return false;
+    }
+
+    long data = key + klen + 1 + hsize;
+    if (data + nbytes > kmap_size_d) {
+      fprintf(stdout, "**> Edf::map_kaldi(): truncated matrix at %ld (%s)\n",
+	      pos, fn_a);
+      Edf::unmap_kaldi();
+      return false;
+    }
+
+    // save the location of the matrix
+    //
+    if (num_kmat_d >= (long)kmat_key_d.size()) {
+      long n = (num_kmat_d > 0) ? 2 * num_kmat_d : MAX_NCHANS;
+      Edf::resize(kmat_key_d, n, true);
+      Edf::resize(kmat_klen_d, n, true);
+      Edf::resize(kmat_type_d, n, true);
+      Edf::resize(kmat_rows_d, n, true);
+      Edf::resize(kmat_cols_d, n, true);
+      Edf::resize(kmat_data_d, n, true);
+    }
+    kmat_key_d[num_kmat_d] = key;
+    kmat_klen_d[num_kmat_d] = klen;
+    kmat_type_d[num_kmat_d] = type;
+    kmat_rows_d[num_kmat_d] = rows;
+    kmat_cols_d[num_kmat_d] = cols;
+    kmat_data_d[num_kmat_d] = data;
+    num_kmat_d++;
+
+    pos = data + nbytes;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::map_kaldi(): %ld matrices in (%s)\n",
+	    num_kmat_d, fn_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: unmap_kaldi
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method releases the ark mapped by map_kaldi.
+//
+bool Edf::unmap_kaldi() {
+
+  // unmap the file
+  //
+  if (kmap_d != (char*)NULL) {
+    munmap(kmap_d, kmap_size_d);
+    kmap_d = (char*)NULL;
+  }
+  kmap_size_d = 0;
+  num_kmat_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_kaldi_matrix
+//
+// arguments:
+//  long& rows: the number of frames (output)
+//  long& cols: the dimension of each frame (output)
+//  char* key: the key of the matrix, if not NULL (output)
+//  long index: the index of the matrix in the ark (input)
+//
+// return: a pointer to the matrix data
+//
+// This method returns a view of a matrix in the mapped ark. The data is
+// stored row by row as little endian floats, and must not be modified.
+// The matrix starts right after its key, so the view is generally not
+// aligned for floats: values must be copied out with memcpy (see
+// widen). key, if supplied, must hold MAX_LSTR_LENGTH + 1 characters.
+// NULL is returned if the index is out of range or if the matrix is
+// compressed, since there is no float data to view (see
+// get_kaldi_features).
+//
+const char* Edf::get_kaldi_matrix(long& rows_a, long& cols_a, char* key_a,
+				  long index_a) {
+
+  // check the index
+  //
+  if ((index_a < 0) || (index_a >= num_kmat_d)) {
+    rows_a = 0;
+    cols_a = 0;
+    return (const char*)NULL;
+  }
+
+  // copy the key
+  //
+  if (key_a != (char*)NULL) {
+    long klen = kmat_klen_d[index_a];
+    if (klen > (long)MAX_LSTR_LENGTH) {
+      klen = MAX_LSTR_LENGTH;
+    }
+    memcpy(key_a, kmap_d + kmat_key_d[index_a], klen);
+    key_a[klen] = (char)NULL;
+  }
+
+  // exit gracefully
+  //
+  rows_a = kmat_rows_d[index_a];
+  cols_a = kmat_cols_d[index_a];
+  if (kmat_type_d[index_a] != KMAT_FM) {
+    return (const char*)NULL;
+  }
+  return kmap_d + kmat_data_d[index_a];
+}
+
+// method: widen
+//
+// arguments:
+//  VVectorDouble& feat: the features (output)
+//  const char* data: a matrix returned by get_kaldi_matrix (input)
+//  long rows: the number of frames (input)
+//  long cols: the dimension of each frame (input)
+//
+// return: a logical value indicating status
+//
+// This method converts a little endian float matrix to double
+// precision. The data need not be aligned: each value is loaded with
+// memcpy, which compiles to an unaligned load, so on little endian
+// machines each frame is still a single contiguous loop that the
+// compiler vectorizes.
+//
+bool Edf::widen(VVectorDouble& feat_a, const char* data_a,
+		long rows_a, long cols_a) {
+
+  // check if we need to byte swap
+  //
+  bool big_endian = Edf::is_big_endian();
+
+  // loop over all frames
+  //
+  Edf::resize(feat_a, rows_a, false);
+  for (long j = 0; j < rows_a; j++) {
+    Edf::resize(feat_a[j], cols_a, false);
+    if (cols_a == 0) {
+      continue;
+    }
+
+    const char* x = data_a + j * cols_a * sizeof(float);
+    double* y = &feat_a[j][0];
+
+    if (big_endian) {
+      float val;
+      for (long k = 0; k < cols_a; k++) {
+	Edf::swap_bytes(&val, (void*)(x + k * sizeof(float)), sizeof(float));
+	y[k] = val;
+      }
+    }
+    else {
+      float val;
+      for (long k = 0; k < cols_a; k++) {
+	memcpy(&val, x + k * sizeof(float), sizeof(float));
+	y[k] = val;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_kaldi_features
+//
+// arguments:
+//  VVectorDouble& feat: the features (output)
+//  long index: the index of the matrix in the mapped ark (input)
+//
+// return: a logical value indicating status
+//
+// This method converts a matrix of the mapped ark to double precision.
+// Float matrices are widened and compressed matrices are decompressed.
+//
+bool Edf::get_kaldi_features(VVectorDouble& feat_a, long index_a) {
+
+  // check the index
+  //
+  if ((index_a < 0) || (index_a >= num_kmat_d)) {
+    fprintf(stdout, "**> Edf::get_kaldi_features(): invalid index %ld\n",
+	    index_a);
+    return false;
+  }
+
+  // float matrices can be converted directly from the mapping
+  //
+  long rows = kmat_rows_d[index_a];
+  long cols = kmat_cols_d[index_a];
+  long type = kmat_type_d[index_a];
+
+  if (type == KMAT_FM) {
+    return Edf::widen(feat_a, kmap_d + kmat_data_d[index_a], rows, cols);
+  }
+
+  // compressed matrices need the range from the header
+  //
+  long hdr = kmat_key_d[index_a] + kmat_klen_d[index_a] + 1;
+  long hsize, dsize;
+  float vmin, range;
+  Edf::parse_kaldi_header(type, rows, cols, vmin, range, hsize, dsize,
+			  (const unsigned char*)(kmap_d + hdr),
+			  kmap_size_d - hdr);
+
+  // exit gracefully
+  //
+  return Edf::decode_kaldi_matrix(feat_a, type, rows, cols, vmin, range,
+				  (const unsigned char*)(kmap_d +
+							 kmat_data_d[index_a]));
+}
+
+// method: find_kaldi_key
+//
+// arguments:
+//  char* ark: the ark containing the matrix (output)
+//  long& offset: the offset of the matrix in the ark (output)
+//  char* scp: the scp file (input)
+//  char* key: the key to look up (input)
+//
+// return: a logical value indicating status
+//
+// This method looks up a key in an scp file. Each line has the form
+// "key ark:offset". ark must hold MAX_LSTR_LENGTH + 1 characters.
+//
+bool Edf::find_kaldi_key(char* ark_a, long& offset_a, char* scp_a,
+			 char* key_a) {
+
+  // declare local variables
+  //
+  char line[MAX_LSTR_LENGTH + 1];
+  long klen = strlen(key_a);
+
+  // open the scp file
+  //
+  FILE* fp = fopen(scp_a, "r");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::find_kaldi_key(): error opening (%s)\n",
+	    scp_a);
+    return false;
+  }
+
+  // loop over all lines
+  //
+  while (fgets(line, MAX_LSTR_LENGTH, fp) != (char*)NULL) {
+
+    // check the key
+    //
+    if ((strncmp(line, key_a, klen) != 0) || (line[klen] != SPACE[0])) {
+      continue;
+    }
+
+    // the offset follows the last colon, so the ark name may contain one
+    //
+    char* loc = line + klen + 1;
+    loc[strcspn(loc, "\r\n")] = (char)NULL;
+    char* delim = rindex(loc, COLON[0]);
+    if (delim == (char*)NULL) {
+      break;
+    }
+    *delim = (char)NULL;
+    strcpy(ark_a, loc);
+    offset_a = atol(delim + 1);
+
+    fclose(fp);
+    return true;
+  }
+
+  // the key was not found
+  //
+  fclose(fp);
+  return false;
+}
+
+// method: create_kaldi_scp_name
+//
+// arguments:
+//  char* scp: the scp filename (output)
+//  char* ark: the ark filename (input)
+//
+// return: a logical value indicating status
+//
+// This method replaces the extension of the ark filename with
+// KALDI_SCP_EXT, or appends it if there is none. scp must hold
+// strlen(ark) + strlen(KALDI_SCP_EXT) + 2 characters.
+//
+bool Edf::create_kaldi_scp_name(char* scp_a, char* ark_a) {
+
+  // copy the name and locate the extension
+  //
+  strcpy(scp_a, ark_a);
+  char* dot = rindex(scp_a, DOT[0]);
+  char* slash = rindex(scp_a, SLASH[0]);
+  if ((dot == (char*)NULL) || ((slash != (char*)NULL) && (dot < slash))) {
+    dot = scp_a + strlen(scp_a);
+  }
+
+  // add the new extension
+  //
+  *dot = (char)NULL;
+  strcat(scp_a, DOT);
+  strcat(scp_a, KALDI_SCP_EXT);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: parse_kaldi_header
+//
+// arguments:
+//  long& type: the type of matrix (KALDI_MTYPE) (output)
+//  long& rows: the number of frames (output)
+//  long& cols: the dimension of each frame (output)
+//  float& vmin: the minimum of a compressed matrix (output)
+//  float& range: the range of a compressed matrix (output)
+//  long& hsize: the size of the header in bytes (output)
+//  long& dsize: the size of the data in bytes (output)
+//  const unsigned char* hdr: the header, starting at the binary marker
+//   that follows the key (input)
+//  long n: the number of bytes available at hdr (input)
+//
+// return: a logical value indicating status
+//
+// This method parses the header of a binary Kaldi matrix:
+//
+//  float:      "\0BFM \4<rows>\4<cols>"
+//  compressed: "\0BCM " (or "CM2 ", "CM3 ") <min><range><rows><cols>
+//
+// All values are stored in little endian format.
+//
+bool Edf::parse_kaldi_header(long& type_a, long& rows_a, long& cols_a,
+			     float& vmin_a, float& range_a,
+			     long& hsize_a, long& dsize_a,
+			     const unsigned char* hdr_a, long n_a) {
+
+  // declare local variables
+  //
+  int32_t rows;
+  int32_t cols;
+  bool big_endian = Edf::is_big_endian();
+
+  // check the binary marker
+  //
+  if ((n_a < 2) || (hdr_a[0] != (unsigned char)NULL) || (hdr_a[1] != 'B')) {
+    return false;
+  }
+
+  // case 1: a float matrix
+  //
+  if ((n_a >= KALDI_HEADER_FIXED_SIZE) &&
+      (memcmp(&hdr_a[1], KALDI_HEADER_STR, strlen(KALDI_HEADER_STR)) == 0) &&
+      (hdr_a[1 + strlen(KALDI_HEADER_STR)] == SPACE[0]) &&
+      (hdr_a[KALDI_FRAME_FIXED_LOC - 1] == KALDI_HEADER_EOT) &&
+      (hdr_a[KALDI_VECTOR_FIXED_LOC - 1] == KALDI_HEADER_EOT)) {
+    type_a = KMAT_FM;
+    hsize_a = KALDI_HEADER_FIXED_SIZE;
+    memcpy(&rows, &hdr_a[KALDI_FRAME_FIXED_LOC], sizeof(int32_t));
+    memcpy(&cols, &hdr_a[KALDI_VECTOR_FIXED_LOC], sizeof(int32_t));
+    vmin_a = 0;
+    range_a = 0;
+  }
+
+  // case 2: a compressed matrix
+  //
+  else {
+
+    // find the token
+    //
+    const char* tok;
+    if ((n_a >= 6) && (hdr_a[5] == SPACE[0]) &&
+	(memcmp(&hdr_a[2], KALDI_CM2_STR, 3) == 0)) {
+      type_a = KMAT_CM2;
+      tok = KALDI_CM2_STR;
+    }
+    else if ((n_a >= 6) && (hdr_a[5] == SPACE[0]) &&
+	     (memcmp(&hdr_a[2], KALDI_CM3_STR, 3) == 0)) {
+      type_a = KMAT_CM3;
+      tok = KALDI_CM3_STR;
+    }
+    else if ((n_a >= 5) && (hdr_a[4] == SPACE[0]) &&
+	     (memcmp(&hdr_a[2], KALDI_CM_STR, 2) == 0)) {
+      type_a = KMAT_CM;
+      tok = KALDI_CM_STR;
+    }
+    else {
+      return false;
+    }
+
+    // read the global header
+    //
+    long loc = 2 + strlen(tok) + 1;
+    hsize_a = loc + 2 * sizeof(float) + 2 * sizeof(int32_t);
+    if (n_a < hsize_a) {
+      return false;
+    }
+    memcpy(&vmin_a, &hdr_a[loc], sizeof(float));
+    memcpy(&range_a, &hdr_a[loc + sizeof(float)], sizeof(float));
+    memcpy(&rows, &hdr_a[loc + 2 * sizeof(float)], sizeof(int32_t));
+    memcpy(&cols, &hdr_a[loc + 2 * sizeof(float) + sizeof(int32_t)],
+	   sizeof(int32_t));
+
+    if (big_endian) {
+      float tmp = vmin_a;
+      Edf::swap_bytes(&vmin_a, &tmp, sizeof(float));
+      tmp = range_a;
+      Edf::swap_bytes(&range_a, &tmp, sizeof(float));
+    }
+  }
+
+  // byte swap the dimensions if necessary
+  //
+  if (big_endian) {
+    int32_t tmp = rows;
+    Edf::swap_bytes(&rows, &tmp, sizeof(int32_t));
+    tmp = cols;
+    Edf::swap_bytes(&cols, &tmp, sizeof(int32_t));
+  }
+  if ((rows < 0) || (cols < 0)) {
+    return false;
+  }
+  rows_a = rows;
+  cols_a = cols;
+
+  // compute the size of the data
+  //
+  if (type_a == KMAT_FM) {
+    dsize_a = rows_a * cols_a * sizeof(float);
+  }
+  else if (type_a == KMAT_CM) {
+    dsize_a = cols_a * 4 * sizeof(uint16_t) + rows_a * cols_a;
+  }
+  else if (type_a == KMAT_CM2) {
+    dsize_a = rows_a * cols_a * sizeof(uint16_t);
+  }
+  else {
+    dsize_a = rows_a * cols_a;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: decode_kaldi_matrix
+//
+// arguments:
+//  VVectorDouble& feat: the features (output)
+//  long type: the type of matrix (KALDI_MTYPE) (input)
+//  long rows: the number of frames (input)
+//  long cols: the dimension of each frame (input)
+//  float vmin: the minimum of a compressed matrix (input)
+//  float range: the range of a compressed matrix (input)
+//  const unsigned char* data: the data following the header (input)
+//
+// return: a logical value indicating status
+//
+// This method converts the data of a binary Kaldi matrix to double
+// precision. For "CM", a 256-entry lookup table is built for each
+// column from its percentile header, so that each value is a single
+// table lookup. "CM2" and "CM3" are a linear map of the codes, which
+// the compiler vectorizes. The arithmetic is done in single precision,
+// as in Kaldi, so the values match those Kaldi produces.
+//
+bool Edf::decode_kaldi_matrix(VVectorDouble& feat_a, long type_a,
+			      long rows_a, long cols_a,
+			      float vmin_a, float range_a,
+			      const unsigned char* data_a) {
+
+  // float matrices are simply widened
+  //
+  if (type_a == KMAT_FM) {
+    return Edf::widen(feat_a, (const char*)data_a, rows_a, cols_a);
+  }
+
+  // create output space
+  //
+  bool big_endian = Edf::is_big_endian();
+
+  Edf::resize(feat_a, rows_a, false);
+  for (long j = 0; j < rows_a; j++) {
+    Edf::resize(feat_a[j], cols_a, false);
+  }
+  if ((rows_a == 0) || (cols_a == 0)) {
+    return true;
+  }
+
+  // case 1: one byte per value with per-column headers
+  //
+  if (type_a == KMAT_CM) {
+
+    // build a lookup table for each column:
+    //  codes 0-64 span [p0, p25], 64-192 span [p25, p75] and
+    //  192-255 span [p75, p100].
+    //
+    float* lut = new float[cols_a * 256];
+    float inc = range_a * (1.0f / 65535.0f);
+
+    for (long k = 0; k < cols_a; k++) {
+      uint16_t ph[4];
+      memcpy(ph, data_a + k * 4 * sizeof(uint16_t), 4 * sizeof(uint16_t));
+      if (big_endian) {
+	for (long l = 0; l < 4; l++) {
+	  uint16_t tmp = ph[l];
+	  Edf::swap_bytes(&ph[l], &tmp, sizeof(uint16_t));
+	}
+      }
+      float p0 = vmin_a + inc * ph[0];
+      float p25 = vmin_a + inc * ph[1];
+      float p75 = vmin_a + inc * ph[2];
+      float p100 = vmin_a + inc * ph[3];
+
+      float* t = lut + k * 256;
+      for (long c = 0; c <= 64; c++) {
+	t[c] = p0 + (p25 - p0) * c * (1.0f / 64.0f);
+      }
+      for (long c = 65; c <= 192; c++) {
+	t[c] = p25 + (p75 - p25) * (c - 64) * (1.0f / 128.0f);
+      }
+      for (long c = 193; c < 256; c++) {
+	t[c] = p75 + (p100 - p75) * (c - 192) * (1.0f / 63.0f);
+      }
+    }
+
+    // the bytes are stored column by column
+    //
+    const unsigned char* b = data_a + cols_a * 4 * sizeof(uint16_t);
+    for (long j = 0; j < rows_a; j++) {
+      double* y = &feat_a[j][0];
+      for (long k = 0; k < cols_a; k++) {
+	y[k] = lut[k * 256 + b[k * rows_a + j]];
+      }
+    }
+
+    delete [] lut;
+  }
+
+  // case 2: two bytes per value, stored row by row
+  //
+  else if (type_a == KMAT_CM2) {
+    float inc = range_a * (1.0f / 65535.0f);
+    for (long j = 0; j < rows_a; j++) {
+      uint16_t x[cols_a];
+      memcpy(x, data_a + j * cols_a * sizeof(uint16_t),
+	     cols_a * sizeof(uint16_t));
+      if (big_endian) {
+	for (long k = 0; k < cols_a; k++) {
+	  uint16_t tmp = x[k];
+	  Edf::swap_bytes(&x[k], &tmp, sizeof(uint16_t));
+	}
+      }
+      double* y = &feat_a[j][0];
+      for (long k = 0; k < cols_a; k++) {
+	y[k] = vmin_a + inc * x[k];
+      }
+    }
+  }
+
+  // case 3: one byte per value, stored row by row
+  //
+  else {
+    float inc = range_a * (1.0f / 255.0f);
+    for (long j = 0; j < rows_a; j++) {
+      const unsigned char* x = data_a + j * cols_a;
+      double* y = &feat_a[j][0];
+      for (long k = 0; k < cols_a; k++) {
+	y[k] = vmin_a + inc * x[k];
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_kaldi_cm
+//
+// arguments:
+//  FILE* fp: the ark, positioned after the key (input)
+//  VVectorDouble& feat: the features of one channel (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a matrix in Kaldi's compressed format, choosing
+// the format the way Kaldi does by default: "CM" when there are more
+// than KALDI_CM_MIN_ROWS rows, "CM2" otherwise. The quantization
+// follows Kaldi's CompressedMatrix so that the arks can be read by
+// Kaldi tools. The entry is assembled in memory and written with one
+// call.
+//
+bool Edf::write_kaldi_cm(FILE* fp_a, VVectorDouble& feat_a) {
+
+  // declare local variables
+  //
+  long rows = feat_a.size();
+  long cols = (rows > 0) ? (long)feat_a[0].size() : 0;
+  long type = (rows > KALDI_CM_MIN_ROWS) ? KMAT_CM : KMAT_CM2;
+  const char* tok = (type == KMAT_CM) ? KALDI_CM_STR : KALDI_CM2_STR;
+  bool big_endian = Edf::is_big_endian();
+
+  // compute the global range
+  //
+  float vmin = 0;
+  float vmax = 0;
+  for (long j = 0; j < rows; j++) {
+    if ((long)feat_a[j].size() != cols) {
+      fprintf(stdout,
+	      "**> Edf::write_kaldi_cm(): feature vectors must have the same"
+	      " size\n");
+      return false;
+    }
+    for (long k = 0; k < cols; k++) {
+      float val = feat_a[j][k];
+      if (((j == 0) && (k == 0)) || (val < vmin)) {
+	vmin = val;
+      }
+      if (((j == 0) && (k == 0)) || (val > vmax)) {
+	vmax = val;
+      }
+    }
+  }
+  if (vmax == vmin) {
+    vmax = vmin + (1.0 + fabs(vmin));
+  }
+  float range = vmax - vmin;
+
+  // create space for the entry: the header followed by the data
+  //
+  long loc = 2 + strlen(tok) + 1;
+  long hsize = loc + 2 * sizeof(float) + 2 * sizeof(int32_t);
+  long dsize = (type == KMAT_CM) ?
+    (cols * 4 * sizeof(uint16_t) + rows * cols) :
+    (rows * cols * sizeof(uint16_t));
+  unsigned char* buf = new unsigned char[hsize + dsize];
+
+  // write the header
+  //
+  int32_t dims[2] = {(int32_t)rows, (int32_t)cols};
+  float grange[2] = {vmin, range};
+  buf[0] = (unsigned char)NULL;
+  buf[1] = 'B';
+  memcpy(&buf[2], tok, strlen(tok));
+  buf[loc - 1] = SPACE[0];
+  for (long l = 0; l < 2; l++) {
+    if (big_endian) {
+      Edf::swap_bytes(&buf[loc + l * sizeof(float)], &grange[l],
+		      sizeof(float));
+      Edf::swap_bytes(&buf[loc + 2 * sizeof(float) + l * sizeof(int32_t)],
+		      &dims[l], sizeof(int32_t));
+    }
+    else {
+      memcpy(&buf[loc + l * sizeof(float)], &grange[l], sizeof(float));
+      memcpy(&buf[loc + 2 * sizeof(float) + l * sizeof(int32_t)], &dims[l],
+	     sizeof(int32_t));
+    }
+  }
+  unsigned char* data = buf + hsize;
+
+  // case 1: per-column headers and one byte per value
+  //
+  if (type == KMAT_CM) {
+
+    float col[rows];
+    unsigned char* b = data + cols * 4 * sizeof(uint16_t);
+    long q = rows / 4;
+
+    for (long k = 0; k < cols; k++) {
+
+      // compute the percentiles of the column as Kaldi does
+      //
+      for (long j = 0; j < rows; j++) {
+	col[j] = feat_a[j][k];
+      }
+      std::nth_element(col, col + q, col + rows);
+      std::nth_element(col, col, col + q);
+      std::nth_element(col + q + 1, col + 3 * q, col + rows);
+      std::nth_element(col + 3 * q + 1, col + rows - 1, col + rows);
+
+      long pv[4];
+      float pf[4] = {col[0], col[q], col[3 * q], col[rows - 1]};
+      for (long l = 0; l < 4; l++) {
+	float f = (pf[l] - vmin) / range;
+	f = (f > 1.0f) ? 1.0f : ((f < 0.0f) ? 0.0f : f);
+	pv[l] = (long)(f * 65535 + 0.499);
+      }
+      uint16_t ph[4];
+      ph[0] = (pv[0] < 65532) ? pv[0] : 65532;
+      ph[1] = (pv[1] > ph[0] + 1) ? pv[1] : ph[0] + 1;
+      ph[1] = (ph[1] < 65533) ? ph[1] : 65533;
+      ph[2] = (pv[2] > ph[1] + 1) ? pv[2] : ph[1] + 1;
+      ph[2] = (ph[2] < 65534) ? ph[2] : 65534;
+      ph[3] = (pv[3] > ph[2] + 1) ? pv[3] : ph[2] + 1;
+
+      for (long l = 0; l < 4; l++) {
+	if (big_endian) {
+	  Edf::swap_bytes(data + (k * 4 + l) * sizeof(uint16_t), &ph[l],
+			  sizeof(uint16_t));
+	}
+	else {
+	  memcpy(data + (k * 4 + l) * sizeof(uint16_t), &ph[l],
+		 sizeof(uint16_t));
+	}
+      }
+
+      // quantize the column
+      //
+      float inc = range * (1.0f / 65535.0f);
+      float p0 = vmin + inc * ph[0];
+      float p25 = vmin + inc * ph[1];
+      float p75 = vmin + inc * ph[2];
+      float p100 = vmin + inc * ph[3];
+
+      for (long j = 0; j < rows; j++) {
+	float val = feat_a[j][k];
+	long c;
+	if (val < p25) {
+	  c = (long)((val - p0) / (p25 - p0) * 64 + 0.5);
+	  c = (c < 0) ? 0 : ((c > 64) ? 64 : c);
+	}
+	else if (val < p75) {
+	  c = 64 + (long)((val - p25) / (p75 - p25) * 128 + 0.5);
+	  c = (c < 64) ? 64 : ((c > 192) ? 192 : c);
+	}
+	else {
+	  c = 192 + (long)((val - p75) / (p100 - p75) * 63 + 0.5);
+	  c = (c < 192) ? 192 : ((c > 255) ? 255 : c);
+	}
+	b[k * rows + j] = (unsigned char)c;
+      }
+    }
+  }
+
+  // case 2: two bytes per value, row by row
+  //
+  else {
+    for (long j = 0; j < rows; j++) {
+      for (long k = 0; k < cols; k++) {
+	float f = ((float)feat_a[j][k] - vmin) / range;
+	f = (f > 1.0f) ? 1.0f : ((f < 0.0f) ? 0.0f : f);
+	uint16_t v = (uint16_t)(f * 65535 + 0.499);
+	if (big_endian) {
+	  Edf::swap_bytes(data + (j * cols + k) * sizeof(uint16_t), &v,
+			  sizeof(uint16_t));
+	}
+	else {
+	  memcpy(data + (j * cols + k) * sizeof(uint16_t), &v,
+		 sizeof(uint16_t));
+	}
+      }
+    }
+  }
+
+  // write the entry
+  //
+  bool status = ((long)fwrite(buf, 1, hsize + dsize, fp_a) == hsize + dsize);
+  delete [] buf;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+//
+// end of file
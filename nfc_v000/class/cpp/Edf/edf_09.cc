@@ -0,0 +1,542 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_09.cc
+//
+// This file contains methods associated with the class Edf that read
+// and write multichannel HTK features. Each channel is serialized into
+// one contiguous buffer and the per-channel files are processed in
+// parallel.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+// the work shared by the threads: each thread takes the next channel
+// that has not been processed until none are left
+//
+struct EdfHtkJob {
+  Edf* edf;
+  VVVectorDouble* feat;
+  char** fnames;
+  long nf;
+  long next;
+  bool write;
+  bool* status;
+};
+
+// method: read_htk_channels
+//
+// arguments:
+//  VVVectorDouble& feat: feature matrix (output)
+//  char** fnames: one filename per channel (input)
+//  long nf: the number of channels (input)
+//
+// return: a logical value indicating status
+//
+// This method reads one HTK file per channel using up to nthreads_d
+// threads. Each file is read with a single call and decoded from
+// memory (see decode_htk_channel). The frame duration is taken from
+// the last channel.
+//
+bool Edf::read_htk_channels(VVVectorDouble& feat_a, char** fnames_a,
+			    long nf_a) {
+
+  // create space for the feature data:
+  //  the outer vector is sized here since the threads only fill in
+  //  their own channels
+  //
+  Edf::resize(feat_a, nf_a, false);
+  if (nf_a == 0) {
+    return true;
+  }
+
+  // run the threads:
+  //  the calling thread also takes part, so if a thread cannot be
+  //  created the remaining channels are still processed
+  //
+  long nt = (nthreads_d < nf_a) ? nthreads_d : nf_a;
+  bool status[nf_a];
+  pthread_t threads[nt];
+  EdfHtkJob job = {this, &feat_a, fnames_a, nf_a, 0, false, status};
+
+  long nc = 1;
+  while ((nc < nt) &&
+	 (pthread_create(&threads[nc], NULL, Edf::htk_worker, &job) == 0)) {
+    nc++;
+  }
+  Edf::htk_worker(&job);
+  for (long i = 1; i < nc; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // check the status of each channel
+  //
+  for (long i = 0; i < nf_a; i++) {
+    if (!status[i]) {
+      fprintf(stdout,
+	      "**> Edf::read_htk_channels(): error reading channel %ld - [%s]\n",
+	      i, fnames_a[i]);
+      return false;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_htk_channels
+//
+// arguments:
+//  VVVectorDouble& feat: feature matrix (input)
+//  char** fnames: one filename per channel (input)
+//  long nf: the number of channels (input)
+//
+// return: a logical value indicating status
+//
+// This method writes one HTK file per channel using up to nthreads_d
+// threads. Each channel is serialized into one buffer (see
+// encode_htk_channel) and written with a single call.
+//
+bool Edf::write_htk_channels(VVVectorDouble& feat_a, char** fnames_a,
+			     long nf_a) {
+
+  // check the arguments
+  //
+  if (nf_a == 0) {
+    return true;
+  }
+
+  // run the threads:
+  //  the calling thread also takes part, so if a thread cannot be
+  //  created the remaining channels are still processed
+  //
+  long nt = (nthreads_d < nf_a) ? nthreads_d : nf_a;
+  bool status[nf_a];
+  pthread_t threads[nt];
+  EdfHtkJob job = {this, &feat_a, fnames_a, nf_a, 0, true, status};
+
+  long nc = 1;
+  while ((nc < nt) &&
+	 (pthread_create(&threads[nc], NULL, Edf::htk_worker, &job) == 0)) {
+    nc++;
+  }
+  Edf::htk_worker(&job);
+  for (long i = 1; i < nc; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // check the status of each channel
+  //
+  for (long i = 0; i < nf_a; i++) {
+    if (!status[i]) {
+      fprintf(stdout,
+	      "**> Edf::write_htk_channels(): error writing channel %ld - [%s]\n",
+	      i, fnames_a[i]);
+      return false;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: htk_worker
+//
+// arguments:
+//  void* arg: the EdfHtkJob shared by all threads (input)
+//
+// return: NULL
+//
+// This method is the body of a thread used by read_htk_channels and
+// write_htk_channels. Channels are claimed one at a time, so files of
+// different sizes are balanced across threads.
+//
+void* Edf::htk_worker(void* arg_a) {
+
+  // declare local variables
+  //
+  EdfHtkJob* job = (EdfHtkJob*)arg_a;
+  Edf* edf = job->edf;
+
+  // loop until all channels are claimed
+  //
+  long i;
+  while ((i = __sync_fetch_and_add(&job->next, 1)) < job->nf) {
+
+    char* fname = job->fnames[i];
+    job->status[i] = false;
+
+    // case 1: serialize the channel and write it in one call
+    //
+    if (job->write) {
+      unsigned char* buf;
+      long nbytes;
+      if (!edf->encode_htk_channel(buf, nbytes, (*job->feat)[i],
+				   edf->fdur_d)) {
+	continue;
+      }
+
+      int fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (fd >= 0) {
+	long n = 0;
+	while (n < nbytes) {
+	  long m = write(fd, buf + n, nbytes - n);
+	  if (m <= 0) {
+	    break;
+	  }
+	  n += m;
+	}
+	job->status[i] = ((close(fd) == 0) && (n == nbytes));
+      }
+      delete [] buf;
+    }
+
+    // case 2: read the file in one call and decode it
+    //
+    else {
+      int fd = open(fname, O_RDONLY);
+      if (fd < 0) {
+	continue;
+      }
+      struct stat st;
+      if (fstat(fd, &st) != 0) {
+	close(fd);
+	continue;
+      }
+
+      long nbytes = st.st_size;
+      unsigned char* buf = new unsigned char[nbytes + 1];
+      long n = 0;
+      while (n < nbytes) {
+	long m = read(fd, buf + n, nbytes - n);
+	if (m <= 0) {
+	  break;
+	}
+	n += m;
+      }
+      close(fd);
+
+      double fdur;
+      if (n == nbytes) {
+	job->status[i] = edf->decode_htk_channel((*job->feat)[i], fdur,
+						 buf, nbytes);
+	if (job->status[i] && (i == job->nf - 1)) {
+	  edf->fdur_d = fdur;
+	}
+      }
+      delete [] buf;
+    }
+  }
+
+  // exit gracefully
+  //
+  return NULL;
+}
+
+// method: encode_htk_channel
+//
+// arguments:
+//  unsigned char*& buf: the serialized file, allocated here (output)
+//  long& nbytes: the size of the buffer (output)
+//  VVectorDouble& feat: the features of one channel (input)
+//  double fdur: the frame duration (input)
+//
+// return: a logical value indicating status
+//
+// This method serializes one channel into the HTK binary format: a
+// 12-byte header followed by the frames as big endian floats. Each
+// frame is converted and byte-swapped in one contiguous loop that the
+// compiler vectorizes. The caller must delete buf.
+//
+bool Edf::encode_htk_channel(unsigned char*& buf_a, long& nbytes_a,
+			     VVectorDouble& feat_a, double fdur_a) {
+
+  // declare local variables
+  //
+  bool big_endian = Edf::is_big_endian();
+  long num_frames = feat_a.size();
+  long vec_size = (num_frames > 0) ? (long)feat_a[0].size() : 0;
+
+  // check the vector size:
+  //  the frame size in bytes must fit in a signed 16-bit integer, and
+  //  all frames must have the same size
+  //
+  if ((vec_size * (long)sizeof(float)) >=
+      (1L << (sizeof(int16_t) * CHAR_BIT - 1))) {
+    fprintf(stdout, "**> Edf::encode_htk_channel(): frame is too large\n");
+    return false;
+  }
+  for (long i = 0; i < num_frames; i++) {
+    if ((long)feat_a[i].size() != vec_size) {
+      fprintf(stdout, "%s %s [%ld] [%ld]\n",
+	      "**> Edf::encode_htk_channel():",
+	      "feature vectors must have the same size",
+	      (long)feat_a[i].size(), vec_size);
+      return false;
+    }
+  }
+
+  // create space
+  //
+  nbytes_a = HTK_HEADER_SIZE + num_frames * vec_size * sizeof(float);
+  buf_a = new unsigned char[nbytes_a];
+
+  // write the header in big endian format
+  //
+  int32_t hdr32[2] = {(int32_t)num_frames,
+		      (int32_t)round(fdur_a / HTK_FDUR_SCALE)};
+  int16_t hdr16[2] = {(int16_t)(vec_size * sizeof(float)),
+		      (int16_t)HTK_PARMKIND_USER};
+
+  for (long l = 0; l < 2; l++) {
+    if (!big_endian) {
+      Edf::swap_bytes(buf_a + l * sizeof(int32_t), &hdr32[l],
+		      sizeof(int32_t));
+      Edf::swap_bytes(buf_a + 2 * sizeof(int32_t) + l * sizeof(int16_t),
+		      &hdr16[l], sizeof(int16_t));
+    }
+    else {
+      memcpy(buf_a + l * sizeof(int32_t), &hdr32[l], sizeof(int32_t));
+      memcpy(buf_a + 2 * sizeof(int32_t) + l * sizeof(int16_t),
+	     &hdr16[l], sizeof(int16_t));
+    }
+  }
+
+  // convert and swap the frames
+  //
+  uint32_t* y = (uint32_t*)(buf_a + HTK_HEADER_SIZE);
+  for (long i = 0; i < num_frames; i++) {
+    if (vec_size == 0) {
+      break;
+    }
+    const double* x = &feat_a[i][0];
+    uint32_t* yi = y + i * vec_size;
+    for (long k = 0; k < vec_size; k++) {
+      float f = (float)x[k];
+      uint32_t u;
+      memcpy(&u, &f, sizeof(uint32_t));
+      yi[k] = big_endian ? u : __builtin_bswap32(u);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: decode_htk_channel
+//
+// arguments:
+//  VVectorDouble& feat: the features of one channel (output)
+//  double& fdur: the frame duration (output)
+//  const unsigned char* buf: the contents of an HTK file (input)
+//  long nbytes: the size of the buffer (input)
+//
+// return: a logical value indicating status
+//
+// This method is the inverse of encode_htk_channel.
+//
+bool Edf::decode_htk_channel(VVectorDouble& feat_a, double& fdur_a,
+			     const unsigned char* buf_a, long nbytes_a) {
+
+  // declare local variables
+  //
+  bool big_endian = Edf::is_big_endian();
+  int32_t hdr32[2];
+  int16_t hdr16[2];
+
+  // read the header
+  //
+  if (nbytes_a < HTK_HEADER_SIZE) {
+    return false;
+  }
+  for (long l = 0; l < 2; l++) {
+    if (!big_endian) {
+      Edf::swap_bytes(&hdr32[l], (void*)(buf_a + l * sizeof(int32_t)),
+		      sizeof(int32_t));
+      Edf::swap_bytes(&hdr16[l],
+		      (void*)(buf_a + 2 * sizeof(int32_t) +
+			      l * sizeof(int16_t)), sizeof(int16_t));
+    }
+    else {
+      memcpy(&hdr32[l], buf_a + l * sizeof(int32_t), sizeof(int32_t));
+      memcpy(&hdr16[l], buf_a + 2 * sizeof(int32_t) + l * sizeof(int16_t),
+	     sizeof(int16_t));
+    }
+  }
+
+  long num_frames = hdr32[0];
+  fdur_a = hdr32[1] * HTK_FDUR_SCALE;
+  long vec_size = hdr16[0] / sizeof(float);
+
+  if (hdr16[1] != HTK_PARMKIND_USER) {
+    fprintf(stdout,
+	    "**> Edf::decode_htk_channel(): error reading htk code [%d != %ld]\n",
+	    hdr16[1], HTK_PARMKIND_USER);
+    return false;
+  }
+  if ((num_frames < 0) || (vec_size < 0) ||
+      (HTK_HEADER_SIZE + num_frames * vec_size * (long)sizeof(float) >
+       nbytes_a)) {
+    fprintf(stdout, "**> Edf::decode_htk_channel(): file is truncated\n");
+    return false;
+  }
+
+  // swap and convert the frames
+  //
+  Edf::resize(feat_a, num_frames, false);
+  const unsigned char* x = buf_a + HTK_HEADER_SIZE;
+
+  for (long i = 0; i < num_frames; i++) {
+    Edf::resize(feat_a[i], vec_size, false);
+    if (vec_size == 0) {
+      continue;
+    }
+    uint32_t u[vec_size];
+    memcpy(u, x + i * vec_size * sizeof(float), vec_size * sizeof(float));
+
+    double* y = &feat_a[i][0];
+    for (long k = 0; k < vec_size; k++) {
+      uint32_t v = big_endian ? u[k] : __builtin_bswap32(u[k]);
+      float f;
+      memcpy(&f, &v, sizeof(float));
+      y[k] = f;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: list_matching_filenames
+//
+// arguments:
+//  char** fnames: list of filenames (output)
+//  long& nf: number of filenames (output)
+//  char* bfn: base filename (input)
+//  char* fmt: filename modifier format specification (input)
+//
+// return: a logical value indicating status
+//
+// This method finds the same files as get_matching_filenames
+// (channels 0, 1, ... up to the first one missing) but reads the
+// directory only once. Each entry that matches the base name and
+// extension is parsed for its channel index, which is checked by
+// regenerating the name from fmt.
+//
+// Note that this method allocates memory inside of fnames, so that
+// memory must be cleaned up by the calling method.
+//
+bool Edf::list_matching_filenames(char** fnames_a, long& nf_a,
+				  char* bfn_a, char* fmt_a) {
+
+  // declare local variables
+  //
+  char dirname[MAX_LSTR_LENGTH];
+  char bname[MAX_MSTR_LENGTH];
+  char ext[MAX_SSTR_LENGTH];
+  char fname[MAX_LSTR_LENGTH];
+  char mod[MAX_MSTR_LENGTH];
+  char* names[MAX_NCHANS];
+
+  // get the directory and extension
+  //
+  nf_a = 0;
+  if (Edf::create_matching_filename(dirname, bname, ext, fname,
+				    0, bfn_a, fmt_a) == false) {
+    return false;
+  }
+
+  // get the base name without the directory and extension
+  //
+  char* ddelim = rindex(bfn_a, SLASH[0]);
+  char* base = (ddelim == (char*)NULL) ? bfn_a : ddelim + 1;
+  long blen = rindex(bfn_a, DOT[0]) - base;
+  long elen = strlen(ext);
+  if (blen < 0) {
+    return false;
+  }
+
+  // read the directory once
+  //
+  DIR* dir;
+  struct dirent* ent;
+
+  if ((dir = opendir(dirname)) == NULL) {
+    return false;
+  }
+
+  for (long i = 0; i < MAX_NCHANS; i++) {
+    names[i] = (char*)NULL;
+  }
+
+  while ((ent = readdir(dir)) != NULL) {
+
+    // check the base name and the extension
+    //
+    long len = strlen(ent->d_name);
+    if ((len <= blen + elen) ||
+	(strncmp(ent->d_name, base, blen) != 0) ||
+	(strcmp(ent->d_name + len - elen, ext) != 0)) {
+      continue;
+    }
+
+    // extract the modifier and parse the channel index from it
+    //
+    long mlen = len - blen - elen;
+    if (mlen >= (long)MAX_MSTR_LENGTH) {
+      continue;
+    }
+    strncpy(mod, ent->d_name + blen, mlen);
+    mod[mlen] = (char)NULL;
+
+    char* digits = strpbrk(mod, "0123456789");
+    if (digits == (char*)NULL) {
+      continue;
+    }
+    long index = atol(digits);
+    if ((index < 0) || (index >= MAX_NCHANS)) {
+      continue;
+    }
+
+    // make sure the modifier is exactly what fmt produces
+    //
+    sprintf(fname, fmt_a, index);
+    if ((strcmp(fname, mod) != 0) || (names[index] != (char*)NULL)) {
+      continue;
+    }
+    names[index] = new char[strlen(dirname) + len + 2];
+    strcpy(names[index], dirname);
+    strcat(names[index], SLASH);
+    strcat(names[index], ent->d_name);
+  }
+  closedir(dir);
+
+  // keep the channels up to the first one that is missing
+  //
+  while ((nf_a < MAX_NCHANS) && (names[nf_a] != (char*)NULL)) {
+    fnames_a[nf_a] = names[nf_a];
+    nf_a++;
+  }
+  for (long i = nf_a; i < MAX_NCHANS; i++) {
+    if (names[i] != (char*)NULL) {
+      delete [] names[i];
+    }
+  }
+
+  // display debug information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::list_matching_filenames(): %ld files for [%s]\n",
+	    nf_a, bfn_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,928 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_10.cc
+//
+// This file contains methods associated with the class Edf that
+// read and write version 2 raw feature files.
+//
+// A version 2 raw file holds a dense (frames x dimension) matrix for
+// each channel. It is written in the byte order of the machine, as
+// version 1 raw files are, in the following order:
+//
+//  (1) header (RAW2_HEADER_SIZE bytes):
+//      magic string RAW2_MAGIC              (4 bytes)
+//      data type (RAW_DTYPE)                (4-byte int)
+//      number of channels                   (4-byte int)
+//      number of frames                     (4-byte int)
+//      feature dimension                    (4-byte int)
+//      reserved                             (4-byte int)
+//      offset of the channel table          (8-byte int)
+//      zero padding
+//  (2) channel table: the offset of each channel (8-byte ints)
+//  (3) channel #0: frame #0, frame #1, ... (data type)
+//      channel #1: ...
+//
+// Every channel starts on a RAW2_ALIGN boundary, so any range of
+// frames of a channel is contiguous on disk and can be read with a
+// single pread, or viewed in place after the file is mapped.
+//
+// Values are stored as 4-byte floats or as 2-byte half precision or
+// bfloat16 values. Half precision conversions use the F16C
+// instructions when the code is compiled with them (e.g., -mf16c).
+//
+
+// system include files
+//
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+// method: read_features_raw2
+//
+// arguments:
+//  VVVectorDouble& feat: feature data (output)
+//  char* fn: input filename (input)
+//  int fd: the file, if already open (input)
+//
+// return: a logical value indicating status
+//
+// This method reads all channels of a version 2 raw file. Each
+// channel is read with one pread. If fd is not negative, it is read
+// instead of opening fn, and it is closed.
+//
+bool Edf::read_features_raw2(VVVectorDouble& feat_a, char* fn_a, int fd_a) {
+
+  // declare local variables
+  //
+  long dtype, nchan, nframes, dim;
+  VectorLong offsets;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::read_features_raw2(): beginning read [%s]\n",
+	    fn_a);
+  }
+
+  // open the file and read the header
+  //
+  int fd = (fd_a >= 0) ? fd_a : open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::read_features_raw2(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  struct stat st;
+  if ((fstat(fd, &st) != 0) ||
+      (!Edf::read_raw2_header(dtype, nchan, nframes, dim, offsets,
+			      fd, st.st_size))) {
+    fprintf(stdout, "**> Edf::read_features_raw2(): invalid header (%s)\n",
+	    fn_a);
+    close(fd);
+    return false;
+  }
+
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout,
+	    "Edf::read_features_raw2(): (nchan, nframes, fdim) %ld %ld %ld\n",
+	    nchan, nframes, dim);
+  }
+
+  // read each channel into a single buffer and convert it
+  //
+  long nbytes = nframes * dim * Edf::get_raw2_esize(dtype);
+  char* buf = new char[nbytes + 1];
+
+  Edf::resize(feat_a, nchan, false);
+  for (long i = 0; i < nchan; i++) {
+    if (pread(fd, buf, nbytes, offsets[i]) != nbytes) {
+      fprintf(stdout,
+	      "**> Edf::read_features_raw2(): error reading channel %ld (%s)\n",
+	      i, fn_a);
+      delete [] buf;
+      close(fd);
+      return false;
+    }
+    Edf::decode_raw2(feat_a[i], buf, nframes, dim, dtype);
+  }
+
+  // clean up
+  //
+  delete [] buf;
+  close(fd);
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::read_features_raw2(): end of read [%ld bytes]\n",
+	    nchan * nbytes);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_features_raw2
+//
+// arguments:
+//  VVVectorDouble& feat: feature data (input)
+//  char* fn: output filename (input)
+//  RAW_DTYPE dtype: the data type of the stored values (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a version 2 raw file. All channels must have the
+// same number of frames and all frames the same dimension. Half
+// precision and bfloat16 values are rounded to nearest even.
+//
+bool Edf::write_features_raw2(VVVectorDouble& feat_a, char* fn_a,
+			      RAW_DTYPE dtype_a) {
+
+  // declare local variables
+  //
+  long nchan = feat_a.size();
+  long nframes = (nchan > 0) ? (long)feat_a[0].size() : 0;
+  long dim = (nframes > 0) ? (long)feat_a[0][0].size() : 0;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::write_features_raw2(): beginning write [%s]\n",
+	    fn_a);
+  }
+
+  // check the data type
+  //
+  if (Edf::get_raw2_esize(dtype_a) == 0) {
+    fprintf(stdout,
+	    "**> Edf::write_features_raw2(): unsupported data type %ld\n",
+	    (long)dtype_a);
+    return false;
+  }
+
+  // check that the features are dense
+  //
+  for (long i = 0; i < nchan; i++) {
+    if ((long)feat_a[i].size() != nframes) {
+      fprintf(stdout,
+	      "**> Edf::write_features_raw2(): channel %ld has %ld frames\n",
+	      i, (long)feat_a[i].size());
+      return false;
+    }
+    for (long j = 0; j < nframes; j++) {
+      if ((long)feat_a[i][j].size() != dim) {
+	fprintf(stdout,
+		"**> Edf::write_features_raw2(): frame %ld of channel %ld %s\n",
+		j, i, "has the wrong dimension");
+	return false;
+      }
+    }
+  }
+
+  // open the file and write the header
+  //
+  FILE* fp = fopen(fn_a, "w");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::write_features_raw2(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  long cbytes;
+  bool status = Edf::write_raw2_header(fp, cbytes, nchan, nframes, dim,
+				       dtype_a);
+
+  // write each channel as one block, including its padding
+  //
+  long fbytes = dim * Edf::get_raw2_esize(dtype_a);
+  char* buf = new char[cbytes + 1];
+  memset(buf, 0, cbytes);
+
+  for (long i = 0; status && (i < nchan); i++) {
+    for (long j = 0; (dim > 0) && (j < nframes); j++) {
+      Edf::encode_values(buf + j * fbytes, &feat_a[i][j][0], dim, dtype_a);
+    }
+    status &= (fwrite(buf, 1, cbytes, fp) == (size_t)cbytes);
+  }
+
+  // clean up
+  //
+  delete [] buf;
+  if (fclose(fp) != 0) {
+    status = false;
+  }
+
+  if (!status) {
+    fprintf(stdout, "**> Edf::write_features_raw2(): error writing (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::write_features_raw2(): end of write [%ld bytes]\n",
+	    nchan * cbytes);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_features_raw
+//
+// arguments:
+//  VVectorDouble& feat: the selected frames (output)
+//  char* fn: input filename (input)
+//  long chan: the channel index (input)
+//  long start: the first frame (input)
+//  long nframes: the number of frames, or -1 for all remaining (input)
+//
+// return: a logical value indicating status
+//
+// This method reads a range of frames of one channel of a version 2
+// raw file. The frames are contiguous, so they are read with a single
+// pread and the rest of the file is never touched.
+//
+bool Edf::read_features_raw(VVectorDouble& feat_a, char* fn_a, long chan_a,
+			    long start_a, long nframes_a) {
+
+  // declare local variables
+  //
+  long dtype, nchan, nframes, dim;
+  VectorLong offsets;
+
+  // open the file and read the header
+  //
+  int fd = open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::read_features_raw(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  struct stat st;
+  if ((fstat(fd, &st) != 0) ||
+      (!Edf::read_raw2_header(dtype, nchan, nframes, dim, offsets,
+			      fd, st.st_size))) {
+    fprintf(stdout, "**> Edf::read_features_raw(): %s (%s)\n",
+	    "not a version 2 raw file", fn_a);
+    close(fd);
+    return false;
+  }
+
+  // check the range
+  //
+  if (nframes_a < 0) {
+    nframes_a = nframes - start_a;
+  }
+  if ((chan_a < 0) || (chan_a >= nchan) || (start_a < 0) ||
+      (nframes_a < 0) || (start_a + nframes_a > nframes)) {
+    fprintf(stdout,
+	    "**> Edf::read_features_raw(): invalid range [%ld, %ld, %ld]\n",
+	    chan_a, start_a, nframes_a);
+    close(fd);
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::read_features_raw(): channel %ld, frames [%ld, %ld) (%s)\n",
+	    chan_a, start_a, start_a + nframes_a, fn_a);
+  }
+
+  // read the frames
+  //
+  long fbytes = dim * Edf::get_raw2_esize(dtype);
+  long nbytes = nframes_a * fbytes;
+  char* buf = new char[nbytes + 1];
+
+  if (pread(fd, buf, nbytes, offsets[chan_a] + start_a * fbytes) != nbytes) {
+    fprintf(stdout, "**> Edf::read_features_raw(): error reading (%s)\n",
+	    fn_a);
+    delete [] buf;
+    close(fd);
+    return false;
+  }
+  close(fd);
+
+  // convert the frames
+  //
+  Edf::decode_raw2(feat_a, buf, nframes_a, dim, dtype);
+  delete [] buf;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: map_raw
+//
+// arguments:
+//  char* fn: a version 2 raw file (input)
+//
+// return: a logical value indicating status
+//
+// This method maps a version 2 raw file into memory. get_raw_matrix
+// returns a pointer to a channel in the mapping, which stays valid
+// until unmap_raw is called or another file is mapped.
+//
+bool Edf::map_raw(char* fn_a) {
+
+  // release any file that is already mapped
+  //
+  Edf::unmap_raw();
+
+  // open the file and read the header
+  //
+  int fd = open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::map_raw(): error opening (%s)\n", fn_a);
+    return false;
+  }
+
+  struct stat st;
+  if ((fstat(fd, &st) != 0) ||
+      (!Edf::read_raw2_header(rmap_dtype_d, rmap_nchan_d, rmap_nframes_d,
+			      rmap_dim_d, rmap_offset_d, fd, st.st_size))) {
+    fprintf(stdout, "**> Edf::map_raw(): not a version 2 raw file (%s)\n",
+	    fn_a);
+    close(fd);
+    rmap_nchan_d = 0;
+    return false;
+  }
+
+  // map the file
+  //
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    fprintf(stdout, "**> Edf::map_raw(): error in mmap (%s)\n", fn_a);
+    rmap_nchan_d = 0;
+    return false;
+  }
+  rmap_d = (char*)map;
+  rmap_size_d = st.st_size;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout,
+	    "Edf::map_raw(): (nchan, nframes, fdim) %ld %ld %ld (%s)\n",
+	    rmap_nchan_d, rmap_nframes_d, rmap_dim_d, fn_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: unmap_raw
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method releases the file mapped by map_raw.
+//
+bool Edf::unmap_raw() {
+
+  // unmap the file
+  //
+  if (rmap_d != (char*)NULL) {
+    munmap(rmap_d, rmap_size_d);
+    rmap_d = (char*)NULL;
+  }
+  rmap_size_d = 0;
+  rmap_nchan_d = 0;
+  rmap_nframes_d = 0;
+  rmap_dim_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_raw_matrix
+//
+// arguments:
+//  long& nframes: the number of frames (output)
+//  long& dim: the dimension of each frame (output)
+//  long chan: the channel index (input)
+//
+// return: a pointer to the channel data
+//
+// This method returns a view of one channel of the mapped file. The
+// frames are stored one after another and must not be modified.
+// Frame j starts at element j * dim. NULL is returned if the channel
+// is out of range or if the values are not stored as floats (see
+// get_raw_features).
+//
+const float* Edf::get_raw_matrix(long& nframes_a, long& dim_a, long chan_a) {
+
+  // check the channel
+  //
+  if ((chan_a < 0) || (chan_a >= rmap_nchan_d)) {
+    nframes_a = 0;
+    dim_a = 0;
+    return (const float*)NULL;
+  }
+
+  // exit gracefully
+  //
+  nframes_a = rmap_nframes_d;
+  dim_a = rmap_dim_d;
+  if (rmap_dtype_d != RDT_FLOAT32) {
+    return (const float*)NULL;
+  }
+  return (const float*)(rmap_d + rmap_offset_d[chan_a]);
+}
+
+// method: get_raw_features
+//
+// arguments:
+//  VVectorDouble& feat: the features (output)
+//  long chan: the channel index (input)
+//
+// return: a logical value indicating status
+//
+// This method converts one channel of the mapped file to double
+// precision, whatever the data type of the stored values.
+//
+bool Edf::get_raw_features(VVectorDouble& feat_a, long chan_a) {
+
+  // check the channel
+  //
+  if ((chan_a < 0) || (chan_a >= rmap_nchan_d)) {
+    fprintf(stdout, "**> Edf::get_raw_features(): invalid channel %ld\n",
+	    chan_a);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return Edf::decode_raw2(feat_a, rmap_d + rmap_offset_d[chan_a],
+			  rmap_nframes_d, rmap_dim_d, rmap_dtype_d);
+}
+
+// method: read_raw2_header
+//
+// arguments:
+//  long& dtype: the data type (output)
+//  long& nchan: the number of channels (output)
+//  long& nframes: the number of frames (output)
+//  long& dim: the feature dimension (output)
+//  VectorLong& offsets: the offset of each channel (output)
+//  int fd: an open file (input)
+//  long fsize: the size of the file in bytes (input)
+//
+// return: a logical value indicating status
+//
+// This method reads the header and the channel table of a version 2
+// raw file, and checks that every channel lies within the file.
+//
+bool Edf::read_raw2_header(long& dtype_a, long& nchan_a, long& nframes_a,
+			   long& dim_a, VectorLong& offsets_a,
+			   int fd_a, long fsize_a) {
+
+  // read and check the header
+  //
+  unsigned char hdr[RAW2_HEADER_SIZE];
+  if ((pread(fd_a, hdr, RAW2_HEADER_SIZE, 0) != RAW2_HEADER_SIZE) ||
+      (!Edf::is_raw2(hdr, RAW2_HEADER_SIZE))) {
+    return false;
+  }
+
+  int32_t ival[5];
+  int64_t itab;
+  memcpy(ival, hdr + 4, sizeof(ival));
+  memcpy(&itab, hdr + 24, sizeof(itab));
+
+  dtype_a = ival[0];
+  nchan_a = ival[1];
+  nframes_a = ival[2];
+  dim_a = ival[3];
+
+  if ((Edf::get_raw2_esize(dtype_a) == 0) || (nchan_a < 0) ||
+      (nframes_a < 0) || (dim_a < 0) || (itab < RAW2_HEADER_SIZE) ||
+      (itab + nchan_a * (long)sizeof(int64_t) > fsize_a)) {
+    return false;
+  }
+
+  // read the channel table and check each channel
+  //
+  long nbytes = nframes_a * dim_a * Edf::get_raw2_esize(dtype_a);
+  int64_t* tab = new int64_t[nchan_a + 1];
+  long tbytes = nchan_a * sizeof(int64_t);
+
+  if (pread(fd_a, tab, tbytes, itab) != tbytes) {
+    delete [] tab;
+    return false;
+  }
+
+  Edf::resize(offsets_a, nchan_a, false);
+  for (long i = 0; i < nchan_a; i++) {
+    if ((tab[i] < itab + tbytes) || (tab[i] + nbytes > fsize_a)) {
+      delete [] tab;
+      return false;
+    }
+    offsets_a[i] = tab[i];
+  }
+  delete [] tab;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: decode_raw2
+//
+// arguments:
+//  VVectorDouble& feat: the features (output)
+//  const char* data: the frames as stored in the file (input)
+//  long nframes: the number of frames (input)
+//  long dim: the dimension of each frame (input)
+//  long dtype: the data type (input)
+//
+// return: a logical value indicating status
+//
+// This method converts frames of a version 2 raw file to double
+// precision.
+//
+bool Edf::decode_raw2(VVectorDouble& feat_a, const char* data_a,
+		      long nframes_a, long dim_a, long dtype_a) {
+
+  // check the data type
+  //
+  long esize = Edf::get_raw2_esize(dtype_a);
+  if (esize == 0) {
+    fprintf(stdout, "**> Edf::decode_raw2(): unsupported data type %ld\n",
+	    dtype_a);
+    return false;
+  }
+
+  // loop over all frames
+  //
+  Edf::resize(feat_a, nframes_a, false);
+  for (long j = 0; j < nframes_a; j++) {
+    Edf::resize(feat_a[j], dim_a, false);
+    if (dim_a > 0) {
+      Edf::decode_values(&feat_a[j][0], data_a + j * dim_a * esize, dim_a,
+			 dtype_a);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_raw2_header
+//
+// arguments:
+//  FILE* fp: the output file (input)
+//  long& cbytes: the bytes used by each channel, with padding (output)
+//  long nchan: the number of channels (input)
+//  long nframes: the number of frames (input)
+//  long dim: the feature dimension (input)
+//  long dtype: the data type (input)
+//
+// return: a logical value indicating status
+//
+// This method writes the header and the channel table of a version 2
+// raw file, padded so that the first channel is aligned. The channels
+// must then be written in order, each padded to cbytes.
+//
+bool Edf::write_raw2_header(FILE* fp_a, long& cbytes_a, long nchan_a,
+			    long nframes_a, long dim_a, long dtype_a) {
+
+  // compute the offset of each channel
+  //
+  long nbytes = nframes_a * dim_a * Edf::get_raw2_esize(dtype_a);
+  long table = RAW2_HEADER_SIZE;
+  long data = table + nchan_a * sizeof(int64_t);
+  data = ((data + RAW2_ALIGN - 1) / RAW2_ALIGN) * RAW2_ALIGN;
+  cbytes_a = ((nbytes + RAW2_ALIGN - 1) / RAW2_ALIGN) * RAW2_ALIGN;
+
+  // build the header and the table
+  //
+  char* hdr = new char[data];
+  int32_t ival[5] = {(int32_t)dtype_a, (int32_t)nchan_a,
+		     (int32_t)nframes_a, (int32_t)dim_a, 0};
+  int64_t itab = table;
+
+  memset(hdr, 0, data);
+  memcpy(hdr, RAW2_MAGIC, strlen(RAW2_MAGIC));
+  memcpy(hdr + 4, ival, sizeof(ival));
+  memcpy(hdr + 24, &itab, sizeof(itab));
+
+  for (long i = 0; i < nchan_a; i++) {
+    int64_t offset = data + i * cbytes_a;
+    memcpy(hdr + table + i * sizeof(int64_t), &offset, sizeof(offset));
+  }
+
+  // write them
+  //
+  bool status = (fwrite(hdr, 1, data, fp_a) == (size_t)data);
+  delete [] hdr;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: encode_values
+//
+// arguments:
+//  char* y: the values as stored in the file (output)
+//  const double* x: the values (input)
+//  long n: the number of values (input)
+//  long dtype: the data type (input)
+//
+// return: a logical value indicating status
+//
+// This method converts contiguous values to a stored data type. Half
+// precision values are converted in blocks of RAW2_BLOCK.
+//
+bool Edf::encode_values(char* y_a, const double* x_a, long n_a,
+			long dtype_a) {
+
+  // floats are converted directly
+  //
+  if (dtype_a == RDT_FLOAT32) {
+    float* y = (float*)y_a;
+    for (long i = 0; i < n_a; i++) {
+      y[i] = x_a[i];
+    }
+    return true;
+  }
+
+  // half precision values go through a block of floats
+  //
+  float tmp[RAW2_BLOCK];
+  uint16_t* y = (uint16_t*)y_a;
+  for (long i = 0; i < n_a; i += RAW2_BLOCK) {
+    long m = Edf::min(RAW2_BLOCK, n_a - i);
+    for (long k = 0; k < m; k++) {
+      tmp[k] = x_a[i + k];
+    }
+    Edf::encode_half(y + i, tmp, m, dtype_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: decode_values
+//
+// arguments:
+//  double* y: the values (output)
+//  const char* x: the values as stored in the file (input)
+//  long n: the number of values (input)
+//  long dtype: the data type (input)
+//
+// return: a logical value indicating status
+//
+// This method converts contiguous stored values to double precision.
+// x need not be aligned (a Kaldi matrix starts right after its key):
+// floats are loaded with memcpy, and half precision values are copied
+// into an aligned block when x is not aligned.
+//
+bool Edf::decode_values(double* y_a, const char* x_a, long n_a,
+			long dtype_a) {
+
+  // floats are converted directly
+  //
+  if (dtype_a == RDT_FLOAT32) {
+    float val;
+    for (long i = 0; i < n_a; i++) {
+      memcpy(&val, x_a + i * sizeof(float), sizeof(float));
+      y_a[i] = val;
+    }
+    return true;
+  }
+
+  // half precision values go through a block of floats
+  //
+  float tmp[RAW2_BLOCK];
+  uint16_t htmp[RAW2_BLOCK];
+  bool aligned = (((uintptr_t)x_a % sizeof(uint16_t)) == 0);
+  for (long i = 0; i < n_a; i += RAW2_BLOCK) {
+    long m = Edf::min(RAW2_BLOCK, n_a - i);
+    if (aligned) {
+      Edf::decode_half(tmp, (const uint16_t*)x_a + i, m, dtype_a);
+    }
+    else {
+      memcpy(htmp, x_a + i * sizeof(uint16_t), m * sizeof(uint16_t));
+      Edf::decode_half(tmp, htmp, m, dtype_a);
+    }
+    for (long k = 0; k < m; k++) {
+      y_a[i + k] = tmp[k];
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: is_raw2
+//
+// arguments:
+//  const unsigned char* buf: the start of a file (input)
+//  long n: the number of bytes in buf (input)
+//
+// return: a boolean value that is true if buf holds a version 2 header
+//
+// This method checks for the magic string of a version 2 raw file.
+// Version 1 files start with the number of channels, which can never
+// match it.
+//
+bool Edf::is_raw2(const unsigned char* buf_a, long n_a) {
+  long len = strlen(RAW2_MAGIC);
+  return ((n_a >= RAW2_HEADER_SIZE) && (memcmp(buf_a, RAW2_MAGIC, len) == 0));
+}
+
+// method: get_raw2_esize
+//
+// arguments:
+//  long dtype: the data type (input)
+//
+// return: the number of bytes per value, or 0 for an unknown type
+//
+// This method returns the size of a stored value.
+//
+long Edf::get_raw2_esize(long dtype_a) {
+  if (dtype_a == RDT_FLOAT32) {
+    return sizeof(float);
+  }
+  else if ((dtype_a == RDT_FLOAT16) || (dtype_a == RDT_BFLOAT16)) {
+    return sizeof(uint16_t);
+  }
+  return 0;
+}
+
+// method: encode_half
+//
+// arguments:
+//  uint16_t* y: the packed values (output)
+//  const float* x: the values to pack (input)
+//  long n: the number of values (input)
+//  long dtype: RDT_FLOAT16 or RDT_BFLOAT16 (input)
+//
+// return: a logical value indicating status
+//
+// This method rounds floats to half precision or bfloat16 values,
+// to nearest even. Values are processed in order, so y may point to
+// the same memory as x. Half precision overflows to infinity and
+// small values become subnormal, as with the F16C instructions.
+//
+bool Edf::encode_half(uint16_t* y_a, const float* x_a, long n_a,
+		      long dtype_a) {
+
+  // bfloat16: round the upper half of each float
+  //
+  if (dtype_a == RDT_BFLOAT16) {
+    for (long i = 0; i < n_a; i++) {
+      uint32_t f;
+      memcpy(&f, x_a + i, sizeof(f));
+      uint32_t r = (f + 0x7fff + ((f >> 16) & 1)) >> 16;
+      y_a[i] = ((f & 0x7fffffff) > 0x7f800000) ? ((f >> 16) | 0x40) : r;
+    }
+    return true;
+  }
+
+  // half precision: convert eight values at a time when possible
+  //
+  long i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= n_a; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(x_a + i),
+				_MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128((__m128i*)(y_a + i), h);
+  }
+#endif
+
+  for (; i < n_a; i++) {
+    uint32_t f;
+    memcpy(&f, x_a + i, sizeof(f));
+    uint32_t sign = (f >> 16) & 0x8000;
+    uint32_t a = f & 0x7fffffff;
+
+    // infinity and nan
+    //
+    if (a >= 0x7f800000) {
+      y_a[i] = sign | 0x7c00 | ((a > 0x7f800000) ? 0x200 : 0);
+    }
+
+    // values that round beyond the largest half
+    //
+    else if (a >= 0x477ff000) {
+      y_a[i] = sign | 0x7c00;
+    }
+
+    // subnormal halves: let the floating point unit round by adding
+    // 0.5, whose unit in the last place is the half subnormal step
+    //
+    else if (a < 0x38800000) {
+      float v;
+      memcpy(&v, &a, sizeof(v));
+      v += 0.5f;
+      uint32_t b;
+      memcpy(&b, &v, sizeof(b));
+      y_a[i] = sign | (b - 0x3f000000);
+    }
+
+    // normal halves: rebias the exponent and round
+    //
+    else {
+      a += 0xc8000fff + ((a >> 13) & 1);
+      y_a[i] = sign | (a >> 13);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: decode_half
+//
+// arguments:
+//  float* y: the expanded values (output)
+//  const uint16_t* x: the packed values (input)
+//  long n: the number of values (input)
+//  long dtype: RDT_FLOAT16 or RDT_BFLOAT16 (input)
+//
+// return: a logical value indicating status
+//
+// This method expands half precision or bfloat16 values to floats.
+// The conversion is exact.
+//
+bool Edf::decode_half(float* y_a, const uint16_t* x_a, long n_a,
+		      long dtype_a) {
+
+  // bfloat16: the value is the upper half of a float
+  //
+  if (dtype_a == RDT_BFLOAT16) {
+    for (long i = 0; i < n_a; i++) {
+      uint32_t f = (uint32_t)x_a[i] << 16;
+      memcpy(y_a + i, &f, sizeof(f));
+    }
+    return true;
+  }
+
+  // half precision: convert eight values at a time when possible
+  //
+  long i = 0;
+#if defined(__F16C__)
+  for (; i + 8 <= n_a; i += 8) {
+    __m128i h = _mm_loadu_si128((const __m128i*)(x_a + i));
+    _mm256_storeu_ps(y_a + i, _mm256_cvtph_ps(h));
+  }
+#endif
+
+  for (; i < n_a; i++) {
+    uint32_t h = x_a[i];
+    uint32_t sign = (h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t f;
+
+    // infinity and nan (nans are made quiet)
+    //
+    if (exp == 0x1f) {
+      f = sign | 0x7f800000 | (mant << 13) | ((mant != 0) ? 0x400000 : 0);
+    }
+
+    // zero and subnormals: scale the mantissa by 2^-24
+    //
+    else if (exp == 0) {
+      float v = (float)mant * 5.9604644775390625e-8f;
+      memcpy(&f, &v, sizeof(f));
+      f |= sign;
+    }
+
+    // normal values: rebias the exponent
+    //
+    else {
+      f = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    memcpy(y_a + i, &f, sizeof(f));
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
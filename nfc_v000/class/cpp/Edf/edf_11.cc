@@ -0,0 +1,746 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_11.cc
+//
+// This file contains methods associated with the class Edf that
+// write and read shuffled training shards.
+//
+// A shard is named "<base>_NNNNN.shd" and is written in the byte order
+// of the machine in the following order:
+//
+//  (1) example #0: frame #0, frame #1, ...  (4-byte floats)
+//      example #1: ...
+//  (2) one record per example (SHARD_RECORD_SIZE bytes):
+//      offset of the example                (8-byte int)
+//      number of frames                     (4-byte int)
+//      feature dimension                    (4-byte int)
+//      channel                              (4-byte int)
+//      label                                (4-byte int)
+//      start time in secs                   (8-byte double)
+//      offset of the filename in (3)        (4-byte int)
+//      reserved                             (4-byte int)
+//  (3) the filenames, each terminated by a null
+//  (4) trailer (SHARD_TRAILER_SIZE bytes):
+//      offset of (2)                        (8-byte int)
+//      number of examples                   (8-byte int)
+//      size of (3) in bytes                 (8-byte int)
+//      magic string SHARD_MAGIC             (4 bytes)
+//      reserved                             (4-byte int)
+//
+// Examples are drawn at random when a shard is written, so reading
+// the shards in order visits the examples in shuffled order with large
+// sequential reads.
+//
+
+// system include files
+//
+#include <algorithm>
+
+// local include files
+//
+#include "Edf.h"
+
+// method: open_shard_writer
+//
+// arguments:
+//  char* base: the base of the shard filenames (input)
+//  long nframes: frames per example, or 0 for whole channels (input)
+//  long shard_size: the number of examples per shard (input)
+//  long seed: the seed of the shuffle (input)
+//
+// return: a logical value indicating status
+//
+// This method starts a set of shards. Examples are added with
+// add_examples or add_example, and wait in a pool of SHARD_NPOOL
+// shards. Each time the pool fills, a shard is drawn from it at random
+// and written. The remaining examples are written by
+// close_shard_writer, so only the last shard can be short.
+//
+bool Edf::open_shard_writer(char* base_a, long nframes_a, long shard_size_a,
+			    long seed_a) {
+
+  // close any writer that is still open
+  //
+  Edf::close_shard_writer();
+
+  // check the arguments
+  //
+  if ((strlen(base_a) > MAX_LSTR_LENGTH - 16) || (shard_size_a <= 0) ||
+      (nframes_a < 0)) {
+    fprintf(stdout, "**> Edf::open_shard_writer(): invalid arguments\n");
+    return false;
+  }
+
+  // save the parameters and seed the generator as srand48 does
+  //
+  strcpy(shard_base_d, base_a);
+  shard_num_d = 0;
+  shard_size_d = shard_size_a;
+  shard_nframes_d = nframes_a;
+  shard_seed_d[0] = 0x330e;
+  shard_seed_d[1] = (unsigned short)(seed_a & 0xffff);
+  shard_seed_d[2] = (unsigned short)((seed_a >> 16) & 0xffff);
+
+  // size the pool
+  //
+  long npool = SHARD_NPOOL * shard_size_d;
+  shard_npool_d = 0;
+  Edf::resize(shard_pool_d, npool, false);
+  Edf::resize(shard_file_d, npool, false);
+  Edf::resize(shard_chan_d, npool, false);
+  Edf::resize(shard_label_d, npool, false);
+  Edf::resize(shard_start_d, npool, false);
+  shard_nbytes_d = 0;
+  shard_last_d = -1;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::open_shard_writer(): %ld examples per shard (%s)\n",
+	    shard_size_d, shard_base_d);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: add_examples
+//
+// arguments:
+//  VVVectorDouble& feat: the features of a file (input)
+//  char* fname: the file the features came from (input)
+//  long label: the label of the examples (input)
+//
+// return: a logical value indicating status
+//
+// This method cuts each channel into examples of the number of frames
+// given to open_shard_writer. Frames that do not fill an example are
+// dropped. The start time of an example is its first frame times the
+// frame duration.
+//
+bool Edf::add_examples(VVVectorDouble& feat_a, char* fname_a, long label_a) {
+
+  // declare local variables
+  //
+  VVectorDouble ex;
+
+  // loop over all channels and windows
+  //
+  for (long i = 0; i < (long)feat_a.size(); i++) {
+    long nfr = feat_a[i].size();
+    long win = (shard_nframes_d > 0) ? shard_nframes_d : nfr;
+    if (win == 0) {
+      continue;
+    }
+
+    Edf::resize(ex, win, false);
+    for (long j = 0; j + win <= nfr; j += win) {
+      for (long k = 0; k < win; k++) {
+	ex[k] = feat_a[i][j + k];
+      }
+      if (!Edf::add_example(ex, fname_a, i, j * fdur_d, label_a)) {
+	return false;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: add_example
+//
+// arguments:
+//  VVectorDouble& ex: the frames of the example (input)
+//  char* fname: the file the example came from (input)
+//  long chan: the channel of the example (input)
+//  double start: the start time of the example in secs (input)
+//  long label: the label of the example (input)
+//
+// return: a logical value indicating status
+//
+// This method adds one example to the pool, writing a shard if the
+// pool is full. All frames of an example must have the same dimension.
+//
+bool Edf::add_example(VVectorDouble& ex_a, char* fname_a, long chan_a,
+		      double start_a, long label_a) {
+
+  // check the writer and the example
+  //
+  if (shard_base_d[0] == (char)NULL) {
+    fprintf(stdout, "**> Edf::add_example(): no shard writer is open\n");
+    return false;
+  }
+
+  long dim = (ex_a.size() > 0) ? (long)ex_a[0].size() : 0;
+  for (long j = 1; j < (long)ex_a.size(); j++) {
+    if ((long)ex_a[j].size() != dim) {
+      fprintf(stdout,
+	      "**> Edf::add_example(): frame %ld has the wrong dimension\n",
+	      j);
+      return false;
+    }
+  }
+
+  // store the filename once for consecutive examples of a file
+  //
+  if ((shard_last_d < 0) ||
+      (strcmp(shard_names_d + shard_last_d, fname_a) != 0)) {
+    long len = strlen(fname_a) + 1;
+    if (shard_nbytes_d + len > shard_ncap_d) {
+      long ncap = 2 * (shard_nbytes_d + len) + MAX_LSTR_LENGTH;
+      char* names = new char[ncap];
+      if (shard_names_d != (char*)NULL) {
+	memcpy(names, shard_names_d, shard_nbytes_d);
+	delete [] shard_names_d;
+      }
+      shard_names_d = names;
+      shard_ncap_d = ncap;
+    }
+    memcpy(shard_names_d + shard_nbytes_d, fname_a, len);
+    shard_last_d = shard_nbytes_d;
+    shard_nbytes_d += len;
+  }
+
+  // add the example to the pool
+  //
+  long n = shard_npool_d++;
+  shard_pool_d[n] = ex_a;
+  shard_file_d[n] = shard_last_d;
+  shard_chan_d[n] = chan_a;
+  shard_label_d[n] = label_a;
+  shard_start_d[n] = start_a;
+
+  // write a shard when the pool is full
+  //
+  if (shard_npool_d == (long)shard_pool_d.size()) {
+    return Edf::write_shard(shard_size_d);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_shard_writer
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method writes the examples left in the pool and releases the
+// pool.
+//
+bool Edf::close_shard_writer() {
+
+  // declare local variables
+  //
+  bool status = true;
+
+  // check if a writer is open
+  //
+  if (shard_base_d[0] == (char)NULL) {
+    return true;
+  }
+
+  // flush the pool
+  //
+  while (status && (shard_npool_d > 0)) {
+    status = Edf::write_shard(Edf::min(shard_size_d, shard_npool_d));
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::close_shard_writer(): %ld shards (%s)\n",
+	    shard_num_d, shard_base_d);
+  }
+
+  // release the pool
+  //
+  shard_base_d[0] = (char)NULL;
+  shard_npool_d = 0;
+  Edf::resize(shard_pool_d, 0, false);
+  if (shard_names_d != (char*)NULL) {
+    delete [] shard_names_d;
+    shard_names_d = (char*)NULL;
+  }
+  shard_nbytes_d = 0;
+  shard_ncap_d = 0;
+  shard_last_d = -1;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: open_shard_reader
+//
+// arguments:
+//  char* base: the base of the shard filenames (input)
+//
+// return: a logical value indicating status
+//
+// This method prepares to read the shards written with this base, in
+// order. Only one shard is held in memory at a time.
+//
+bool Edf::open_shard_reader(char* base_a) {
+
+  // close any reader that is still open
+  //
+  Edf::close_shard_reader();
+
+  // check the base
+  //
+  if (strlen(base_a) > MAX_LSTR_LENGTH - 16) {
+    fprintf(stdout, "**> Edf::open_shard_reader(): filename too long\n");
+    return false;
+  }
+  strcpy(shard_rbase_d, base_a);
+  shard_rnum_d = 0;
+
+  // open the first shard
+  //
+  if (!Edf::open_next_shard()) {
+    fprintf(stdout, "**> Edf::open_shard_reader(): no shards for (%s)\n",
+	    base_a);
+    shard_rbase_d[0] = (char)NULL;
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_shard
+//
+// arguments:
+//  VVVectorDouble& ex: the examples of the shard (output)
+//  long& nex: the number of examples (output)
+//
+// return: a logical value indicating status
+//
+// This method reads the next shard with one sequential read and
+// starts prefetching the shard after it. false is returned, with nex
+// set to zero, after the last shard. The metadata of the examples is
+// available through get_shard_info until the next call.
+//
+bool Edf::read_shard(VVVectorDouble& ex_a, long& nex_a) {
+
+  // declare local variables
+  //
+  char fname[MAX_LSTR_LENGTH + 1];
+
+  // check for the end of the shards
+  //
+  nex_a = 0;
+  shard_nex_d = 0;
+  if (shard_fd_d < 0) {
+    return false;
+  }
+  Edf::create_shard_name(fname, shard_rbase_d, shard_rnum_d);
+
+  // read the whole shard
+  //
+  struct stat st;
+  if (fstat(shard_fd_d, &st) != 0) {
+    fprintf(stdout, "**> Edf::read_shard(): error in fstat (%s)\n", fname);
+    return false;
+  }
+  long fsize = st.st_size;
+
+  if (fsize > shard_bsize_d) {
+    if (shard_buf_d != (char*)NULL) {
+      delete [] shard_buf_d;
+    }
+    shard_buf_d = new char[fsize];
+    shard_bsize_d = fsize;
+  }
+
+  long nread = 0;
+  while (nread < fsize) {
+    long n = read(shard_fd_d, shard_buf_d + nread, fsize - nread);
+    if (n <= 0) {
+      break;
+    }
+    nread += n;
+  }
+  close(shard_fd_d);
+  shard_fd_d = -1;
+
+  // start reading the next shard in the background
+  //
+  shard_rnum_d++;
+  Edf::open_next_shard();
+
+  // check the trailer
+  //
+  int64_t trl[3];
+  if ((nread != fsize) || (fsize < SHARD_TRAILER_SIZE) ||
+      (memcmp(shard_buf_d + fsize - SHARD_TRAILER_SIZE + sizeof(trl),
+	      SHARD_MAGIC, strlen(SHARD_MAGIC)) != 0)) {
+    fprintf(stdout, "**> Edf::read_shard(): invalid shard (%s)\n", fname);
+    return false;
+  }
+  memcpy(trl, shard_buf_d + fsize - SHARD_TRAILER_SIZE, sizeof(trl));
+
+  // bound each part by the file size so that their sum cannot overflow
+  //
+  if ((trl[0] < 0) || (trl[1] < 0) || (trl[2] < 0) ||
+      (trl[0] > fsize) || (trl[1] > fsize / SHARD_RECORD_SIZE) ||
+      (trl[2] > fsize) ||
+      (trl[0] + trl[1] * SHARD_RECORD_SIZE + trl[2] + SHARD_TRAILER_SIZE !=
+       fsize)) {
+    fprintf(stdout, "**> Edf::read_shard(): invalid footer (%s)\n", fname);
+    return false;
+  }
+
+  // convert the examples
+  //
+  Edf::resize(ex_a, trl[1], false);
+  for (long i = 0; i < trl[1]; i++) {
+    const char* rec = shard_buf_d + trl[0] + i * SHARD_RECORD_SIZE;
+    int64_t offset;
+    int32_t shape[2];
+    memcpy(&offset, rec, sizeof(offset));
+    memcpy(shape, rec + 8, sizeof(shape));
+
+    if ((offset < 0) || (shape[0] < 0) || (shape[1] < 0) ||
+	(offset + (long)shape[0] * shape[1] * (long)sizeof(float) > trl[0])) {
+      fprintf(stdout, "**> Edf::read_shard(): invalid example %ld (%s)\n",
+	      i, fname);
+      return false;
+    }
+    Edf::decode_raw2(ex_a[i], shard_buf_d + offset, shape[0], shape[1],
+		     RDT_FLOAT32);
+  }
+
+  shard_nex_d = trl[1];
+  shard_footer_d = trl[0];
+  shard_nnames_d = trl[2];
+  nex_a = shard_nex_d;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::read_shard(): %ld examples [%ld bytes] (%s)\n",
+	    nex_a, fsize, fname);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_shard_info
+//
+// arguments:
+//  char* fname: the file of the example (output)
+//  long& chan: the channel of the example (output)
+//  double& start: the start time of the example in secs (output)
+//  long& label: the label of the example (output)
+//  long index: the example in the last shard read (input)
+//
+// return: a logical value indicating status
+//
+// This method returns the metadata of an example. fname, if not NULL,
+// must hold MAX_LSTR_LENGTH + 1 characters.
+//
+bool Edf::get_shard_info(char* fname_a, long& chan_a, double& start_a,
+			 long& label_a, long index_a) {
+
+  // check the index
+  //
+  if ((index_a < 0) || (index_a >= shard_nex_d)) {
+    fprintf(stdout, "**> Edf::get_shard_info(): invalid index %ld\n",
+	    index_a);
+    return false;
+  }
+
+  // decode the record
+  //
+  const char* rec = shard_buf_d + shard_footer_d + index_a * SHARD_RECORD_SIZE;
+  int32_t ival[2];
+  int32_t name;
+  double start;
+  memcpy(ival, rec + 16, sizeof(ival));
+  memcpy(&start, rec + 24, sizeof(start));
+  memcpy(&name, rec + 32, sizeof(name));
+
+  chan_a = ival[0];
+  label_a = ival[1];
+  start_a = start;
+
+  // copy the filename:
+  //  the offset comes from the file, so it must point into the table
+  //  of filenames and the name must be terminated within it
+  //
+  if (fname_a != (char*)NULL) {
+    const char* names = shard_buf_d + shard_footer_d +
+      shard_nex_d * SHARD_RECORD_SIZE;
+    if ((name < 0) || (name >= shard_nnames_d) ||
+	(memchr(names + name, (char)NULL, shard_nnames_d - name) ==
+	 (void*)NULL)) {
+      fprintf(stdout, "**> Edf::get_shard_info(): %s %ld (%ld)\n",
+	      "invalid filename offset", (long)name, index_a);
+      return false;
+    }
+    strncpy(fname_a, names + name, MAX_LSTR_LENGTH);
+    fname_a[MAX_LSTR_LENGTH] = (char)NULL;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_shard_reader
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method closes any prefetched shard and releases the buffer.
+//
+bool Edf::close_shard_reader() {
+
+  // close the next shard
+  //
+  if (shard_fd_d >= 0) {
+    close(shard_fd_d);
+    shard_fd_d = -1;
+  }
+
+  // release the buffer
+  //
+  if (shard_buf_d != (char*)NULL) {
+    delete [] shard_buf_d;
+    shard_buf_d = (char*)NULL;
+  }
+  shard_bsize_d = 0;
+  shard_nex_d = 0;
+  shard_footer_d = 0;
+  shard_nnames_d = 0;
+  shard_rbase_d[0] = (char)NULL;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_shard
+//
+// arguments:
+//  long nex: the number of examples to write (input)
+//
+// return: a logical value indicating status
+//
+// This method draws nex examples at random from the pool and writes
+// them as the next shard. The drawn examples are swapped to the end
+// of the pool, which is then shortened.
+//
+bool Edf::write_shard(long nex_a) {
+
+  // declare local variables
+  //
+  char fname[MAX_LSTR_LENGTH + 1];
+
+  // draw the examples: a partial Fisher-Yates shuffle
+  //
+  long first = shard_npool_d - nex_a;
+  for (long i = shard_npool_d - 1; i >= first; i--) {
+    long r = (long)(erand48(shard_seed_d) * (i + 1));
+    if (r != i) {
+      shard_pool_d[r].swap(shard_pool_d[i]);
+      std::swap(shard_file_d[r], shard_file_d[i]);
+      std::swap(shard_chan_d[r], shard_chan_d[i]);
+      std::swap(shard_label_d[r], shard_label_d[i]);
+      std::swap(shard_start_d[r], shard_start_d[i]);
+    }
+  }
+
+  // open the shard
+  //
+  if (!Edf::create_shard_name(fname, shard_base_d, shard_num_d++)) {
+    return false;
+  }
+  FILE* fp = fopen(fname, "w");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::write_shard(): error opening (%s)\n", fname);
+    return false;
+  }
+
+  // write the examples and build the records
+  //
+  char* recs = new char[nex_a * SHARD_RECORD_SIZE + 1];
+  long* gname = new long[nex_a + 1];
+  long* lname = new long[nex_a + 1];
+  long nnames = 0;
+  long nbytes = 0;
+  int64_t offset = 0;
+  bool status = true;
+
+  float* y = (float*)NULL;
+  long ysize = 0;
+  for (long i = 0; i < nex_a; i++) {
+    long n = first + i;
+    VVectorDouble& ex = shard_pool_d[n];
+    int32_t rows = ex.size();
+    int32_t cols = (rows > 0) ? (int32_t)ex[0].size() : 0;
+
+    // convert the frames to floats
+    //
+    long nval = (long)rows * cols;
+    if (nval > ysize) {
+      if (y != (float*)NULL) {
+	delete [] y;
+      }
+      y = new float[nval];
+      ysize = nval;
+    }
+    if (nval > 0) {
+      for (long j = 0; j < rows; j++) {
+	for (long k = 0; k < cols; k++) {
+	  y[j * cols + k] = ex[j][k];
+	}
+      }
+      status &= (fwrite(y, sizeof(float), nval, fp) == (size_t)nval);
+    }
+
+    // locate the filename in the table of this shard
+    //
+    long j = 0;
+    while ((j < nnames) && (gname[j] != shard_file_d[n])) {
+      j++;
+    }
+    if (j == nnames) {
+      gname[j] = shard_file_d[n];
+      lname[j] = nbytes;
+      nbytes += strlen(shard_names_d + shard_file_d[n]) + 1;
+      nnames++;
+    }
+
+    // fill the record
+    //
+    char* rec = recs + i * SHARD_RECORD_SIZE;
+    int32_t ival[4] = {rows, cols, (int32_t)shard_chan_d[n],
+		       (int32_t)shard_label_d[n]};
+    int32_t name[2] = {(int32_t)lname[j], 0};
+    double start = shard_start_d[n];
+    memcpy(rec, &offset, sizeof(offset));
+    memcpy(rec + 8, ival, sizeof(ival));
+    memcpy(rec + 24, &start, sizeof(start));
+    memcpy(rec + 32, name, sizeof(name));
+
+    offset += nval * sizeof(float);
+  }
+
+  // write the footer and the trailer
+  //
+  status &= (fwrite(recs, SHARD_RECORD_SIZE, nex_a, fp) == (size_t)nex_a);
+  for (long j = 0; j < nnames; j++) {
+    const char* str = shard_names_d + gname[j];
+    long len = strlen(str) + 1;
+    status &= (fwrite(str, 1, len, fp) == (size_t)len);
+  }
+
+  char trl[SHARD_TRAILER_SIZE];
+  int64_t ival[3] = {offset, nex_a, nbytes};
+  memset(trl, 0, SHARD_TRAILER_SIZE);
+  memcpy(trl, ival, sizeof(ival));
+  memcpy(trl + sizeof(ival), SHARD_MAGIC, strlen(SHARD_MAGIC));
+  status &= (fwrite(trl, 1, SHARD_TRAILER_SIZE, fp) ==
+	     (size_t)SHARD_TRAILER_SIZE);
+
+  // clean up
+  //
+  if (y != (float*)NULL) {
+    delete [] y;
+  }
+  delete [] recs;
+  delete [] gname;
+  delete [] lname;
+  if (fclose(fp) != 0) {
+    status = false;
+  }
+  if (!status) {
+    fprintf(stdout, "**> Edf::write_shard(): error writing (%s)\n", fname);
+    return false;
+  }
+
+  // release the examples
+  //
+  for (long n = first; n < shard_npool_d; n++) {
+    Edf::resize(shard_pool_d[n], 0, false);
+  }
+  shard_npool_d = first;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::write_shard(): %ld examples (%s)\n", nex_a, fname);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: create_shard_name
+//
+// arguments:
+//  char* fname: the shard filename (output)
+//  char* base: the base of the shard filenames (input)
+//  long num: the shard number (input)
+//
+// return: a logical value indicating status
+//
+// This method creates the filename of a shard: "<base>_NNNNN.shd".
+// fname must hold MAX_LSTR_LENGTH + 1 characters. false is returned if
+// the name does not fit.
+//
+bool Edf::create_shard_name(char* fname_a, char* base_a, long num_a) {
+  if (snprintf(fname_a, MAX_LSTR_LENGTH + 1, "%s_%05ld.%s", base_a, num_a,
+	       SHARD_EXT) > (int)MAX_LSTR_LENGTH) {
+    fprintf(stdout, "**> Edf::create_shard_name(): filename too long\n");
+    return false;
+  }
+  return true;
+}
+
+// method: open_next_shard
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method opens shard shard_rnum_d, if it exists, and asks the
+// kernel to start reading it so that it is in memory by the time
+// read_shard needs it.
+//
+bool Edf::open_next_shard() {
+
+  // open the shard
+  //
+  char fname[MAX_LSTR_LENGTH + 1];
+  if (!Edf::create_shard_name(fname, shard_rbase_d, shard_rnum_d)) {
+    return false;
+  }
+  shard_fd_d = open(fname, O_RDONLY);
+  if (shard_fd_d < 0) {
+    return false;
+  }
+
+  // prefetch it
+  //
+  posix_fadvise(shard_fd_d, 0, 0, POSIX_FADV_SEQUENTIAL);
+  posix_fadvise(shard_fd_d, 0, 0, POSIX_FADV_WILLNEED);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
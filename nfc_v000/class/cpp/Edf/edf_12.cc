@@ -0,0 +1,944 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_12.cc
+//
+// This file contains the methods of the class FeatureTensor and the
+// methods of the class Edf that read and write feature tensors.
+//
+// Raw, raw v2 and Kaldi float matrices are converted directly between
+// the file and the tensor. HTK files and Kaldi compressed matrices are
+// converted through nested vectors.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+//-----------------------------------------------------------------------------
+//
+// FeatureTensor methods
+//
+//-----------------------------------------------------------------------------
+
+// method: default constructor
+//
+// arguments: none
+//
+// return: none
+//
+FeatureTensor::FeatureTensor() {
+  nchan_d = 0;
+  nframes_d = 0;
+  dim_d = 0;
+  cstride_d = 0;
+  fstride_d = 0;
+  size_d = 0;
+  data_d = (double*)NULL;
+}
+
+// method: copy constructor
+//
+// arguments:
+//  const FeatureTensor& ft: the tensor to copy (input)
+//
+// return: none
+//
+FeatureTensor::FeatureTensor(const FeatureTensor& ft_a) {
+  nchan_d = 0;
+  nframes_d = 0;
+  dim_d = 0;
+  cstride_d = 0;
+  fstride_d = 0;
+  size_d = 0;
+  data_d = (double*)NULL;
+  *this = ft_a;
+}
+
+// method: assignment operator
+//
+// arguments:
+//  const FeatureTensor& ft: the tensor to copy (input)
+//
+// return: a reference to this tensor
+//
+// The tensor is left empty if there is no memory for the copy.
+//
+FeatureTensor& FeatureTensor::operator=(const FeatureTensor& ft_a) {
+  if (this != &ft_a) {
+    if (!resize(ft_a.nchan_d, ft_a.nframes_d, ft_a.dim_d)) {
+      clear();
+      return *this;
+    }
+    if (nchan_d > 0) {
+      memcpy(data_d, ft_a.data_d, nchan_d * cstride_d * sizeof(double));
+    }
+  }
+  return *this;
+}
+
+// method: destructor
+//
+// arguments: none
+//
+// return: none
+//
+FeatureTensor::~FeatureTensor() {
+  clear();
+}
+
+// method: resize
+//
+// arguments:
+//  long nchan: the number of channels (input)
+//  long nframes: the number of frames per channel (input)
+//  long dim: the number of features per frame (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the shape of the tensor. The data is a single
+// aligned block that is only reallocated when it must grow, so a tensor
+// can be reused across files without touching the allocator. Values
+// are not preserved.
+//
+bool FeatureTensor::resize(long nchan_a, long nframes_a, long dim_a) {
+
+  // check the arguments
+  //
+  if ((nchan_a < 0) || (nframes_a < 0) || (dim_a < 0)) {
+    fprintf(stdout, "**> FeatureTensor::resize(): invalid shape\n");
+    return false;
+  }
+
+  // compute the strides: each channel is rounded up to the alignment
+  //
+  long nalign = ALIGN / sizeof(double);
+  long cstride = ((nframes_a * dim_a + nalign - 1) / nalign) * nalign;
+
+  // grow the data if necessary
+  //
+  long size = nchan_a * cstride;
+  if (size > size_d) {
+    clear();
+    void* ptr;
+    if (posix_memalign(&ptr, ALIGN, size * sizeof(double)) != 0) {
+      fprintf(stdout, "**> FeatureTensor::resize(): out of memory\n");
+      return false;
+    }
+    data_d = (double*)ptr;
+    size_d = size;
+  }
+
+  nchan_d = nchan_a;
+  nframes_d = nframes_a;
+  dim_d = dim_a;
+  cstride_d = cstride;
+  fstride_d = dim_a;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: set_dim
+//
+// arguments:
+//  long dim: the number of features per frame (input)
+//
+// return: a logical value indicating status
+//
+// This method changes the dimension of the frames, keeping the first
+// min(old, new) values of every frame. Values added to a frame are
+// zero. The frames are moved within the current block when it is large
+// enough, so appending features to a tensor does not copy it.
+//
+bool FeatureTensor::set_dim(long dim_a) {
+
+  // check the argument
+  //
+  if (dim_a < 0) {
+    fprintf(stdout, "**> FeatureTensor::set_dim(): invalid dimension\n");
+    return false;
+  }
+  if (dim_a == dim_d) {
+    return true;
+  }
+
+  // compute the new strides
+  //
+  long nalign = ALIGN / sizeof(double);
+  long cstride = ((nframes_d * dim_a + nalign - 1) / nalign) * nalign;
+  long size = nchan_d * cstride;
+  long ncopy = (dim_a < dim_d) ? dim_a : dim_d;
+
+  // grow into a new block
+  //
+  if (size > size_d) {
+    void* ptr;
+    if (posix_memalign(&ptr, ALIGN, size * sizeof(double)) != 0) {
+      fprintf(stdout, "**> FeatureTensor::set_dim(): out of memory\n");
+      return false;
+    }
+    double* data = (double*)ptr;
+    for (long i = 0; i < nchan_d; i++) {
+      for (long j = 0; j < nframes_d; j++) {
+	double* y = data + i * cstride + j * dim_a;
+	memcpy(y, get_frame(i, j), ncopy * sizeof(double));
+	memset(y + ncopy, 0, (dim_a - ncopy) * sizeof(double));
+      }
+    }
+    free(data_d);
+    data_d = data;
+    size_d = size;
+  }
+
+  // widen in place:
+  //  every frame moves up, so the frames are moved from the last one
+  //
+  else if (dim_a > dim_d) {
+    for (long i = nchan_d - 1; i >= 0; i--) {
+      for (long j = nframes_d - 1; j >= 0; j--) {
+	double* y = data_d + i * cstride + j * dim_a;
+	memmove(y, get_frame(i, j), ncopy * sizeof(double));
+	memset(y + ncopy, 0, (dim_a - ncopy) * sizeof(double));
+      }
+    }
+  }
+
+  // narrow in place:
+  //  every frame moves down, so the frames are moved from the first one
+  //
+  else {
+    for (long i = 0; i < nchan_d; i++) {
+      for (long j = 0; j < nframes_d; j++) {
+	memmove(data_d + i * cstride + j * dim_a, get_frame(i, j),
+		ncopy * sizeof(double));
+      }
+    }
+  }
+
+  dim_d = dim_a;
+  cstride_d = cstride;
+  fstride_d = dim_a;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: clear
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method releases the data and empties the tensor.
+//
+bool FeatureTensor::clear() {
+
+  // release the data
+  //
+  if (data_d != (double*)NULL) {
+    free(data_d);
+    data_d = (double*)NULL;
+  }
+
+  nchan_d = 0;
+  nframes_d = 0;
+  dim_d = 0;
+  cstride_d = 0;
+  fstride_d = 0;
+  size_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: assign
+//
+// arguments:
+//  VVVectorDouble& feat: the features (input)
+//
+// return: a logical value indicating status
+//
+// This method copies nested vectors into the tensor. false is returned
+// if the channels or frames differ in size.
+//
+bool FeatureTensor::assign(VVVectorDouble& feat_a) {
+
+  // find the shape
+  //
+  long nchan = feat_a.size();
+  long nframes = (nchan > 0) ? (long)feat_a[0].size() : 0;
+  long dim = (nframes > 0) ? (long)feat_a[0][0].size() : 0;
+
+  for (long i = 0; i < nchan; i++) {
+    if ((long)feat_a[i].size() != nframes) {
+      fprintf(stdout, "**> FeatureTensor::assign(): %s %ld\n",
+	      "wrong number of frames in channel", i);
+      return false;
+    }
+    for (long j = 0; j < nframes; j++) {
+      if ((long)feat_a[i][j].size() != dim) {
+	fprintf(stdout, "**> FeatureTensor::assign(): %s %ld of channel %ld\n",
+		"wrong dimension in frame", j, i);
+	return false;
+      }
+    }
+  }
+
+  // copy the frames
+  //
+  if (!resize(nchan, nframes, dim)) {
+    return false;
+  }
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; (dim > 0) && (j < nframes); j++) {
+      memcpy(get_frame(i, j), &feat_a[i][j][0], dim * sizeof(double));
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: copy_to
+//
+// arguments:
+//  VVVectorDouble& feat: the features (output)
+//
+// return: a logical value indicating status
+//
+// This method copies the tensor into nested vectors.
+//
+bool FeatureTensor::copy_to(VVVectorDouble& feat_a) const {
+
+  // size the vectors and copy the frames
+  //
+  if ((long)feat_a.size() != nchan_d) {
+    feat_a.resize(nchan_d, false);
+  }
+  for (long i = 0; i < nchan_d; i++) {
+    if ((long)feat_a[i].size() != nframes_d) {
+      feat_a[i].resize(nframes_d, false);
+    }
+    for (long j = 0; j < nframes_d; j++) {
+      if ((long)feat_a[i][j].size() != dim_d) {
+	feat_a[i][j].resize(dim_d, false);
+      }
+      if (dim_d > 0) {
+	memcpy(&feat_a[i][j][0], data_d + i * cstride_d + j * fstride_d,
+	       dim_d * sizeof(double));
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// Edf methods
+//
+//-----------------------------------------------------------------------------
+
+// method: read_features
+//
+// arguments:
+//  FeatureTensor& feat: feature data (output)
+//  char* fn: input filename (input)
+//
+// return: a logical value indicating status
+//
+// This method reads feature data from a file into a tensor. It
+// branches on the type of the file, as read_features does for nested
+// vectors.
+//
+bool Edf::read_features(FeatureTensor& feat_a, char* fn_a) {
+
+  // check the file type
+  //
+  int fd;
+  FTYPE ftype = Edf::sniff(fd, fn_a);
+
+  // check for one of four things: raw, raw v2, kaldi, htk
+  //
+  if (ftype == FTYPE_RAW) {
+    return Edf::read_features_raw(feat_a, fn_a, fd);
+  }
+  else if (ftype == FTYPE_RAW2) {
+    return Edf::read_features_raw2(feat_a, fn_a, fd);
+  }
+  else if (ftype == FTYPE_KALDI) {
+    return Edf::read_features_kaldi(feat_a, fn_a, fd);
+  }
+  else if (ftype == FTYPE_HTK) {
+    close(fd);
+    return Edf::read_features_htk(feat_a, fn_a);
+  }
+  else {
+    if (fd >= 0) {
+      close(fd);
+    }
+    fprintf(stdout, "Edf::read_features(): The file type is not supported\n");
+    return false;
+  }
+}
+
+// method: read_features_raw
+//
+// arguments:
+//  FeatureTensor& feat: feature data (output)
+//  char* fn: input filename (input)
+//  int fd: the file, if already open (input)
+//
+// return: a logical value indicating status
+//
+// This method reads a raw file into a tensor. Each channel of a
+// version 1 file is read with one call and its frames are unpacked
+// into the tensor. All frames must have the same dimension. If fd is
+// not negative, it is read instead of opening fn, and it is closed.
+//
+bool Edf::read_features_raw(FeatureTensor& feat_a, char* fn_a, int fd_a) {
+
+  // open the file
+  //
+  int fd = (fd_a >= 0) ? fd_a : open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::read_features_raw(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  // version 2 files are dense and are read by channel
+  //
+  unsigned char hdr[RAW2_HEADER_SIZE];
+  long n = pread(fd, hdr, RAW2_HEADER_SIZE, 0);
+  if (Edf::is_raw2(hdr, n)) {
+    return Edf::read_features_raw2(feat_a, fn_a, fd);
+  }
+
+  // read the dimensions and the size of the first frame:
+  //  an empty file has only the number of channels and of frames
+  //
+  int32_t dims[3] = {0, 0, 0};
+  struct stat st;
+  if ((fstat(fd, &st) != 0) || (n < 2 * (long)sizeof(int32_t))) {
+    fprintf(stdout, "**> Edf::read_features_raw(): invalid file (%s)\n",
+	    fn_a);
+    close(fd);
+    return false;
+  }
+  memcpy(dims, hdr, 2 * sizeof(int32_t));
+
+  long nchan = dims[0];
+  long nframes = dims[1];
+  if ((nchan > 0) && (nframes > 0)) {
+    if (n < (long)sizeof(dims)) {
+      fprintf(stdout, "**> Edf::read_features_raw(): invalid file (%s)\n",
+	      fn_a);
+      close(fd);
+      return false;
+    }
+    memcpy(&dims[2], hdr + 2 * sizeof(int32_t), sizeof(int32_t));
+  }
+  long dim = dims[2];
+  long fbytes = sizeof(int32_t) + dim * sizeof(float);
+
+  // compare the sizes by division so that they cannot overflow
+  //
+  long body = (long)st.st_size - 2 * (long)sizeof(int32_t);
+  if ((nchan < 0) || (nframes < 0) || (dim < 0) ||
+      ((nchan > 0) && ((nframes > body / fbytes) ||
+		       ((nframes > 0) &&
+			(nchan > body / (nframes * fbytes)))))) {
+    fprintf(stdout, "**> Edf::read_features_raw(): invalid dimensions (%s)\n",
+	    fn_a);
+    close(fd);
+    return false;
+  }
+  long cbytes = (nchan > 0) ? nframes * fbytes : 0;
+
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::read_raw(): (nchan, nframes, fdim) %ld %ld %ld\n",
+	    nchan, nframes, dim);
+  }
+
+  // read each channel and unpack its frames
+  //
+  if (!feat_a.resize(nchan, nframes, dim)) {
+    close(fd);
+    return false;
+  }
+  char* buf = new char[cbytes + 1];
+
+  for (long i = 0; i < nchan; i++) {
+    long offset = 2 * sizeof(int32_t) + i * cbytes;
+    if (pread(fd, buf, cbytes, offset) != cbytes) {
+      fprintf(stdout, "**> Edf::read_features_raw(): error reading (%s)\n",
+	      fn_a);
+      delete [] buf;
+      close(fd);
+      return false;
+    }
+
+    for (long j = 0; j < nframes; j++) {
+      int32_t ndim;
+      memcpy(&ndim, buf + j * fbytes, sizeof(ndim));
+      if (ndim != dim) {
+	fprintf(stdout, "**> Edf::read_features_raw(): %s %ld (%s)\n",
+		"frames differ in size in channel", i, fn_a);
+	delete [] buf;
+	close(fd);
+	return false;
+      }
+      Edf::decode_values(feat_a.get_frame(i, j),
+			 buf + j * fbytes + sizeof(int32_t), dim, RDT_FLOAT32);
+    }
+  }
+
+  // clean up
+  //
+  delete [] buf;
+  close(fd);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_features_raw2
+//
+// arguments:
+//  FeatureTensor& feat: feature data (output)
+//  char* fn: input filename (input)
+//  int fd: the file, if already open (input)
+//
+// return: a logical value indicating status
+//
+// This method reads a version 2 raw file into a tensor. Each channel
+// is read with one pread and converted in a single pass. If fd is not
+// negative, it is read instead of opening fn, and it is closed.
+//
+bool Edf::read_features_raw2(FeatureTensor& feat_a, char* fn_a, int fd_a) {
+
+  // declare local variables
+  //
+  long dtype, nchan, nframes, dim;
+  VectorLong offsets;
+
+  // open the file and read the header
+  //
+  int fd = (fd_a >= 0) ? fd_a : open(fn_a, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stdout, "**> Edf::read_features_raw2(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  struct stat st;
+  if ((fstat(fd, &st) != 0) ||
+      (!Edf::read_raw2_header(dtype, nchan, nframes, dim, offsets,
+			      fd, st.st_size))) {
+    fprintf(stdout, "**> Edf::read_features_raw2(): invalid header (%s)\n",
+	    fn_a);
+    close(fd);
+    return false;
+  }
+
+  // read and convert each channel
+  //
+  if (!feat_a.resize(nchan, nframes, dim)) {
+    close(fd);
+    return false;
+  }
+  long nbytes = nframes * dim * Edf::get_raw2_esize(dtype);
+  char* buf = new char[nbytes + 1];
+
+  for (long i = 0; i < nchan; i++) {
+    if (pread(fd, buf, nbytes, offsets[i]) != nbytes) {
+      fprintf(stdout,
+	      "**> Edf::read_features_raw2(): error reading channel %ld (%s)\n",
+	      i, fn_a);
+      delete [] buf;
+      close(fd);
+      return false;
+    }
+    Edf::decode_values(feat_a.get_channel(i), buf, nframes * dim, dtype);
+  }
+
+  // clean up
+  //
+  delete [] buf;
+  close(fd);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: read_features_htk
+//
+// arguments:
+//  FeatureTensor& feat: feature data (output)
+//  char* fn: base filename (input)
+//
+// return: a logical value indicating status
+//
+// This method reads a multichannel HTK file into a tensor. The
+// channels are read in parallel into nested vectors and then copied.
+//
+bool Edf::read_features_htk(FeatureTensor& feat_a, char* fn_a) {
+
+  // read the channels
+  //
+  VVVectorDouble feat;
+  if (!Edf::read_features_htk(feat, fn_a)) {
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return feat_a.assign(feat);
+}
+
+// method: read_features_kaldi
+//
+// arguments:
+//  FeatureTensor& feat: feature data (output)
+//  char* fn: input filename (input)
+//  int fd: the file, if already open (input)
+//
+// return: a logical value indicating status
+//
+// This method reads a Kaldi ark into a tensor. All matrices must have
+// the same size. Float matrices are converted straight from the
+// mapped ark. If fd is not negative, it is mapped instead of opening
+// fn, and it is closed.
+//
+bool Edf::read_features_kaldi(FeatureTensor& feat_a, char* fn_a, int fd_a) {
+
+  // map the ark and locate all matrices
+  //
+  if (!Edf::map_kaldi(fn_a, fd_a)) {
+    return false;
+  }
+
+  // check the sizes
+  //
+  long nchan = Edf::get_kaldi_nmat();
+  long nframes = (nchan > 0) ? kmat_rows_d[0] : 0;
+  long dim = (nchan > 0) ? kmat_cols_d[0] : 0;
+
+  for (long i = 1; i < nchan; i++) {
+    if ((kmat_rows_d[i] != nframes) || (kmat_cols_d[i] != dim)) {
+      fprintf(stdout, "**> Edf::read_features_kaldi(): %s %ld (%s)\n",
+	      "wrong size for matrix", i, fn_a);
+      Edf::unmap_kaldi();
+      return false;
+    }
+  }
+
+  // convert each channel:
+  //  compressed matrices (and float matrices on big endian machines)
+  //  are decoded through a vector
+  //
+  bool big_endian = Edf::is_big_endian();
+  VVectorDouble tmp;
+
+  if (!feat_a.resize(nchan, nframes, dim)) {
+    Edf::unmap_kaldi();
+    return false;
+  }
+  for (long i = 0; i < nchan; i++) {
+    long rows, cols;
+    const char* data = Edf::get_kaldi_matrix(rows, cols, (char*)NULL, i);
+
+    if ((data != (const char*)NULL) && (!big_endian)) {
+      Edf::decode_values(feat_a.get_channel(i), data, rows * cols,
+			 RDT_FLOAT32);
+    }
+    else {
+      Edf::get_kaldi_features(tmp, i);
+      for (long j = 0; (cols > 0) && (j < rows); j++) {
+	memcpy(feat_a.get_frame(i, j), &tmp[j][0], cols * sizeof(double));
+      }
+    }
+  }
+
+  // release the mapping
+  //
+  Edf::unmap_kaldi();
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_features
+//
+// arguments:
+//  FeatureTensor& feat: feature data (input)
+//  char* fn: output filename (input)
+//  FFMT ffmt: feature file format specifier (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a tensor to a file. It branches on the type of
+// the file.
+//
+bool Edf::write_features(FeatureTensor& feat_a, char* fn_a, FFMT ffmt_a) {
+
+  // declare local variables
+  //
+  bool status = false;
+
+  // branch on the format
+  //
+  if (ffmt_a == FFMT_HTK) {
+    status = Edf::write_features_htk(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_KALDI) {
+    status = Edf::write_features_kaldi(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_KALDI_CM) {
+    status = Edf::write_features_kaldi(feat_a, fn_a, true);
+  }
+  else if (ffmt_a == FFMT_RAW) {
+    status = Edf::write_features_raw(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_RAW2) {
+    status = Edf::write_features_raw2(feat_a, fn_a);
+  }
+  else if (ffmt_a == FFMT_RAW2_F16) {
+    status = Edf::write_features_raw2(feat_a, fn_a, RDT_FLOAT16);
+  }
+  else if (ffmt_a == FFMT_RAW2_BF16) {
+    status = Edf::write_features_raw2(feat_a, fn_a, RDT_BFLOAT16);
+  }
+  else {
+    fprintf(stdout, "**> Edf::write_features(): unrecognized filetype\n");
+    return false;
+  }
+
+  // add the features to the statistics when they are collected: only
+  // features that were written are counted
+  //
+  if ((status) && (stats_on_d) && (!stats_d.add(feat_a))) {
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: write_features_raw
+//
+// arguments:
+//  FeatureTensor& feat: feature data (input)
+//  char* fn: output filename (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a tensor as a version 1 raw file. Each channel
+// is packed and written with one call.
+//
+bool Edf::write_features_raw(FeatureTensor& feat_a, char* fn_a) {
+
+  // declare local variables
+  //
+  long nchan = feat_a.get_nchan();
+  long nframes = feat_a.get_nframes();
+  long dim = feat_a.get_dim();
+  long fbytes = sizeof(int32_t) + dim * sizeof(float);
+  long cbytes = nframes * fbytes;
+
+  // open the file and write the dimensions
+  //
+  FILE* fp = fopen(fn_a, "w");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::write_features_raw(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  int32_t dims[2] = {(int32_t)nchan, (int32_t)nframes};
+  bool status = (fwrite(dims, sizeof(int32_t), 2, fp) == 2);
+
+  // pack and write each channel
+  //
+  char* buf = new char[cbytes + 1];
+  int32_t ndim = dim;
+
+  for (long i = 0; status && (i < nchan); i++) {
+    for (long j = 0; j < nframes; j++) {
+      memcpy(buf + j * fbytes, &ndim, sizeof(ndim));
+      Edf::encode_values(buf + j * fbytes + sizeof(int32_t),
+			 feat_a.get_frame(i, j), dim, RDT_FLOAT32);
+    }
+    status &= (fwrite(buf, 1, cbytes, fp) == (size_t)cbytes);
+  }
+
+  // clean up
+  //
+  delete [] buf;
+  if (fclose(fp) != 0) {
+    status = false;
+  }
+  if (!status) {
+    fprintf(stdout, "**> Edf::write_features_raw(): error writing (%s)\n",
+	    fn_a);
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: write_features_raw2
+//
+// arguments:
+//  FeatureTensor& feat: feature data (input)
+//  char* fn: output filename (input)
+//  RAW_DTYPE dtype: the data type of the stored values (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a tensor as a version 2 raw file. Each channel
+// is contiguous in the tensor, so it is converted in a single pass and
+// written with one call.
+//
+bool Edf::write_features_raw2(FeatureTensor& feat_a, char* fn_a,
+			      RAW_DTYPE dtype_a) {
+
+  // check the data type
+  //
+  if (Edf::get_raw2_esize(dtype_a) == 0) {
+    fprintf(stdout,
+	    "**> Edf::write_features_raw2(): unsupported data type %ld\n",
+	    (long)dtype_a);
+    return false;
+  }
+
+  // open the file and write the header
+  //
+  long nchan = feat_a.get_nchan();
+  long nframes = feat_a.get_nframes();
+  long dim = feat_a.get_dim();
+
+  FILE* fp = fopen(fn_a, "w");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> Edf::write_features_raw2(): error opening (%s)\n",
+	    fn_a);
+    return false;
+  }
+
+  long cbytes;
+  bool status = Edf::write_raw2_header(fp, cbytes, nchan, nframes, dim,
+				       dtype_a);
+
+  // write each channel as one block, including its padding
+  //
+  char* buf = new char[cbytes + 1];
+  memset(buf, 0, cbytes);
+
+  for (long i = 0; status && (i < nchan); i++) {
+    Edf::encode_values(buf, feat_a.get_channel(i), nframes * dim, dtype_a);
+    status &= (fwrite(buf, 1, cbytes, fp) == (size_t)cbytes);
+  }
+
+  // clean up
+  //
+  delete [] buf;
+  if (fclose(fp) != 0) {
+    status = false;
+  }
+  if (!status) {
+    fprintf(stdout, "**> Edf::write_features_raw2(): error writing (%s)\n",
+	    fn_a);
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: write_features_htk
+//
+// arguments:
+//  FeatureTensor& feat: feature data (input)
+//  char* fn: base filename (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a tensor as a multichannel HTK file, one file per
+// channel, through nested vectors.
+//
+bool Edf::write_features_htk(FeatureTensor& feat_a, char* fn_a) {
+  VVVectorDouble feat;
+  feat_a.copy_to(feat);
+  return Edf::write_features_htk(feat, fn_a);
+}
+
+// method: write_features_kaldi
+//
+// arguments:
+//  FeatureTensor& feat: feature data (input)
+//  char* fn: output filename (input)
+//  bool compress: if true, matrices are compressed (input)
+//
+// return: a logical value indicating status
+//
+// This method writes a tensor as a Kaldi ark, through nested vectors.
+//
+bool Edf::write_features_kaldi(FeatureTensor& feat_a, char* fn_a,
+			       bool compress_a) {
+  VVVectorDouble feat;
+  feat_a.copy_to(feat);
+  return Edf::write_features_kaldi(feat, fn_a, compress_a);
+}
+
+// method: debug
+//
+// arguments:
+//  FeatureTensor& feat: the features to be debugged (input)
+//  FILE* fp: the output file pointer (input)
+//
+// return: a logical value indicating status
+//
+// This method generates some simple debug information for a tensor.
+//
+bool Edf::debug(FeatureTensor& feat_a, FILE* fp_a) {
+
+  // display the shape
+  //
+  fprintf(fp_a, "no. channels = %ld\n", feat_a.get_nchan());
+  fprintf(fp_a, "no. frames per channel = %ld\n", feat_a.get_nframes());
+  fprintf(fp_a, "no. features per frame = %ld\n", feat_a.get_dim());
+  fprintf(fp_a, "strides (channel, frame) = %ld %ld\n",
+	  feat_a.get_cstride(), feat_a.get_fstride());
+
+  // display some feature values
+  //
+  long max_nchans = (long)Edf::min(3, feat_a.get_nchan());
+  long max_nframes = (long)Edf::min(3, feat_a.get_nframes());
+
+  for (long i = 0; i < max_nchans; i++) {
+    fprintf(fp_a, "channel number %ld:\n", i);
+    for (long j = 0; j < max_nframes; j++) {
+      fprintf(fp_a, "frame number %ld:\n", j);
+      for (long k = 0; k < feat_a.get_dim(); k++) {
+	fprintf(fp_a, "feat[%ld][%ld][%ld] = %f\n", i, j, k, feat_a(i, j, k));
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,606 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_13.cc
+//
+// This file contains methods associated with the class Edf that write
+// feature files incrementally, as frames are produced.
+//
+// Frames are encoded as they arrive into a block of FWR_BLOCK frames
+// per channel, and each full block is written with one call, so memory
+// use does not depend on the length of the recording. The files are
+// identical to those written by write_features:
+//
+//  HTK:      each channel is its own file and is written in place.
+//  raw, raw v2, Kaldi:
+//            the channels are stored one after the other, so channel 0
+//            is written in place and the other channels are spooled to
+//            temporary files that are appended on close.
+//
+// The headers are written with a frame count of zero when the writer
+// is opened and are patched with the real counts on close.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+// method: open_feature_writer
+//
+// arguments:
+//  char* fn: output filename (input)
+//  FFMT ffmt: feature file format specifier (input)
+//  long nchan: the number of channels (input)
+//  long dim: the number of features per frame (input)
+//
+// return: a logical value indicating status
+//
+// This method starts a feature file. Frames are added with write_frames
+// or write_frame and the file is finished by close_feature_writer.
+// HTK filenames are created from fn as write_features_htk does.
+// Compressed Kaldi matrices are not supported, since their scaling is
+// computed from the whole channel.
+//
+bool Edf::open_feature_writer(char* fn_a, FFMT ffmt_a, long nchan_a,
+			      long dim_a) {
+
+  // close any writer that is still open
+  //
+  Edf::close_feature_writer();
+
+  // check the arguments
+  //
+  if ((nchan_a <= 0) || (nchan_a > MAX_NCHANS) || (dim_a <= 0) ||
+      (strlen(fn_a) > MAX_LSTR_LENGTH)) {
+    fprintf(stdout, "**> Edf::open_feature_writer(): invalid arguments\n");
+    return false;
+  }
+
+  if ((ffmt_a != FFMT_RAW) && (ffmt_a != FFMT_RAW2) &&
+      (ffmt_a != FFMT_RAW2_F16) && (ffmt_a != FFMT_RAW2_BF16) &&
+      (ffmt_a != FFMT_HTK) && (ffmt_a != FFMT_KALDI)) {
+    fprintf(stdout,
+	    "**> Edf::open_feature_writer(): unsupported file format %ld\n",
+	    (long)ffmt_a);
+    return false;
+  }
+
+  // check the frame size:
+  //  HTK and Kaldi store the frame size in bytes in a 16-bit integer
+  //
+  if (((ffmt_a == FFMT_HTK) || (ffmt_a == FFMT_KALDI)) &&
+      ((dim_a * (long)sizeof(float)) >=
+       (1L << (sizeof(int16_t) * CHAR_BIT - 1)))) {
+    fprintf(stdout, "**> Edf::open_feature_writer(): frame is too large\n");
+    return false;
+  }
+
+  // give statistics that are collected the shape of the features
+  //
+  if ((stats_on_d) && (stats_d.get_nchan() == 0) &&
+      (!stats_d.resize(nchan_a, dim_a, stats_d.get_alpha()))) {
+    return false;
+  }
+  if ((stats_on_d) && ((stats_d.get_nchan() != nchan_a) ||
+		       (stats_d.get_dim() != dim_a))) {
+    fprintf(stdout, "**> Edf::open_feature_writer(): %s\n",
+	    "shape does not match the statistics");
+    return false;
+  }
+
+  // save the parameters
+  //
+  strcpy(fwr_fname_d, fn_a);
+  fwr_ffmt_d = ffmt_a;
+  fwr_nchan_d = nchan_a;
+  fwr_dim_d = dim_a;
+
+  if (ffmt_a == FFMT_RAW2_F16) {
+    fwr_dtype_d = RDT_FLOAT16;
+  }
+  else if (ffmt_a == FFMT_RAW2_BF16) {
+    fwr_dtype_d = RDT_BFLOAT16;
+  }
+  else {
+    fwr_dtype_d = RDT_FLOAT32;
+  }
+
+  if (ffmt_a == FFMT_RAW) {
+    fwr_fbytes_d = sizeof(int32_t) + dim_a * sizeof(float);
+  }
+  else {
+    fwr_fbytes_d = dim_a * Edf::get_raw2_esize(fwr_dtype_d);
+  }
+
+  // create space for the blocks
+  //
+  fwr_buf_d = new char[nchan_a * FWR_BLOCK * fwr_fbytes_d];
+  for (long i = 0; i < nchan_a; i++) {
+    fwr_nframes_d[i] = 0;
+    fwr_nbuf_d[i] = 0;
+  }
+
+  // create the channel names:
+  //  HTK files use them as filenames and Kaldi arks as keys, with the
+  //  extension and the directory removed
+  //
+  if ((ffmt_a == FFMT_HTK) || (ffmt_a == FFMT_KALDI)) {
+    if (!Edf::create_filelist(fwr_names_d, nchan_a, fn_a, fnmod_d)) {
+      Edf::release_feature_writer();
+      return false;
+    }
+  }
+
+  if (ffmt_a == FFMT_KALDI) {
+    for (long i = 0; i < nchan_a; i++) {
+      char* key = strtok(fwr_names_d[i], DOT);
+      char* token = strtok(key, SLASH);
+      while (token != NULL) {
+	key = token;
+	token = strtok(NULL, SLASH);
+      }
+      memmove(fwr_names_d[i], key, strlen(key) + 1);
+    }
+  }
+
+  // open the outputs and write the headers
+  //
+  bool status = true;
+
+  if (ffmt_a == FFMT_HTK) {
+    for (long i = 0; status && (i < nchan_a); i++) {
+      fwr_sink_d[i] = fopen(fwr_names_d[i], "w");
+      status = (fwr_sink_d[i] != (FILE*)NULL) &&
+	Edf::write_fwr_header(fwr_sink_d[i], i, 0);
+    }
+  }
+  else {
+    fwr_fp_d = fopen(fn_a, "w");
+    fwr_sink_d[0] = fwr_fp_d;
+    status = (fwr_fp_d != (FILE*)NULL) &&
+      Edf::write_fwr_header(fwr_fp_d, 0, 0);
+    for (long i = 1; status && (i < nchan_a); i++) {
+      fwr_sink_d[i] = tmpfile();
+      status = (fwr_sink_d[i] != (FILE*)NULL);
+    }
+  }
+
+  if (!status) {
+    fprintf(stdout, "**> Edf::open_feature_writer(): error opening (%s)\n",
+	    fn_a);
+    Edf::release_feature_writer();
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::open_feature_writer(): %s (%ld %ld) [%s]\n",
+	    "(nchan, dim)", nchan_a, dim_a, fn_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_frames
+//
+// arguments:
+//  VVVectorDouble& frames: frames of each channel (input)
+//  long nframes: the number of frames to write from each channel (input)
+//
+// return: a logical value indicating status
+//
+// This method appends frames[i][0..nframes-1] to channel i, for every
+// channel. It accepts the output of read_stream directly.
+//
+bool Edf::write_frames(VVVectorDouble& frames_a, long nframes_a) {
+
+  // check the arguments
+  //
+  if ((long)frames_a.size() < fwr_nchan_d) {
+    fprintf(stdout, "**> Edf::write_frames(): %s [%ld] [%ld]\n",
+	    "wrong number of channels", (long)frames_a.size(), fwr_nchan_d);
+    return false;
+  }
+
+  // write the frames
+  //
+  for (long i = 0; i < fwr_nchan_d; i++) {
+    if ((long)frames_a[i].size() < nframes_a) {
+      fprintf(stdout, "**> Edf::write_frames(): %s %ld\n",
+	      "too few frames in channel", i);
+      return false;
+    }
+    for (long j = 0; j < nframes_a; j++) {
+      if (!Edf::write_frame(frames_a[i][j], i)) {
+	return false;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write_frame
+//
+// arguments:
+//  VectorDouble& frame: a frame (input)
+//  long chan: the channel the frame belongs to (input)
+//
+// return: a logical value indicating status
+//
+// This method appends one frame to a channel. The frame is converted
+// to the stored format immediately and the block of the channel is
+// written when it fills.
+//
+bool Edf::write_frame(VectorDouble& frame_a, long chan_a) {
+
+  // check that a writer is open and check the arguments
+  //
+  if (fwr_buf_d == (char*)NULL) {
+    fprintf(stdout, "**> Edf::write_frame(): no writer is open\n");
+    return false;
+  }
+  if ((chan_a < 0) || (chan_a >= fwr_nchan_d) ||
+      ((long)frame_a.size() != fwr_dim_d)) {
+    fprintf(stdout, "**> Edf::write_frame(): %s [%ld] [%ld]\n",
+	    "invalid channel or frame size", chan_a, (long)frame_a.size());
+    return false;
+  }
+
+  // encode the frame into the block
+  //
+  char* y = fwr_buf_d +
+    (chan_a * FWR_BLOCK + fwr_nbuf_d[chan_a]) * fwr_fbytes_d;
+
+  if (fwr_ffmt_d == FFMT_RAW) {
+    int32_t ndim = fwr_dim_d;
+    memcpy(y, &ndim, sizeof(int32_t));
+    Edf::encode_values(y + sizeof(int32_t), &frame_a[0], fwr_dim_d,
+		       RDT_FLOAT32);
+  }
+  else {
+    Edf::encode_values(y, &frame_a[0], fwr_dim_d, fwr_dtype_d);
+  }
+
+  // swap the bytes:
+  //  HTK files are big endian and Kaldi arks are little endian
+  //
+  bool big_endian = Edf::is_big_endian();
+  if (((fwr_ffmt_d == FFMT_HTK) && (!big_endian)) ||
+      ((fwr_ffmt_d == FFMT_KALDI) && big_endian)) {
+    uint32_t* u = (uint32_t*)y;
+    for (long k = 0; k < fwr_dim_d; k++) {
+      u[k] = __builtin_bswap32(u[k]);
+    }
+  }
+
+  // write the block if it is full
+  //
+  fwr_nframes_d[chan_a]++;
+  if ((++fwr_nbuf_d[chan_a] == FWR_BLOCK) &&
+      (!Edf::flush_fwr_block(chan_a))) {
+    return false;
+  }
+
+  // add the frame to the statistics when they are collected, once it
+  // has been written
+  //
+  if ((stats_on_d) && (!stats_d.add_frame(&frame_a[0], chan_a))) {
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_feature_writer
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method writes the remaining frames, appends the spooled
+// channels, patches the frame counts in the headers and closes the
+// file. Raw files store a single frame count, so every channel must
+// have the same number of frames. Kaldi arks also get an scp file, as
+// with write_features_kaldi.
+//
+bool Edf::close_feature_writer() {
+
+  // check that a writer is open
+  //
+  if (fwr_buf_d == (char*)NULL) {
+    return true;
+  }
+
+  // write the remaining blocks
+  //
+  bool status = true;
+  for (long i = 0; i < fwr_nchan_d; i++) {
+    status &= Edf::flush_fwr_block(i);
+  }
+
+  // check the frame counts of raw files
+  //
+  bool is_raw = (fwr_ffmt_d != FFMT_HTK) && (fwr_ffmt_d != FFMT_KALDI);
+  for (long i = 1; is_raw && (i < fwr_nchan_d); i++) {
+    if (fwr_nframes_d[i] != fwr_nframes_d[0]) {
+      fprintf(stdout, "**> Edf::close_feature_writer(): %s [%ld] [%ld]\n",
+	      "channels differ in length", fwr_nframes_d[i], fwr_nframes_d[0]);
+      status = false;
+      break;
+    }
+  }
+
+  // patch the HTK headers
+  //
+  if (fwr_ffmt_d == FFMT_HTK) {
+    for (long i = 0; status && (i < fwr_nchan_d); i++) {
+      status = (fseek(fwr_sink_d[i], 0, SEEK_SET) == 0) &&
+	Edf::write_fwr_header(fwr_sink_d[i], i, fwr_nframes_d[i]);
+    }
+  }
+
+  // append the spooled channels to raw files and Kaldi arks:
+  //  raw v2 channels are padded to RAW2_ALIGN
+  //
+  else if (status) {
+    bool is_raw2 = is_raw && (fwr_ffmt_d != FFMT_RAW);
+    char pad[RAW2_ALIGN];
+    memset(pad, 0, RAW2_ALIGN);
+    long nbytes = fwr_nframes_d[0] * fwr_fbytes_d;
+    long npad = is_raw2 ?
+      (RAW2_ALIGN - nbytes % RAW2_ALIGN) % RAW2_ALIGN : 0;
+
+    // open the scp file and add the entry of channel 0
+    //
+    FILE* fp_scp = (FILE*)NULL;
+    char scp_name[strlen(fwr_fname_d) + strlen(KALDI_SCP_EXT) + 2];
+
+    if (fwr_ffmt_d == FFMT_KALDI) {
+      Edf::create_kaldi_scp_name(scp_name, fwr_fname_d);
+      fp_scp = fopen(scp_name, "w");
+      status = (fp_scp != (FILE*)NULL) &&
+	(fprintf(fp_scp, "%s %s:%ld\n", fwr_names_d[0], fwr_fname_d,
+		 (long)strlen(fwr_names_d[0]) + 1) >= 0);
+    }
+
+    for (long i = 0; status && (i < fwr_nchan_d); i++) {
+
+      // write the header of the channel
+      //
+      if ((i > 0) && (fwr_ffmt_d == FFMT_KALDI)) {
+	status = (fprintf(fp_scp, "%s %s:%ld\n", fwr_names_d[i], fwr_fname_d,
+			  ftell(fwr_fp_d) + (long)strlen(fwr_names_d[i]) + 1)
+		  >= 0) &&
+	  Edf::write_fwr_header(fwr_fp_d, i, fwr_nframes_d[i]);
+      }
+
+      // copy the spooled frames a block at a time
+      //
+      if (i > 0) {
+	long bsize = FWR_BLOCK * fwr_fbytes_d;
+	rewind(fwr_sink_d[i]);
+	long n;
+	while (status &&
+	       ((n = fread(fwr_buf_d, 1, bsize, fwr_sink_d[i])) > 0)) {
+	  status = (fwrite(fwr_buf_d, 1, n, fwr_fp_d) == (size_t)n);
+	}
+      }
+
+      // pad the channel
+      //
+      if (status && (npad > 0)) {
+	status = (fwrite(pad, 1, npad, fwr_fp_d) == (size_t)npad);
+      }
+    }
+
+    // patch the header of channel 0
+    //
+    status = status && (fseek(fwr_fp_d, 0, SEEK_SET) == 0) &&
+      Edf::write_fwr_header(fwr_fp_d, 0, fwr_nframes_d[0]);
+
+    if ((fp_scp != (FILE*)NULL) && (fclose(fp_scp) != 0)) {
+      status = false;
+    }
+  }
+
+  // close the files
+  //
+  if (!Edf::release_feature_writer()) {
+    status = false;
+  }
+  if (!status) {
+    fprintf(stdout, "**> Edf::close_feature_writer(): error writing (%s)\n",
+	    fwr_fname_d);
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::close_feature_writer(): done writing [%s]\n",
+	    fwr_fname_d);
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: write_fwr_header
+//
+// arguments:
+//  FILE* fp: the output file, positioned at the header (input)
+//  long chan: the channel (input)
+//  long nframes: the number of frames in the channel (input)
+//
+// return: a logical value indicating status
+//
+// This method writes the header of a channel in the format of the open
+// writer. Raw files have a single header, which is written with
+// channel 0. The size of a header does not depend on nframes, so it
+// can be rewritten in place.
+//
+bool Edf::write_fwr_header(FILE* fp_a, long chan_a, long nframes_a) {
+
+  // declare local variables
+  //
+  bool big_endian = Edf::is_big_endian();
+
+  // raw files: the number of channels and frames
+  //
+  if (fwr_ffmt_d == FFMT_RAW) {
+    if (chan_a > 0) {
+      return true;
+    }
+    int32_t dims[2] = {(int32_t)fwr_nchan_d, (int32_t)nframes_a};
+    return (fwrite(dims, sizeof(int32_t), 2, fp_a) == 2);
+  }
+
+  // raw v2 files: the header and the channel table
+  //
+  else if ((fwr_ffmt_d != FFMT_HTK) && (fwr_ffmt_d != FFMT_KALDI)) {
+    if (chan_a > 0) {
+      return true;
+    }
+    long cbytes;
+    return Edf::write_raw2_header(fp_a, cbytes, fwr_nchan_d, nframes_a,
+				  fwr_dim_d, fwr_dtype_d);
+  }
+
+  // HTK files: the header in big endian format
+  //
+  else if (fwr_ffmt_d == FFMT_HTK) {
+    unsigned char buf[HTK_HEADER_SIZE];
+    int32_t hdr32[2] = {(int32_t)nframes_a,
+			(int32_t)round(fdur_d / HTK_FDUR_SCALE)};
+    int16_t hdr16[2] = {(int16_t)(fwr_dim_d * sizeof(float)),
+			(int16_t)HTK_PARMKIND_USER};
+
+    for (long l = 0; l < 2; l++) {
+      if (!big_endian) {
+	Edf::swap_bytes(buf + l * sizeof(int32_t), &hdr32[l],
+			sizeof(int32_t));
+	Edf::swap_bytes(buf + 2 * sizeof(int32_t) + l * sizeof(int16_t),
+			&hdr16[l], sizeof(int16_t));
+      }
+      else {
+	memcpy(buf + l * sizeof(int32_t), &hdr32[l], sizeof(int32_t));
+	memcpy(buf + 2 * sizeof(int32_t) + l * sizeof(int16_t),
+	       &hdr16[l], sizeof(int16_t));
+      }
+    }
+    return (fwrite(buf, 1, HTK_HEADER_SIZE, fp_a) == HTK_HEADER_SIZE);
+  }
+
+  // Kaldi arks: the key and a float matrix header in little endian
+  // format
+  //
+  int32_t dims[2] = {(int32_t)nframes_a, (int32_t)fwr_dim_d};
+  unsigned char buf[2][sizeof(int32_t)];
+  for (long l = 0; l < 2; l++) {
+    if (big_endian) {
+      Edf::swap_bytes(buf[l], &dims[l], sizeof(int32_t));
+    }
+    else {
+      memcpy(buf[l], &dims[l], sizeof(int32_t));
+    }
+  }
+
+  return (fprintf(fp_a, "%s %c%s %c", fwr_names_d[chan_a],
+		  '\0', KALDI_HEADER_STR, KALDI_HEADER_EOT) >= 0) &&
+    (fwrite(buf[0], sizeof(int32_t), 1, fp_a) == 1) &&
+    (fprintf(fp_a, "%c", KALDI_HEADER_EOT) >= 0) &&
+    (fwrite(buf[1], sizeof(int32_t), 1, fp_a) == 1);
+}
+
+// method: flush_fwr_block
+//
+// arguments:
+//  long chan: the channel (input)
+//
+// return: a logical value indicating status
+//
+// This method writes the frames waiting in the block of a channel.
+//
+bool Edf::flush_fwr_block(long chan_a) {
+
+  // write the block with one call
+  //
+  long n = fwr_nbuf_d[chan_a];
+  fwr_nbuf_d[chan_a] = 0;
+  if (n == 0) {
+    return true;
+  }
+
+  char* block = fwr_buf_d + chan_a * FWR_BLOCK * fwr_fbytes_d;
+  if (fwrite(block, fwr_fbytes_d, n, fwr_sink_d[chan_a]) != (size_t)n) {
+    fprintf(stdout, "**> Edf::flush_fwr_block(): %s %ld (%s)\n",
+	    "error writing channel", chan_a, fwr_fname_d);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: release_feature_writer
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method closes the files of the writer, including the temporary
+// files, and deletes its memory. It does not finish the output.
+//
+bool Edf::release_feature_writer() {
+
+  // close the files
+  //
+  bool status = true;
+  for (long i = 0; i < fwr_nchan_d; i++) {
+    if ((fwr_sink_d[i] != (FILE*)NULL) && (fwr_sink_d[i] != fwr_fp_d)) {
+      if (fclose(fwr_sink_d[i]) != 0) {
+	status = false;
+      }
+    }
+    fwr_sink_d[i] = (FILE*)NULL;
+  }
+  if (fwr_fp_d != (FILE*)NULL) {
+    if (fclose(fwr_fp_d) != 0) {
+      status = false;
+    }
+    fwr_fp_d = (FILE*)NULL;
+  }
+
+  // delete the names and the blocks
+  //
+  for (long i = 0; i < fwr_nchan_d; i++) {
+    if (fwr_names_d[i] != (char*)NULL) {
+      delete [] fwr_names_d[i];
+      fwr_names_d[i] = (char*)NULL;
+    }
+  }
+  if (fwr_buf_d != (char*)NULL) {
+    delete [] fwr_buf_d;
+    fwr_buf_d = (char*)NULL;
+  }
+  fwr_nchan_d = 0;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+//
+// end of file
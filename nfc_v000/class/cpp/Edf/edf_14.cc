@@ -0,0 +1,324 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_14.cc
+//
+// This file contains methods associated with the class Edf that cut
+// signals into overlapping, tapered frames.
+//
+// Frames are spaced by the frame duration (fdur_d) and span the window
+// duration (wdur_d), both in secs. They are converted to samples using
+// the sample frequency, so:
+//
+//  frame shift   = round(fdur * fs)
+//  window length = round(wdur * fs)
+//  frame j       = samples [j * shift, j * shift + length)
+//
+// Only complete windows are used. A frame of a signal is a view into
+// the signal itself (see get_frame_view); tapering writes it into a
+// caller supplied buffer using a table that is computed once for each
+// window type and length.
+//
+
+// system include files
+//
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+// method: get_frame_shift
+//
+// arguments: none
+//
+// return: the number of samples between frames
+//
+long Edf::get_frame_shift() {
+  return (long)round(fdur_d * hdr_sample_frequency_d);
+}
+
+// method: get_window_length
+//
+// arguments: none
+//
+// return: the number of samples in a window
+//
+long Edf::get_window_length() {
+  return (long)round(wdur_d * hdr_sample_frequency_d);
+}
+
+// method: get_num_frames
+//
+// arguments:
+//  long nsamples: the number of samples in a signal (input)
+//
+// return: the number of complete windows in the signal
+//
+long Edf::get_num_frames(long nsamples_a) {
+
+  // check the frame parameters
+  //
+  long shift = Edf::get_frame_shift();
+  long wlen = Edf::get_window_length();
+  if ((shift <= 0) || (wlen <= 0) || (nsamples_a < wlen)) {
+    return 0;
+  }
+
+  // exit gracefully
+  //
+  return 1 + (nsamples_a - wlen) / shift;
+}
+
+// method: get_frame_view
+//
+// arguments:
+//  VectorDouble& sig: one channel of a signal (input)
+//  long frame: the frame index (input)
+//
+// return: a pointer to the first sample of the frame
+//
+// This method returns the untapered samples of a frame without copying
+// them. The window length is given by get_window_length. NULL is
+// returned if the frame is not complete.
+//
+const double* Edf::get_frame_view(VectorDouble& sig_a, long frame_a) {
+
+  // check the frame index
+  //
+  if ((frame_a < 0) || (frame_a >= Edf::get_num_frames(sig_a.size()))) {
+    return (const double*)NULL;
+  }
+
+  // exit gracefully
+  //
+  return &sig_a[0] + frame_a * Edf::get_frame_shift();
+}
+
+// method: window_frame
+//
+// arguments:
+//  double* y: the tapered frame (output)
+//  const double* x: the samples of the frame (input)
+//
+// return: a logical value indicating status
+//
+// This method multiplies a frame by the current window. y must hold
+// get_window_length values and may be the same as x.
+//
+bool Edf::window_frame(double* y_a, const double* x_a) {
+
+  // make sure the window is current
+  //
+  long wlen = Edf::get_window_length();
+  if (!Edf::create_window(wlen)) {
+    return false;
+  }
+
+  // taper the frame
+  //
+  Edf::multiply(y_a, x_a, win_tab_d, wlen);
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: frame_signal
+//
+// arguments:
+//  FeatureTensor& frames: the tapered frames (output)
+//  VVectorDouble& sig: the signal (input)
+//
+// return: a logical value indicating status
+//
+// This method cuts every channel of a signal into tapered frames:
+// frames(i, j, k) is sample k of frame j of channel i. Channels that
+// differ in length are cut to the number of frames of the shortest
+// one. The tensor is only reallocated when it must grow, so reusing it
+// across signals does not allocate.
+//
+bool Edf::frame_signal(FeatureTensor& frames_a, VVectorDouble& sig_a) {
+
+  // check the frame parameters
+  //
+  long shift = Edf::get_frame_shift();
+  long wlen = Edf::get_window_length();
+  if ((shift <= 0) || (wlen <= 0)) {
+    fprintf(stdout, "**> Edf::frame_signal(): %s (%f %f %f)\n",
+	    "invalid frame parameters (fdur, wdur, fs)",
+	    fdur_d, wdur_d, (double)hdr_sample_frequency_d);
+    return false;
+  }
+
+  // find the number of frames
+  //
+  long nchan = sig_a.size();
+  long nframes = (nchan > 0) ? Edf::get_num_frames(sig_a[0].size()) : 0;
+  for (long i = 1; i < nchan; i++) {
+    long nf = Edf::get_num_frames(sig_a[i].size());
+    if (nf < nframes) {
+      nframes = nf;
+    }
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::frame_signal(): %s %ld %ld %ld %ld\n",
+	    "(nchan, nframes, shift, wlen)", nchan, nframes, shift, wlen);
+  }
+
+  // taper the frames straight into the tensor
+  //
+  if ((!frames_a.resize(nchan, nframes, wlen)) ||
+      (!Edf::create_window(wlen))) {
+    return false;
+  }
+
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; j < nframes; j++) {
+      Edf::multiply(frames_a.get_frame(i, j), &sig_a[i][0] + j * shift,
+		    win_tab_d, wlen);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: create_window
+//
+// arguments:
+//  long wlen: the window length in samples (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the table of the current window type if the
+// type or the length has changed. The windows are symmetric, as in
+// HTK:
+//
+//  hamming:  0.54 - 0.46 cos(2 pi n / (N - 1))
+//  hann:     0.50 - 0.50 cos(2 pi n / (N - 1))
+//  blackman: 0.42 - 0.50 cos(2 pi n / (N - 1)) + 0.08 cos(4 pi n / (N - 1))
+//
+bool Edf::create_window(long wlen_a) {
+
+  // check if the table is current
+  //
+  if ((win_tab_d != (double*)NULL) && (wlen_a == win_len_d) &&
+      (win_type_d == win_ttype_d)) {
+    return true;
+  }
+
+  if (wlen_a <= 0) {
+    fprintf(stdout, "**> Edf::create_window(): invalid length %ld\n",
+	    wlen_a);
+    return false;
+  }
+
+  // create space:
+  //  the table is aligned so that it can be read with aligned loads
+  //
+  if (wlen_a > win_len_d) {
+    free(win_tab_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       wlen_a * sizeof(double)) != 0) {
+      win_tab_d = (double*)NULL;
+      win_len_d = 0;
+      fprintf(stdout, "**> Edf::create_window(): out of memory\n");
+      return false;
+    }
+    win_tab_d = (double*)ptr;
+  }
+  win_len_d = wlen_a;
+  win_ttype_d = win_type_d;
+
+  // compute the window
+  //
+  double arg = (wlen_a > 1) ? 2.0 * M_PI / (double)(wlen_a - 1) : 0.0;
+
+  for (long n = 0; n < wlen_a; n++) {
+    if (win_type_d == WIN_HAMMING) {
+      win_tab_d[n] = 0.54 - 0.46 * cos(arg * n);
+    }
+    else if (win_type_d == WIN_HANN) {
+      win_tab_d[n] = 0.50 - 0.50 * cos(arg * n);
+    }
+    else if (win_type_d == WIN_BLACKMAN) {
+      win_tab_d[n] = 0.42 - 0.50 * cos(arg * n) + 0.08 * cos(2.0 * arg * n);
+    }
+    else {
+      win_tab_d[n] = 1.0;
+    }
+  }
+
+  // a window of one sample is not tapered
+  //
+  if (wlen_a == 1) {
+    win_tab_d[0] = 1.0;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::create_window(): type %ld, length %ld\n",
+	    (long)win_type_d, wlen_a);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: multiply
+//
+// arguments:
+//  double* y: the product (output)
+//  const double* x: the first vector (input)
+//  const double* w: the second vector (input)
+//  long n: the number of elements (input)
+//
+// return: a logical value indicating status
+//
+// This method multiplies two vectors element by element, using AVX or
+// SSE2 when the compiler targets them. y may be the same as x.
+//
+bool Edf::multiply(double* y_a, const double* x_a, const double* w_a,
+		   long n_a) {
+
+  // multiply full vectors
+  //
+  long i = 0;
+#if defined(__AVX__)
+  for (; i + 4 <= n_a; i += 4) {
+    _mm256_storeu_pd(y_a + i, _mm256_mul_pd(_mm256_loadu_pd(x_a + i),
+					    _mm256_loadu_pd(w_a + i)));
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n_a; i += 2) {
+    _mm_storeu_pd(y_a + i, _mm_mul_pd(_mm_loadu_pd(x_a + i),
+				      _mm_loadu_pd(w_a + i)));
+  }
+#endif
+
+  // multiply the rest
+  //
+  for (; i < n_a; i++) {
+    y_a[i] = x_a[i] * w_a[i];
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,808 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_15.cc
+//
+// This file contains methods associated with the class Edf that compute
+// fast Fourier transforms of real signals.
+//
+// A real transform of n samples returns the n / 2 + 1 non-negative
+// frequency bins as interleaved complex values:
+//
+//  y[2k] + i y[2k + 1] = sum_t x[t] exp(-2 pi i k t / n)
+//
+// An even length is computed as a complex transform of n / 2 points
+// (even samples as the real part, odd samples as the imaginary part)
+// followed by a split step. An odd length is computed as a complex
+// transform of n points.
+//
+// Complex transforms use the Stockham autosort algorithm: each pass
+// applies radix r butterflies and reads one buffer and writes the
+// other, so the output is in natural order without a bit reversal.
+// The lengths are factored into radices 4, 2, 3 and 5. Other prime
+// factors are handled by a generic (slower) pass, so any length works.
+//
+// A plan holds the factors and the twiddle factors of one length.
+// Up to FFT_NPLANS plans are kept, and the oldest is replaced when a
+// new length is needed.
+//
+
+// system include files
+//
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+//-----------------------------------------------------------------------------
+//
+// complex arithmetic:
+//  a complex value is one SSE2 register (real in the low half), or a
+//  pair of doubles when SSE2 is not available
+//
+//-----------------------------------------------------------------------------
+
+#if defined(__SSE2__)
+
+typedef __m128d Complex;
+
+static inline Complex cload(const double* p) {
+  return _mm_loadu_pd(p);
+}
+
+static inline void cstore(double* p, Complex a) {
+  _mm_storeu_pd(p, a);
+}
+
+static inline Complex cset(double re, double im) {
+  return _mm_set_pd(im, re);
+}
+
+static inline Complex cadd(Complex a, Complex b) {
+  return _mm_add_pd(a, b);
+}
+
+static inline Complex csub(Complex a, Complex b) {
+  return _mm_sub_pd(a, b);
+}
+
+static inline Complex cscale(Complex a, double s) {
+  return _mm_mul_pd(a, _mm_set1_pd(s));
+}
+
+// multiply by -i: (re, im) -> (im, -re)
+//
+static inline Complex cmul_mi(Complex a) {
+  return _mm_xor_pd(_mm_shuffle_pd(a, a, 1), _mm_set_pd(-0.0, 0.0));
+}
+
+static inline Complex cmul(Complex a, Complex w) {
+  Complex wr = _mm_unpacklo_pd(w, w);
+  Complex wi = _mm_unpackhi_pd(w, w);
+  Complex t = _mm_mul_pd(_mm_shuffle_pd(a, a, 1), wi);
+  t = _mm_xor_pd(t, _mm_set_pd(0.0, -0.0));
+  return _mm_add_pd(_mm_mul_pd(a, wr), t);
+}
+
+#else
+
+struct Complex {
+  double re;
+  double im;
+};
+
+static inline Complex cload(const double* p) {
+  Complex a = {p[0], p[1]};
+  return a;
+}
+
+static inline void cstore(double* p, Complex a) {
+  p[0] = a.re;
+  p[1] = a.im;
+}
+
+static inline Complex cset(double re, double im) {
+  Complex a = {re, im};
+  return a;
+}
+
+static inline Complex cadd(Complex a, Complex b) {
+  Complex c = {a.re + b.re, a.im + b.im};
+  return c;
+}
+
+static inline Complex csub(Complex a, Complex b) {
+  Complex c = {a.re - b.re, a.im - b.im};
+  return c;
+}
+
+static inline Complex cscale(Complex a, double s) {
+  Complex c = {a.re * s, a.im * s};
+  return c;
+}
+
+static inline Complex cmul_mi(Complex a) {
+  Complex c = {a.im, -a.re};
+  return c;
+}
+
+static inline Complex cmul(Complex a, Complex w) {
+  Complex c = {a.re * w.re - a.im * w.im, a.re * w.im + a.im * w.re};
+  return c;
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+//
+// public methods
+//
+//-----------------------------------------------------------------------------
+
+// method: fft
+//
+// arguments:
+//  double* y: n / 2 + 1 interleaved complex bins (output)
+//  const double* x: n real samples (input)
+//  long n: the length of the transform (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the transform of a real signal. y must hold
+// 2 * (n / 2 + 1) values and must not overlap x.
+//
+bool Edf::fft(double* y_a, const double* x_a, long n_a) {
+
+  // find the plan
+  //
+  long plan = Edf::get_fft_plan(n_a);
+  if (plan < 0) {
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return Edf::fft_real(plan, y_a, x_a);
+}
+
+// method: ifft
+//
+// arguments:
+//  double* y: n real samples (output)
+//  const double* x: n / 2 + 1 interleaved complex bins (input)
+//  long n: the length of the transform (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the inverse of fft, including the 1 / n scale,
+// so ifft(fft(x)) is x. The imaginary parts of bin 0 (and of bin n / 2
+// for even n) are ignored. y must not overlap x.
+//
+bool Edf::ifft(double* y_a, const double* x_a, long n_a) {
+
+  // find the plan
+  //
+  long plan = Edf::get_fft_plan(n_a);
+  if (plan < 0) {
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return Edf::ifft_real(plan, y_a, x_a);
+}
+
+// method: fft
+//
+// arguments:
+//  FeatureTensor& spec: the spectra of the frames (output)
+//  FeatureTensor& frames: frames of real samples (input)
+//
+// return: a logical value indicating status
+//
+// This method transforms every frame of every channel with one plan:
+// spec(i, j, 2k) + i spec(i, j, 2k + 1) is bin k of frame j of
+// channel i, for k = 0, ..., dim / 2. spec is only reallocated when it
+// must grow.
+//
+bool Edf::fft(FeatureTensor& spec_a, FeatureTensor& frames_a) {
+
+  // declare local variables
+  //
+  long nchan = frames_a.get_nchan();
+  long nframes = frames_a.get_nframes();
+  long n = frames_a.get_dim();
+
+  // find the plan and size the output
+  //
+  long plan = Edf::get_fft_plan(n);
+  if ((plan < 0) || (!spec_a.resize(nchan, nframes, 2 * (n / 2 + 1)))) {
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::fft(): %s %ld %ld %ld\n",
+	    "(nchan, nframes, n)", nchan, nframes, n);
+  }
+
+  // transform the frames
+  //
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; j < nframes; j++) {
+      Edf::fft_real(plan, spec_a.get_frame(i, j), frames_a.get_frame(i, j));
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: get_fft_plan
+//
+// arguments:
+//  long n: the length of a real transform (input)
+//
+// return: the index of the plan, or -1 if it cannot be created
+//
+// This method returns the plan of a length, creating it if needed. The
+// work buffers are grown to fit the plan.
+//
+long Edf::get_fft_plan(long n_a) {
+
+  // look for the plan
+  //
+  for (long i = 0; i < fft_nplans_d; i++) {
+    if (fft_n_d[i] == n_a) {
+      return i;
+    }
+  }
+
+  // check the length
+  //
+  if (n_a <= 0) {
+    fprintf(stdout, "**> Edf::get_fft_plan(): invalid length %ld\n", n_a);
+    return -1;
+  }
+
+  // grow the work buffers: two complex buffers of n points. the
+  // existing plans are dropped if this fails, since they use them.
+  //
+  if (4 * n_a > fft_wsize_d) {
+    free(fft_work_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       4 * n_a * sizeof(double)) != 0) {
+      fft_work_d = (double*)NULL;
+      fft_wsize_d = 0;
+      fft_nplans_d = 0;
+      fft_next_d = 0;
+      fprintf(stdout, "**> Edf::get_fft_plan(): out of memory\n");
+      return -1;
+    }
+    fft_work_d = (double*)ptr;
+    fft_wsize_d = 4 * n_a;
+  }
+
+  // pick a slot: the oldest plan is replaced once all slots are used
+  //
+  long plan = fft_next_d;
+  fft_next_d = (fft_next_d + 1) % FFT_NPLANS;
+  if (plan == fft_nplans_d) {
+    fft_nplans_d++;
+  }
+
+  // create the plan
+  //
+  if (!Edf::create_fft_plan(plan, n_a)) {
+    fft_n_d[plan] = -1;
+    return -1;
+  }
+
+  // exit gracefully
+  //
+  return plan;
+}
+
+// method: create_fft_plan
+//
+// arguments:
+//  long plan: the index of the plan (input)
+//  long n: the length of a real transform (input)
+//
+// return: a logical value indicating status
+//
+// This method factors the complex length and computes the tables of a
+// plan. The table holds, in complex values:
+//
+//  for each pass of radix r over a length of n_p points:
+//    w^(j p) for p < n_p / r and 0 < j < r, with w = exp(-2 pi i / n_p)
+//    and, for a generic radix, exp(-2 pi i t / r) for t < r
+//  for even n, exp(-2 pi i k / n) for k <= n / 2 (the split step)
+//
+bool Edf::create_fft_plan(long plan_a, long n_a) {
+
+  // factor the complex length
+  //
+  long nc = ((n_a % 2) == 0) ? n_a / 2 : n_a;
+  long npass = 0;
+  long rem = nc;
+
+  while ((rem % 4) == 0) {
+    fft_radix_d[plan_a][npass++] = 4;
+    rem /= 4;
+  }
+  for (long r = 2; rem > 1; r++) {
+    while ((rem % r) == 0) {
+      fft_radix_d[plan_a][npass++] = r;
+      rem /= r;
+    }
+  }
+
+  // find the size of the table
+  //
+  long size = 0;
+  long len = nc;
+  for (long i = 0; i < npass; i++) {
+    long r = fft_radix_d[plan_a][i];
+    fft_toff_d[plan_a][i] = size;
+    size += (r - 1) * (len / r);
+    if (r > 5) {
+      size += r;
+    }
+    len /= r;
+  }
+  fft_soff_d[plan_a] = size;
+  if (nc != n_a) {
+    size += nc + 1;
+  }
+
+  // create space
+  //
+  free(fft_tab_d[plan_a]);
+  void* ptr;
+  if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		     (2 * size + 2) * sizeof(double)) != 0) {
+    fft_tab_d[plan_a] = (double*)NULL;
+    fprintf(stdout, "**> Edf::create_fft_plan(): out of memory\n");
+    return false;
+  }
+  double* tab = (double*)ptr;
+
+  // compute the twiddle factors of each pass
+  //
+  len = nc;
+  for (long i = 0; i < npass; i++) {
+    long r = fft_radix_d[plan_a][i];
+    long m = len / r;
+    double* tw = tab + 2 * fft_toff_d[plan_a][i];
+
+    for (long p = 0; p < m; p++) {
+      for (long j = 1; j < r; j++) {
+	double arg = -2.0 * M_PI * (double)((j * p) % len) / (double)len;
+	tw[2 * ((r - 1) * p + j - 1)] = cos(arg);
+	tw[2 * ((r - 1) * p + j - 1) + 1] = sin(arg);
+      }
+    }
+
+    if (r > 5) {
+      double* rt = tw + 2 * (r - 1) * m;
+      for (long t = 0; t < r; t++) {
+	rt[2 * t] = cos(-2.0 * M_PI * t / r);
+	rt[2 * t + 1] = sin(-2.0 * M_PI * t / r);
+      }
+    }
+    len = m;
+  }
+
+  // compute the factors of the split step
+  //
+  if (nc != n_a) {
+    double* ws = tab + 2 * fft_soff_d[plan_a];
+    for (long k = 0; k <= nc; k++) {
+      ws[2 * k] = cos(-2.0 * M_PI * k / n_a);
+      ws[2 * k + 1] = sin(-2.0 * M_PI * k / n_a);
+    }
+  }
+
+  // save the plan
+  //
+  fft_n_d[plan_a] = n_a;
+  fft_nc_d[plan_a] = nc;
+  fft_npass_d[plan_a] = npass;
+  fft_tab_d[plan_a] = tab;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::create_fft_plan(): n = %ld, radices =", n_a);
+    for (long i = 0; i < npass; i++) {
+      fprintf(stdout, " %ld", fft_radix_d[plan_a][i]);
+    }
+    fprintf(stdout, "\n");
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: fft_complex
+//
+// arguments:
+//  long plan: the index of the plan (input)
+//  double* a: the input, overwritten (input/output)
+//  double* b: a work buffer of the same size (input)
+//
+// return: a pointer to the transform, which is either a or b
+//
+// This method computes a complex transform of fft_nc_d[plan] points
+// by running the passes of the plan back and forth between a and b.
+//
+double* Edf::fft_complex(long plan_a, double* a_a, double* b_a) {
+  return Edf::fft_batch(plan_a, a_a, b_a, 1);
+}
+
+// method: fft_batch
+//
+// arguments:
+//  long plan: the index of the plan (input)
+//  double* a: nseq contiguous sequences, overwritten (input/output)
+//  double* b: a work buffer of the same size (input)
+//  long nseq: the number of sequences (input)
+//
+// return: a pointer to the transforms, which is either a or b
+//
+// This method computes the complex transforms of nseq sequences of
+// fft_nc_d[plan] points. Each pass is applied to every sequence before
+// the next one, so the twiddle factors of a pass are loaded once for
+// the whole batch.
+//
+double* Edf::fft_batch(long plan_a, double* a_a, double* b_a, long nseq_a) {
+
+  // run the passes
+  //
+  double* x = a_a;
+  double* y = b_a;
+  long nc = fft_nc_d[plan_a];
+  long len = nc;
+  long s = 1;
+
+  for (long i = 0; i < fft_npass_d[plan_a]; i++) {
+    long r = fft_radix_d[plan_a][i];
+    const double* tw = fft_tab_d[plan_a] + 2 * fft_toff_d[plan_a][i];
+    for (long q = 0; q < nseq_a; q++) {
+      Edf::fft_pass(y + 2 * q * nc, x + 2 * q * nc, tw, len / r, s, r);
+    }
+    double* tmp = x;
+    x = y;
+    y = tmp;
+    len /= r;
+    s *= r;
+  }
+
+  // exit gracefully
+  //
+  return x;
+}
+
+// method: fft_pass
+//
+// arguments:
+//  double* y: the output of the pass (output)
+//  const double* x: the input of the pass (input)
+//  const double* tw: the table of the pass (input)
+//  long m: the number of butterfly groups (input)
+//  long s: the stride of the butterflies (input)
+//  long r: the radix (input)
+//
+// return: a logical value indicating status
+//
+// This method runs one Stockham pass. For p < m and q < s, the inputs
+// a_k = x[q + s (p + k m)], k < r, are combined by an r point DFT and
+// the outputs are written, times w^(j p), to y[q + s (r p + j)].
+//
+bool Edf::fft_pass(double* y_a, const double* x_a, const double* tw_a,
+		   long m_a, long s_a, long r_a) {
+
+  // declare local variables:
+  //  xs and ys are the distances between the inputs and the outputs
+  //  of a butterfly, in doubles
+  //
+  long xs = 2 * s_a * m_a;
+  long ys = 2 * s_a;
+
+  // radix 4
+  //
+  if (r_a == 4) {
+    for (long p = 0; p < m_a; p++) {
+      Complex w1 = cload(tw_a + 6 * p);
+      Complex w2 = cload(tw_a + 6 * p + 2);
+      Complex w3 = cload(tw_a + 6 * p + 4);
+      const double* x = x_a + 2 * s_a * p;
+      double* y = y_a + 2 * s_a * 4 * p;
+
+      for (long q = 0; q < 2 * s_a; q += 2) {
+	Complex a0 = cload(x + q);
+	Complex a1 = cload(x + q + xs);
+	Complex a2 = cload(x + q + 2 * xs);
+	Complex a3 = cload(x + q + 3 * xs);
+	Complex t0 = cadd(a0, a2);
+	Complex t1 = csub(a0, a2);
+	Complex t2 = cadd(a1, a3);
+	Complex t3 = cmul_mi(csub(a1, a3));
+	cstore(y + q, cadd(t0, t2));
+	cstore(y + q + ys, cmul(cadd(t1, t3), w1));
+	cstore(y + q + 2 * ys, cmul(csub(t0, t2), w2));
+	cstore(y + q + 3 * ys, cmul(csub(t1, t3), w3));
+      }
+    }
+  }
+
+  // radix 2
+  //
+  else if (r_a == 2) {
+    for (long p = 0; p < m_a; p++) {
+      Complex w1 = cload(tw_a + 2 * p);
+      const double* x = x_a + 2 * s_a * p;
+      double* y = y_a + 2 * s_a * 2 * p;
+
+      for (long q = 0; q < 2 * s_a; q += 2) {
+	Complex a0 = cload(x + q);
+	Complex a1 = cload(x + q + xs);
+	cstore(y + q, cadd(a0, a1));
+	cstore(y + q + ys, cmul(csub(a0, a1), w1));
+      }
+    }
+  }
+
+  // radix 3:
+  //  b1,2 = a0 - (a1 + a2) / 2 -/+ i sin(2 pi / 3) (a1 - a2)
+  //
+  else if (r_a == 3) {
+    const double s1 = sin(2.0 * M_PI / 3.0);
+    for (long p = 0; p < m_a; p++) {
+      Complex w1 = cload(tw_a + 4 * p);
+      Complex w2 = cload(tw_a + 4 * p + 2);
+      const double* x = x_a + 2 * s_a * p;
+      double* y = y_a + 2 * s_a * 3 * p;
+
+      for (long q = 0; q < 2 * s_a; q += 2) {
+	Complex a0 = cload(x + q);
+	Complex a1 = cload(x + q + xs);
+	Complex a2 = cload(x + q + 2 * xs);
+	Complex t1 = cadd(a1, a2);
+	Complex t2 = cscale(cmul_mi(csub(a1, a2)), s1);
+	Complex t3 = csub(a0, cscale(t1, 0.5));
+	cstore(y + q, cadd(a0, t1));
+	cstore(y + q + ys, cmul(cadd(t3, t2), w1));
+	cstore(y + q + 2 * ys, cmul(csub(t3, t2), w2));
+      }
+    }
+  }
+
+  // radix 5:
+  //  with t1 = a1 + a4, t2 = a2 + a3, t3 = a1 - a4, t4 = a2 - a3,
+  //  b1,4 = a0 + c1 t1 + c2 t2 -/+ i (s1 t3 + s2 t4)
+  //  b2,3 = a0 + c2 t1 + c1 t2 -/+ i (s2 t3 - s1 t4)
+  //
+  else if (r_a == 5) {
+    const double c1 = cos(2.0 * M_PI / 5.0);
+    const double c2 = cos(4.0 * M_PI / 5.0);
+    const double s1 = sin(2.0 * M_PI / 5.0);
+    const double s2 = sin(4.0 * M_PI / 5.0);
+    for (long p = 0; p < m_a; p++) {
+      Complex w1 = cload(tw_a + 8 * p);
+      Complex w2 = cload(tw_a + 8 * p + 2);
+      Complex w3 = cload(tw_a + 8 * p + 4);
+      Complex w4 = cload(tw_a + 8 * p + 6);
+      const double* x = x_a + 2 * s_a * p;
+      double* y = y_a + 2 * s_a * 5 * p;
+
+      for (long q = 0; q < 2 * s_a; q += 2) {
+	Complex a0 = cload(x + q);
+	Complex a1 = cload(x + q + xs);
+	Complex a2 = cload(x + q + 2 * xs);
+	Complex a3 = cload(x + q + 3 * xs);
+	Complex a4 = cload(x + q + 4 * xs);
+	Complex t1 = cadd(a1, a4);
+	Complex t2 = cadd(a2, a3);
+	Complex t3 = cmul_mi(csub(a1, a4));
+	Complex t4 = cmul_mi(csub(a2, a3));
+	Complex u1 = cadd(a0, cadd(cscale(t1, c1), cscale(t2, c2)));
+	Complex u2 = cadd(a0, cadd(cscale(t1, c2), cscale(t2, c1)));
+	Complex v1 = cadd(cscale(t3, s1), cscale(t4, s2));
+	Complex v2 = csub(cscale(t3, s2), cscale(t4, s1));
+	cstore(y + q, cadd(a0, cadd(t1, t2)));
+	cstore(y + q + ys, cmul(cadd(u1, v1), w1));
+	cstore(y + q + 2 * ys, cmul(cadd(u2, v2), w2));
+	cstore(y + q + 3 * ys, cmul(csub(u2, v2), w3));
+	cstore(y + q + 4 * ys, cmul(csub(u1, v1), w4));
+      }
+    }
+  }
+
+  // any other radix: a direct DFT using the roots stored after the
+  // twiddle factors
+  //
+  else {
+    const double* rt = tw_a + 2 * (r_a - 1) * m_a;
+    Complex a[r_a];
+    for (long p = 0; p < m_a; p++) {
+      const double* w = tw_a + 2 * (r_a - 1) * p;
+      const double* x = x_a + 2 * s_a * p;
+      double* y = y_a + 2 * s_a * r_a * p;
+
+      for (long q = 0; q < 2 * s_a; q += 2) {
+	for (long k = 0; k < r_a; k++) {
+	  a[k] = cload(x + q + k * xs);
+	}
+	for (long j = 0; j < r_a; j++) {
+	  Complex b = a[0];
+	  for (long k = 1; k < r_a; k++) {
+	    b = cadd(b, cmul(a[k], cload(rt + 2 * ((j * k) % r_a))));
+	  }
+	  if (j > 0) {
+	    b = cmul(b, cload(w + 2 * (j - 1)));
+	  }
+	  cstore(y + q + j * ys, b);
+	}
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: fft_real
+//
+// arguments:
+//  long plan: the index of the plan (input)
+//  double* y: n / 2 + 1 interleaved complex bins (output)
+//  const double* x: n real samples (input)
+//
+// return: a logical value indicating status
+//
+// This method computes a real transform with a plan. For even n, the
+// transform Z of z[t] = x[2t] + i x[2t + 1] is split into the
+// transforms of the even and odd samples:
+//
+//  E[k] = (Z[k] + conj(Z[M - k])) / 2
+//  O[k] = (Z[k] - conj(Z[M - k])) / 2i
+//  X[k] = E[k] + exp(-2 pi i k / n) O[k],   M = n / 2, Z[M] = Z[0]
+//
+bool Edf::fft_real(long plan_a, double* y_a, const double* x_a) {
+
+  // declare local variables
+  //
+  long n = fft_n_d[plan_a];
+  long nc = fft_nc_d[plan_a];
+  double* a = fft_work_d;
+  double* b = fft_work_d + 2 * nc;
+
+  // odd lengths: a complex transform of the samples
+  //
+  if (nc == n) {
+    for (long t = 0; t < n; t++) {
+      a[2 * t] = x_a[t];
+      a[2 * t + 1] = 0.0;
+    }
+    double* z = Edf::fft_complex(plan_a, a, b);
+    memcpy(y_a, z, 2 * (n / 2 + 1) * sizeof(double));
+    return true;
+  }
+
+  // even lengths: the samples are already interleaved complex values
+  //
+  memcpy(a, x_a, n * sizeof(double));
+  double* z = Edf::fft_complex(plan_a, a, b);
+
+  // split the transform
+  //
+  const double* ws = fft_tab_d[plan_a] + 2 * fft_soff_d[plan_a];
+  for (long k = 0; k <= nc; k++) {
+    long k1 = (k == nc) ? 0 : k;
+    long k2 = (k == 0) ? 0 : nc - k;
+    Complex zk = cload(z + 2 * k1);
+    Complex zc = cset(z[2 * k2], -z[2 * k2 + 1]);
+    Complex e = cscale(cadd(zk, zc), 0.5);
+    Complex o = cscale(cmul_mi(csub(zk, zc)), 0.5);
+    cstore(y_a + 2 * k, cadd(e, cmul(o, cload(ws + 2 * k))));
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: ifft_real
+//
+// arguments:
+//  long plan: the index of the plan (input)
+//  double* y: n real samples (output)
+//  const double* x: n / 2 + 1 interleaved complex bins (input)
+//
+// return: a logical value indicating status
+//
+// This method computes an inverse real transform with a plan. For even
+// n, the split is undone:
+//
+//  E[k] = (X[k] + conj(X[M - k])) / 2
+//  O[k] = (X[k] - conj(X[M - k])) exp(2 pi i k / n) / 2
+//  Z[k] = E[k] + i O[k]
+//
+// and z = conj(fft(conj(Z))) / M gives the even and odd samples.
+//
+bool Edf::ifft_real(long plan_a, double* y_a, const double* x_a) {
+
+  // declare local variables
+  //
+  long n = fft_n_d[plan_a];
+  long nc = fft_nc_d[plan_a];
+  double* a = fft_work_d;
+  double* b = fft_work_d + 2 * nc;
+
+  // odd lengths: rebuild the conjugate of the full spectrum
+  //
+  if (nc == n) {
+    for (long k = 0; k <= n / 2; k++) {
+      a[2 * k] = x_a[2 * k];
+      a[2 * k + 1] = (k == 0) ? 0.0 : -x_a[2 * k + 1];
+    }
+    for (long k = n / 2 + 1; k < n; k++) {
+      a[2 * k] = x_a[2 * (n - k)];
+      a[2 * k + 1] = x_a[2 * (n - k) + 1];
+    }
+    double* z = Edf::fft_complex(plan_a, a, b);
+    for (long t = 0; t < n; t++) {
+      y_a[t] = z[2 * t] / n;
+    }
+    return true;
+  }
+
+  // even lengths: merge the halves into conj(Z)
+  //
+  const double* ws = fft_tab_d[plan_a] + 2 * fft_soff_d[plan_a];
+  for (long k = 0; k < nc; k++) {
+    Complex xk = cset(x_a[2 * k], (k == 0) ? 0.0 : x_a[2 * k + 1]);
+    Complex xc = cset(x_a[2 * (nc - k)],
+		      (k == 0) ? 0.0 : -x_a[2 * (nc - k) + 1]);
+    Complex e = cscale(cadd(xk, xc), 0.5);
+    Complex o = cscale(cmul(csub(xk, xc), cset(ws[2 * k], -ws[2 * k + 1])),
+		       0.5);
+
+    // z = e + i o, stored conjugated
+    //
+    Complex z = csub(e, cmul_mi(o));
+    double tmp[2];
+    cstore(tmp, z);
+    a[2 * k] = tmp[0];
+    a[2 * k + 1] = -tmp[1];
+  }
+
+  // transform and conjugate back
+  //
+  double* z = Edf::fft_complex(plan_a, a, b);
+  double scale = 1.0 / nc;
+  for (long t = 0; t < nc; t++) {
+    y_a[2 * t] = z[2 * t] * scale;
+    y_a[2 * t + 1] = -z[2 * t + 1] * scale;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
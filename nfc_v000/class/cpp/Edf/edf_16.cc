@@ -0,0 +1,374 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_16.cc
+//
+// This file contains methods associated with the class Edf that compute
+// log band power features.
+//
+// The power in a band is the power of the signal, in squared signal
+// units, that falls in [lo, hi) Hz:
+//
+//  P = sum_k g_k c_k |X[k]|^2 / (n sum_t w[t]^2)
+//
+// where X is the transform of a frame of n samples tapered by the
+// window w, c_k is 2 for bins that stand for a positive and a negative
+// frequency (1 for bin 0 and bin n / 2), and g_k is the fraction of
+// bin k (centered on k fs / n, fs / n Hz wide, and clipped to
+// [0, fs / 2]) that lies inside the band. The weights are computed
+// once per frame length, sample frequency and window.
+// For a rectangular window the bands add up to the mean square of the
+// frame (Parseval).
+//
+// The features are log(max(P, LOG_FLOOR)). Each frame is tapered,
+// transformed and reduced in a scratch buffer, so neither the frames
+// nor the spectra are stored. Frames of a signal can instead slide the
+// bins of the bands (see set_spectrum_mode and edf_21), or average the
+// spectra of several tapers (edf_23), whose weights add up to one and
+// whose energy is one, so sum_t w[t]^2 is replaced by 1.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+// method: set_bands
+//
+// arguments:
+//  VectorDouble& flo: the lower edge of each band in Hz (input)
+//  VectorDouble& fhi: the upper edge of each band in Hz (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the bands. Bands may overlap or leave gaps.
+//
+bool Edf::set_bands(VectorDouble& flo_a, VectorDouble& fhi_a) {
+
+  // check the bands
+  //
+  if ((flo_a.size() == 0) || (flo_a.size() != fhi_a.size())) {
+    fprintf(stdout, "**> Edf::set_bands(): invalid number of bands\n");
+    return false;
+  }
+  for (long i = 0; i < (long)flo_a.size(); i++) {
+    if ((flo_a[i] < 0) || (fhi_a[i] <= flo_a[i])) {
+      fprintf(stdout, "**> Edf::set_bands(): invalid band %ld [%f %f]\n",
+	      i, flo_a[i], fhi_a[i]);
+      return false;
+    }
+  }
+
+  // save the bands and invalidate the weights
+  //
+  Edf::resize(band_lo_d, flo_a.size(), false);
+  Edf::resize(band_hi_d, fhi_a.size(), false);
+  band_lo_d = flo_a;
+  band_hi_d = fhi_a;
+  band_n_d = -1;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_band_power
+//
+// arguments:
+//  FeatureTensor& feat: log band powers (output)
+//  VVectorDouble& sig: the signal (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the log band power of every frame of every
+// channel: feat(i, j, b) is band b of frame j of channel i. Frames are
+// cut as in frame_signal, but are taken straight from the signal, and
+// their spectra are computed as set by set_spectrum_mode.
+//
+bool Edf::compute_band_power(FeatureTensor& feat_a, VVectorDouble& sig_a) {
+
+  // check the frame parameters
+  //
+  long shift = Edf::get_frame_shift();
+  long n = Edf::get_window_length();
+  if ((shift <= 0) || (n <= 0)) {
+    fprintf(stdout, "**> Edf::compute_band_power(): %s (%f %f %f)\n",
+	    "invalid frame parameters (fdur, wdur, fs)",
+	    fdur_d, wdur_d, (double)hdr_sample_frequency_d);
+    return false;
+  }
+
+  // find the number of frames
+  //
+  long nchan = sig_a.size();
+  long nframes = (nchan > 0) ? Edf::get_num_frames(sig_a[0].size()) : 0;
+  for (long i = 1; i < nchan; i++) {
+    long nf = Edf::get_num_frames(sig_a[i].size());
+    if (nf < nframes) {
+      nframes = nf;
+    }
+  }
+
+  // prepare the window, the transform and the weights
+  //
+  long plan = Edf::get_fft_plan(n);
+  if ((plan < 0) || (!Edf::create_window(n)) ||
+      (!Edf::create_band_weights(n)) ||
+      (!feat_a.resize(nchan, nframes, band_lo_d.size()))) {
+    return false;
+  }
+  if ((spec_mode_d == SPEC_SLIDING) &&
+      (!Edf::create_sdft_tables(n, shift, 1))) {
+    return false;
+  }
+  if ((spec_mode_d == SPEC_MULTITAPER) && (!Edf::create_multitaper(n))) {
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::compute_band_power(): %s %ld %ld %ld %ld\n",
+	    "(nchan, nframes, n, nbands)", nchan, nframes, n,
+	    (long)band_lo_d.size());
+  }
+
+  // compute the spectrum of each frame and reduce it
+  //
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; j < nframes; j++) {
+      Edf::band_frame(feat_a.get_frame(i, j), &sig_a[i][0] + j * shift,
+		      plan, 0, j == 0);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_band_power
+//
+// arguments:
+//  FeatureTensor& feat: log band powers (output)
+//  FeatureTensor& frames: tapered frames (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the log band power of frames produced by
+// frame_signal. The frames are assumed to be tapered by the current
+// window, whose power is used to scale the bands.
+//
+bool Edf::compute_band_power(FeatureTensor& feat_a, FeatureTensor& frames_a) {
+
+  // declare local variables
+  //
+  long nchan = frames_a.get_nchan();
+  long nframes = frames_a.get_nframes();
+  long n = frames_a.get_dim();
+
+  // prepare the window, the transform and the weights
+  //
+  long plan = Edf::get_fft_plan(n);
+  if ((plan < 0) || (!Edf::create_window(n)) ||
+      (!Edf::create_band_weights(n)) ||
+      (!feat_a.resize(nchan, nframes, band_lo_d.size()))) {
+    return false;
+  }
+
+  // reduce each frame
+  //
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; j < nframes; j++) {
+      Edf::band_power(feat_a.get_frame(i, j), frames_a.get_frame(i, j),
+		      plan);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: create_band_weights
+//
+// arguments:
+//  long n: the frame length in samples (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the bin weights of the bands, including the
+// one-sided and the window scale, and sizes the scratch buffer. The
+// current window table must be of length n. Nothing is done if the
+// weights are current.
+//
+bool Edf::create_band_weights(long n_a) {
+
+  // check if the weights are current: sliding bins use the weights of
+  // transforms
+  //
+  double fs = hdr_sample_frequency_d;
+  SPECTRUM_MODE mode =
+    (spec_mode_d == SPEC_MULTITAPER) ? SPEC_MULTITAPER : SPEC_FFT;
+  if ((band_n_d == n_a) && (band_fs_d == fs) &&
+      (band_win_d == win_ttype_d) && (band_mode_d == mode)) {
+    return true;
+  }
+  if (fs <= 0) {
+    fprintf(stdout,
+	    "**> Edf::create_band_weights(): sample frequency is not set\n");
+    return false;
+  }
+
+  // grow the scratch buffer: a frame and its spectrum
+  //
+  long bsize = n_a + 2 * (n_a / 2 + 1);
+  if (bsize > band_bsize_d) {
+    free(band_buf_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       bsize * sizeof(double)) != 0) {
+      band_buf_d = (double*)NULL;
+      band_bsize_d = 0;
+      band_n_d = -1;
+      fprintf(stdout, "**> Edf::create_band_weights(): out of memory\n");
+      return false;
+    }
+    band_buf_d = (double*)ptr;
+    band_bsize_d = bsize;
+  }
+
+  // compute the scale: the power of the window, or of the tapers
+  //
+  double wpow = 0;
+  for (long t = 0; t < n_a; t++) {
+    wpow += win_tab_d[t] * win_tab_d[t];
+  }
+  if (mode == SPEC_MULTITAPER) {
+    wpow = 1.0;
+  }
+  double scale = (wpow > 0) ? 1.0 / (n_a * wpow) : 0.0;
+
+  // find the bins of each band and their weights
+  //
+  long nbands = band_lo_d.size();
+  long nbins = n_a / 2 + 1;
+  double df = fs / n_a;
+
+  Edf::resize(band_first_d, nbands, false);
+  Edf::resize(band_nbins_d, nbands, false);
+  Edf::resize(band_wgt_d, nbands * nbins, false);
+
+  long nw = 0;
+  for (long b = 0; b < nbands; b++) {
+    band_first_d[b] = 0;
+    band_nbins_d[b] = 0;
+
+    for (long k = 0; k < nbins; k++) {
+
+      // the overlap of the bin with the band: bin 0 and bin n / 2
+      // only span half a bin inside [0, fs / 2]
+      //
+      double blo = Edf::max(0.0, (k - 0.5) * df);
+      double bhi = Edf::min(fs / 2, (k + 0.5) * df);
+      double lo = Edf::max(band_lo_d[b], blo);
+      double hi = Edf::min(band_hi_d[b], bhi);
+      if (hi <= lo) {
+	continue;
+      }
+      if (band_nbins_d[b] == 0) {
+	band_first_d[b] = k;
+      }
+
+      // the weight, with the bins in between kept contiguous
+      //
+      double c = ((k == 0) || (2 * k == n_a)) ? 1.0 : 2.0;
+      long l = k - band_first_d[b];
+      while (band_nbins_d[b] < l) {
+	band_wgt_d[nw++] = 0;
+	band_nbins_d[b]++;
+      }
+      band_wgt_d[nw++] = c * scale * (hi - lo) / (bhi - blo);
+      band_nbins_d[b]++;
+    }
+
+    if ((band_nbins_d[b] == 0) && (debug_level_d >= LEVEL_BRIEF)) {
+      fprintf(stdout, "Edf::create_band_weights(): band %ld %s\n",
+	      b, "has no bins below the Nyquist frequency");
+    }
+  }
+
+  // save the parameters of the weights: the sliding tables depend on
+  // the bins
+  //
+  band_n_d = n_a;
+  band_fs_d = fs;
+  band_win_d = win_ttype_d;
+  band_mode_d = mode;
+  sdft_n_d = -1;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: band_power
+//
+// arguments:
+//  double* y: the log power of each band (output)
+//  const double* x: a tapered frame (input)
+//  long plan: the fft plan of the frame length (input)
+//
+// return: a logical value indicating status
+//
+// This method transforms one frame into the scratch buffer and reduces
+// the spectrum to log band powers.
+//
+bool Edf::band_power(double* y_a, const double* x_a, long plan_a) {
+
+  // transform the frame
+  //
+  double* spec = band_buf_d + band_n_d;
+  Edf::fft_real(plan_a, spec, x_a);
+
+  // exit gracefully
+  //
+  return Edf::band_sum(y_a, spec);
+}
+
+// method: band_sum
+//
+// arguments:
+//  double* y: the log power of each band (output)
+//  const double* spec: the spectrum of a tapered frame (input)
+//
+// return: a logical value indicating status
+//
+// This method reduces a spectrum to log band powers. Only the bins of
+// the bands are read.
+//
+bool Edf::band_sum(double* y_a, const double* spec_a) {
+
+  // integrate the bands
+  //
+  const double* w = &band_wgt_d[0];
+  for (long b = 0; b < (long)band_lo_d.size(); b++) {
+    const double* z = spec_a + 2 * band_first_d[b];
+    long nk = band_nbins_d[b];
+    double sum = 0;
+    for (long k = 0; k < nk; k++) {
+      sum += w[k] * (z[2 * k] * z[2 * k] + z[2 * k + 1] * z[2 * k + 1]);
+    }
+    w += nk;
+    y_a[b] = log(Edf::max(sum, LOG_FLOOR));
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,376 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_17.cc
+//
+// This file contains methods associated with the class Edf that compute
+// linear frequency cepstral coefficients (LFCCs).
+//
+// Each frame produces 1 + ncep features:
+//
+//  feat[0]     = log(sum_t x[t]^2)              (frame energy)
+//  feat[i]     = c_i, i = 1, ..., ncep          (cepstral coefficients)
+//
+// The energy is computed from the untapered frame, as in HTK. The
+// cepstral coefficients are computed from the tapered frame:
+//
+//  F_m = sum_k H_m[k] |X[k]|^2                  (filterbank energies)
+//  c_i = sqrt(2 / M) sum_m log(F_m) cos(pi i (m + 0.5) / M)
+//
+// where H_m, m = 0, ..., M - 1, are triangular filters equally spaced
+// (in Hz) between flo and fhi, so neighbouring filters overlap by half.
+// The filters and the DCT are tabulated once per frame length, sample
+// frequency and set of parameters. Both products are computed with
+// vectorized dot products, and the summation order is fixed, so the
+// output of a build does not change from run to run. Logs are floored
+// at LOG_FLOOR.
+//
+// The layout matches the ENERGY and CEPSTRAL feature names: energy
+// first, followed by the cepstral coefficients. Delta features can be
+// appended by the delta methods.
+//
+
+// system include files
+//
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+// method: set_lfcc
+//
+// arguments:
+//  long nfilt: the number of filters (input)
+//  long ncep: the number of cepstral coefficients (input)
+//  double flo: the lower edge of the filterbank in Hz (input)
+//  double fhi: the upper edge in Hz, or 0 for half the sample
+//              frequency (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the parameters of the cepstral front end. ncep must
+// be less than nfilt.
+//
+bool Edf::set_lfcc(long nfilt_a, long ncep_a, double flo_a, double fhi_a) {
+
+  // check the parameters
+  //
+  if ((nfilt_a <= 0) || (ncep_a <= 0) || (ncep_a >= nfilt_a) ||
+      (flo_a < 0) || ((fhi_a > 0) && (fhi_a <= flo_a))) {
+    fprintf(stdout, "**> Edf::set_lfcc(): %s (%ld %ld %f %f)\n",
+	    "invalid parameters", nfilt_a, ncep_a, flo_a, fhi_a);
+    return false;
+  }
+
+  // save the parameters and invalidate the tables
+  //
+  lfcc_nfilt_d = nfilt_a;
+  lfcc_ncep_d = ncep_a;
+  lfcc_flo_d = flo_a;
+  lfcc_fhi_d = fhi_a;
+  lfcc_n_d = -1;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_lfcc
+//
+// arguments:
+//  FeatureTensor& feat: energy and cepstral coefficients (output)
+//  VVectorDouble& sig: the signal (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the energy and the cepstral coefficients of
+// every frame of every channel: feat(i, j, 0) is the log energy of
+// frame j of channel i and feat(i, j, k) is c_k. Frames are cut as in
+// frame_signal and tapered by the current window.
+//
+bool Edf::compute_lfcc(FeatureTensor& feat_a, VVectorDouble& sig_a) {
+
+  // check the frame parameters
+  //
+  long shift = Edf::get_frame_shift();
+  long n = Edf::get_window_length();
+  if ((shift <= 0) || (n <= 0)) {
+    fprintf(stdout, "**> Edf::compute_lfcc(): %s (%f %f %f)\n",
+	    "invalid frame parameters (fdur, wdur, fs)",
+	    fdur_d, wdur_d, (double)hdr_sample_frequency_d);
+    return false;
+  }
+
+  // find the number of frames
+  //
+  long nchan = sig_a.size();
+  long nframes = (nchan > 0) ? Edf::get_num_frames(sig_a[0].size()) : 0;
+  for (long i = 1; i < nchan; i++) {
+    long nf = Edf::get_num_frames(sig_a[i].size());
+    if (nf < nframes) {
+      nframes = nf;
+    }
+  }
+
+  // prepare the window, the transform and the tables
+  //
+  long plan = Edf::get_fft_plan(n);
+  if ((plan < 0) || (!Edf::create_window(n)) ||
+      (!Edf::create_lfcc_tables(n)) ||
+      (!feat_a.resize(nchan, nframes, 1 + lfcc_ncep_d))) {
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::compute_lfcc(): %s %ld %ld %ld %ld %ld\n",
+	    "(nchan, nframes, n, nfilt, ncep)", nchan, nframes, n,
+	    lfcc_nfilt_d, lfcc_ncep_d);
+  }
+
+  // compute the features of each frame
+  //
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; j < nframes; j++) {
+      Edf::lfcc_frame(feat_a.get_frame(i, j), &sig_a[i][0] + j * shift,
+		      plan);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: create_lfcc_tables
+//
+// arguments:
+//  long n: the frame length in samples (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the filterbank and the DCT, and sizes the
+// scratch buffer. lfcc_buf_d holds, in order, the DCT (ncep rows of
+// nfilt values), a frame, its spectrum, its power spectrum and its log
+// filterbank energies. Nothing is done if the tables are current.
+//
+bool Edf::create_lfcc_tables(long n_a) {
+
+  // check if the tables are current
+  //
+  double fs = hdr_sample_frequency_d;
+  if ((lfcc_n_d == n_a) && (lfcc_fs_d == fs)) {
+    return true;
+  }
+  if (fs <= 0) {
+    fprintf(stdout,
+	    "**> Edf::create_lfcc_tables(): sample frequency is not set\n");
+    return false;
+  }
+
+  // declare local variables
+  //
+  long nfilt = lfcc_nfilt_d;
+  long ncep = lfcc_ncep_d;
+  long nbins = n_a / 2 + 1;
+  double df = fs / n_a;
+  double flo = lfcc_flo_d;
+  double fhi = (lfcc_fhi_d > 0) ? Edf::min(lfcc_fhi_d, fs / 2) : fs / 2;
+  if (fhi <= flo) {
+    fprintf(stdout, "**> Edf::create_lfcc_tables(): %s [%f %f]\n",
+	    "the filterbank is above half the sample frequency", flo, fhi);
+    return false;
+  }
+
+  // grow the scratch buffer
+  //
+  long bsize = ncep * nfilt + n_a + 2 * nbins + nbins + nfilt;
+  if (bsize > lfcc_bsize_d) {
+    free(lfcc_buf_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       bsize * sizeof(double)) != 0) {
+      lfcc_buf_d = (double*)NULL;
+      lfcc_bsize_d = 0;
+      lfcc_n_d = -1;
+      fprintf(stdout, "**> Edf::create_lfcc_tables(): out of memory\n");
+      return false;
+    }
+    lfcc_buf_d = (double*)ptr;
+    lfcc_bsize_d = bsize;
+  }
+
+  // compute the filters:
+  //  filter m rises from edge m to edge m + 1 and falls to edge m + 2
+  //
+  Edf::resize(lfcc_first_d, nfilt, false);
+  Edf::resize(lfcc_nbins_d, nfilt, false);
+  Edf::resize(lfcc_wgt_d, nfilt * nbins, false);
+
+  double step = (fhi - flo) / (nfilt + 1);
+  long nw = 0;
+  for (long m = 0; m < nfilt; m++) {
+    double lo = flo + m * step;
+    double ctr = lo + step;
+    double hi = ctr + step;
+    lfcc_first_d[m] = 0;
+    lfcc_nbins_d[m] = 0;
+
+    for (long k = 0; k < nbins; k++) {
+      double f = k * df;
+      if ((f <= lo) || (f >= hi)) {
+	continue;
+      }
+      if (lfcc_nbins_d[m] == 0) {
+	lfcc_first_d[m] = k;
+      }
+      lfcc_wgt_d[nw++] = (f <= ctr) ? (f - lo) / step : (hi - f) / step;
+      lfcc_nbins_d[m]++;
+    }
+
+    if ((lfcc_nbins_d[m] == 0) && (debug_level_d >= LEVEL_BRIEF)) {
+      fprintf(stdout, "Edf::create_lfcc_tables(): filter %ld %s\n",
+	      m, "contains no bins (the frames are too short)");
+    }
+  }
+
+  // compute the DCT
+  //
+  double* dct = lfcc_buf_d;
+  double scale = sqrt(2.0 / nfilt);
+  for (long i = 0; i < ncep; i++) {
+    for (long m = 0; m < nfilt; m++) {
+      dct[i * nfilt + m] = scale * cos(M_PI * (i + 1) * (m + 0.5) / nfilt);
+    }
+  }
+
+  // save the parameters of the tables
+  //
+  lfcc_n_d = n_a;
+  lfcc_fs_d = fs;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: lfcc_frame
+//
+// arguments:
+//  double* y: energy and cepstral coefficients (output)
+//  const double* x: the untapered frame (input)
+//  long plan: the fft plan of the frame length (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the features of one frame in the scratch buffer.
+//
+bool Edf::lfcc_frame(double* y_a, const double* x_a, long plan_a) {
+
+  // declare local variables
+  //
+  long n = lfcc_n_d;
+  long nfilt = lfcc_nfilt_d;
+  long ncep = lfcc_ncep_d;
+  long nbins = n / 2 + 1;
+  double* dct = lfcc_buf_d;
+  double* frame = dct + ncep * nfilt;
+  double* spec = frame + n;
+  double* pow = spec + 2 * nbins;
+  double* fbank = pow + nbins;
+
+  // compute the energy of the frame
+  //
+  y_a[0] = log(Edf::max(Edf::dot(x_a, x_a, n), LOG_FLOOR));
+
+  // taper and transform the frame, and find its power spectrum
+  //
+  Edf::multiply(frame, x_a, win_tab_d, n);
+  Edf::fft_real(plan_a, spec, frame);
+  for (long k = 0; k < nbins; k++) {
+    pow[k] = spec[2 * k] * spec[2 * k] + spec[2 * k + 1] * spec[2 * k + 1];
+  }
+
+  // apply the filterbank
+  //
+  const double* w = &lfcc_wgt_d[0];
+  for (long m = 0; m < nfilt; m++) {
+    long nk = lfcc_nbins_d[m];
+    double e = Edf::dot(w, pow + lfcc_first_d[m], nk);
+    fbank[m] = log(Edf::max(e, LOG_FLOOR));
+    w += nk;
+  }
+
+  // apply the DCT
+  //
+  for (long i = 0; i < ncep; i++) {
+    y_a[1 + i] = Edf::dot(dct + i * nfilt, fbank, nfilt);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: dot
+//
+// arguments:
+//  const double* x: the first vector (input)
+//  const double* y: the second vector (input)
+//  long n: the number of elements (input)
+//
+// return: the dot product of x and y
+//
+// This method computes a dot product with AVX or SSE2 when the
+// compiler targets them. The partial sums are always added in the same
+// order, so the result is reproducible for a given build.
+//
+double Edf::dot(const double* x_a, const double* y_a, long n_a) {
+
+  // declare local variables
+  //
+  long i = 0;
+  double sum = 0;
+
+  // accumulate full vectors
+  //
+#if defined(__AVX__)
+  __m256d acc = _mm256_setzero_pd();
+  for (; i + 4 <= n_a; i += 4) {
+    acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(x_a + i),
+					   _mm256_loadu_pd(y_a + i)));
+  }
+  double part[4];
+  _mm256_storeu_pd(part, acc);
+  sum = (part[0] + part[1]) + (part[2] + part[3]);
+#elif defined(__SSE2__)
+  __m128d acc = _mm_setzero_pd();
+  for (; i + 2 <= n_a; i += 2) {
+    acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(x_a + i),
+				     _mm_loadu_pd(y_a + i)));
+  }
+  double part[2];
+  _mm_storeu_pd(part, acc);
+  sum = part[0] + part[1];
+#endif
+
+  // accumulate the rest
+  //
+  for (; i < n_a; i++) {
+    sum += x_a[i] * y_a[i];
+  }
+
+  // exit gracefully
+  //
+  return sum;
+}
+
+//
+// end of file
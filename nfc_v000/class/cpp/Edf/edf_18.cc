@@ -0,0 +1,547 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_18.cc
+//
+// This file contains methods associated with the class Edf that append
+// differential features (deltas, delta-deltas and minmax differential
+// energy) to feature frames.
+//
+// A frame of dimension D is extended to:
+//
+//  [ b (D1) | d (D1) | a (ndd) ]
+//
+// where b is the frame followed, if enabled, by the differential energy
+// (so D1 is D or D + 1), d are the deltas of b and a are the
+// delta-deltas of the first ndd values of d (by default the D values
+// that precede the differential energy). With the cepstral front end
+// and minmax energy enabled, the energy and the cepstra get deltas and
+// delta-deltas, and the differential energy only gets a delta (the
+// DMINMAX_EGY_NO_DELTA-DELTA feature name).
+//
+// The deltas use the HTK regression formula over +/- win frames:
+//
+//  d[t] = sum_{k=1}^{win} k (b[t + k] - b[t - k]) / (2 sum_{k=1}^{win} k^2)
+//
+// and the differential energy of frame t is the maximum minus the
+// minimum of the energy (value 0 of the frame) over +/- mmwin frames.
+// Frames beyond either end of a sequence are replicas of the first or
+// the last frame.
+//
+// The features are computed as a stream. Each channel runs a pipeline
+// of up to three stages (minmax, delta, delta-delta), each holding a
+// ring buffer of 2h + 1 frames, where h is its half width. A stage
+// passes on its center frame with its own values appended, so the
+// output of the last stage is the complete frame. The output lags the
+// input by mmwin + 2 win frames; the missing frames are produced when
+// the stream is flushed. The batch method runs the same pipeline over a
+// tensor, so both give identical values.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+// method: set_deltas
+//
+// arguments:
+//  long win: the half width of the regression window in frames (input)
+//  long ndd: the number of values that get delta-deltas, or -1 for the
+//            values of the input frames (input)
+//
+// return: a logical value indicating status
+//
+bool Edf::set_deltas(long win_a, long ndd_a) {
+
+  // check the parameters
+  //
+  if ((win_a <= 0) || (win_a > MAX_DELTA_WIN) || (ndd_a < -1)) {
+    fprintf(stdout, "**> Edf::set_deltas(): invalid parameters (%ld %ld)\n",
+	    win_a, ndd_a);
+    return false;
+  }
+
+  // save the parameters
+  //
+  dlt_win_d = win_a;
+  dlt_ndd_d = ndd_a;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: set_minmax_energy
+//
+// arguments:
+//  bool mode: if true, the differential energy is appended (input)
+//  long win: the half width of its window in frames (input)
+//
+// return: a logical value indicating status
+//
+bool Edf::set_minmax_energy(bool mode_a, long win_a) {
+
+  // check the parameters
+  //
+  if ((win_a <= 0) || (win_a > MAX_DELTA_WIN)) {
+    fprintf(stdout, "**> Edf::set_minmax_energy(): invalid window %ld\n",
+	    win_a);
+    return false;
+  }
+
+  // save the parameters
+  //
+  dlt_mm_d = mode_a;
+  dlt_mmwin_d = win_a;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_delta_dim
+//
+// arguments:
+//  long dim: the dimension of the input frames (input)
+//
+// return: the dimension of the output frames
+//
+long Edf::get_delta_dim(long dim_a) {
+
+  // count the values of each part
+  //
+  long d1 = dim_a + (dlt_mm_d ? 1 : 0);
+  long ndd = (dlt_ndd_d < 0) ? dim_a : dlt_ndd_d;
+  if (ndd > d1) {
+    ndd = d1;
+  }
+
+  // exit gracefully
+  //
+  return 2 * d1 + ndd;
+}
+
+// method: append_deltas
+//
+// arguments:
+//  FeatureTensor& feat: the features (input/output)
+//
+// return: a logical value indicating status
+//
+// This method appends the differential features to every frame of a
+// tensor, in place. The tensor is widened to get_delta_dim values per
+// frame. Any open delta stream is closed.
+//
+bool Edf::append_deltas(FeatureTensor& feat_a) {
+
+  // declare local variables
+  //
+  long nchan = feat_a.get_nchan();
+  long nframes = feat_a.get_nframes();
+  long dim = feat_a.get_dim();
+
+  // widen the frames and set up one stream per channel
+  //
+  if ((dim <= 0) || (!Edf::open_delta_stream(nchan, dim)) ||
+      (!feat_a.set_dim(Edf::get_delta_dim(dim)))) {
+    Edf::close_delta_stream();
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::append_deltas(): %s %ld %ld %ld %ld\n",
+	    "(nchan, nframes, dim, new dim)", nchan, nframes, dim,
+	    feat_a.get_dim());
+  }
+
+  // stream each channel through its pipeline:
+  //  frame j is only written after frame j + lag has been read, and the
+  //  original values of a frame are copied when it is pushed, so the
+  //  output can overwrite the input
+  //
+  bool status = true;
+  for (long i = 0; (status) && (i < nchan); i++) {
+    long nout;
+    long j = 0;
+    for (long k = 0; (status) && (k < nframes); k++) {
+      status = Edf::push_delta_frame(feat_a.get_frame(i, j), nout,
+				     feat_a.get_frame(i, k), i);
+      j += nout;
+    }
+    while ((status) && (j < nframes)) {
+      status = Edf::flush_delta_frame(feat_a.get_frame(i, j), nout, i);
+      if (nout == 0) {
+	break;
+      }
+      j++;
+    }
+  }
+
+  // release the streams
+  //
+  Edf::close_delta_stream();
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: open_delta_stream
+//
+// arguments:
+//  long nchan: the number of channels (input)
+//  long dim: the dimension of the input frames (input)
+//
+// return: a logical value indicating status
+//
+// This method sets up a pipeline for every channel using the current
+// delta parameters. Any open stream is closed.
+//
+bool Edf::open_delta_stream(long nchan_a, long dim_a) {
+
+  // check the arguments
+  //
+  Edf::close_delta_stream();
+  if ((nchan_a <= 0) || (dim_a <= 0)) {
+    fprintf(stdout, "**> Edf::open_delta_stream(): %s (%ld %ld)\n",
+	    "invalid shape", nchan_a, dim_a);
+    return false;
+  }
+
+  // build the stages: each one passes its input on and appends values
+  //
+  long d1 = dim_a + (dlt_mm_d ? 1 : 0);
+  long ns = 0;
+  if (dlt_mm_d) {
+    dlt_type_d[ns] = DLT_MINMAX;
+    dlt_h_d[ns] = dlt_mmwin_d;
+    dlt_width_d[ns] = dim_a;
+    dlt_wout_d[ns++] = d1;
+  }
+  dlt_type_d[ns] = DLT_DELTA;
+  dlt_h_d[ns] = dlt_win_d;
+  dlt_width_d[ns] = d1;
+  dlt_wout_d[ns++] = 2 * d1;
+  dlt_type_d[ns] = DLT_DDELTA;
+  dlt_h_d[ns] = dlt_win_d;
+  dlt_width_d[ns] = 2 * d1;
+  dlt_wout_d[ns++] = Edf::get_delta_dim(dim_a);
+  dlt_nstages_d = ns;
+
+  // lay out the rings of a channel, followed by two frames of scratch
+  //
+  long cstride = 0;
+  for (long s = 0; s < ns; s++) {
+    dlt_off_d[s] = cstride;
+    cstride += (2 * dlt_h_d[s] + 1) * dlt_width_d[s];
+  }
+  long bsize = nchan_a * cstride + 2 * dlt_wout_d[ns - 1];
+
+  // create space
+  //
+  if (bsize > dlt_bsize_d) {
+    free(dlt_buf_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       bsize * sizeof(double)) != 0) {
+      dlt_buf_d = (double*)NULL;
+      dlt_bsize_d = 0;
+      fprintf(stdout, "**> Edf::open_delta_stream(): out of memory\n");
+      return false;
+    }
+    dlt_buf_d = (double*)ptr;
+    dlt_bsize_d = bsize;
+  }
+
+  // reset the state of every stage of every channel
+  //
+  Edf::resize(dlt_head_d, nchan_a * DLT_NSTAGES, false);
+  Edf::resize(dlt_fill_d, nchan_a * DLT_NSTAGES, false);
+  Edf::resize(dlt_nin_d, nchan_a * DLT_NSTAGES, false);
+  Edf::resize(dlt_nout_d, nchan_a * DLT_NSTAGES, false);
+  for (long i = 0; i < nchan_a * DLT_NSTAGES; i++) {
+    dlt_head_d[i] = 0;
+    dlt_fill_d[i] = 0;
+    dlt_nin_d[i] = 0;
+    dlt_nout_d[i] = 0;
+  }
+
+  dlt_nchan_d = nchan_a;
+  dlt_cstride_d = cstride;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: push_delta_frame
+//
+// arguments:
+//  double* y: an output frame (output)
+//  long& nout: the number of frames written to y, 0 or 1 (output)
+//  const double* x: an input frame (input)
+//  long chan: the channel (input)
+//
+// return: a logical value indicating status
+//
+// This method pushes a frame of dimension dim (see open_delta_stream)
+// through the pipeline of a channel. Once the pipeline is full, every
+// push produces the frame that is lag frames older. y must hold
+// get_delta_dim(dim) values and may be the same as x.
+//
+bool Edf::push_delta_frame(double* y_a, long& nout_a, const double* x_a,
+			   long chan_a) {
+
+  // check the stream
+  //
+  nout_a = 0;
+  if ((chan_a < 0) || (chan_a >= dlt_nchan_d)) {
+    fprintf(stdout, "**> Edf::push_delta_frame(): invalid channel %ld\n",
+	    chan_a);
+    return false;
+  }
+
+  // run the frame through the stages
+  //
+  return Edf::run_delta_stages(y_a, nout_a, x_a, chan_a, 0);
+}
+
+// method: flush_delta_frame
+//
+// arguments:
+//  double* y: an output frame (output)
+//  long& nout: the number of frames written to y, 0 or 1 (output)
+//  long chan: the channel (input)
+//
+// return: a logical value indicating status
+//
+// This method produces one of the frames still held by the pipeline of
+// a channel, by padding it with replicas of the last frame. It must be
+// called until nout is 0 at the end of a stream. The channel can then
+// be reused for a new stream.
+//
+bool Edf::flush_delta_frame(double* y_a, long& nout_a, long chan_a) {
+
+  // check the stream
+  //
+  nout_a = 0;
+  if ((chan_a < 0) || (chan_a >= dlt_nchan_d)) {
+    fprintf(stdout, "**> Edf::flush_delta_frame(): invalid channel %ld\n",
+	    chan_a);
+    return false;
+  }
+
+  // pad the first stage that still holds frames until a frame comes out
+  // of the last stage
+  //
+  long* nin = &dlt_nin_d[chan_a * DLT_NSTAGES];
+  long* nout = &dlt_nout_d[chan_a * DLT_NSTAGES];
+
+  for (long s = 0; s < dlt_nstages_d; s++) {
+    while (nout[s] < nin[s]) {
+      if (!Edf::run_delta_stages(y_a, nout_a, (const double*)NULL,
+				 chan_a, s)) {
+	return false;
+      }
+      if (nout_a > 0) {
+	return true;
+      }
+    }
+  }
+
+  // the stream is empty: reset the channel
+  //
+  for (long s = 0; s < DLT_NSTAGES; s++) {
+    dlt_head_d[chan_a * DLT_NSTAGES + s] = 0;
+    dlt_fill_d[chan_a * DLT_NSTAGES + s] = 0;
+    nin[s] = 0;
+    nout[s] = 0;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_delta_stream
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method ends the streams. Frames that were not flushed are lost.
+// The buffers are kept for the next stream.
+//
+bool Edf::close_delta_stream() {
+
+  // reset the shape
+  //
+  dlt_nchan_d = 0;
+  dlt_nstages_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: run_delta_stages
+//
+// arguments:
+//  double* y: an output frame (output)
+//  long& nout: the number of frames written to y, 0 or 1 (output)
+//  const double* x: an input frame, or NULL to pad the first stage with
+//                   a replica of its last input (input)
+//  long chan: the channel (input)
+//  long first: the first stage to run (input)
+//
+// return: a logical value indicating status
+//
+// This method pushes a frame into a stage and passes what comes out on
+// to the next stages. The two scratch frames at the end of the buffer
+// hold the output of a stage while it is pushed into the next one.
+//
+bool Edf::run_delta_stages(double* y_a, long& nout_a, const double* x_a,
+			   long chan_a, long first_a) {
+
+  // declare local variables
+  //
+  double* tmp[2];
+  tmp[0] = dlt_buf_d + dlt_nchan_d * dlt_cstride_d;
+  tmp[1] = tmp[0] + dlt_wout_d[dlt_nstages_d - 1];
+  const double* x = x_a;
+  nout_a = 0;
+
+  // run the stages: the last one writes to y
+  //
+  for (long s = first_a; s < dlt_nstages_d; s++) {
+    double* z = (s == dlt_nstages_d - 1) ? y_a : tmp[s % 2];
+    if (!Edf::push_delta_stage(z, x, chan_a, s)) {
+      return true;
+    }
+    x = z;
+  }
+
+  // exit gracefully
+  //
+  nout_a = 1;
+  return true;
+}
+
+// method: push_delta_stage
+//
+// arguments:
+//  double* y: the output of the stage (output)
+//  const double* x: an input frame, or NULL for a replica of the last
+//                   input (input)
+//  long chan: the channel (input)
+//  long s: the stage (input)
+//
+// return: true if a frame was written to y
+//
+// This method pushes a frame into the ring of a stage. The first frame
+// of a stream is pushed h + 1 times, so that the frames before it are
+// replicas. When the ring is full, the center frame is copied to y and
+// the values of the stage are appended.
+//
+bool Edf::push_delta_stage(double* y_a, const double* x_a, long chan_a,
+			   long s_a) {
+
+  // declare local variables
+  //
+  long k = chan_a * DLT_NSTAGES + s_a;
+  long h = dlt_h_d[s_a];
+  long r = 2 * h + 1;
+  long w = dlt_width_d[s_a];
+  double* ring = dlt_buf_d + chan_a * dlt_cstride_d + dlt_off_d[s_a];
+
+  // push the frame, or a replica of the last one
+  //
+  if (x_a != (const double*)NULL) {
+    long ncopy = (dlt_fill_d[k] == 0) ? h + 1 : 1;
+    for (long i = 0; i < ncopy; i++) {
+      dlt_head_d[k] = (dlt_head_d[k] + 1) % r;
+      memcpy(ring + dlt_head_d[k] * w, x_a, w * sizeof(double));
+    }
+    dlt_fill_d[k] += ncopy;
+    dlt_nin_d[k]++;
+  }
+  else {
+    long prev = dlt_head_d[k];
+    dlt_head_d[k] = (prev + 1) % r;
+    memcpy(ring + dlt_head_d[k] * w, ring + prev * w, w * sizeof(double));
+    dlt_fill_d[k]++;
+  }
+
+  // wait until the ring is full
+  //
+  if (dlt_fill_d[k] < r) {
+    return false;
+  }
+
+  // find the frames in time order: frame h is the center
+  //
+  const double* f[2 * MAX_DELTA_WIN + 1];
+  for (long i = 0; i < r; i++) {
+    f[i] = ring + ((dlt_head_d[k] + 1 + i) % r) * w;
+  }
+
+  // pass the center frame on
+  //
+  memcpy(y_a, f[h], w * sizeof(double));
+  double* z = y_a + w;
+
+  // differential energy: the range of value 0
+  //
+  if (dlt_type_d[s_a] == DLT_MINMAX) {
+    double vmax = f[0][0];
+    double vmin = f[0][0];
+    for (long i = 1; i < r; i++) {
+      vmax = Edf::max(vmax, f[i][0]);
+      vmin = Edf::min(vmin, f[i][0]);
+    }
+    z[0] = vmax - vmin;
+  }
+
+  // deltas of the whole frame, or delta-deltas of the first values of
+  // the deltas (which follow the d1 values of the frame)
+  //
+  else {
+    long off = 0;
+    long n = w;
+    if (dlt_type_d[s_a] == DLT_DDELTA) {
+      off = w / 2;
+      n = dlt_wout_d[s_a] - w;
+    }
+
+    double norm = 0;
+    for (long i = 1; i <= h; i++) {
+      norm += i * i;
+    }
+    norm = 1.0 / (2.0 * norm);
+
+    for (long j = 0; j < n; j++) {
+      z[j] = 0;
+    }
+    for (long i = 1; i <= h; i++) {
+      const double* fp = f[h + i] + off;
+      const double* fm = f[h - i] + off;
+      double c = i * norm;
+      for (long j = 0; j < n; j++) {
+	z[j] += c * (fp[j] - fm[j]);
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  dlt_nout_d[k]++;
+  return true;
+}
+
+//
+// end of file
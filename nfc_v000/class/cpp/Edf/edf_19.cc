@@ -0,0 +1,1048 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_19.cc
+//
+// This file contains methods associated with the class Edf that filter
+// signals.
+//
+// A filter is a cascade of biquads (second-order sections) followed by
+// an optional FIR filter. The sections are designed from a list of
+// specifications (lowpass, highpass and notch), so they are recomputed
+// when the sample frequency changes:
+//
+//  lowpass, highpass: Butterworth, designed by the bilinear transform
+//                     with the cutoff prewarped (an odd order adds a
+//                     first-order section)
+//  notch:             the second-order notch of the Audio EQ Cookbook
+//
+// Each section is run in transposed direct form II:
+//
+//  y = b0 x + z1,   z1 = b1 x - a1 y + z2,   z2 = b2 x - a2 y
+//
+// The recursion cannot be vectorized along time, so channels are
+// processed in groups of FILT_NLANES, one channel per lane of a vector
+// register: a block of samples of the group is interleaved into a
+// buffer, run through every section and copied back.
+//
+// Short FIR filters are computed directly. Longer ones use overlap-save
+// with an FFT of a power of two length of at least four times the
+// number of taps.
+//
+// The state of the filters is kept per channel between the blocks of a
+// stream. In batch mode a signal can be filtered forward and backward
+// (zero phase). As in filtfilt, the ends are then extended by odd
+// reflection, and each pass starts from the steady state of its first
+// sample, so the ends have no transients.
+//
+
+// system include files
+//
+#include <algorithm>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+//-----------------------------------------------------------------------------
+//
+// lane arithmetic:
+//  a group of channels is one AVX or SSE2 register, or a single double
+//  when neither is available
+//
+//-----------------------------------------------------------------------------
+
+#if defined(__AVX__)
+
+typedef __m256d Lanes;
+static const long FILT_NLANES = 4;
+
+static inline Lanes lload(const double* p) {
+  return _mm256_loadu_pd(p);
+}
+
+static inline void lstore(double* p, Lanes a) {
+  _mm256_storeu_pd(p, a);
+}
+
+static inline Lanes lset(double a) {
+  return _mm256_set1_pd(a);
+}
+
+static inline Lanes ladd(Lanes a, Lanes b) {
+  return _mm256_add_pd(a, b);
+}
+
+static inline Lanes lsub(Lanes a, Lanes b) {
+  return _mm256_sub_pd(a, b);
+}
+
+static inline Lanes lmul(Lanes a, Lanes b) {
+  return _mm256_mul_pd(a, b);
+}
+
+#elif defined(__SSE2__)
+
+typedef __m128d Lanes;
+static const long FILT_NLANES = 2;
+
+static inline Lanes lload(const double* p) {
+  return _mm_loadu_pd(p);
+}
+
+static inline void lstore(double* p, Lanes a) {
+  _mm_storeu_pd(p, a);
+}
+
+static inline Lanes lset(double a) {
+  return _mm_set1_pd(a);
+}
+
+static inline Lanes ladd(Lanes a, Lanes b) {
+  return _mm_add_pd(a, b);
+}
+
+static inline Lanes lsub(Lanes a, Lanes b) {
+  return _mm_sub_pd(a, b);
+}
+
+static inline Lanes lmul(Lanes a, Lanes b) {
+  return _mm_mul_pd(a, b);
+}
+
+#else
+
+typedef double Lanes;
+static const long FILT_NLANES = 1;
+
+static inline Lanes lload(const double* p) {
+  return *p;
+}
+
+static inline void lstore(double* p, Lanes a) {
+  *p = a;
+}
+
+static inline Lanes lset(double a) {
+  return a;
+}
+
+static inline Lanes ladd(Lanes a, Lanes b) {
+  return a + b;
+}
+
+static inline Lanes lsub(Lanes a, Lanes b) {
+  return a - b;
+}
+
+static inline Lanes lmul(Lanes a, Lanes b) {
+  return a * b;
+}
+
+#endif
+
+//-----------------------------------------------------------------------------
+//
+// public methods
+//
+//-----------------------------------------------------------------------------
+
+// method: add_lowpass
+//
+// arguments:
+//  double fc: the cutoff frequency in Hz (input)
+//  long order: the order of the filter (input)
+//
+// return: a logical value indicating status
+//
+// This method appends a Butterworth lowpass filter to the cascade. Any
+// open filter stream is closed.
+//
+bool Edf::add_lowpass(double fc_a, long order_a) {
+  return Edf::add_filter_spec(FILT_LOWPASS, fc_a, order_a);
+}
+
+// method: add_highpass
+//
+// arguments:
+//  double fc: the cutoff frequency in Hz (input)
+//  long order: the order of the filter (input)
+//
+// return: a logical value indicating status
+//
+// This method appends a Butterworth highpass filter to the cascade. Any
+// open filter stream is closed.
+//
+bool Edf::add_highpass(double fc_a, long order_a) {
+  return Edf::add_filter_spec(FILT_HIGHPASS, fc_a, order_a);
+}
+
+// method: add_notch
+//
+// arguments:
+//  double f0: the center frequency in Hz (input)
+//  double q: the quality factor, f0 over the -3 dB bandwidth (input)
+//
+// return: a logical value indicating status
+//
+// This method appends a notch filter to the cascade. Any open filter
+// stream is closed.
+//
+bool Edf::add_notch(double f0_a, double q_a) {
+  return Edf::add_filter_spec(FILT_NOTCH, f0_a, q_a);
+}
+
+// method: set_fir
+//
+// arguments:
+//  VectorDouble& h: the impulse response, or an empty vector (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the FIR filter applied after the cascade. Any open
+// filter stream is closed.
+//
+bool Edf::set_fir(VectorDouble& h_a) {
+
+  // save the taps and invalidate the tables
+  //
+  Edf::close_filter_stream();
+  Edf::resize(filt_h_d, h_a.size(), false);
+  filt_h_d = h_a;
+  filt_fs_d = -1;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: design_fir
+//
+// arguments:
+//  VectorDouble& h: the impulse response (output)
+//  double flo: the lower edge in Hz, or 0 for a lowpass (input)
+//  double fhi: the upper edge in Hz, or 0 for a highpass (input)
+//  long ntaps: the number of taps, which must be odd (input)
+//
+// return: a logical value indicating status
+//
+// This method designs a linear phase FIR filter by windowing an ideal
+// response with a Hamming window. The gain is normalized to 1 at 0 Hz
+// (lowpass), at fs / 2 (highpass) or at the center of the band.
+//
+bool Edf::design_fir(VectorDouble& h_a, double flo_a, double fhi_a,
+		     long ntaps_a) {
+
+  // check the arguments
+  //
+  double fs = hdr_sample_frequency_d;
+  if ((fs <= 0) || (ntaps_a <= 0) || (ntaps_a % 2 == 0) ||
+      (flo_a < 0) || (fhi_a < 0) || (flo_a >= fs / 2) ||
+      (fhi_a >= fs / 2) || ((flo_a == 0) && (fhi_a == 0)) ||
+      ((fhi_a > 0) && (fhi_a <= flo_a))) {
+    fprintf(stdout, "**> Edf::design_fir(): %s (%f %f %ld %f)\n",
+	    "invalid parameters (flo, fhi, ntaps, fs)",
+	    flo_a, fhi_a, ntaps_a, fs);
+    return false;
+  }
+
+  // the ideal response is the difference of two lowpass filters
+  //
+  double wlo = 2.0 * M_PI * flo_a / fs;
+  double whi = (fhi_a > 0) ? 2.0 * M_PI * fhi_a / fs : M_PI;
+  long m = ntaps_a / 2;
+  Edf::resize(h_a, ntaps_a, false);
+
+  for (long k = 0; k < ntaps_a; k++) {
+    double t = k - m;
+    double hk = (k == m) ? (whi - wlo) / M_PI :
+      (sin(whi * t) - sin(wlo * t)) / (M_PI * t);
+    double w = (ntaps_a > 1) ?
+      0.54 - 0.46 * cos(2.0 * M_PI * k / (ntaps_a - 1)) : 1.0;
+    h_a[k] = hk * w;
+  }
+
+  // normalize the gain at a frequency in the pass band
+  //
+  double wc = (flo_a == 0) ? 0.0 : ((fhi_a == 0) ? M_PI : (wlo + whi) / 2);
+  double re = 0;
+  double im = 0;
+  for (long k = 0; k < ntaps_a; k++) {
+    re += h_a[k] * cos(wc * (k - m));
+    im += h_a[k] * sin(wc * (k - m));
+  }
+  double gain = sqrt(re * re + im * im);
+  if (gain > 0) {
+    for (long k = 0; k < ntaps_a; k++) {
+      h_a[k] /= gain;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: clear_filters
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method removes every filter. Any open filter stream is closed.
+//
+bool Edf::clear_filters() {
+
+  // clear the specifications and the taps
+  //
+  Edf::close_filter_stream();
+  Edf::resize(filt_stype_d, 0, false);
+  Edf::resize(filt_sfreq_d, 0, false);
+  Edf::resize(filt_sparam_d, 0, false);
+  Edf::resize(filt_h_d, 0, false);
+  filt_fs_d = -1;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: filter_signal
+//
+// arguments:
+//  VVectorDouble& sig: the signal (input/output)
+//
+// return: a logical value indicating status
+//
+// This method filters every channel of a signal in place, starting from
+// a zero state. If zero phase is set, each channel is filtered forward
+// and then backward, which squares the magnitude response and cancels
+// the phase. Any open filter stream is closed.
+//
+bool Edf::filter_signal(VVectorDouble& sig_a) {
+
+  // set up a stream for the channels
+  //
+  long nchan = sig_a.size();
+  if (nchan == 0) {
+    return true;
+  }
+  if (!Edf::open_filter_stream(nchan)) {
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::filter_signal(): %s %ld %ld %ld %d\n",
+	    "(nchan, nsections, ntaps, zero phase)", nchan, filt_nsos_d,
+	    (long)filt_h_d.size(), (int)filt_zphase_d);
+  }
+
+  // filter forward only
+  //
+  if (!filt_zphase_d) {
+    bool status = Edf::run_filters(sig_a);
+    Edf::close_filter_stream();
+    return status;
+  }
+
+  // extend the ends of each channel by odd reflection: by three times
+  //  the order of the filter, and by three periods of the lowest
+  //  highpass cutoff, whose response settles slowly
+  //
+  long order = 3 * (2 * filt_nsos_d + filt_h_d.size());
+  for (long i = 0; i < (long)filt_stype_d.size(); i++) {
+    if (filt_stype_d[i] == FILT_HIGHPASS) {
+      order = Edf::max(order,
+		       ceil(3.0 * hdr_sample_frequency_d / filt_sfreq_d[i]));
+    }
+  }
+  VVectorDouble ext(nchan);
+  VectorLong npad(nchan);
+
+  for (long i = 0; i < nchan; i++) {
+    long n = sig_a[i].size();
+    npad[i] = (n > 0) ? Edf::min(order, n - 1) : 0;
+    Edf::resize(ext[i], n + 2 * npad[i], false);
+    for (long t = 0; t < n; t++) {
+      ext[i][npad[i] + t] = sig_a[i][t];
+    }
+    for (long t = 1; t <= npad[i]; t++) {
+      ext[i][npad[i] - t] = 2.0 * sig_a[i][0] - sig_a[i][t];
+      ext[i][npad[i] + n - 1 + t] = 2.0 * sig_a[i][n - 1] -
+	sig_a[i][n - 1 - t];
+    }
+  }
+
+  // filter forward, then backward
+  //
+  for (long i = 0; i < nchan; i++) {
+    Edf::set_filter_state(i, (ext[i].size() > 0) ? ext[i][0] : 0.0);
+  }
+  bool status = Edf::run_filters(ext);
+
+  for (long i = 0; i < nchan; i++) {
+    std::reverse(ext[i].begin(), ext[i].end());
+    Edf::set_filter_state(i, (ext[i].size() > 0) ? ext[i][0] : 0.0);
+  }
+  status = status && Edf::run_filters(ext);
+
+  // copy the middle back in time order
+  //
+  for (long i = 0; i < nchan; i++) {
+    long n = sig_a[i].size();
+    long m = ext[i].size();
+    for (long t = 0; t < n; t++) {
+      sig_a[i][t] = ext[i][m - 1 - npad[i] - t];
+    }
+  }
+
+  // exit gracefully
+  //
+  Edf::close_filter_stream();
+  return status;
+}
+
+// method: open_filter_stream
+//
+// arguments:
+//  long nchan: the number of channels (input)
+//
+// return: a logical value indicating status
+//
+// This method designs the filters for the current sample frequency and
+// creates a zero state for every channel. Any open stream is closed.
+//
+bool Edf::open_filter_stream(long nchan_a) {
+
+  // check the arguments and design the filters
+  //
+  Edf::close_filter_stream();
+  if (nchan_a <= 0) {
+    fprintf(stdout, "**> Edf::open_filter_stream(): %s %ld\n",
+	    "invalid number of channels", nchan_a);
+    return false;
+  }
+  if (!Edf::create_filter_tables()) {
+    return false;
+  }
+
+  // create space for the state: the channels are padded to a whole
+  //  number of groups, so the last group has no special case
+  //
+  long cpad = ((nchan_a + FILT_NLANES - 1) / FILT_NLANES) * FILT_NLANES;
+  long ntaps = filt_h_d.size();
+  long ssize = 2 * filt_nsos_d * cpad + cpad * Edf::max(ntaps - 1, 0);
+
+  if (ssize > filt_ssize_d) {
+    free(filt_state_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       ssize * sizeof(double)) != 0) {
+      filt_state_d = (double*)NULL;
+      filt_ssize_d = 0;
+      fprintf(stdout, "**> Edf::open_filter_stream(): out of memory\n");
+      return false;
+    }
+    filt_state_d = (double*)ptr;
+    filt_ssize_d = ssize;
+  }
+
+  filt_nchan_d = nchan_a;
+  filt_cpad_d = cpad;
+
+  // exit gracefully
+  //
+  return Edf::reset_filter_state();
+}
+
+// method: filter_block
+//
+// arguments:
+//  VVectorDouble& sig: a block of the signal (input/output)
+//
+// return: a logical value indicating status
+//
+// This method filters the next block of every channel of a stream in
+// place. The output is the same as filtering the concatenated blocks
+// at once. Channels may differ in length.
+//
+bool Edf::filter_block(VVectorDouble& sig_a) {
+
+  // check the stream
+  //
+  if ((filt_nchan_d == 0) || ((long)sig_a.size() != filt_nchan_d)) {
+    fprintf(stdout, "**> Edf::filter_block(): %s (%ld %ld)\n",
+	    "the stream is not open for these channels",
+	    (long)sig_a.size(), filt_nchan_d);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return Edf::run_filters(sig_a);
+}
+
+// method: close_filter_stream
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method ends a stream. The buffers are kept for the next one.
+//
+bool Edf::close_filter_stream() {
+
+  // reset the shape
+  //
+  filt_nchan_d = 0;
+  filt_cpad_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: add_filter_spec
+//
+// arguments:
+//  FILTER_TYPE type: the type of the filter (input)
+//  double freq: the cutoff or center frequency in Hz (input)
+//  double param: the order or the quality factor (input)
+//
+// return: a logical value indicating status
+//
+bool Edf::add_filter_spec(FILTER_TYPE type_a, double freq_a,
+			  double param_a) {
+
+  // check the parameters: the frequency is checked against the sample
+  //  frequency when the filter is designed
+  //
+  bool order = (type_a != FILT_NOTCH);
+  if ((freq_a <= 0) || (param_a <= 0) ||
+      ((order) && ((param_a != floor(param_a)) ||
+		   (param_a > MAX_FILT_ORDER)))) {
+    fprintf(stdout, "**> Edf::add_filter_spec(): %s (%ld %f %f)\n",
+	    "invalid parameters", (long)type_a, freq_a, param_a);
+    return false;
+  }
+
+  // append the specification and invalidate the tables
+  //
+  Edf::close_filter_stream();
+  long n = filt_stype_d.size();
+  Edf::resize(filt_stype_d, n + 1, true);
+  Edf::resize(filt_sfreq_d, n + 1, true);
+  Edf::resize(filt_sparam_d, n + 1, true);
+  filt_stype_d[n] = type_a;
+  filt_sfreq_d[n] = freq_a;
+  filt_sparam_d[n] = param_a;
+  filt_fs_d = -1;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: create_filter_tables
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method computes the sections of the cascade and, for long FIR
+// filters, the transform of the taps. Nothing is done if the tables
+// are current. The coefficients of section s are stored as
+// (b0, b1, b2, a1, a2) at filt_sos_d[5 s], with a0 = 1.
+//
+bool Edf::create_filter_tables() {
+
+  // check if the tables are current
+  //
+  double fs = hdr_sample_frequency_d;
+  if (filt_fs_d == fs) {
+    return true;
+  }
+  if (fs <= 0) {
+    fprintf(stdout,
+	    "**> Edf::create_filter_tables(): sample frequency is not set\n");
+    return false;
+  }
+
+  // count the sections
+  //
+  long nspec = filt_stype_d.size();
+  long nsos = 0;
+  for (long i = 0; i < nspec; i++) {
+    nsos += (filt_stype_d[i] == FILT_NOTCH) ? 1 :
+      ((long)filt_sparam_d[i] + 1) / 2;
+  }
+  Edf::resize(filt_sos_d, 5 * nsos, false);
+
+  // design the sections
+  //
+  long s = 0;
+  for (long i = 0; i < nspec; i++) {
+    double f = filt_sfreq_d[i];
+    if (f >= fs / 2) {
+      fprintf(stdout, "**> Edf::create_filter_tables(): %s (%f %f)\n",
+	      "frequency above half the sample frequency", f, fs);
+      filt_fs_d = -1;
+      return false;
+    }
+    double w0 = 2.0 * M_PI * f / fs;
+    double cw = cos(w0);
+    double* c;
+
+    // notch
+    //
+    if (filt_stype_d[i] == FILT_NOTCH) {
+      double alpha = sin(w0) / (2.0 * filt_sparam_d[i]);
+      c = &filt_sos_d[5 * s++];
+      c[0] = 1.0 / (1.0 + alpha);
+      c[1] = -2.0 * cw / (1.0 + alpha);
+      c[2] = c[0];
+      c[3] = c[1];
+      c[4] = (1.0 - alpha) / (1.0 + alpha);
+      continue;
+    }
+
+    // butterworth: the poles in pairs, with the real pole of an odd
+    //  order as a first-order section. pair k is at an angle of
+    //  pi (order - 2k - 1) / (2 order) from the negative real axis.
+    //
+    bool lp = (filt_stype_d[i] == FILT_LOWPASS);
+    long order = (long)filt_sparam_d[i];
+    for (long k = 0; k < order / 2; k++) {
+      double q = 1.0 / (2.0 * cos(M_PI * (order - 2 * k - 1) /
+				  (2.0 * order)));
+      double alpha = sin(w0) / (2.0 * q);
+      double a0 = 1.0 + alpha;
+      c = &filt_sos_d[5 * s++];
+      c[0] = (lp ? (1.0 - cw) : (1.0 + cw)) / (2.0 * a0);
+      c[1] = (lp ? 2.0 : -2.0) * c[0];
+      c[2] = c[0];
+      c[3] = -2.0 * cw / a0;
+      c[4] = (1.0 - alpha) / a0;
+    }
+    if (order % 2 == 1) {
+      double k = tan(w0 / 2);
+      c = &filt_sos_d[5 * s++];
+      c[0] = (lp ? k : 1.0) / (1.0 + k);
+      c[1] = lp ? c[0] : -c[0];
+      c[2] = 0;
+      c[3] = (k - 1.0) / (k + 1.0);
+      c[4] = 0;
+    }
+  }
+  filt_nsos_d = nsos;
+
+  // size the fft of the FIR filter, and reverse the taps for the
+  //  direct form
+  //
+  long ntaps = filt_h_d.size();
+  filt_nfft_d = 0;
+  if (ntaps >= FIR_FFT_MIN) {
+    filt_nfft_d = 1;
+    while (filt_nfft_d < 4 * ntaps) {
+      filt_nfft_d *= 2;
+    }
+  }
+  Edf::resize(filt_hr_d, ntaps, false);
+  for (long k = 0; k < ntaps; k++) {
+    filt_hr_d[k] = filt_h_d[ntaps - 1 - k];
+  }
+
+  // create space for a block of lanes and the overlap-save buffers:
+  //  the transform of the taps, a segment, and its transform
+  //
+  long nfft = filt_nfft_d;
+  long bsize = FILT_NLANES * FILT_BLOCK + 3 * (nfft + 2);
+  if (bsize > filt_bsize_d) {
+    free(filt_buf_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       bsize * sizeof(double)) != 0) {
+      filt_buf_d = (double*)NULL;
+      filt_bsize_d = 0;
+      fprintf(stdout, "**> Edf::create_filter_tables(): out of memory\n");
+      return false;
+    }
+    filt_buf_d = (double*)ptr;
+    filt_bsize_d = bsize;
+  }
+
+  // transform the taps
+  //
+  if (nfft > 0) {
+    double* hf = filt_buf_d + FILT_NLANES * FILT_BLOCK;
+    double* seg = hf + nfft + 2;
+    memset(seg, 0, nfft * sizeof(double));
+    for (long k = 0; k < ntaps; k++) {
+      seg[k] = filt_h_d[k];
+    }
+    if (!Edf::fft(hf, seg, nfft)) {
+      return false;
+    }
+  }
+
+  // save the sample frequency of the tables
+  //
+  filt_fs_d = fs;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::create_filter_tables(): %s %ld %ld %ld\n",
+	    "(nsections, ntaps, nfft)", nsos, ntaps, nfft);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: reset_filter_state
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method zeroes the state of every channel of the stream.
+//
+bool Edf::reset_filter_state() {
+
+  // zero the sections and the FIR history
+  //
+  long ntaps = filt_h_d.size();
+  long ssize = 2 * filt_nsos_d * filt_cpad_d +
+    filt_cpad_d * Edf::max(ntaps - 1, 0);
+  if (ssize > 0) {
+    memset(filt_state_d, 0, ssize * sizeof(double));
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: set_filter_state
+//
+// arguments:
+//  long chan: the channel (input)
+//  double x0: a constant input (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the state of a channel to the steady state of a
+// constant input x0. A section of DC gain g maps x0 to y0 = g x0, so:
+//
+//  z1 = y0 - b0 x0,   z2 = b2 x0 - a2 y0
+//
+// and y0 is the input of the next section. The FIR history is x0.
+//
+bool Edf::set_filter_state(long chan_a, double x0_a) {
+
+  // run the constant through the sections
+  //
+  double x = x0_a;
+  for (long s = 0; s < filt_nsos_d; s++) {
+    const double* c = &filt_sos_d[5 * s];
+    double* zs1 = filt_state_d + 2 * s * filt_cpad_d + chan_a;
+    double* zs2 = zs1 + filt_cpad_d;
+    double y = x * (c[0] + c[1] + c[2]) / (1.0 + c[3] + c[4]);
+    *zs1 = y - c[0] * x;
+    *zs2 = c[2] * x - c[4] * y;
+    x = y;
+  }
+
+  // fill the history
+  //
+  long nh = Edf::max(filt_h_d.size(), 1) - 1;
+  double* hist = filt_state_d + 2 * filt_nsos_d * filt_cpad_d +
+    chan_a * nh;
+  for (long k = 0; k < nh; k++) {
+    hist[k] = x;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: run_filters
+//
+// arguments:
+//  VVectorDouble& sig: a block of the signal (input/output)
+//
+// return: a logical value indicating status
+//
+// This method runs the cascade over groups of channels, and then the
+// FIR filter over each channel, updating the state. A group is run in
+// lanes up to the length of its shortest channel; the rest of longer
+// channels is run one channel at a time.
+//
+bool Edf::run_filters(VVectorDouble& sig_a) {
+
+  // declare local variables
+  //
+  long nchan = filt_nchan_d;
+  long cpad = filt_cpad_d;
+  double* buf = filt_buf_d;
+
+  // run the cascade
+  //
+  for (long c0 = 0; (filt_nsos_d > 0) && (c0 < cpad); c0 += FILT_NLANES) {
+    long nl = Edf::min(FILT_NLANES, nchan - c0);
+
+    // find the length of the shortest channel of the group
+    //
+    long n = sig_a[c0].size();
+    for (long l = 1; l < nl; l++) {
+      n = Edf::min(n, (long)sig_a[c0 + l].size());
+    }
+
+    // run the group in blocks: unused lanes are fed zeros
+    //
+    for (long b = 0; b < n; b += FILT_BLOCK) {
+      long nb = Edf::min(FILT_BLOCK, n - b);
+      if (nl < FILT_NLANES) {
+	memset(buf, 0, FILT_NLANES * nb * sizeof(double));
+      }
+      for (long l = 0; l < nl; l++) {
+	const double* x = &sig_a[c0 + l][b];
+	for (long t = 0; t < nb; t++) {
+	  buf[t * FILT_NLANES + l] = x[t];
+	}
+      }
+      Edf::biquad_lanes(buf, nb, c0);
+      for (long l = 0; l < nl; l++) {
+	double* y = &sig_a[c0 + l][b];
+	for (long t = 0; t < nb; t++) {
+	  y[t] = buf[t * FILT_NLANES + l];
+	}
+      }
+    }
+
+    // run the rest of the longer channels
+    //
+    for (long l = 0; l < nl; l++) {
+      long m = sig_a[c0 + l].size();
+      if (m > n) {
+	Edf::biquad_channel(&sig_a[c0 + l][n], m - n, c0 + l);
+      }
+    }
+  }
+
+  // run the FIR filter
+  //
+  if (filt_h_d.size() > 0) {
+    for (long i = 0; i < nchan; i++) {
+      if (!Edf::fir_channel(sig_a[i], i)) {
+	return false;
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: biquad_lanes
+//
+// arguments:
+//  double* x: interleaved samples of a group of channels (input/output)
+//  long n: the number of samples per channel (input)
+//  long chan: the first channel of the group (input)
+//
+// return: a logical value indicating status
+//
+// This method runs every section over a block of a group of channels.
+// The state of section s of channel c is at filt_state_d[2 s cpad + c]
+// and filt_state_d[(2 s + 1) cpad + c], so a group loads it at once.
+//
+bool Edf::biquad_lanes(double* x_a, long n_a, long chan_a) {
+
+  // run the sections one after the other over the block
+  //
+  for (long s = 0; s < filt_nsos_d; s++) {
+    const double* c = &filt_sos_d[5 * s];
+    double* zs1 = filt_state_d + 2 * s * filt_cpad_d + chan_a;
+    double* zs2 = zs1 + filt_cpad_d;
+    Lanes b0 = lset(c[0]);
+    Lanes b1 = lset(c[1]);
+    Lanes b2 = lset(c[2]);
+    Lanes a1 = lset(c[3]);
+    Lanes a2 = lset(c[4]);
+    Lanes z1 = lload(zs1);
+    Lanes z2 = lload(zs2);
+
+    double* p = x_a;
+    for (long t = 0; t < n_a; t++, p += FILT_NLANES) {
+      Lanes xt = lload(p);
+      Lanes yt = ladd(lmul(b0, xt), z1);
+      z1 = ladd(lsub(lmul(b1, xt), lmul(a1, yt)), z2);
+      z2 = lsub(lmul(b2, xt), lmul(a2, yt));
+      lstore(p, yt);
+    }
+
+    lstore(zs1, z1);
+    lstore(zs2, z2);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: biquad_channel
+//
+// arguments:
+//  double* x: the samples of one channel (input/output)
+//  long n: the number of samples (input)
+//  long chan: the channel (input)
+//
+// return: a logical value indicating status
+//
+// This method runs every section over the samples of one channel,
+// using the same state as biquad_lanes.
+//
+bool Edf::biquad_channel(double* x_a, long n_a, long chan_a) {
+
+  // run the sections one after the other
+  //
+  for (long s = 0; s < filt_nsos_d; s++) {
+    const double* c = &filt_sos_d[5 * s];
+    double* zs1 = filt_state_d + 2 * s * filt_cpad_d + chan_a;
+    double* zs2 = zs1 + filt_cpad_d;
+    double z1 = *zs1;
+    double z2 = *zs2;
+
+    for (long t = 0; t < n_a; t++) {
+      double xt = x_a[t];
+      double yt = c[0] * xt + z1;
+      z1 = c[1] * xt - c[3] * yt + z2;
+      z2 = c[2] * xt - c[4] * yt;
+      x_a[t] = yt;
+    }
+
+    *zs1 = z1;
+    *zs2 = z2;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: fir_channel
+//
+// arguments:
+//  VectorDouble& x: the samples of one channel (input/output)
+//  long chan: the channel (input)
+//
+// return: a logical value indicating status
+//
+// This method runs the FIR filter over the samples of one channel. The
+// last ntaps - 1 inputs of the channel are kept as its history.
+// Overlap-save cuts the history and the samples into segments of nfft
+// samples that overlap by ntaps - 1, and keeps the last nfft - ntaps + 1
+// outputs of the circular convolution of each segment.
+//
+bool Edf::fir_channel(VectorDouble& x_a, long chan_a) {
+
+  // declare local variables
+  //
+  long n = x_a.size();
+  long ntaps = filt_h_d.size();
+  long nh = ntaps - 1;
+  long nfft = filt_nfft_d;
+  double* hist = filt_state_d + 2 * filt_nsos_d * filt_cpad_d +
+    chan_a * nh;
+  if (n == 0) {
+    return true;
+  }
+
+  // grow the extended signal: the history, the samples and room for a
+  //  zero padded segment
+  //
+  long esize = nh + n + nfft;
+  if (esize > filt_esize_d) {
+    free(filt_ext_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       esize * sizeof(double)) != 0) {
+      filt_ext_d = (double*)NULL;
+      filt_esize_d = 0;
+      fprintf(stdout, "**> Edf::fir_channel(): out of memory\n");
+      return false;
+    }
+    filt_ext_d = (double*)ptr;
+    filt_esize_d = esize;
+  }
+
+  double* ext = filt_ext_d;
+  memcpy(ext, hist, nh * sizeof(double));
+  memcpy(ext + nh, &x_a[0], n * sizeof(double));
+
+  // direct form: y[t] = sum_k h[k] x[t - k]
+  //
+  if (nfft == 0) {
+    const double* hr = &filt_hr_d[0];
+    for (long t = 0; t < n; t++) {
+      x_a[t] = Edf::dot(hr, ext + t, ntaps);
+    }
+  }
+
+  // overlap-save
+  //
+  else {
+    long plan = Edf::get_fft_plan(nfft);
+    if (plan < 0) {
+      return false;
+    }
+    const double* hf = filt_buf_d + FILT_NLANES * FILT_BLOCK;
+    double* spec = (double*)hf + nfft + 2;
+    double* seg = spec + nfft + 2;
+    long step = nfft - nh;
+    memset(ext + nh + n, 0, nfft * sizeof(double));
+
+    for (long p = 0; p < n; p += step) {
+
+      // multiply the transforms: one complex bin at a time
+      //
+      Edf::fft_real(plan, spec, ext + p);
+      for (long k = 0; k <= nfft / 2; k++) {
+	double re = spec[2 * k] * hf[2 * k] - spec[2 * k + 1] * hf[2 * k + 1];
+	double im = spec[2 * k] * hf[2 * k + 1] + spec[2 * k + 1] * hf[2 * k];
+	spec[2 * k] = re;
+	spec[2 * k + 1] = im;
+      }
+      Edf::ifft_real(plan, seg, spec);
+
+      // keep the outputs that did not wrap around
+      //
+      long m = Edf::min(step, n - p);
+      memcpy(&x_a[p], seg + nh, m * sizeof(double));
+    }
+  }
+
+  // save the history
+  //
+  memcpy(hist, ext + n, nh * sizeof(double));
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
@@ -0,0 +1,648 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_20.cc
+//
+// This file contains methods associated with the class Edf that resample
+// signals to a common sample frequency.
+//
+// Each channel has its own sample frequency, given by its record size
+// and the record duration, so files that mix rates (e.g., an EKG
+// channel) are handled. A rate change fs_out / fs_in is reduced to a
+// ratio L / M of integers and computed with a polyphase filter: the
+// signal is conceptually upsampled by L, lowpass filtered and
+// downsampled by M, but only the products that contribute to an output
+// are computed:
+//
+//  y[m] = L sum_k h[p + k L] x[b - k],   u = m M + D, b = u / L, p = u % L
+//
+// where h is a lowpass prototype of N = 2 D + 1 taps centered on D,
+// so the output is not delayed. As in scipy's resample_poly, D is
+// RS_HALF_ZEROS max(L, M), the cutoff is half of the lower of the two
+// rates, and the sinc is tapered by a Kaiser window (beta
+// RS_KAISER_BETA). Each phase p holds ceil(N / L) taps, stored in
+// reverse so that an output is one vectorized dot product with
+// consecutive samples.
+//
+// A design is computed once per ratio. Up to RS_NDESIGNS designs are
+// kept, and the oldest is replaced when a new ratio is needed.
+//
+// A stream keeps, for each channel, the number of samples read and
+// written and the last samples of the input, so a signal can be
+// resampled block by block. A signal of n samples gives ceil(n L / M)
+// samples once the stream is flushed.
+//
+
+// local include files
+//
+#include "Edf.h"
+
+// method: get_channel_frequency
+//
+// arguments:
+//  long chan: the channel number in the header (input)
+//
+// return: the sample frequency of the channel in Hz
+//
+double Edf::get_channel_frequency(long chan_a) {
+
+  // check the record duration
+  //
+  if (hdr_ghdi_dur_rec_d <= 0) {
+    return hdr_sample_frequency_d;
+  }
+
+  // exit gracefully
+  //
+  return (double)hdr_chan_rec_size_d[chan_a] / (double)hdr_ghdi_dur_rec_d;
+}
+
+// method: resample
+//
+// arguments:
+//  VVectorDouble& sig: the signal (input/output)
+//  double fs: the new sample frequency in Hz (input)
+//
+// return: a logical value indicating status
+//
+// This method resamples every channel of a signal from its own sample
+// frequency (see get_channel_frequency) to fs. Annotation channels are
+// not changed. The header is updated: the sample frequency becomes fs
+// and the record size of each resampled channel fs times the record
+// duration, which must be a whole number of samples.
+//
+bool Edf::resample(VVectorDouble& sig_a, double fs_a) {
+
+  // check that a record holds a whole number of samples
+  //
+  double rsize = fs_a * hdr_ghdi_dur_rec_d;
+  if ((hdr_ghdi_dur_rec_d > 0) && (fabs(rsize - round(rsize)) > 1e-9)) {
+    fprintf(stdout, "**> Edf::resample(): %s (%f %ld)\n",
+	    "sample frequency gives a fractional record size (fs, dur)",
+	    fs_a, hdr_ghdi_dur_rec_d);
+    return false;
+  }
+
+  // collect the rates of the channels
+  //
+  long nchan = sig_a.size();
+  VectorDouble fs_in(nchan);
+  for (long i = 0; i < nchan; i++) {
+    fs_in[i] = Edf::is_annotation(i) ? fs_a : Edf::get_channel_frequency(i);
+  }
+
+  // resample the channels
+  //
+  if (!Edf::resample(sig_a, fs_in, fs_a)) {
+    return false;
+  }
+
+  // update the header
+  //
+  for (long i = 0; i < nchan; i++) {
+    if (!Edf::is_annotation(i)) {
+      hdr_chan_rec_size_d[i] = (long)round(rsize);
+    }
+  }
+  hdr_sample_frequency_d = fs_a;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: resample
+//
+// arguments:
+//  VVectorDouble& sig: the signal (input/output)
+//  VectorDouble& fs_in: the sample frequency of each channel (input)
+//  double fs_out: the new sample frequency in Hz (input)
+//
+// return: a logical value indicating status
+//
+// This method resamples every channel of a signal from its frequency
+// to fs_out. Channels already at fs_out are not changed. The header is
+// not changed. Any open resampling stream is closed.
+//
+bool Edf::resample(VVectorDouble& sig_a, VectorDouble& fs_in_a,
+		   double fs_out_a) {
+
+  // set up a stream
+  //
+  long nchan = sig_a.size();
+  if (nchan == 0) {
+    return true;
+  }
+  if (!Edf::open_resample_stream(fs_in_a, fs_out_a)) {
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::resample(): %s %ld %f\n",
+	    "(nchan, fs_out)", nchan, fs_out_a);
+  }
+
+  // run each channel through the stream and flush it
+  //
+  VectorDouble tail;
+  bool status = true;
+  for (long i = 0; (status) && (i < nchan); i++) {
+    if (rs_cl_d[i] == rs_cm_d[i]) {
+      continue;
+    }
+    status = Edf::resample_channel(sig_a[i], i, false) &&
+      Edf::resample_channel(tail, i, true);
+    if (status) {
+      long n = sig_a[i].size();
+      Edf::resize(sig_a[i], n + tail.size(), true);
+      for (long t = 0; t < (long)tail.size(); t++) {
+	sig_a[i][n + t] = tail[t];
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  Edf::close_resample_stream();
+  return status;
+}
+
+// method: open_resample_stream
+//
+// arguments:
+//  VectorDouble& fs_in: the sample frequency of each channel (input)
+//  double fs_out: the new sample frequency in Hz (input)
+//
+// return: a logical value indicating status
+//
+// This method finds the ratio of each channel, designs the filters and
+// creates an empty history for every channel. Any open stream is
+// closed.
+//
+bool Edf::open_resample_stream(VectorDouble& fs_in_a, double fs_out_a) {
+
+  // find the ratios and the designs
+  //
+  Edf::close_resample_stream();
+  long nchan = fs_in_a.size();
+  if (nchan == 0) {
+    fprintf(stdout, "**> Edf::open_resample_stream(): no channels\n");
+    return false;
+  }
+
+  Edf::resize(rs_cl_d, nchan, false);
+  Edf::resize(rs_cm_d, nchan, false);
+  Edf::resize(rs_nin_d, nchan, false);
+  Edf::resize(rs_nout_d, nchan, false);
+
+  long hstride = 0;
+  for (long i = 0; i < nchan; i++) {
+    long l;
+    long m;
+    if (!Edf::get_resample_ratio(l, m, fs_in_a[i], fs_out_a)) {
+      return false;
+    }
+    rs_cl_d[i] = l;
+    rs_cm_d[i] = m;
+    rs_nin_d[i] = 0;
+    rs_nout_d[i] = 0;
+    if (l == m) {
+      continue;
+    }
+    long d = Edf::get_resample_design(l, m);
+    if (d < 0) {
+      return false;
+    }
+    hstride = Edf::max(hstride, rs_ntap_d[d] - 1);
+  }
+
+  // create space for the history of each channel
+  //
+  long hsize = nchan * hstride;
+  if (hsize > rs_hsize_d) {
+    free(rs_hist_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       hsize * sizeof(double)) != 0) {
+      rs_hist_d = (double*)NULL;
+      rs_hsize_d = 0;
+      fprintf(stdout, "**> Edf::open_resample_stream(): out of memory\n");
+      return false;
+    }
+    rs_hist_d = (double*)ptr;
+    rs_hsize_d = hsize;
+  }
+  if (hsize > 0) {
+    memset(rs_hist_d, 0, hsize * sizeof(double));
+  }
+
+  rs_nchan_d = nchan;
+  rs_hstride_d = hstride;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: resample_block
+//
+// arguments:
+//  VVectorDouble& sig: a block of the signal (input/output)
+//
+// return: a logical value indicating status
+//
+// This method replaces the next block of each channel of a stream by
+// the samples that can be computed from the input so far. Channels may
+// differ in length, and the number of output samples varies from block
+// to block.
+//
+bool Edf::resample_block(VVectorDouble& sig_a) {
+
+  // check the stream
+  //
+  if ((rs_nchan_d == 0) || ((long)sig_a.size() != rs_nchan_d)) {
+    fprintf(stdout, "**> Edf::resample_block(): %s (%ld %ld)\n",
+	    "the stream is not open for these channels",
+	    (long)sig_a.size(), rs_nchan_d);
+    return false;
+  }
+
+  // resample the channels
+  //
+  for (long i = 0; i < rs_nchan_d; i++) {
+    if (!Edf::resample_channel(sig_a[i], i, false)) {
+      return false;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: flush_resample_stream
+//
+// arguments:
+//  VVectorDouble& sig: the last samples of each channel (output)
+//
+// return: a logical value indicating status
+//
+// This method computes the samples still owed by each channel, as if
+// the input were followed by zeros. The channels can then be reused
+// for a new stream.
+//
+bool Edf::flush_resample_stream(VVectorDouble& sig_a) {
+
+  // check the stream
+  //
+  if (rs_nchan_d == 0) {
+    fprintf(stdout, "**> Edf::flush_resample_stream(): no open stream\n");
+    return false;
+  }
+
+  // flush the channels and reset them
+  //
+  Edf::resize(sig_a, rs_nchan_d, false);
+  for (long i = 0; i < rs_nchan_d; i++) {
+    if (!Edf::resample_channel(sig_a[i], i, true)) {
+      return false;
+    }
+    rs_nin_d[i] = 0;
+    rs_nout_d[i] = 0;
+  }
+  memset(rs_hist_d, 0, rs_nchan_d * rs_hstride_d * sizeof(double));
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_resample_stream
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method ends a stream. The designs and the buffers are kept.
+//
+bool Edf::close_resample_stream() {
+
+  // reset the shape
+  //
+  rs_nchan_d = 0;
+  rs_hstride_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: is_annotation
+//
+// arguments:
+//  long chan: the channel number in the header (input)
+//
+// return: true if the channel holds EDF+ annotations
+//
+// Labels are upcased when the header is read, so the match ignores case.
+//
+bool Edf::is_annotation(long chan_a) {
+  return (hdr_chan_labels_d[chan_a] != (char*)NULL) &&
+    (strcasestr(hdr_chan_labels_d[chan_a], ANNOTATION) != (char*)NULL);
+}
+
+// method: get_resample_ratio
+//
+// arguments:
+//  long& l: the upsampling factor (output)
+//  long& m: the downsampling factor (output)
+//  double fs_in: the input sample frequency (input)
+//  double fs_out: the output sample frequency (input)
+//
+// return: a logical value indicating status
+//
+// This method reduces fs_out / fs_in to a ratio of integers. The rates
+// are scaled by the smallest power of 10 (up to 1000) that makes both
+// of them integers.
+//
+bool Edf::get_resample_ratio(long& l_a, long& m_a, double fs_in_a,
+			     double fs_out_a) {
+
+  // find a scale that makes both rates integers
+  //
+  l_a = 0;
+  m_a = 0;
+  if ((fs_in_a > 0) && (fs_out_a > 0)) {
+    for (double q = 1; q <= 1000; q *= 10) {
+      if ((fabs(fs_in_a * q - round(fs_in_a * q)) < 1e-6) &&
+	  (fabs(fs_out_a * q - round(fs_out_a * q)) < 1e-6)) {
+	l_a = (long)round(fs_out_a * q);
+	m_a = (long)round(fs_in_a * q);
+	break;
+      }
+    }
+  }
+
+  // reduce the ratio
+  //
+  long a = l_a;
+  long b = m_a;
+  while (b != 0) {
+    long r = a % b;
+    a = b;
+    b = r;
+  }
+  if (a > 0) {
+    l_a /= a;
+    m_a /= a;
+  }
+
+  // check the factors
+  //
+  if ((l_a <= 0) || (m_a <= 0) || (l_a > MAX_RS_FACTOR) ||
+      (m_a > MAX_RS_FACTOR)) {
+    fprintf(stdout, "**> Edf::get_resample_ratio(): %s (%f %f)\n",
+	    "unsupported rate change", fs_in_a, fs_out_a);
+    return false;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_resample_design
+//
+// arguments:
+//  long l: the upsampling factor (input)
+//  long m: the downsampling factor (input)
+//
+// return: the index of the design, or -1 if it cannot be created
+//
+// This method returns the design of a ratio, creating it if needed.
+// The taps of phase p start at rs_tab_d[d] + p * rs_ntap_d[d].
+//
+long Edf::get_resample_design(long l_a, long m_a) {
+
+  // look for the ratio
+  //
+  for (long d = 0; d < rs_ndesigns_d; d++) {
+    if ((rs_l_d[d] == l_a) && (rs_m_d[d] == m_a)) {
+      return d;
+    }
+  }
+
+  // pick a slot: a free one, or the oldest
+  //
+  long d = rs_next_d;
+  rs_next_d = (rs_next_d + 1) % RS_NDESIGNS;
+  if (rs_ndesigns_d < RS_NDESIGNS) {
+    rs_ndesigns_d++;
+  }
+  rs_l_d[d] = -1;
+  rs_m_d[d] = -1;
+
+  // size the prototype
+  //
+  long k = Edf::max(l_a, m_a);
+  long half = RS_HALF_ZEROS * k;
+  long n = 2 * half + 1;
+  long ntap = (n + l_a - 1) / l_a;
+
+  // create space
+  //
+  free(rs_tab_d[d]);
+  void* ptr;
+  if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		     l_a * ntap * sizeof(double)) != 0) {
+    rs_tab_d[d] = (double*)NULL;
+    fprintf(stdout, "**> Edf::get_resample_design(): out of memory\n");
+    return -1;
+  }
+  rs_tab_d[d] = (double*)ptr;
+
+  // compute the prototype: a Kaiser windowed sinc with a cutoff of
+  //  1 / (2 k) of the upsampled rate, with a gain of 1 at 0 Hz
+  //
+  VectorDouble h(n);
+  double i0b = Edf::bessel_i0(RS_KAISER_BETA);
+  double sum = 0;
+  for (long i = 0; i < n; i++) {
+    double t = (double)(i - half) / k;
+    double r = (double)(i - half) / half;
+    double sinc = (i == half) ? 1.0 : sin(M_PI * t) / (M_PI * t);
+    h[i] = sinc * Edf::bessel_i0(RS_KAISER_BETA * sqrt(1.0 - r * r)) / i0b;
+    sum += h[i];
+  }
+
+  // split it into phases, in reverse, including the gain of L
+  //
+  double* tab = rs_tab_d[d];
+  for (long p = 0; p < l_a; p++) {
+    for (long j = 0; j < ntap; j++) {
+      long i = p + (ntap - 1 - j) * l_a;
+      tab[p * ntap + j] = (i < n) ? l_a * h[i] / sum : 0.0;
+    }
+  }
+
+  rs_l_d[d] = l_a;
+  rs_m_d[d] = m_a;
+  rs_half_d[d] = half;
+  rs_ntap_d[d] = ntap;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::get_resample_design(): %s %ld %ld %ld %ld\n",
+	    "(design, L, M, taps per phase)", d, l_a, m_a, ntap);
+  }
+
+  // exit gracefully
+  //
+  return d;
+}
+
+// method: resample_channel
+//
+// arguments:
+//  VectorDouble& x: a block of one channel, replaced by its output
+//                   (input/output)
+//  long chan: the channel (input)
+//  bool flush: if true, x is ignored and the owed samples are
+//              computed by padding the input with zeros (input)
+//
+// return: a logical value indicating status
+//
+// This method computes every output whose last input sample is in the
+// block. The block follows the history of the channel in a buffer, so
+// each output is a dot product over consecutive samples. A channel
+// whose rate does not change is passed through.
+//
+bool Edf::resample_channel(VectorDouble& x_a, long chan_a, bool flush_a) {
+
+  // pass the block through if the rate does not change
+  //
+  long l = rs_cl_d[chan_a];
+  long m = rs_cm_d[chan_a];
+  if (l == m) {
+    if (flush_a) {
+      Edf::resize(x_a, 0, false);
+    }
+    return true;
+  }
+
+  // find the design
+  //
+  long d = Edf::get_resample_design(l, m);
+  if (d < 0) {
+    return false;
+  }
+  long half = rs_half_d[d];
+  long ntap = rs_ntap_d[d];
+  long nh = ntap - 1;
+  long nin = rs_nin_d[chan_a];
+  long nout = rs_nout_d[chan_a];
+
+  // find the number of new inputs and outputs:
+  //  output j needs inputs up to (j M + half) / L. a flush pads the
+  //  input with enough zeros to complete ceil(nin L / M) outputs.
+  //
+  long n;
+  long ntotal;
+  if (flush_a) {
+    ntotal = (nin * l + m - 1) / m;
+    long last = ((ntotal - 1) * m + half) / l;
+    n = Edf::max(last + 1 - nin, 0);
+  }
+  else {
+    n = x_a.size();
+    long num = (nin + n) * l - half;
+    ntotal = (num > 0) ? (num + m - 1) / m : 0;
+  }
+  long nnew = Edf::max(ntotal - nout, 0);
+
+  // grow the buffer: the history followed by the block
+  //
+  long esize = nh + n;
+  if (esize > rs_esize_d) {
+    free(rs_ext_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       esize * sizeof(double)) != 0) {
+      rs_ext_d = (double*)NULL;
+      rs_esize_d = 0;
+      fprintf(stdout, "**> Edf::resample_channel(): out of memory\n");
+      return false;
+    }
+    rs_ext_d = (double*)ptr;
+    rs_esize_d = esize;
+  }
+
+  double* ext = rs_ext_d;
+  double* hist = rs_hist_d + chan_a * rs_hstride_d;
+  memcpy(ext, hist, nh * sizeof(double));
+  if (flush_a) {
+    memset(ext + nh, 0, n * sizeof(double));
+  }
+  else if (n > 0) {
+    memcpy(ext + nh, &x_a[0], n * sizeof(double));
+  }
+
+  // compute the outputs:
+  //  the inputs of output j are samples b - nh, ..., b, which start at
+  //  ext + b - nin
+  //
+  Edf::resize(x_a, nnew, false);
+  const double* tab = rs_tab_d[d];
+  for (long j = 0; j < nnew; j++) {
+    long u = (nout + j) * m + half;
+    long b = u / l;
+    long p = u % l;
+    x_a[j] = Edf::dot(tab + p * ntap, ext + (b - nin), ntap);
+  }
+
+  // update the history
+  //
+  memcpy(hist, ext + n, nh * sizeof(double));
+  rs_nin_d[chan_a] = nin + n;
+  rs_nout_d[chan_a] = nout + nnew;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: bessel_i0
+//
+// arguments:
+//  double x: the argument (input)
+//
+// return: the modified Bessel function of the first kind of order 0
+//
+// This method sums the power series of I0 until the terms are
+// negligible.
+//
+double Edf::bessel_i0(double x_a) {
+
+  // sum (x / 2)^2k / (k!)^2
+  //
+  double y = x_a * x_a / 4.0;
+  double term = 1.0;
+  double sum = 1.0;
+  for (long k = 1; (k < 100) && (term > 1e-17 * sum); k++) {
+    term *= y / (double)(k * k);
+    sum += term;
+  }
+
+  // exit gracefully
+  //
+  return sum;
+}
+
+//
+// end of file
@@ -0,0 +1,836 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_21.cc
+//
+// This file contains methods associated with the class Edf that compute
+// the spectra of overlapping frames incrementally.
+//
+// Frames of n samples spaced by h samples share n - h samples, so a
+// transform per frame mostly redoes the work of the previous frame.
+// Only the bins of the bands are needed for band power, and each can be
+// slid from one frame to the next. For a frequency f (in cycles per
+// sample) and z = exp(-2 pi i f), the sum
+//
+//  S_s = sum_{t < n} x[s + t] z^t
+//
+// of the frame at s gives the sum of the next frame as
+//
+//  S_{s+h} = z^-h (S_s - L) + z^(n-h) E
+//
+// where L is the block sum sum_{u < h} x[s + u] z^u of the samples that
+// leave the frame and E that of the samples x[s + n + u] that enter it.
+// When h divides n into a few blocks, the block sums of the frame are
+// kept in a ring and L is the oldest of them, so a frame costs one block
+// sum of h samples per frequency instead of a transform of n samples.
+//
+// The windows of create_window are sums of cosines of period n - 1:
+//
+//  w[t] = sum_m a_m cos(2 pi m t / (n - 1))
+//
+// so the tapered bin k is a sum of 2 M + 1 untapered sums:
+//
+//  X[k] = sum_{m = -M..M} c_m S(k / n - m / (n - 1))
+//
+// with c_0 = a_0 and c_m = c_-m = a_m / 2. Each bin thus takes one
+// accumulator for a rectangular window, three for Hamming and Hann
+// windows, and five for a Blackman window, and the result is the same
+// as that of a transform of the tapered frame.
+//
+// Sliding accumulates rounding errors, so the accumulators are computed
+// again from the samples every sdft_resync_d frames (and at the start
+// of each channel). The block sums are vectorized over groups of
+// SDFT_GROUP accumulators.
+//
+// Sliding pays off when few bins are needed or frames overlap a lot: a
+// frame costs about 2 M + 1 times h products per bin, against
+// O(n log n) for a transform. benchmark_band_power times both.
+//
+
+// system include files
+//
+#include <time.h>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+// method: open_band_stream
+//
+// arguments:
+//  long nchan: the number of channels (input)
+//
+// return: a logical value indicating status
+//
+// This method starts computing band powers block by block, using the
+// current bands, frame parameters, window and spectrum mode.
+//
+bool Edf::open_band_stream(long nchan_a) {
+
+  // check the arguments and the frame parameters
+  //
+  Edf::close_band_stream();
+  long n = Edf::get_window_length();
+  long h = Edf::get_frame_shift();
+  if (nchan_a <= 0) {
+    fprintf(stdout, "**> Edf::open_band_stream(): %s %ld\n",
+	    "invalid number of channels", nchan_a);
+    return false;
+  }
+  if ((n <= 0) || (h <= 0)) {
+    fprintf(stdout, "**> Edf::open_band_stream(): %s (%f %f %f)\n",
+	    "invalid frame parameters (fdur, wdur, fs)",
+	    fdur_d, wdur_d, (double)hdr_sample_frequency_d);
+    return false;
+  }
+
+  // prepare the window, the transform, the weights and the tables: slot
+  // 0 of the tables is used by compute_band_power
+  //
+  if ((Edf::get_fft_plan(n) < 0) || (!Edf::create_window(n)) ||
+      (!Edf::create_band_weights(n))) {
+    return false;
+  }
+  if ((spec_mode_d == SPEC_SLIDING) &&
+      (!Edf::create_sdft_tables(n, h, nchan_a + 1))) {
+    return false;
+  }
+  if ((spec_mode_d == SPEC_MULTITAPER) && (!Edf::create_multitaper(n))) {
+    return false;
+  }
+
+  // create space for the samples of each channel: a channel keeps less
+  // than n + h samples between blocks, so there is always room for more
+  //
+  long cap = 2 * n + h;
+  long bsize = nchan_a * cap;
+  if (bsize > bs_bsize_d) {
+    free(bs_buf_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       bsize * sizeof(double)) != 0) {
+      bs_buf_d = (double*)NULL;
+      bs_bsize_d = 0;
+      fprintf(stdout, "**> Edf::open_band_stream(): out of memory\n");
+      return false;
+    }
+    bs_buf_d = (double*)ptr;
+    bs_bsize_d = bsize;
+  }
+
+  Edf::resize(bs_fill_d, nchan_a, false);
+  Edf::resize(bs_nout_d, nchan_a, false);
+  for (long i = 0; i < nchan_a; i++) {
+    bs_fill_d[i] = 0;
+    bs_nout_d[i] = 0;
+  }
+
+  bs_nchan_d = nchan_a;
+  bs_n_d = n;
+  bs_h_d = h;
+  bs_mode_d = spec_mode_d;
+  bs_cap_d = cap;
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::open_band_stream(): %s %ld %ld %ld %d\n",
+	    "(nchan, n, h, mode)", nchan_a, n, h, (int)spec_mode_d);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: band_power_block
+//
+// arguments:
+//  FeatureTensor& feat: log band powers of the new frames (output)
+//  VVectorDouble& sig: the next samples of each channel (input)
+//
+// return: a logical value indicating status
+//
+// This method appends a block of samples to each channel of the stream
+// and computes the frames it completes, so feat may have no frames.
+// All channels must get the same number of samples. The frames are
+// those compute_band_power gives for the whole signal.
+//
+bool Edf::band_power_block(FeatureTensor& feat_a, VVectorDouble& sig_a) {
+
+  // check the stream
+  //
+  long nchan = sig_a.size();
+  if ((bs_nchan_d == 0) || (nchan != bs_nchan_d)) {
+    fprintf(stdout, "**> Edf::band_power_block(): %s (%ld %ld)\n",
+	    "the stream is not open for these channels", nchan, bs_nchan_d);
+    return false;
+  }
+  if ((Edf::get_window_length() != bs_n_d) ||
+      (Edf::get_frame_shift() != bs_h_d) || (spec_mode_d != bs_mode_d)) {
+    fprintf(stdout, "**> Edf::band_power_block(): %s\n",
+	    "the frame parameters or the spectrum mode changed");
+    return false;
+  }
+  long len = sig_a[0].size();
+  for (long i = 1; i < nchan; i++) {
+    if ((long)sig_a[i].size() != len) {
+      fprintf(stdout, "**> Edf::band_power_block(): %s (%ld %ld)\n",
+	      "channels have different block lengths",
+	      len, (long)sig_a[i].size());
+      return false;
+    }
+  }
+
+  // make sure the tables are current (the bands may have changed)
+  //
+  long n = bs_n_d;
+  long h = bs_h_d;
+  long plan = Edf::get_fft_plan(n);
+  if ((plan < 0) || (!Edf::create_window(n)) ||
+      (!Edf::create_band_weights(n))) {
+    return false;
+  }
+  if ((bs_mode_d == SPEC_SLIDING) &&
+      (!Edf::create_sdft_tables(n, h, nchan + 1))) {
+    return false;
+  }
+  if ((bs_mode_d == SPEC_MULTITAPER) && (!Edf::create_multitaper(n))) {
+    return false;
+  }
+
+  // count the frames the block completes: every channel has the same
+  // number of samples buffered
+  //
+  long total = bs_fill_d[0] + len;
+  long nnew = 0;
+  if (bs_nout_d[0] > 0) {
+    nnew = (total - n) / h;
+  }
+  else if (total >= n) {
+    nnew = (total - n) / h + 1;
+  }
+  if (!feat_a.resize(nchan, nnew, band_lo_d.size())) {
+    return false;
+  }
+
+  // move the samples through the buffer of each channel
+  //
+  for (long i = 0; i < nchan; i++) {
+    double* buf = bs_buf_d + i * bs_cap_d;
+    const double* x = (len > 0) ? &sig_a[i][0] : (const double*)NULL;
+    long nleft = len;
+    long j = 0;
+
+    do {
+
+      // append as many samples as fit
+      //
+      long m = bs_cap_d - bs_fill_d[i];
+      if (m > nleft) {
+	m = nleft;
+      }
+      if (m > 0) {
+	memcpy(buf + bs_fill_d[i], x, m * sizeof(double));
+	bs_fill_d[i] += m;
+	x += m;
+	nleft -= m;
+      }
+
+      // compute the frames that are complete: the buffer starts at the
+      // last frame once there is one
+      //
+      long off = (bs_nout_d[i] > 0) ? h : 0;
+      while (off + n <= bs_fill_d[i]) {
+	Edf::band_frame(feat_a.get_frame(i, j++), buf + off, plan, i + 1,
+			bs_nout_d[i] == 0);
+	bs_nout_d[i]++;
+	off += h;
+      }
+
+      // drop the samples before the last frame
+      //
+      long keep = (bs_nout_d[i] > 0) ? off - h : 0;
+      if (keep > 0) {
+	memmove(buf, buf + keep, (bs_fill_d[i] - keep) * sizeof(double));
+	bs_fill_d[i] -= keep;
+      }
+    } while (nleft > 0);
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_FULL) {
+    fprintf(stdout, "Edf::band_power_block(): %s %ld %ld %ld\n",
+	    "(nchan, len, nframes)", nchan, len, nnew);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: close_band_stream
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method ends the stream. Its buffers are kept for the next one.
+//
+bool Edf::close_band_stream() {
+
+  // reset the shape
+  //
+  bs_nchan_d = 0;
+  bs_cap_d = 0;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: benchmark_band_power
+//
+// arguments:
+//  VectorDouble& tfft: the time taken with transforms in secs (output)
+//  VectorDouble& tsdft: the time taken with sliding bins in secs (output)
+//  VVectorDouble& sig: the signal (input)
+//  VectorDouble& fdur: the frame durations to time in secs (input)
+//  FILE* fp: the stream to print the results to (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the band powers of a signal in both spectrum
+// modes for each frame duration, using the current window duration,
+// and prints the times and the largest difference between the features.
+// The frame duration and the spectrum mode are restored.
+//
+bool Edf::benchmark_band_power(VectorDouble& tfft_a, VectorDouble& tsdft_a,
+			       VVectorDouble& sig_a, VectorDouble& fdur_a,
+			       FILE* fp_a) {
+
+  // declare local variables
+  //
+  double fdur = fdur_d;
+  SPECTRUM_MODE mode = spec_mode_d;
+  FeatureTensor ffft;
+  FeatureTensor fsdft;
+  bool status = true;
+
+  Edf::resize(tfft_a, fdur_a.size(), false);
+  Edf::resize(tsdft_a, fdur_a.size(), false);
+
+  fprintf(fp_a, "%10s %10s %12s %12s %8s %10s\n", "hop/win", "nframes",
+	  "fft (secs)", "slide (secs)", "speedup", "max diff");
+
+  // time both modes for each frame duration
+  //
+  for (long i = 0; (status) && (i < (long)fdur_a.size()); i++) {
+    fdur_d = fdur_a[i];
+    double t[2];
+
+    for (long k = 0; (status) && (k < 2); k++) {
+      spec_mode_d = (k == 0) ? SPEC_FFT : SPEC_SLIDING;
+      struct timespec t0;
+      struct timespec t1;
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      status = Edf::compute_band_power((k == 0) ? ffft : fsdft, sig_a);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      t[k] = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+    }
+    if (!status) {
+      break;
+    }
+
+    // compare the features
+    //
+    double diff = 0;
+    for (long c = 0; c < ffft.get_nchan(); c++) {
+      for (long j = 0; j < ffft.get_nframes(); j++) {
+	for (long b = 0; b < ffft.get_dim(); b++) {
+	  diff = Edf::max(diff, fabs(ffft(c, j, b) - fsdft(c, j, b)));
+	}
+      }
+    }
+
+    tfft_a[i] = t[0];
+    tsdft_a[i] = t[1];
+    fprintf(fp_a, "%10.4f %10ld %12.4f %12.4f %8.2f %10.2e\n",
+	    (double)Edf::get_frame_shift() / Edf::get_window_length(),
+	    ffft.get_nframes(), t[0], t[1],
+	    (t[1] > 0) ? t[0] / t[1] : 0.0, diff);
+  }
+
+  // restore the parameters
+  //
+  fdur_d = fdur;
+  spec_mode_d = mode;
+
+  // exit gracefully
+  //
+  return status;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: band_frame
+//
+// arguments:
+//  double* y: the log power of each band (output)
+//  const double* x: the first sample of a frame (input)
+//  long plan: the fft plan of the frame length (input)
+//  long slot: the sliding state to use (input)
+//  bool first: true if the previous frame is not x - h (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the band powers of one untapered frame, with a
+// transform, with the transforms of the tapers or by sliding the bins
+// of the previous frame of the slot. The window, the weights and, for
+// sliding or tapers, the tables must be current.
+//
+bool Edf::band_frame(double* y_a, const double* x_a, long plan_a,
+		     long slot_a, bool first_a) {
+
+  // taper and transform the frame
+  //
+  if (spec_mode_d == SPEC_FFT) {
+    Edf::multiply(band_buf_d, x_a, win_tab_d, band_n_d);
+    return Edf::band_power(y_a, band_buf_d, plan_a);
+  }
+
+  // average the spectra of the tapers
+  //
+  if (spec_mode_d == SPEC_MULTITAPER) {
+    double* pow = band_buf_d + band_n_d;
+    Edf::mt_frame(pow, x_a, mt_set_d, mt_plan_d, mt_buf_d);
+    return Edf::band_psum(y_a, pow);
+  }
+
+  // slide the bins, or compute them again when they are not valid,
+  // frames do not overlap or the slot is due to be resynchronized
+  //
+  bool sync = (first_a) || (sdft_count_d[slot_a] < 0) ||
+    (sdft_h_d >= sdft_n_d) || (sdft_count_d[slot_a] >= sdft_resync_d);
+
+  double* spec = band_buf_d + band_n_d;
+  Edf::sdft_frame(spec, x_a, slot_a, sync);
+
+  // exit gracefully
+  //
+  return Edf::band_sum(y_a, spec);
+}
+
+// method: create_sdft_tables
+//
+// arguments:
+//  long n: the frame length in samples (input)
+//  long h: the frame shift in samples (input)
+//  long nslots: the number of sliding states needed (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the tables that slide the bins of the bands, and
+// sizes the states. The window table and the band weights must be
+// current for n. Nothing is recomputed if the tables are current. When
+// the tables or the number of states change, every state is computed
+// from the samples on its next frame.
+//
+bool Edf::create_sdft_tables(long n_a, long h_a, long nslots_a) {
+
+  // check if the tables are current
+  //
+  bool fresh = (sdft_n_d != n_a) || (sdft_h_d != h_a);
+  if (fresh) {
+
+    // find the cosine terms of the window (see create_window)
+    //
+    double a[3] = {1.0, 0.0, 0.0};
+    long nm = 1;
+    if (win_ttype_d == WIN_HAMMING) {
+      a[0] = 0.54;
+      a[1] = -0.46;
+      nm = 2;
+    }
+    else if (win_ttype_d == WIN_HANN) {
+      a[0] = 0.50;
+      a[1] = -0.50;
+      nm = 2;
+    }
+    else if (win_ttype_d == WIN_BLACKMAN) {
+      a[0] = 0.42;
+      a[1] = -0.50;
+      a[2] = 0.08;
+      nm = 3;
+    }
+    else if (win_ttype_d != WIN_RECTANGULAR) {
+      fprintf(stdout, "**> Edf::create_sdft_tables(): %s %d\n",
+	      "window cannot be slid", (int)win_ttype_d);
+      return false;
+    }
+
+    // term j of a bin is the exponential m = j - (nm - 1)
+    //
+    long nterm = 2 * nm - 1;
+    for (long j = 0; j < nterm; j++) {
+      long m = labs(j - (nm - 1));
+      sdft_coef_d[j] = (m == 0) ? a[0] : 0.5 * a[m];
+    }
+
+    // collect the bins of the bands
+    //
+    long nbins = n_a / 2 + 1;
+    VectorLong used(nbins);
+    for (long k = 0; k < nbins; k++) {
+      used[k] = 0;
+    }
+    for (long b = 0; b < (long)band_lo_d.size(); b++) {
+      for (long k = 0; k < band_nbins_d[b]; k++) {
+	used[band_first_d[b] + k] = 1;
+      }
+    }
+    long nused = 0;
+    for (long k = 0; k < nbins; k++) {
+      nused += used[k];
+    }
+    Edf::resize(sdft_bin_d, nused, false);
+    nused = 0;
+    for (long k = 0; k < nbins; k++) {
+      if (used[k] != 0) {
+	sdft_bin_d[nused++] = k;
+      }
+    }
+
+    // choose the blocks: the ring is kept when h splits a frame into at
+    // most SDFT_MAXRING blocks. otherwise a frame is summed in blocks of
+    // at least n / SDFT_MAXRING samples when it is resynchronized, so
+    // small shifts do not make resynchronization slow.
+    //
+    long nring = 0;
+    long nb = h_a;
+    if ((n_a % h_a == 0) && (n_a / h_a > 1) && (n_a / h_a <= SDFT_MAXRING)) {
+      nring = n_a / h_a;
+    }
+    else if (h_a >= n_a) {
+      nb = n_a;
+    }
+    else if (nb * SDFT_MAXRING < n_a) {
+      nb = (n_a + SDFT_MAXRING - 1) / SDFT_MAXRING;
+    }
+
+    // size the tables: nb block factors, q + 1 block offsets, two slide
+    // factors and two scratch sums per group
+    //
+    long q = n_a / nb;
+    long nacc = nused * nterm;
+    long ngrp = (nacc + SDFT_GROUP - 1) / SDFT_GROUP;
+    long gsize = 2 * SDFT_GROUP;
+    long tsize = ngrp * gsize * (nb + q + 1 + 4);
+
+    if (tsize > sdft_tsize_d) {
+      free(sdft_tab_d);
+      void* ptr;
+      if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+			 tsize * sizeof(double)) != 0) {
+	sdft_tab_d = (double*)NULL;
+	sdft_tsize_d = 0;
+	sdft_n_d = -1;
+	fprintf(stdout, "**> Edf::create_sdft_tables(): out of memory\n");
+	return false;
+      }
+      sdft_tab_d = (double*)ptr;
+      sdft_tsize_d = tsize;
+    }
+    memset(sdft_tab_d, 0, tsize * sizeof(double));
+
+    sdft_nterm_d = nterm;
+    sdft_ngrp_d = ngrp;
+    sdft_nring_d = nring;
+    sdft_nb_d = nb;
+    sdft_poff_d = ngrp * gsize * nb;
+    sdft_zoff_d = sdft_poff_d + ngrp * gsize * (q + 1);
+
+    // compute the factors of each accumulator: phases are reduced to
+    // [0, 1) cycles before the cosines are taken
+    //
+    double mstep = (n_a > 1) ? 1.0 / (double)(n_a - 1) : 0.0;
+    for (long i = 0; i < nacc; i++) {
+      long k = sdft_bin_d[i / nterm];
+      long m = i % nterm - (nm - 1);
+      double f = (double)k / (double)n_a - m * mstep;
+      long l = i % SDFT_GROUP;
+      long g = (i / SDFT_GROUP) * gsize + l;
+
+      double* z = sdft_tab_d + (i / SDFT_GROUP) * gsize * nb + l;
+      for (long u = 0; u < nb; u++) {
+	double p = f * u - floor(f * u);
+	z[u * gsize] = cos(2.0 * M_PI * p);
+	z[u * gsize + SDFT_GROUP] = -sin(2.0 * M_PI * p);
+      }
+      for (long j = 0; j <= q; j++) {
+	double p = f * j * nb - floor(f * j * nb);
+	z = sdft_tab_d + sdft_poff_d + j * ngrp * gsize + g;
+	z[0] = cos(2.0 * M_PI * p);
+	z[SDFT_GROUP] = -sin(2.0 * M_PI * p);
+      }
+
+      double p = f * h_a - floor(f * h_a);
+      z = sdft_tab_d + sdft_zoff_d + g;
+      z[0] = cos(2.0 * M_PI * p);
+      z[SDFT_GROUP] = sin(2.0 * M_PI * p);
+
+      p = f * (n_a - h_a) - floor(f * (n_a - h_a));
+      z += ngrp * gsize;
+      z[0] = cos(2.0 * M_PI * p);
+      z[SDFT_GROUP] = -sin(2.0 * M_PI * p);
+    }
+
+    sdft_n_d = n_a;
+    sdft_h_d = h_a;
+
+    // display debugging information
+    //
+    if (debug_level_d >= LEVEL_DETAILED) {
+      fprintf(stdout,
+	      "Edf::create_sdft_tables(): %s %ld %ld %ld %ld %ld %ld\n",
+	      "(n, h, nbins, nterm, nb, nring)",
+	      n_a, h_a, nused, nterm, nb, nring);
+    }
+  }
+
+  // size the states: the accumulators and the ring of each slot. slots
+  // are never dropped, since a stream may be open.
+  //
+  long nslots = (nslots_a > sdft_nslots_d) ? nslots_a : sdft_nslots_d;
+  long sstride = sdft_ngrp_d * 2 * SDFT_GROUP * (1 + sdft_nring_d);
+  long ssize = sstride * nslots;
+  if (ssize > sdft_ssize_d) {
+    free(sdft_state_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       ssize * sizeof(double)) != 0) {
+      sdft_state_d = (double*)NULL;
+      sdft_ssize_d = 0;
+      sdft_nslots_d = 0;
+      fprintf(stdout, "**> Edf::create_sdft_tables(): out of memory\n");
+      return false;
+    }
+    sdft_state_d = (double*)ptr;
+    sdft_ssize_d = ssize;
+    fresh = true;
+  }
+  if ((fresh) || (sstride != sdft_sstride_d) || (nslots > sdft_nslots_d)) {
+    Edf::resize(sdft_head_d, nslots, false);
+    Edf::resize(sdft_count_d, nslots, false);
+    for (long i = 0; i < nslots; i++) {
+      sdft_head_d[i] = 0;
+      sdft_count_d[i] = -1;
+    }
+    sdft_sstride_d = sstride;
+    sdft_nslots_d = nslots;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: sdft_frame
+//
+// arguments:
+//  double* spec: the spectrum, written for the bins of the bands (output)
+//  const double* x: the first sample of a frame (input)
+//  long slot: the sliding state (input)
+//  bool sync: true to compute the bins from the samples (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the tapered bins of the bands of a frame. When
+// sync is false, the state must hold the frame at x - h, whose samples
+// must still be readable.
+//
+bool Edf::sdft_frame(double* spec_a, const double* x_a, long slot_a,
+		     bool sync_a) {
+
+  // declare local variables
+  //
+  long n = sdft_n_d;
+  long h = sdft_h_d;
+  long nb = sdft_nb_d;
+  long q = n / nb;
+  long r = n % nb;
+  long gsize = 2 * SDFT_GROUP;
+  long asize = sdft_ngrp_d * gsize;
+
+  double* s = sdft_state_d + slot_a * sdft_sstride_d;
+  double* ring = s + asize;
+  const double* zmh = sdft_tab_d + sdft_zoff_d;
+  const double* zf = zmh + asize;
+  double* g0 = sdft_tab_d + sdft_zoff_d + 2 * asize;
+  double* g1 = g0 + asize;
+
+  // compute the sums from the samples: S = sum_j z^(j nb) G_j, where G_j
+  // is the sum of block j (the last one has r samples)
+  //
+  if (sync_a) {
+    memset(s, 0, asize * sizeof(double));
+    for (long j = 0; j <= q; j++) {
+      long len = (j < q) ? nb : r;
+      if (len == 0) {
+	break;
+      }
+      double* g = (sdft_nring_d > 0) ? ring + j * asize : g0;
+      Edf::sdft_block_sum(g, x_a + j * nb, len);
+
+      const double* z = sdft_tab_d + sdft_poff_d + j * asize;
+      for (long i = 0; i < asize; i += gsize) {
+	for (long l = i; l < i + SDFT_GROUP; l++) {
+	  long m = l + SDFT_GROUP;
+	  s[l] += z[l] * g[l] - z[m] * g[m];
+	  s[m] += z[l] * g[m] + z[m] * g[l];
+	}
+      }
+    }
+    sdft_head_d[slot_a] = 0;
+    sdft_count_d[slot_a] = 0;
+  }
+
+  // slide the sums from the frame at x - h: the block that leaves is the
+  // oldest of the ring, or is summed again
+  //
+  else {
+    const double* lv = g0;
+    if (sdft_nring_d > 0) {
+      lv = ring + sdft_head_d[slot_a] * asize;
+    }
+    else {
+      Edf::sdft_block_sum(g0, x_a - h, h);
+    }
+    Edf::sdft_block_sum(g1, x_a - h + n, h);
+
+    for (long i = 0; i < asize; i += gsize) {
+      for (long l = i; l < i + SDFT_GROUP; l++) {
+	long m = l + SDFT_GROUP;
+	double dr = s[l] - lv[l];
+	double di = s[m] - lv[m];
+	s[l] = zmh[l] * dr - zmh[m] * di + zf[l] * g1[l] - zf[m] * g1[m];
+	s[m] = zmh[l] * di + zmh[m] * dr + zf[l] * g1[m] + zf[m] * g1[l];
+      }
+    }
+
+    if (sdft_nring_d > 0) {
+      memcpy(ring + sdft_head_d[slot_a] * asize, g1, asize * sizeof(double));
+      sdft_head_d[slot_a] = (sdft_head_d[slot_a] + 1) % sdft_nring_d;
+    }
+    sdft_count_d[slot_a]++;
+  }
+
+  // combine the sums of each bin with the coefficients of the window
+  //
+  long nterm = sdft_nterm_d;
+  for (long b = 0; b < (long)sdft_bin_d.size(); b++) {
+    double re = 0;
+    double im = 0;
+    for (long j = 0; j < nterm; j++) {
+      long i = b * nterm + j;
+      long l = (i / SDFT_GROUP) * gsize + i % SDFT_GROUP;
+      re += sdft_coef_d[j] * s[l];
+      im += sdft_coef_d[j] * s[l + SDFT_GROUP];
+    }
+    spec_a[2 * sdft_bin_d[b]] = re;
+    spec_a[2 * sdft_bin_d[b] + 1] = im;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: sdft_block_sum
+//
+// arguments:
+//  double* g: the sums of each group of accumulators (output)
+//  const double* x: the first sample of a block (input)
+//  long len: the length of the block, at most sdft_nb_d (input)
+//
+// return: a logical value indicating status
+//
+// This method computes sum_{u < len} x[u] z^u for every accumulator,
+// using AVX or SSE2 when the compiler targets them. Each group keeps
+// its sums in registers while it runs over the block, with two sets of
+// sums so that consecutive samples do not wait on each other.
+//
+bool Edf::sdft_block_sum(double* g_a, const double* x_a, long len_a) {
+
+  // declare local variables
+  //
+  long gsize = 2 * SDFT_GROUP;
+  long tstride = gsize * sdft_nb_d;
+
+  for (long k = 0; k < sdft_ngrp_d; k++) {
+    const double* t = sdft_tab_d + k * tstride;
+    double* g = g_a + k * gsize;
+    long u = 0;
+
+#if defined(__AVX__)
+    __m256d re0 = _mm256_setzero_pd();
+    __m256d im0 = _mm256_setzero_pd();
+    __m256d re1 = _mm256_setzero_pd();
+    __m256d im1 = _mm256_setzero_pd();
+    for (; u + 2 <= len_a; u += 2) {
+      __m256d x0 = _mm256_set1_pd(x_a[u]);
+      __m256d x1 = _mm256_set1_pd(x_a[u + 1]);
+      const double* t0 = t + u * gsize;
+      re0 = _mm256_add_pd(re0, _mm256_mul_pd(x0, _mm256_load_pd(t0)));
+      im0 = _mm256_add_pd(im0, _mm256_mul_pd(x0, _mm256_load_pd(t0 + 4)));
+      re1 = _mm256_add_pd(re1, _mm256_mul_pd(x1, _mm256_load_pd(t0 + 8)));
+      im1 = _mm256_add_pd(im1, _mm256_mul_pd(x1, _mm256_load_pd(t0 + 12)));
+    }
+    _mm256_storeu_pd(g, _mm256_add_pd(re0, re1));
+    _mm256_storeu_pd(g + 4, _mm256_add_pd(im0, im1));
+#elif defined(__SSE2__)
+    __m128d a[8];
+    for (long l = 0; l < 8; l++) {
+      a[l] = _mm_setzero_pd();
+    }
+    for (; u + 2 <= len_a; u += 2) {
+      __m128d x0 = _mm_set1_pd(x_a[u]);
+      __m128d x1 = _mm_set1_pd(x_a[u + 1]);
+      const double* t0 = t + u * gsize;
+      for (long l = 0; l < 4; l++) {
+	a[l] = _mm_add_pd(a[l], _mm_mul_pd(x0, _mm_load_pd(t0 + 2 * l)));
+	a[l + 4] = _mm_add_pd(a[l + 4],
+			      _mm_mul_pd(x1, _mm_load_pd(t0 + 8 + 2 * l)));
+      }
+    }
+    for (long l = 0; l < 4; l++) {
+      _mm_storeu_pd(g + 2 * l, _mm_add_pd(a[l], a[l + 4]));
+    }
+#else
+    for (long l = 0; l < gsize; l++) {
+      g[l] = 0;
+    }
+#endif
+
+    // add the remaining samples
+    //
+    for (; u < len_a; u++) {
+      const double* t0 = t + u * gsize;
+      for (long l = 0; l < gsize; l++) {
+	g[l] += x_a[u] * t0[l];
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
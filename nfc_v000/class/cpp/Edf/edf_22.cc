@@ -0,0 +1,1081 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_22.cc
+//
+// This file contains the methods of the class FeatureStats, which keeps
+// running statistics of features for normalization (CMN / CMVN).
+//
+// The mean and the sum of squared deviations of each channel and
+// feature are updated with Welford's method, one frame at a time, or a
+// block of frames at a time by combining the moments of the block with
+// the running ones (Chan et al.):
+//
+//  n = na + nb,  d = mb - ma
+//  m = ma + d nb / n
+//  M2 = M2a + M2b + d^2 na nb / n
+//
+// The same update merges statistics collected separately (e.g., by
+// other threads, for other files or on other machines), so a corpus can
+// be summarized in pieces.
+//
+// Quantiles are estimated with a sketch per channel and feature that
+// counts values in logarithmic buckets: bucket b holds magnitudes in
+// (gamma^(b-1), gamma^b], with gamma = (1 + alpha) / (1 - alpha), so
+// any quantile is known to within a relative error alpha. Positive and
+// negative values have their own buckets, and magnitudes below
+// SKETCH_MIN are counted as zero. Merging adds the counts, so the
+// result does not depend on the order in which pieces are merged.
+//
+// Statistics are saved in a binary file, written in little endian byte
+// order so that it can be read on any machine:
+//
+//  (1) header (HEADER_SIZE bytes):
+//      magic string MAGIC                   (4 bytes)
+//      version (1)                          (4-byte int)
+//      number of channels                   (8-byte int)
+//      feature dimension                    (8-byte int)
+//      alpha, SKETCH_MIN, SKETCH_MAX        (8-byte floats)
+//      zero padding
+//  (2) the count of each channel            (8-byte ints)
+//  (3) the means, then the sums of squared deviations, by channel and
+//      feature                              (8-byte floats)
+//  (4) when alpha is not zero, for each sketch: the zero count, then
+//      the first bucket, the number of buckets and the counts of the
+//      positive and of the negative buckets (8-byte ints)
+//
+// Normalization computes y = a x + b for each channel and feature, and
+// applies it in place to each frame using AVX or SSE2 when the compiler
+// targets them.
+//
+
+// system include files
+//
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+//-----------------------------------------------------------------------------
+//
+// FeatureStats constants
+//
+//-----------------------------------------------------------------------------
+
+double FeatureStats::DEF_ALPHA = 0.01;
+double FeatureStats::SKETCH_MIN = 1e-9;
+double FeatureStats::SKETCH_MAX = 1e9;
+double FeatureStats::VAR_FLOOR = 1e-20;
+const char* FeatureStats::MAGIC("NFCS");
+
+//-----------------------------------------------------------------------------
+//
+// byte order helpers:
+//  files hold 8-byte little endian words
+//
+//-----------------------------------------------------------------------------
+
+static bool put_words(FILE* fp_a, const void* x_a, long n_a) {
+  uint16_t one = 1;
+  if (*(uint8_t*)&one == 1) {
+    return (fwrite(x_a, sizeof(uint64_t), n_a, fp_a) == (size_t)n_a);
+  }
+  const uint64_t* x = (const uint64_t*)x_a;
+  for (long i = 0; i < n_a; i++) {
+    uint64_t w = __builtin_bswap64(x[i]);
+    if (fwrite(&w, sizeof(uint64_t), 1, fp_a) != 1) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool get_words(FILE* fp_a, void* y_a, long n_a) {
+  if (fread(y_a, sizeof(uint64_t), n_a, fp_a) != (size_t)n_a) {
+    return false;
+  }
+  uint16_t one = 1;
+  if (*(uint8_t*)&one == 0) {
+    uint64_t* y = (uint64_t*)y_a;
+    for (long i = 0; i < n_a; i++) {
+      y[i] = __builtin_bswap64(y[i]);
+    }
+  }
+  return true;
+}
+
+static bool put_long(FILE* fp_a, long x_a) {
+  int64_t x = x_a;
+  return put_words(fp_a, &x, 1);
+}
+
+static bool get_long(FILE* fp_a, long& x_a) {
+  int64_t x;
+  if (!get_words(fp_a, &x, 1)) {
+    return false;
+  }
+  x_a = x;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// FeatureStats methods
+//
+//-----------------------------------------------------------------------------
+
+// method: default constructor
+//
+// arguments: none
+//
+// return: none
+//
+FeatureStats::FeatureStats() {
+  nchan_d = 0;
+  dim_d = 0;
+  alpha_d = DEF_ALPHA;
+  lgamma_d = 0;
+  bmin_d = 0;
+  bmax_d = 0;
+}
+
+// method: destructor
+//
+// arguments: none
+//
+// return: none
+//
+FeatureStats::~FeatureStats() {
+}
+
+// method: resize
+//
+// arguments:
+//  long nchan: the number of channels (input)
+//  long dim: the feature dimension (input)
+//  double alpha: the relative accuracy of the quantiles (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the shape and the accuracy, and clears the
+// statistics.
+//
+bool FeatureStats::resize(long nchan_a, long dim_a, double alpha_a) {
+
+  // check the arguments
+  //
+  if ((nchan_a < 0) || (dim_a < 0) || (!((alpha_a >= 0) && (alpha_a < 1)))) {
+    fprintf(stdout, "**> FeatureStats::resize(): %s (%ld %ld %f)\n",
+	    "invalid shape or accuracy", nchan_a, dim_a, alpha_a);
+    return false;
+  }
+
+  // set the shape and the bucket range
+  //
+  nchan_d = nchan_a;
+  dim_d = dim_a;
+  alpha_d = alpha_a;
+  lgamma_d = 0;
+  bmin_d = 0;
+  bmax_d = 0;
+  if (alpha_a > 0) {
+    lgamma_d = log((1.0 + alpha_a) / (1.0 - alpha_a));
+    bmin_d = (long)ceil(log(SKETCH_MIN) / lgamma_d);
+    bmax_d = (long)ceil(log(SKETCH_MAX) / lgamma_d);
+  }
+
+  long nsk = (alpha_a > 0) ? nchan_a * dim_a : 0;
+  count_d.resize(nchan_a, false);
+  mean_d.resize(nchan_a * dim_a, false);
+  m2_d.resize(nchan_a * dim_a, false);
+  zero_d.resize(nsk, false);
+  lo_d.resize(2 * nsk, false);
+  pos_d.resize(nsk, false);
+  neg_d.resize(nsk, false);
+
+  // exit gracefully
+  //
+  return clear();
+}
+
+// method: clear
+//
+// arguments: none
+//
+// return: a logical value indicating status
+//
+// This method clears the statistics, keeping the shape.
+//
+bool FeatureStats::clear() {
+
+  // clear the moments
+  //
+  for (long i = 0; i < nchan_d; i++) {
+    count_d[i] = 0;
+  }
+  for (long i = 0; i < nchan_d * dim_d; i++) {
+    mean_d[i] = 0;
+    m2_d[i] = 0;
+  }
+
+  // clear the sketches
+  //
+  for (long s = 0; s < (long)zero_d.size(); s++) {
+    zero_d[s] = 0;
+    lo_d[2 * s] = 0;
+    lo_d[2 * s + 1] = 0;
+    pos_d[s].resize(0, false);
+    neg_d[s].resize(0, false);
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_quantile
+//
+// arguments:
+//  long chan: the channel (input)
+//  long k: the feature (input)
+//  double q: the quantile in [0, 1] (input)
+//
+// return: the value of the quantile, or 0 if it is not known
+//
+// This method estimates a quantile from the sketch of a feature. The
+// value is within a relative error alpha of the q (n - 1)-th smallest
+// of the n values seen (values below SKETCH_MIN are reported as zero).
+//
+double FeatureStats::get_quantile(long chan_a, long k_a, double q_a) const {
+
+  // check that there is a sketch with values
+  //
+  if ((!(alpha_d > 0)) || (chan_a < 0) || (chan_a >= nchan_d) ||
+      (k_a < 0) || (k_a >= dim_d) || (count_d[chan_a] == 0)) {
+    return 0.0;
+  }
+
+  // find the rank
+  //
+  double q = (q_a < 0) ? 0.0 : ((q_a > 1) ? 1.0 : q_a);
+  double rank = q * (count_d[chan_a] - 1);
+  long s = chan_a * dim_d + k_a;
+  long cum = 0;
+
+  // walk the buckets in increasing order of value: the negative values
+  // from the largest magnitude down, zero, then the positive values
+  //
+  const VectorLong& neg = neg_d[s];
+  for (long j = (long)neg.size() - 1; j >= 0; j--) {
+    cum += neg[j];
+    if (cum > rank) {
+      return -get_bucket_value(lo_d[2 * s + 1] + j);
+    }
+  }
+
+  cum += zero_d[s];
+  if (cum > rank) {
+    return 0.0;
+  }
+
+  const VectorLong& pos = pos_d[s];
+  for (long j = 0; j < (long)pos.size(); j++) {
+    cum += pos[j];
+    if (cum > rank) {
+      return get_bucket_value(lo_d[2 * s] + j);
+    }
+  }
+
+  // the rank is beyond the counts (should not happen)
+  //
+  return (pos.size() > 0) ?
+    get_bucket_value(lo_d[2 * s] + (long)pos.size() - 1) : 0.0;
+}
+
+// method: add_frame
+//
+// arguments:
+//  const double* x: a frame of dim values (input)
+//  long chan: the channel of the frame (input)
+//
+// return: a logical value indicating status
+//
+// This method adds one frame to the statistics of a channel.
+//
+bool FeatureStats::add_frame(const double* x_a, long chan_a) {
+
+  // check the channel
+  //
+  if ((chan_a < 0) || (chan_a >= nchan_d)) {
+    fprintf(stdout, "**> FeatureStats::add_frame(): %s %ld\n",
+	    "invalid channel", chan_a);
+    return false;
+  }
+
+  // update the moments
+  //
+  long c = ++count_d[chan_a];
+  double* m = &mean_d[0] + chan_a * dim_d;
+  double* m2 = &m2_d[0] + chan_a * dim_d;
+  for (long k = 0; k < dim_d; k++) {
+    double d = x_a[k] - m[k];
+    m[k] += d / c;
+    m2[k] += d * (x_a[k] - m[k]);
+  }
+
+  // update the sketches
+  //
+  if (alpha_d > 0) {
+    for (long k = 0; k < dim_d; k++) {
+      add_value(chan_a * dim_d + k, x_a[k]);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: add_frames
+//
+// arguments:
+//  const double* x: nframes packed frames of dim values (input)
+//  long nframes: the number of frames (input)
+//  long chan: the channel of the frames (input)
+//
+// return: a logical value indicating status
+//
+// This method adds a block of frames to the statistics of a channel.
+// The moments of the block are computed in two passes and combined with
+// the running moments.
+//
+bool FeatureStats::add_frames(const double* x_a, long nframes_a,
+			      long chan_a) {
+
+  // check the channel
+  //
+  if ((chan_a < 0) || (chan_a >= nchan_d)) {
+    fprintf(stdout, "**> FeatureStats::add_frames(): %s %ld\n",
+	    "invalid channel", chan_a);
+    return false;
+  }
+  if (nframes_a <= 0) {
+    return true;
+  }
+
+  // compute the moments of the block
+  //
+  if ((long)work_d.size() < 2 * dim_d) {
+    work_d.resize(2 * dim_d, false);
+  }
+  double* bm = &work_d[0];
+  double* bm2 = bm + dim_d;
+  for (long k = 0; k < dim_d; k++) {
+    bm[k] = 0;
+    bm2[k] = 0;
+  }
+
+  for (long j = 0; j < nframes_a; j++) {
+    const double* y = x_a + j * dim_d;
+    for (long k = 0; k < dim_d; k++) {
+      bm[k] += y[k];
+    }
+  }
+  for (long k = 0; k < dim_d; k++) {
+    bm[k] /= nframes_a;
+  }
+  for (long j = 0; j < nframes_a; j++) {
+    const double* y = x_a + j * dim_d;
+    for (long k = 0; k < dim_d; k++) {
+      double d = y[k] - bm[k];
+      bm2[k] += d * d;
+    }
+  }
+
+  // combine them with the running moments
+  //
+  double na = count_d[chan_a];
+  double nb = nframes_a;
+  double n = na + nb;
+  double* m = &mean_d[0] + chan_a * dim_d;
+  double* m2 = &m2_d[0] + chan_a * dim_d;
+  for (long k = 0; k < dim_d; k++) {
+    double d = bm[k] - m[k];
+    m[k] += d * nb / n;
+    m2[k] += bm2[k] + d * d * na * nb / n;
+  }
+  count_d[chan_a] += nframes_a;
+
+  // update the sketches
+  //
+  if (alpha_d > 0) {
+    for (long j = 0; j < nframes_a; j++) {
+      const double* y = x_a + j * dim_d;
+      for (long k = 0; k < dim_d; k++) {
+	add_value(chan_a * dim_d + k, y[k]);
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: add
+//
+// arguments:
+//  FeatureTensor& feat: features (input)
+//
+// return: a logical value indicating status
+//
+// This method adds every frame of a tensor to the statistics.
+//
+bool FeatureStats::add(FeatureTensor& feat_a) {
+
+  // check the shape
+  //
+  if ((nchan_d == 0) && (!resize(feat_a.get_nchan(), feat_a.get_dim(),
+				 alpha_d))) {
+    return false;
+  }
+  if ((feat_a.get_nchan() != nchan_d) || (feat_a.get_dim() != dim_d)) {
+    fprintf(stdout, "**> FeatureStats::add(): %s (%ld %ld) (%ld %ld)\n",
+	    "shape does not match (nchan, dim)", feat_a.get_nchan(),
+	    feat_a.get_dim(), nchan_d, dim_d);
+    return false;
+  }
+
+  // add the frames of each channel as one block when they are packed,
+  // otherwise one at a time
+  //
+  for (long i = 0; i < nchan_d; i++) {
+    if (feat_a.get_fstride() == dim_d) {
+      add_frames(feat_a.get_channel(i), feat_a.get_nframes(), i);
+    }
+    else {
+      for (long j = 0; j < feat_a.get_nframes(); j++) {
+	add_frame(feat_a.get_frame(i, j), i);
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: add
+//
+// arguments:
+//  VVVectorDouble& feat: features (input)
+//
+// return: a logical value indicating status
+//
+// This method adds every frame of nested vectors to the statistics.
+//
+bool FeatureStats::add(VVVectorDouble& feat_a) {
+
+  // check the shape
+  //
+  long nchan = feat_a.size();
+  long dim = 0;
+  for (long i = 0; (i < nchan) && (dim == 0); i++) {
+    if (feat_a[i].size() > 0) {
+      dim = feat_a[i][0].size();
+    }
+  }
+  if (dim == 0) {
+    return true;
+  }
+  if ((nchan_d == 0) && (!resize(nchan, dim, alpha_d))) {
+    return false;
+  }
+  if ((nchan != nchan_d) || (dim != dim_d)) {
+    fprintf(stdout, "**> FeatureStats::add(): %s (%ld %ld) (%ld %ld)\n",
+	    "shape does not match (nchan, dim)", nchan, dim, nchan_d, dim_d);
+    return false;
+  }
+
+  // add the frames one at a time
+  //
+  for (long i = 0; i < nchan; i++) {
+    for (long j = 0; j < (long)feat_a[i].size(); j++) {
+      if ((long)feat_a[i][j].size() != dim_d) {
+	fprintf(stdout, "**> FeatureStats::add(): %s [%ld][%ld]\n",
+		"invalid frame size", i, j);
+	return false;
+      }
+      add_frame(&feat_a[i][j][0], i);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: merge
+//
+// arguments:
+//  const FeatureStats& st: statistics of the same shape (input)
+//
+// return: a logical value indicating status
+//
+// This method adds statistics collected elsewhere to these ones. The
+// result is the same as if all the frames had been added here, up to
+// rounding, and the sketches are exactly the same.
+//
+bool FeatureStats::merge(const FeatureStats& st_a) {
+
+  // statistics with no shape take the other ones
+  //
+  if (nchan_d == 0) {
+    *this = st_a;
+    return true;
+  }
+  if (st_a.nchan_d == 0) {
+    return true;
+  }
+
+  // check the shape and the accuracy
+  //
+  if ((st_a.nchan_d != nchan_d) || (st_a.dim_d != dim_d) ||
+      (st_a.alpha_d != alpha_d)) {
+    fprintf(stdout, "**> FeatureStats::merge(): %s (%ld %ld %f) %s\n",
+	    "shape or accuracy does not match", st_a.nchan_d, st_a.dim_d,
+	    st_a.alpha_d, "(nchan, dim, alpha)");
+    return false;
+  }
+
+  // combine the moments
+  //
+  for (long i = 0; i < nchan_d; i++) {
+    double na = count_d[i];
+    double nb = st_a.count_d[i];
+    if (nb == 0) {
+      continue;
+    }
+    double n = na + nb;
+    for (long k = 0; k < dim_d; k++) {
+      long l = i * dim_d + k;
+      double d = st_a.mean_d[l] - mean_d[l];
+      mean_d[l] += d * nb / n;
+      m2_d[l] += st_a.m2_d[l] + d * d * na * nb / n;
+    }
+    count_d[i] += st_a.count_d[i];
+  }
+
+  // add the counts of the sketches
+  //
+  for (long s = 0; s < (long)zero_d.size(); s++) {
+    zero_d[s] += st_a.zero_d[s];
+    for (long j = 0; j < (long)st_a.pos_d[s].size(); j++) {
+      if (st_a.pos_d[s][j] != 0) {
+	add_bucket(2 * s, st_a.lo_d[2 * s] + j, st_a.pos_d[s][j]);
+      }
+    }
+    for (long j = 0; j < (long)st_a.neg_d[s].size(); j++) {
+      if (st_a.neg_d[s][j] != 0) {
+	add_bucket(2 * s + 1, st_a.lo_d[2 * s + 1] + j, st_a.neg_d[s][j]);
+      }
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: write
+//
+// arguments:
+//  char* fn: the filename (input)
+//
+// return: a logical value indicating status
+//
+// This method saves the statistics.
+//
+bool FeatureStats::write(char* fn_a) {
+
+  // open the file
+  //
+  FILE* fp = fopen(fn_a, "wb");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> FeatureStats::write(): error opening (%s)\n", fn_a);
+    return false;
+  }
+
+  // write the header
+  //
+  char hdr[HEADER_SIZE];
+  memset(hdr, 0, HEADER_SIZE);
+  memcpy(hdr, MAGIC, strlen(MAGIC));
+  hdr[4] = 1;
+
+  bool status = (fwrite(hdr, 1, 8, fp) == 8) && put_long(fp, nchan_d) &&
+    put_long(fp, dim_d) && put_words(fp, &alpha_d, 1) &&
+    put_words(fp, &SKETCH_MIN, 1) && put_words(fp, &SKETCH_MAX, 1) &&
+    (fwrite(hdr + 48, 1, HEADER_SIZE - 48, fp) ==
+     (size_t)(HEADER_SIZE - 48));
+
+  // write the moments
+  //
+  for (long i = 0; (status) && (i < nchan_d); i++) {
+    status = put_long(fp, count_d[i]);
+  }
+  if ((status) && (nchan_d * dim_d > 0)) {
+    status = put_words(fp, &mean_d[0], nchan_d * dim_d) &&
+      put_words(fp, &m2_d[0], nchan_d * dim_d);
+  }
+
+  // write the sketches
+  //
+  for (long s = 0; (status) && (s < (long)zero_d.size()); s++) {
+    status = put_long(fp, zero_d[s]);
+    for (long t = 0; (status) && (t < 2); t++) {
+      const VectorLong& c = (t == 0) ? pos_d[s] : neg_d[s];
+      status = put_long(fp, lo_d[2 * s + t]) && put_long(fp, c.size());
+      for (long j = 0; (status) && (j < (long)c.size()); j++) {
+	status = put_long(fp, c[j]);
+      }
+    }
+  }
+
+  // close the file
+  //
+  if (fclose(fp) != 0) {
+    status = false;
+  }
+  if (!status) {
+    fprintf(stdout, "**> FeatureStats::write(): error writing (%s)\n", fn_a);
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: read
+//
+// arguments:
+//  char* fn: the filename (input)
+//
+// return: a logical value indicating status
+//
+// This method loads statistics saved by write, replacing these ones.
+//
+bool FeatureStats::read(char* fn_a) {
+
+  // open the file
+  //
+  FILE* fp = fopen(fn_a, "rb");
+  if (fp == (FILE*)NULL) {
+    fprintf(stdout, "**> FeatureStats::read(): error opening (%s)\n", fn_a);
+    return false;
+  }
+
+  // read the header
+  //
+  char hdr[HEADER_SIZE];
+  long nchan = 0;
+  long dim = 0;
+  double alpha = 0;
+  double smin = 0;
+  double smax = 0;
+
+  bool status = (fread(hdr, 1, 8, fp) == 8) &&
+    (memcmp(hdr, MAGIC, strlen(MAGIC)) == 0) && (hdr[4] == 1) &&
+    get_long(fp, nchan) && get_long(fp, dim) &&
+    get_words(fp, &alpha, 1) && get_words(fp, &smin, 1) &&
+    get_words(fp, &smax, 1) &&
+    (fread(hdr + 48, 1, HEADER_SIZE - 48, fp) ==
+     (size_t)(HEADER_SIZE - 48));
+
+  if ((status) && ((smin != SKETCH_MIN) || (smax != SKETCH_MAX))) {
+    fprintf(stdout, "**> FeatureStats::read(): %s (%s)\n",
+	    "sketch range does not match", fn_a);
+    fclose(fp);
+    return false;
+  }
+
+  // check that the file can hold the shape before allocating it: each
+  // channel has a count, each feature two moments and, with sketches,
+  // a zero count and two (first bucket, number of buckets) pairs
+  //
+  struct stat st;
+  if (status) {
+    long rest = (stat(fn_a, &st) == 0) ? (long)st.st_size - HEADER_SIZE : 0;
+    long fbytes = 2 * sizeof(double) + ((alpha > 0) ? 5 * sizeof(long) : 0);
+    if ((nchan < 0) || (dim < 0) || (dim > rest / fbytes) ||
+	(nchan > rest / ((long)sizeof(long) + dim * fbytes))) {
+      fprintf(stdout, "**> FeatureStats::read(): %s (%ld %ld) (%s)\n",
+	      "shape does not fit the file (nchan, dim)", nchan, dim, fn_a);
+      fclose(fp);
+      return false;
+    }
+  }
+  status = status && resize(nchan, dim, alpha);
+
+  // read the moments
+  //
+  for (long i = 0; (status) && (i < nchan_d); i++) {
+    status = get_long(fp, count_d[i]);
+  }
+  if ((status) && (nchan_d * dim_d > 0)) {
+    status = get_words(fp, &mean_d[0], nchan_d * dim_d) &&
+      get_words(fp, &m2_d[0], nchan_d * dim_d);
+  }
+
+  // read the sketches
+  //
+  for (long s = 0; (status) && (s < (long)zero_d.size()); s++) {
+    status = get_long(fp, zero_d[s]);
+    for (long t = 0; (status) && (t < 2); t++) {
+      VectorLong& c = (t == 0) ? pos_d[s] : neg_d[s];
+      long n = 0;
+      status = get_long(fp, lo_d[2 * s + t]) && get_long(fp, n) &&
+	(n >= 0) && (n <= bmax_d - bmin_d + 1) &&
+	((n == 0) || ((lo_d[2 * s + t] >= bmin_d) &&
+		      (lo_d[2 * s + t] <= bmax_d - n + 1)));
+      if (status) {
+	c.resize(n, false);
+      }
+      for (long j = 0; (status) && (j < n); j++) {
+	status = get_long(fp, c[j]);
+      }
+    }
+  }
+
+  // close the file
+  //
+  fclose(fp);
+  if (!status) {
+    fprintf(stdout, "**> FeatureStats::read(): error reading (%s)\n", fn_a);
+    resize(0, 0, DEF_ALPHA);
+  }
+
+  // exit gracefully
+  //
+  return status;
+}
+
+// method: apply
+//
+// arguments:
+//  FeatureTensor& feat: features (input/output)
+//  NORM_MODE mode: the normalization (input)
+//
+// return: a logical value indicating status
+//
+// This method normalizes every frame of a tensor in place with the
+// statistics of its channel.
+//
+bool FeatureStats::apply(FeatureTensor& feat_a, NORM_MODE mode_a) {
+
+  // check the shape
+  //
+  if ((feat_a.get_nchan() != nchan_d) || (feat_a.get_dim() != dim_d)) {
+    fprintf(stdout, "**> FeatureStats::apply(): %s (%ld %ld) (%ld %ld)\n",
+	    "shape does not match (nchan, dim)", feat_a.get_nchan(),
+	    feat_a.get_dim(), nchan_d, dim_d);
+    return false;
+  }
+
+  // compute the transform and apply it to each frame
+  //
+  VectorDouble a;
+  VectorDouble b;
+  if (!get_transform(a, b, mode_a)) {
+    return false;
+  }
+  for (long i = 0; i < nchan_d; i++) {
+    for (long j = 0; j < feat_a.get_nframes(); j++) {
+      transform(feat_a.get_frame(i, j), &a[i * dim_d], &b[i * dim_d]);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: apply
+//
+// arguments:
+//  VVVectorDouble& feat: features (input/output)
+//  NORM_MODE mode: the normalization (input)
+//
+// return: a logical value indicating status
+//
+// This method normalizes every frame of nested vectors in place with
+// the statistics of its channel.
+//
+bool FeatureStats::apply(VVVectorDouble& feat_a, NORM_MODE mode_a) {
+
+  // check the shape
+  //
+  if ((long)feat_a.size() != nchan_d) {
+    fprintf(stdout, "**> FeatureStats::apply(): %s (%ld %ld)\n",
+	    "number of channels does not match", (long)feat_a.size(),
+	    nchan_d);
+    return false;
+  }
+
+  // compute the transform and apply it to each frame
+  //
+  VectorDouble a;
+  VectorDouble b;
+  if (!get_transform(a, b, mode_a)) {
+    return false;
+  }
+  for (long i = 0; i < nchan_d; i++) {
+    for (long j = 0; j < (long)feat_a[i].size(); j++) {
+      if ((long)feat_a[i][j].size() != dim_d) {
+	fprintf(stdout, "**> FeatureStats::apply(): %s [%ld][%ld]\n",
+		"invalid frame size", i, j);
+	return false;
+      }
+      transform(&feat_a[i][j][0], &a[i * dim_d], &b[i * dim_d]);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// FeatureStats private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: get_bucket
+//
+// arguments:
+//  double x: a magnitude of at least SKETCH_MIN (input)
+//
+// return: the bucket of the magnitude
+//
+// The bucket is clamped before it is converted to an integer, since an
+// infinite magnitude has no integer bucket.
+//
+long FeatureStats::get_bucket(double x_a) const {
+  double b = ceil(log(x_a) / lgamma_d);
+  if (!(b > bmin_d)) {
+    return bmin_d;
+  }
+  return (b > bmax_d) ? bmax_d : (long)b;
+}
+
+// method: get_bucket_value
+//
+// arguments:
+//  long b: a bucket (input)
+//
+// return: the magnitude that stands for the bucket
+//
+// This method returns 2 gamma^b / (gamma + 1), which is within a
+// relative error alpha of every magnitude in the bucket.
+//
+double FeatureStats::get_bucket_value(long b_a) const {
+  return 2.0 * exp(b_a * lgamma_d) / (1.0 + exp(lgamma_d));
+}
+
+// method: add_bucket
+//
+// arguments:
+//  long store: 2 s for the positive and 2 s + 1 for the negative
+//              buckets of sketch s (input)
+//  long b: the bucket (input)
+//  long n: the count to add (input)
+//
+// return: a logical value indicating status
+//
+// This method adds to the count of a bucket. The buckets of a store are
+// contiguous, and grow by half their number at a time (but stay within
+// [bmin_d, bmax_d]) so that spreading values do not copy them often.
+//
+bool FeatureStats::add_bucket(long store_a, long b_a, long n_a) {
+
+  // declare local variables
+  //
+  VectorLong& c = (store_a & 1) ? neg_d[store_a / 2] : pos_d[store_a / 2];
+  long lo = lo_d[store_a];
+  long size = c.size();
+
+  // create the first bucket
+  //
+  if (size == 0) {
+    c.resize(1, false);
+    c[0] = 0;
+    lo = b_a;
+  }
+
+  // grow the buckets down: they are copied to their new place
+  //
+  else if (b_a < lo) {
+    long nlo = b_a - size / 2;
+    nlo = (nlo < bmin_d) ? bmin_d : nlo;
+    VectorLong t(size + lo - nlo);
+    for (long j = 0; j < lo - nlo; j++) {
+      t[j] = 0;
+    }
+    for (long j = 0; j < size; j++) {
+      t[lo - nlo + j] = c[j];
+    }
+    c.swap(t);
+    lo = nlo;
+  }
+
+  // grow the buckets up
+  //
+  else if (b_a >= lo + size) {
+    long nhi = b_a + size / 2;
+    nhi = (nhi > bmax_d) ? bmax_d : nhi;
+    c.resize(nhi - lo + 1, true);
+    for (long j = size; j < nhi - lo + 1; j++) {
+      c[j] = 0;
+    }
+  }
+
+  // add the count
+  //
+  c[b_a - lo] += n_a;
+  lo_d[store_a] = lo;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: add_value
+//
+// arguments:
+//  long sketch: the sketch (input)
+//  double x: a value (input)
+//
+// return: a logical value indicating status
+//
+bool FeatureStats::add_value(long sketch_a, double x_a) {
+  double ax = fabs(x_a);
+  if (!(ax >= SKETCH_MIN)) {
+    zero_d[sketch_a]++;
+    return true;
+  }
+  return add_bucket(2 * sketch_a + ((x_a < 0) ? 1 : 0), get_bucket(ax), 1);
+}
+
+// method: get_transform
+//
+// arguments:
+//  VectorDouble& a: the scale of each channel and feature (output)
+//  VectorDouble& b: the offset of each channel and feature (output)
+//  NORM_MODE mode: the normalization (input)
+//
+// return: a logical value indicating status
+//
+// This method computes y = a x + b for each channel and feature:
+//
+//  NORM_MEAN:    a = 1,          b = -mean
+//  NORM_MEANVAR: a = 1 / stddev, b = -mean / stddev
+//  NORM_ROBUST:  a = 1 / s,      b = -median / s
+//
+// where s = IQR / 1.349 is the standard deviation of a normal
+// distribution with the same interquartile range. Features whose
+// spread is not known (e.g., constant ones) are only shifted, and
+// channels without frames are not changed.
+//
+bool FeatureStats::get_transform(VectorDouble& a_a, VectorDouble& b_a,
+				 NORM_MODE mode_a) {
+
+  // check the mode
+  //
+  if ((mode_a == NORM_ROBUST) && (!(alpha_d > 0))) {
+    fprintf(stdout, "**> FeatureStats::get_transform(): %s\n",
+	    "robust normalization needs sketches (alpha > 0)");
+    return false;
+  }
+
+  // compute the shift and the scale of each feature
+  //
+  a_a.resize(nchan_d * dim_d, false);
+  b_a.resize(nchan_d * dim_d, false);
+
+  for (long i = 0; i < nchan_d; i++) {
+    for (long k = 0; k < dim_d; k++) {
+      long l = i * dim_d + k;
+      double shift = 0;
+      double spread = 0;
+
+      if (count_d[i] > 0) {
+	if (mode_a == NORM_ROBUST) {
+	  shift = get_quantile(i, k, 0.5);
+	  spread = (get_quantile(i, k, 0.75) - get_quantile(i, k, 0.25)) /
+	    1.349;
+	  spread = spread * spread;
+	}
+	else {
+	  shift = mean_d[l];
+	  spread = get_var(i, k);
+	}
+      }
+
+      a_a[l] = ((mode_a != NORM_MEAN) && (spread > VAR_FLOOR)) ?
+	1.0 / sqrt(spread) : 1.0;
+      b_a[l] = -shift * a_a[l];
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: transform
+//
+// arguments:
+//  double* x: a frame of dim values (input/output)
+//  const double* a: the scale of each feature (input)
+//  const double* b: the offset of each feature (input)
+//
+// return: a logical value indicating status
+//
+// This method computes x = a x + b in place, using AVX or SSE2 when
+// the compiler targets them.
+//
+bool FeatureStats::transform(double* x_a, const double* a_a,
+			     const double* b_a) {
+
+  // transform full vectors
+  //
+  long k = 0;
+#if defined(__AVX__)
+  for (; k + 4 <= dim_d; k += 4) {
+    _mm256_storeu_pd(x_a + k,
+		     _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(x_a + k),
+						 _mm256_loadu_pd(a_a + k)),
+				   _mm256_loadu_pd(b_a + k)));
+  }
+#elif defined(__SSE2__)
+  for (; k + 2 <= dim_d; k += 2) {
+    _mm_storeu_pd(x_a + k, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(x_a + k),
+						 _mm_loadu_pd(a_a + k)),
+				      _mm_loadu_pd(b_a + k)));
+  }
+#endif
+
+  // transform the rest
+  //
+  for (; k < dim_d; k++) {
+    x_a[k] = x_a[k] * a_a[k] + b_a[k];
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//
+// end of file
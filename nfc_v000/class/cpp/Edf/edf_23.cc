@@ -0,0 +1,780 @@
+// file: $(NEDC_NFC)/class/cpp/Edf/edf_23.cc
+//
+// This file contains methods associated with the class Edf that compute
+// multitaper spectra.
+//
+// A multitaper spectrum averages the periodograms of a frame tapered by
+// K orthogonal windows, the discrete prolate spheroidal sequences
+// (DPSS) of time half-bandwidth product NW:
+//
+//  S[k] = sum_j d_j |X_j[k]|^2,   X_j = fft(w_j x)
+//
+// Each taper has unit energy and concentrates a fraction c_j of its
+// energy in [-W, W], W = NW / n cycles per sample, so the estimate
+// trades a resolution of 2W for a variance about K times lower than
+// that of one window. The weights are d_j = c_j / sum_i c_i.
+//
+// The tapers are the eigenvectors of the largest eigenvalues of the
+// symmetric tridiagonal matrix
+//
+//  T[t][t] = ((n - 1 - 2t) / 2)^2 cos(2 pi W)
+//  T[t][t - 1] = T[t - 1][t] = t (n - t) / 2
+//
+// which commutes with the concentration operator. The eigenvalues are
+// found by bisection on Sturm counts and the eigenvectors by inverse
+// iteration, and the concentrations are computed from the
+// autocorrelation of each taper:
+//
+//  c_j = 2W r[0] + 2 sum_{s > 0} r[s] sin(2 pi W s) / (pi s)
+//
+// The tapers of up to MT_NSETS frame lengths (for the current NW and
+// K) are cached, so they are computed once for a whole recording.
+//
+// Two real sequences a and b are transformed at once as z = a + ib:
+//
+//  |A[k]|^2 + |B[k]|^2 = (|Z[k]|^2 + |Z[n - k]|^2) / 2
+//
+// so the K tapered copies of a frame are packed into (K + 1) / 2
+// complex sequences and transformed together with one batched
+// transform, and their powers are summed without separating them.
+// The tapers are stored scaled by sqrt(d_j), so the sum is S.
+//
+// compute_psd runs the channels in parallel with up to nthreads_d
+// threads. Band powers use the tapers when the spectrum mode is
+// SPEC_MULTITAPER (see edf_16).
+//
+
+// system include files
+//
+#include <float.h>
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// local include files
+//
+#include "Edf.h"
+
+// the work shared by the threads: each thread takes the next channel
+// that has not been processed until none are left
+//
+struct EdfMtJob {
+  Edf* edf;
+  FeatureTensor* psd;
+  VVectorDouble* sig;
+  long nchan;
+  long nframes;
+  long shift;
+  long next;
+  bool* status;
+};
+
+// method: set_multitaper
+//
+// arguments:
+//  double nw: the time half-bandwidth product (input)
+//  long ntapers: the number of tapers (input)
+//
+// return: a logical value indicating status
+//
+// This method sets the tapers of multitaper spectra. The resolution is
+// 2 nw / wdur Hz. Tapers after the first 2 nw - 1 are poorly
+// concentrated, but get little weight.
+//
+bool Edf::set_multitaper(double nw_a, long ntapers_a) {
+
+  // find the number of tapers
+  //
+  long k = ntapers_a;
+  if (k < 0) {
+    k = (long)(2 * nw_a) - 1;
+    k = (k < 1) ? 1 : k;
+  }
+
+  // check the arguments
+  //
+  if ((nw_a <= 0) || (k == 0)) {
+    fprintf(stdout, "**> Edf::set_multitaper(): %s (%f %ld)\n",
+	    "invalid tapers (nw, ntapers)", nw_a, ntapers_a);
+    return false;
+  }
+
+  // save the parameters: the cache is keyed on them
+  //
+  mt_nw_d = nw_a;
+  mt_k_d = k;
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_tapers
+//
+// arguments:
+//  VVectorDouble& tapers: the tapers (output)
+//  VectorDouble& conc: the concentration of each taper (output)
+//  long n: the length of the tapers (input)
+//
+// return: a logical value indicating status
+//
+// This method returns the unit energy tapers of a frame length for the
+// current parameters, in decreasing order of concentration.
+//
+bool Edf::get_tapers(VVectorDouble& tapers_a, VectorDouble& conc_a,
+		     long n_a) {
+
+  // find the tapers
+  //
+  long set = Edf::get_taper_set(n_a);
+  if (set < 0) {
+    return false;
+  }
+
+  // undo the weights
+  //
+  long k = mt_sk_d[set];
+  const double* tab = mt_tab_d[set];
+  const double* conc = tab + 2 * ((k + 1) / 2) * n_a;
+  double csum = 0;
+  for (long j = 0; j < k; j++) {
+    csum += conc[j];
+  }
+
+  Edf::resize(tapers_a, k, false);
+  Edf::resize(conc_a, k, false);
+  for (long j = 0; j < k; j++) {
+    Edf::resize(tapers_a[j], n_a, false);
+    const double* w = tab + 2 * (j / 2) * n_a + (j % 2);
+    double scale = sqrt(csum / conc[j]);
+    for (long t = 0; t < n_a; t++) {
+      tapers_a[j][t] = w[2 * t] * scale;
+    }
+    conc_a[j] = conc[j];
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: compute_psd
+//
+// arguments:
+//  FeatureTensor& psd: the power spectral density of each frame (output)
+//  VVectorDouble& sig: the signal (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the one-sided multitaper power spectral density
+// of every frame of every channel: psd(i, j, k) is the density, in
+// squared signal units per Hz, at k fs / n Hz of frame j of channel i,
+// for k = 0, ..., n / 2. Frames are cut as in compute_band_power. The
+// channels are processed in parallel.
+//
+bool Edf::compute_psd(FeatureTensor& psd_a, VVectorDouble& sig_a) {
+
+  // check the frame parameters
+  //
+  long shift = Edf::get_frame_shift();
+  long n = Edf::get_window_length();
+  if ((shift <= 0) || (n <= 0) || (hdr_sample_frequency_d <= 0)) {
+    fprintf(stdout, "**> Edf::compute_psd(): %s (%f %f %f)\n",
+	    "invalid frame parameters (fdur, wdur, fs)",
+	    fdur_d, wdur_d, (double)hdr_sample_frequency_d);
+    return false;
+  }
+
+  // find the number of frames
+  //
+  long nchan = sig_a.size();
+  long nframes = (nchan > 0) ? Edf::get_num_frames(sig_a[0].size()) : 0;
+  for (long i = 1; i < nchan; i++) {
+    long nf = Edf::get_num_frames(sig_a[i].size());
+    if (nf < nframes) {
+      nframes = nf;
+    }
+  }
+
+  // prepare the tapers and the transform
+  //
+  if ((!Edf::create_multitaper(n)) ||
+      (!psd_a.resize(nchan, nframes, n / 2 + 1))) {
+    return false;
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::compute_psd(): %s %ld %ld %ld %ld\n",
+	    "(nchan, nframes, n, ntapers)", nchan, nframes, n, mt_k_d);
+  }
+  if ((nchan == 0) || (nframes == 0)) {
+    return true;
+  }
+
+  // run the threads:
+  //  the calling thread also takes part, so if a thread cannot be
+  //  created the remaining channels are still processed
+  //
+  long nt = (nthreads_d < nchan) ? nthreads_d : nchan;
+  bool status[nchan];
+  pthread_t threads[nt];
+  EdfMtJob job = {this, &psd_a, &sig_a, nchan, nframes, shift, 0, status};
+
+  long nc = 1;
+  while ((nc < nt) &&
+	 (pthread_create(&threads[nc], NULL, Edf::mt_worker, &job) == 0)) {
+    nc++;
+  }
+  Edf::mt_worker(&job);
+  for (long i = 1; i < nc; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  // check the status of each channel
+  //
+  for (long i = 0; i < nchan; i++) {
+    if (!status[i]) {
+      fprintf(stdout, "**> Edf::compute_psd(): out of memory\n");
+      return false;
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+//
+// private methods
+//
+//-----------------------------------------------------------------------------
+
+// method: create_multitaper
+//
+// arguments:
+//  long n: the frame length in samples (input)
+//
+// return: a logical value indicating status
+//
+// This method finds the tapers of a frame length, the plan of the
+// complex transforms of n points and sizes the scratch buffer of
+// band_frame: the tapered frames and their transforms.
+//
+bool Edf::create_multitaper(long n_a) {
+
+  // find the tapers and the plan: a real transform of 2n points is
+  // computed with a complex transform of n points
+  //
+  mt_set_d = Edf::get_taper_set(n_a);
+  if (mt_set_d < 0) {
+    return false;
+  }
+  mt_plan_d = Edf::get_fft_plan(2 * n_a);
+  if (mt_plan_d < 0) {
+    return false;
+  }
+
+  // grow the scratch buffer
+  //
+  long bsize = 4 * ((mt_k_d + 1) / 2) * n_a;
+  if (bsize > mt_bsize_d) {
+    free(mt_buf_d);
+    void* ptr;
+    if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		       bsize * sizeof(double)) != 0) {
+      mt_buf_d = (double*)NULL;
+      mt_bsize_d = 0;
+      fprintf(stdout, "**> Edf::create_multitaper(): out of memory\n");
+      return false;
+    }
+    mt_buf_d = (double*)ptr;
+    mt_bsize_d = bsize;
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: get_taper_set
+//
+// arguments:
+//  long n: the length of the tapers (input)
+//
+// return: the index of the set, or -1 if it cannot be created
+//
+// This method returns the set of tapers of a length for the current
+// parameters, creating it if needed. The oldest set is replaced once
+// all MT_NSETS sets are used.
+//
+long Edf::get_taper_set(long n_a) {
+
+  // look for the set
+  //
+  for (long i = 0; i < mt_nsets_d; i++) {
+    if ((mt_sn_d[i] == n_a) && (mt_snw_d[i] == mt_nw_d) &&
+	(mt_sk_d[i] == mt_k_d)) {
+      return i;
+    }
+  }
+
+  // check the parameters: the band must be narrower than the
+  // Nyquist band
+  //
+  if ((n_a <= 0) || (mt_k_d > n_a) || (2 * mt_nw_d >= n_a)) {
+    fprintf(stdout, "**> Edf::get_taper_set(): %s (%ld %f %ld)\n",
+	    "invalid tapers (n, nw, ntapers)", n_a, mt_nw_d, mt_k_d);
+    return -1;
+  }
+
+  // pick a slot and create space for the tapers and the concentrations
+  //
+  long set = mt_next_d;
+  mt_next_d = (mt_next_d + 1) % MT_NSETS;
+  if (set == mt_nsets_d) {
+    mt_nsets_d++;
+  }
+
+  mt_sn_d[set] = -1;
+  free(mt_tab_d[set]);
+  void* ptr;
+  long tsize = 2 * ((mt_k_d + 1) / 2) * n_a + mt_k_d;
+  if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		     tsize * sizeof(double)) != 0) {
+    mt_tab_d[set] = (double*)NULL;
+    fprintf(stdout, "**> Edf::get_taper_set(): out of memory\n");
+    return -1;
+  }
+  mt_tab_d[set] = (double*)ptr;
+
+  // compute the tapers
+  //
+  if (!Edf::create_dpss(mt_tab_d[set], n_a, mt_nw_d, mt_k_d)) {
+    return -1;
+  }
+  mt_sn_d[set] = n_a;
+  mt_snw_d[set] = mt_nw_d;
+  mt_sk_d[set] = mt_k_d;
+
+  // exit gracefully
+  //
+  return set;
+}
+
+// method: create_dpss
+//
+// arguments:
+//  double* tab: the table of a set of tapers (output)
+//  long n: the length of the tapers (input)
+//  double nw: the time half-bandwidth product (input)
+//  long k: the number of tapers (input)
+//
+// return: a logical value indicating status
+//
+// This method computes the first k DPSS of length n, their
+// concentrations and their weights, and stores them in tab as
+// described in Edf.h. Symmetric tapers have a positive sum and
+// antisymmetric tapers a positive first half.
+//
+bool Edf::create_dpss(double* tab_a, long n_a, double nw_a, long k_a) {
+
+  // declare local variables
+  //
+  double w = nw_a / n_a;
+  long np = (k_a + 1) / 2;
+  double* conc = tab_a + 2 * np * n_a;
+
+  VectorDouble diag(n_a);
+  VectorDouble off(n_a);
+  VVectorDouble v(k_a);
+
+  // build the tridiagonal matrix: off[t] couples t - 1 and t
+  //
+  double cw = cos(2 * M_PI * w);
+  double lo = 0;
+  double hi = 0;
+  for (long t = 0; t < n_a; t++) {
+    double a = (n_a - 1 - 2.0 * t) / 2;
+    diag[t] = a * a * cw;
+    off[t] = (t == 0) ? 0.0 : t * (n_a - t) / 2.0;
+  }
+  for (long t = 0; t < n_a; t++) {
+    double r = fabs(off[t]) + ((t < n_a - 1) ? fabs(off[t + 1]) : 0.0);
+    lo = (t == 0) ? diag[t] - r : Edf::min(lo, diag[t] - r);
+    hi = (t == 0) ? diag[t] + r : Edf::max(hi, diag[t] + r);
+  }
+  double eps = DBL_EPSILON * Edf::max(fabs(lo), fabs(hi));
+
+  // workspace of the factorization
+  //
+  VectorDouble d0(n_a);
+  VectorDouble d1(n_a);
+  VectorDouble d2(n_a);
+  VectorDouble mult(n_a);
+  VectorLong swap(n_a);
+
+  for (long j = 0; j < k_a; j++) {
+
+    // find eigenvalue n - 1 - j (in increasing order) by bisection:
+    //  the number of pivots of T - x I below zero is the number of
+    //  eigenvalues below x
+    //
+    long m = n_a - 1 - j;
+    double a = lo;
+    double b = hi;
+    while (b - a > 2 * eps) {
+      double x = 0.5 * (a + b);
+      long count = 0;
+      double q = 1;
+      for (long t = 0; t < n_a; t++) {
+	q = diag[t] - x - ((t == 0) ? 0.0 : off[t] * off[t] / q);
+	if (q == 0) {
+	  q = -eps;
+	}
+	if (q < 0) {
+	  count++;
+	}
+      }
+      if (count > m) {
+	b = x;
+      }
+      else {
+	a = x;
+      }
+    }
+    double lambda = 0.5 * (a + b);
+
+    // factor T - lambda I with partial pivoting: row t of U holds
+    // d0[t], d1[t] and d2[t] on the diagonal and the next two columns
+    //
+    for (long t = 0; t < n_a; t++) {
+      d0[t] = diag[t] - lambda;
+      d1[t] = (t < n_a - 1) ? off[t + 1] : 0.0;
+      d2[t] = 0;
+    }
+    for (long t = 0; t < n_a - 1; t++) {
+      double sub = off[t + 1];
+      if (fabs(d0[t]) >= fabs(sub)) {
+	if (d0[t] == 0) {
+	  d0[t] = eps;
+	}
+	mult[t] = sub / d0[t];
+	d0[t + 1] -= mult[t] * d1[t];
+	swap[t] = 0;
+      }
+      else {
+	double r0 = d0[t];
+	double r1 = d1[t];
+	mult[t] = r0 / sub;
+	d0[t] = sub;
+	d1[t] = d0[t + 1];
+	d2[t] = d1[t + 1];
+	d0[t + 1] = r1 - mult[t] * d1[t];
+	d1[t + 1] = -mult[t] * d2[t];
+	swap[t] = 1;
+      }
+    }
+    if (d0[n_a - 1] == 0) {
+      d0[n_a - 1] = eps;
+    }
+
+    // find the eigenvector by inverse iteration, starting from a
+    // vector with a symmetric and an antisymmetric part
+    //
+    VectorDouble& x = v[j];
+    x.resize(n_a, false);
+    for (long t = 0; t < n_a; t++) {
+      x[t] = 1.0 + (double)t / n_a;
+    }
+
+    for (long it = 0; it < 3; it++) {
+
+      // solve (T - lambda I) y = x in place
+      //
+      for (long t = 0; t < n_a - 1; t++) {
+	if (swap[t]) {
+	  double tmp = x[t];
+	  x[t] = x[t + 1];
+	  x[t + 1] = tmp;
+	}
+	x[t + 1] -= mult[t] * x[t];
+      }
+      for (long t = n_a - 1; t >= 0; t--) {
+	double s = x[t];
+	if (t < n_a - 1) {
+	  s -= d1[t] * x[t + 1];
+	}
+	if (t < n_a - 2) {
+	  s -= d2[t] * x[t + 2];
+	}
+	x[t] = s / d0[t];
+      }
+
+      // keep it orthogonal to the previous tapers and normalize it
+      //
+      for (long i = 0; i < j; i++) {
+	double dp = Edf::dot(&x[0], &v[i][0], n_a);
+	for (long t = 0; t < n_a; t++) {
+	  x[t] -= dp * v[i][t];
+	}
+      }
+      double norm = sqrt(Edf::dot(&x[0], &x[0], n_a));
+      for (long t = 0; t < n_a; t++) {
+	x[t] /= norm;
+      }
+    }
+
+    // fix the sign
+    //
+    double s = 0;
+    for (long t = 0; t < n_a; t++) {
+      s += ((j % 2) == 0) ? x[t] : (n_a - 1 - 2.0 * t) * x[t];
+    }
+    if (s < 0) {
+      for (long t = 0; t < n_a; t++) {
+	x[t] = -x[t];
+      }
+    }
+  }
+
+  // compute the concentrations from the autocorrelations: the tapers
+  // are padded to 2n so the circular correlation is the linear one
+  //
+  VectorDouble pad(2 * n_a);
+  VectorDouble spec(2 * (n_a + 1));
+  VectorDouble r(2 * n_a);
+  double csum = 0;
+
+  for (long j = 0; j < k_a; j++) {
+    for (long t = 0; t < 2 * n_a; t++) {
+      pad[t] = (t < n_a) ? v[j][t] : 0.0;
+    }
+    if (!Edf::fft(&spec[0], &pad[0], 2 * n_a)) {
+      return false;
+    }
+    for (long l = 0; l <= n_a; l++) {
+      spec[2 * l] = spec[2 * l] * spec[2 * l] +
+	spec[2 * l + 1] * spec[2 * l + 1];
+      spec[2 * l + 1] = 0;
+    }
+    if (!Edf::ifft(&r[0], &spec[0], 2 * n_a)) {
+      return false;
+    }
+
+    double c = 2 * w * r[0];
+    for (long s = 1; s < n_a; s++) {
+      c += 2 * r[s] * sin(2 * M_PI * w * s) / (M_PI * s);
+    }
+    conc[j] = c;
+    csum += c;
+  }
+
+  // store the tapers in pairs, scaled by the square roots of their
+  // weights
+  //
+  for (long p = 0; p < np; p++) {
+    double* z = tab_a + 2 * p * n_a;
+    long j0 = 2 * p;
+    long j1 = 2 * p + 1;
+    double s0 = sqrt(conc[j0] / csum);
+    double s1 = (j1 < k_a) ? sqrt(conc[j1] / csum) : 0.0;
+    for (long t = 0; t < n_a; t++) {
+      z[2 * t] = s0 * v[j0][t];
+      z[2 * t + 1] = (j1 < k_a) ? s1 * v[j1][t] : 0.0;
+    }
+  }
+
+  // display debugging information
+  //
+  if (debug_level_d >= LEVEL_DETAILED) {
+    fprintf(stdout, "Edf::create_dpss(): %s %ld %f %ld\n",
+	    "(n, nw, ntapers)", n_a, nw_a, k_a);
+    for (long j = 0; j < k_a; j++) {
+      fprintf(stdout, " taper %ld: concentration = %.12f\n", j, conc[j]);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: mt_frame
+//
+// arguments:
+//  double* y: the multitaper spectrum, n / 2 + 1 values (output)
+//  const double* x: the first sample of a frame (input)
+//  long set: the set of tapers (input)
+//  long plan: the plan of complex transforms of n points (input)
+//  double* buf: a scratch buffer of 4 ((k + 1) / 2) n values (input)
+//
+// return: a logical value indicating status
+//
+// This method tapers a frame by every pair of tapers, transforms the
+// pairs in one batch and sums their powers. It only writes y and buf,
+// so threads with their own buffers can run it at the same time.
+//
+bool Edf::mt_frame(double* y_a, const double* x_a, long set_a, long plan_a,
+		   double* buf_a) {
+
+  // declare local variables
+  //
+  long n = mt_sn_d[set_a];
+  long np = (mt_sk_d[set_a] + 1) / 2;
+  const double* tab = mt_tab_d[set_a];
+  double* a = buf_a;
+  double* b = buf_a + 2 * np * n;
+
+  // taper the frame: a pair of tapers gives one complex sequence
+  //
+  for (long p = 0; p < np; p++) {
+    const double* w = tab + 2 * p * n;
+    double* z = a + 2 * p * n;
+    long t = 0;
+#if defined(__AVX__)
+    for (; t + 2 <= n; t += 2) {
+      __m128d x2 = _mm_loadu_pd(x_a + t);
+      __m256d xx =
+	_mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_unpacklo_pd(x2, x2)),
+			     _mm_unpackhi_pd(x2, x2), 1);
+      _mm256_storeu_pd(z + 2 * t,
+		       _mm256_mul_pd(_mm256_loadu_pd(w + 2 * t), xx));
+    }
+#elif defined(__SSE2__)
+    for (; t < n; t++) {
+      _mm_storeu_pd(z + 2 * t,
+		    _mm_mul_pd(_mm_loadu_pd(w + 2 * t), _mm_set1_pd(x_a[t])));
+    }
+#endif
+    for (; t < n; t++) {
+      z[2 * t] = w[2 * t] * x_a[t];
+      z[2 * t + 1] = w[2 * t + 1] * x_a[t];
+    }
+  }
+
+  // transform the pairs
+  //
+  double* z = Edf::fft_batch(plan_a, a, b, np);
+
+  // sum the powers of the pairs
+  //
+  long nbins = n / 2 + 1;
+  for (long k = 0; k < nbins; k++) {
+    y_a[k] = 0;
+  }
+  for (long p = 0; p < np; p++) {
+    const double* zp = z + 2 * p * n;
+    for (long k = 0; k < nbins; k++) {
+      long k2 = (k == 0) ? 0 : n - k;
+      y_a[k] += 0.5 * (zp[2 * k] * zp[2 * k] +
+		       zp[2 * k + 1] * zp[2 * k + 1] +
+		       zp[2 * k2] * zp[2 * k2] +
+		       zp[2 * k2 + 1] * zp[2 * k2 + 1]);
+    }
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: band_psum
+//
+// arguments:
+//  double* y: the log power of each band (output)
+//  const double* pow: a power spectrum, n / 2 + 1 values (input)
+//
+// return: a logical value indicating status
+//
+// This method reduces a power spectrum to log band powers, as band_sum
+// does for a transform.
+//
+bool Edf::band_psum(double* y_a, const double* pow_a) {
+
+  // integrate the bands
+  //
+  const double* w = &band_wgt_d[0];
+  for (long b = 0; b < (long)band_lo_d.size(); b++) {
+    const double* z = pow_a + band_first_d[b];
+    long nk = band_nbins_d[b];
+    double sum = 0;
+    for (long k = 0; k < nk; k++) {
+      sum += w[k] * z[k];
+    }
+    w += nk;
+    y_a[b] = log(Edf::max(sum, LOG_FLOOR));
+  }
+
+  // exit gracefully
+  //
+  return true;
+}
+
+// method: mt_worker
+//
+// arguments:
+//  void* arg: the EdfMtJob shared by all threads (input)
+//
+// return: NULL
+//
+// This method is the body of a thread used by compute_psd. Channels
+// are claimed one at a time. Each thread has its own scratch buffer,
+// and the tapers and the plan are only read.
+//
+void* Edf::mt_worker(void* arg_a) {
+
+  // declare local variables
+  //
+  EdfMtJob* job = (EdfMtJob*)arg_a;
+  Edf* edf = job->edf;
+  long set = edf->mt_set_d;
+  long n = edf->mt_sn_d[set];
+  double fs = edf->hdr_sample_frequency_d;
+
+  // create space for the tapered frames and their transforms
+  //
+  void* ptr;
+  double* buf = (double*)NULL;
+  if (posix_memalign(&ptr, FeatureTensor::ALIGN,
+		     4 * ((edf->mt_sk_d[set] + 1) / 2) * n *
+		     sizeof(double)) == 0) {
+    buf = (double*)ptr;
+  }
+
+  // loop until all channels are claimed
+  //
+  long i;
+  while ((i = __sync_fetch_and_add(&job->next, 1)) < job->nchan) {
+    job->status[i] = false;
+    if (buf == (double*)NULL) {
+      continue;
+    }
+
+    // compute the spectrum of each frame and scale it to a one-sided
+    // density
+    //
+    const double* x = &(*job->sig)[i][0];
+    for (long j = 0; j < job->nframes; j++) {
+      double* y = job->psd->get_frame(i, j);
+      edf->mt_frame(y, x + j * job->shift, set, edf->mt_plan_d, buf);
+      for (long k = 0; k <= n / 2; k++) {
+	y[k] *= (((k == 0) || (2 * k == n)) ? 1.0 : 2.0) / fs;
+      }
+    }
+    job->status[i] = true;
+  }
+
+  // clean up
+  //
+  free(buf);
+
+  // exit gracefully
+  //
+  return (void*)NULL;
+}
+
+//
+// end of file